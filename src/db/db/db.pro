@@ -20,6 +20,9 @@ SOURCES = \
   dbClipboardData.cc \
   dbClip.cc \
   dbCommonReader.cc \
+  dbContourArena.cc \
+  dbCoordArray.cc \
+  dbDeepShapeStore.cc \
   dbEdge.cc \
   dbEdgePair.cc \
   dbEdgePairRelations.cc \
@@ -30,6 +33,7 @@ SOURCES = \
   dbFuzzyCellMapping.cc \
   dbGlyphs.cc \
   dbHershey.cc \
+  dbHierProcessor.cc \
   dbInstances.cc \
   dbInstElement.cc \
   dbLayerMapping.cc \
@@ -90,6 +94,8 @@ SOURCES = \
   gsiDeclDbCell.cc \
   gsiDeclDbCellMapping.cc \
   gsiDeclDbCommonStreamOptions.cc \
+  gsiDeclDbCoordArray.cc \
+  gsiDeclDbDeepShapeStore.cc \
   gsiDeclDbEdge.cc \
   gsiDeclDbEdgePair.cc \
   gsiDeclDbEdgePairs.cc \
@@ -136,6 +142,9 @@ HEADERS = \
   dbClipboard.h \
   dbClip.h \
   dbCommonReader.h \
+  dbContourArena.h \
+  dbCoordArray.h \
+  dbDeepShapeStore.h \
   dbEdge.h \
   dbEdgePair.h \
   dbEdgePairRelations.h \
@@ -148,6 +157,7 @@ HEADERS = \
   dbHash.h \
   dbHersheyFont.h \
   dbHershey.h \
+  dbHierProcessor.h \
   dbInstances.h \
   dbInstElement.h \
   dbLayer.h \
@@ -184,6 +194,7 @@ HEADERS = \
   dbSaveLayoutOptions.h \
   dbShape.h \
   dbShapeRepository.h \
+  dbShapeHash.h \
   dbShapes2.h \
   dbShapeProcessor.h \
   dbShapes.h \
@@ -28,6 +28,7 @@
 
 #include "dbBoxConvert.h"
 #include "tlProgress.h"
+#include "tlThreadedWorkers.h"
 
 #include <list>
 #include <vector>
@@ -35,6 +36,7 @@
 #include <set>
 #include <functional>
 #include <memory>
+#include <algorithm>
 
 namespace db
 {
@@ -131,6 +133,163 @@ struct box_scanner_receiver
   void add (const Obj * /*o1*/, const Prop & /*p1*/, const Obj * /*o2*/, const Prop & /*p2*/) { }
 };
 
+template <class Obj, class Prop> class box_scanner;
+
+/**
+ *  @brief A receiver for one strip of the parallel box scanner
+ *
+ *  An interaction is reported by the strip which contains the larger one of the two
+ *  left box edges. Both objects are present in that strip, hence every interaction is
+ *  reported exactly once. An object is finished by the strip which contains its left 
+ *  box edge.
+ */
+template <class Obj, class Prop, class Rec, class BoxConvert>
+class bs_strip_receiver
+{
+public:
+  typedef typename BoxConvert::box_type::coord_type coord_type;
+
+  bs_strip_receiver (Rec *rec, const std::vector<coord_type> *bounds, size_t strip, const BoxConvert &bc)
+    : mp_rec (rec), mp_bounds (bounds), m_strip (strip), m_bc (bc)
+  {
+    //  .. nothing yet ..
+  }
+
+  void finish (const Obj *obj, const Prop &prop)
+  {
+    if (strip_of (m_bc (*obj).left ()) == m_strip) {
+      mp_rec->finish (obj, prop);
+    }
+  }
+
+  void add (const Obj *o1, const Prop &p1, const Obj *o2, const Prop &p2)
+  {
+    if (strip_of (std::max (m_bc (*o1).left (), m_bc (*o2).left ())) == m_strip) {
+      mp_rec->add (o1, p1, o2, p2);
+    }
+  }
+
+  /**
+   *  @brief Gets the index of the strip which contains the given x coordinate
+   */
+  static size_t strip_of (const std::vector<coord_type> &bounds, coord_type x)
+  {
+    return size_t (std::upper_bound (bounds.begin (), bounds.end (), x) - bounds.begin ());
+  }
+
+private:
+  Rec *mp_rec;
+  const std::vector<coord_type> *mp_bounds;
+  size_t m_strip;
+  BoxConvert m_bc;
+
+  size_t strip_of (coord_type x) const
+  {
+    return strip_of (*mp_bounds, x);
+  }
+};
+
+/**
+ *  @brief A task for the parallel box scanner: scans one strip
+ */
+template <class Obj, class Prop, class Rec, class BoxConvert>
+class bs_strip_task
+  : public tl::Task
+{
+public:
+  typedef typename BoxConvert::box_type::coord_type coord_type;
+
+  bs_strip_task (Rec *rec, const std::vector<coord_type> *bounds, size_t strip, coord_type enl, const BoxConvert &bc)
+    : mp_rec (rec), mp_bounds (bounds), m_strip (strip), m_enl (enl), m_bc (bc)
+  {
+    //  .. nothing yet ..
+  }
+
+  box_scanner<Obj, Prop> &scanner ()
+  {
+    return m_scanner;
+  }
+
+  void process ()
+  {
+    bs_strip_receiver<Obj, Prop, Rec, BoxConvert> rec (mp_rec, mp_bounds, m_strip, m_bc);
+    m_scanner.process (rec, m_enl, m_bc);
+  }
+
+private:
+  box_scanner<Obj, Prop> m_scanner;
+  Rec *mp_rec;
+  const std::vector<coord_type> *mp_bounds;
+  size_t m_strip;
+  coord_type m_enl;
+  BoxConvert m_bc;
+};
+
+template <class Task> class bs_strip_job;
+
+/**
+ *  @brief A worker for the parallel box scanner
+ */
+template <class Task>
+class bs_strip_worker
+  : public tl::Worker
+{
+public:
+  bs_strip_worker (bs_strip_job<Task> *job)
+    : tl::Worker (), mp_job (job)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    Task *strip_task = dynamic_cast <Task *> (task);
+    if (strip_task) {
+      strip_task->process ();
+      mp_job->next_strip ();
+    }
+  }
+
+private:
+  bs_strip_job<Task> *mp_job;
+};
+
+/**
+ *  @brief The job for the parallel box scanner
+ */
+template <class Task>
+class bs_strip_job
+  : public tl::JobBase
+{
+public:
+  bs_strip_job (int nworkers)
+    : tl::JobBase (nworkers), m_strips_done (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  void next_strip ()
+  {
+    tl::MutexLocker locker (&m_mutex);
+    ++m_strips_done;
+  }
+
+  size_t strips_done ()
+  {
+    tl::MutexLocker locker (&m_mutex);
+    return m_strips_done;
+  }
+
+  virtual tl::Worker *create_worker ()
+  {
+    return new bs_strip_worker<Task> (this);
+  }
+
+private:
+  size_t m_strips_done;
+  tl::Mutex m_mutex;
+};
+
 /**
  *  @brief A box scanner framework
  *
@@ -381,6 +540,118 @@ public:
 
   }
 
+  /**
+   *  @brief Get the interactions between the stored objects using multiple threads
+   *
+   *  This method delivers the same interactions than "process", but partitions the
+   *  objects into vertical strips which are scanned in parallel. Each strip is
+   *  extended to the left by the boxes reaching into it (including the enlargement),
+   *  so interactions across the strip boundaries are found. Every interaction is
+   *  reported exactly once.
+   *
+   *  There is one receiver per strip: "recs" gives the receivers and hence the
+   *  maximum number of strips. Each receiver is only called from one thread at a time,
+   *  but different receivers are called from different threads. The results need to
+   *  be combined by the caller.
+   *
+   *  "finish" is called once per object on the receiver of the strip the object's left
+   *  box edge falls into. Note that interactions of the object may still be reported to
+   *  other receivers after that. Hence this method is not suitable for receivers 
+   *  relying on "finish" being called after all interactions of an object.
+   *
+   *  If there are not enough objects or "threads" is less than 2, this method will use
+   *  single-threaded processing and report everything to the first receiver.
+   */
+  template <class Rec, class BoxConvert>
+  void process_parallel (const std::vector<Rec *> &recs, unsigned int threads, typename BoxConvert::box_type::coord_type enl, const BoxConvert &bc = BoxConvert ())
+  {
+    typedef typename BoxConvert::box_type box_type;
+    typedef typename box_type::coord_type coord_type;
+    typedef bs_strip_task<Obj, Prop, Rec, BoxConvert> strip_task;
+
+    //  below this number of objects per strip, multi-threading is not worth the effort
+    const size_t min_objects_per_strip = 1000;
+
+    tl_assert (! recs.empty ());
+
+    size_t nstrips = std::min (recs.size (), m_pp.size () / min_objects_per_strip);
+    if (threads < 2 || nstrips < 2) {
+      process (*recs.front (), enl, bc);
+      return;
+    }
+
+    //  Determine the strip boundaries such that the strips receive about the same number of objects
+
+    std::vector<coord_type> lefts;
+    lefts.reserve (m_pp.size ());
+    for (iterator_type i = m_pp.begin (); i != m_pp.end (); ++i) {
+      lefts.push_back (bc (*i->first).left ());
+    }
+    std::sort (lefts.begin (), lefts.end ());
+
+    std::vector<coord_type> bounds;
+    for (size_t s = 1; s < nstrips; ++s) {
+      coord_type x = lefts [(lefts.size () * s) / nstrips];
+      if (bounds.empty () || x > bounds.back ()) {
+        bounds.push_back (x);
+      }
+    }
+
+    std::vector<coord_type> ().swap (lefts);
+    nstrips = bounds.size () + 1;
+
+    //  NOTE: the job takes ownership over the tasks
+    bs_strip_job<strip_task> job ((int) threads);
+
+    std::vector<strip_task *> tasks;
+    for (size_t s = 0; s < nstrips; ++s) {
+      tasks.push_back (new strip_task (recs [s], &bounds, s, enl, bc));
+      tasks.back ()->scanner ().set_fill_factor (m_fill_factor);
+      tasks.back ()->scanner ().set_scanner_threshold (m_scanner_thr);
+      job.schedule (tasks.back ());
+    }
+
+    //  An object goes into the strip containing its left edge and into all strips to the
+    //  right its box reaches into (including the enlargement)
+
+    for (iterator_type i = m_pp.begin (); i != m_pp.end (); ++i) {
+
+      box_type b = bc (*i->first);
+      size_t s = bs_strip_receiver<Obj, Prop, Rec, BoxConvert>::strip_of (bounds, b.left ());
+      tasks [s]->scanner ().insert (i->first, i->second);
+
+      if (! b.empty ()) {
+        for (++s; s < nstrips && b.right () + enl > bounds [s - 1]; ++s) {
+          tasks [s]->scanner ().insert (i->first, i->second);
+        }
+      }
+
+    }
+
+    std::auto_ptr<tl::RelativeProgress> progress (0);
+    if (m_report_progress) {
+      progress.reset (new tl::RelativeProgress (m_progress_desc.empty () ? tl::to_string (tr ("Processing")) : m_progress_desc, nstrips, 1));
+    }
+
+    try {
+      job.start ();
+      while (job.is_running ()) {
+        if (progress.get ()) {
+          //  This may throw an exception, if the cancel button has been pressed.
+          progress->set (job.strips_done (), true /*force yield*/);
+        }
+        job.wait (100);
+      }
+    } catch (...) {
+      job.terminate ();
+      throw;
+    }
+
+    if (job.has_error ()) {
+      throw tl::Exception (tl::to_string (tr ("Errors occured during processing. First error message says:\n")) + job.error_messages ().front ());
+    }
+  }
+
 private:
   container_type m_pp;
   double m_fill_factor;
@@ -28,9 +28,11 @@
 #include "tlReuseVector.h"
 #include "dbBox.h"
 #include "dbMemStatistics.h"
+#include "tlThreads.h"
 
 #include <limits>
 #include <vector>
+#include <algorithm>
 
 namespace db
 {
@@ -156,6 +158,133 @@ private:
   tl::vector<box_type> m_boxes;
 };
 
+/**
+ *  @brief The minimum number of elements for which the quad tree sorting is done in parallel
+ */
+const size_t box_tree_parallel_sort_threshold = 100000;
+
+/**
+ *  @brief A helper thread for sorting quads of a box tree
+ *
+ *  The quads of a box tree node occupy disjoint ranges of the element 
+ *  vector and attach to separate child slots of the node. Hence they can
+ *  be sorted independently. Each thread sorts one or more quads.
+ */
+template <class Tree, class Iter, class Picker>
+class box_tree_sort_thread
+  : public tl::Thread
+{
+public:
+  typedef typename Tree::box_type box_type;
+  typedef typename Tree::box_tree_node box_tree_node;
+
+  box_tree_sort_thread (Tree *tree, box_tree_node *parent, Picker &picker)
+    : mp_tree (tree), mp_parent (parent), m_picker (picker)
+  { }
+
+  /**
+   *  @brief Adds a quad to sort
+   *
+   *  "threads" is the number of threads the quad may use for further subdivision.
+   */
+  void add (Iter from, Iter to, const box_type &bbox, int quad, unsigned int threads)
+  {
+    m_jobs.push_back (job (from, to, bbox, quad, threads));
+  }
+
+  virtual void run ()
+  {
+    for (typename std::vector<job>::const_iterator j = m_jobs.begin (); j != m_jobs.end (); ++j) {
+      mp_tree->tree_sort (mp_parent, j->from, j->to, m_picker, j->bbox, j->quad, j->threads);
+    }
+  }
+
+  /**
+   *  @brief Sorts the non-empty quads of the given node in parallel
+   *
+   *  "threads" is the total number of threads available for sorting the quads, 
+   *  including the calling thread. If there are more threads than quads, the 
+   *  remaining threads are shared among the quads for further subdivision. 
+   *  Otherwise the quads are distributed over the available threads.
+   */
+  static void sort_quads (Tree *tree, box_tree_node *node, const Iter *qloc, const box_type *qboxes, Picker &picker, unsigned int threads)
+  {
+    int quads [4];
+    unsigned int nq = 0;
+    for (int q = 0; q < 4; ++q) {
+      if (qloc [q] != qloc [q + 1]) {
+        quads [nq++] = q;
+      }
+    }
+
+    if (nq == 0) {
+      return;
+    }
+
+    unsigned int nworkers = std::min (nq, std::max (threads, 1u));
+
+    //  worker 0 is the calling thread
+    std::vector<box_tree_sort_thread *> workers;
+    workers.reserve (nworkers);
+
+    try {
+
+      for (unsigned int w = 0; w < nworkers; ++w) {
+        workers.push_back (new box_tree_sort_thread (tree, node, picker));
+      }
+
+      for (unsigned int i = 0; i < nq; ++i) {
+        unsigned int qthreads = 1;
+        if (nworkers == nq) {
+          qthreads = threads / nq + (i < threads % nq ? 1 : 0);
+        }
+        int q = quads [i];
+        workers [i % nworkers]->add (qloc [q], qloc [q + 1], qboxes [q], q, qthreads);
+      }
+
+      for (unsigned int w = 1; w < nworkers; ++w) {
+        workers [w]->start ();
+      }
+
+      workers [0]->run ();
+
+    } catch (...) {
+      for (unsigned int w = 0; w < workers.size (); ++w) {
+        if (w > 0) {
+          workers [w]->wait ();
+        }
+        delete workers [w];
+      }
+      throw;
+    }
+
+    for (unsigned int w = 0; w < workers.size (); ++w) {
+      if (w > 0) {
+        workers [w]->wait ();
+      }
+      delete workers [w];
+    }
+  }
+
+private:
+  struct job
+  {
+    job (Iter _from, Iter _to, const box_type &_bbox, int _quad, unsigned int _threads)
+      : from (_from), to (_to), bbox (_bbox), quad (_quad), threads (_threads)
+    { }
+
+    Iter from, to;
+    box_type bbox;
+    int quad;
+    unsigned int threads;
+  };
+
+  Tree *mp_tree;
+  box_tree_node *mp_parent;
+  Picker &m_picker;
+  std::vector<job> m_jobs;
+};
+
 /**
  *  @brief The node object
  */
@@ -727,6 +856,16 @@ public:
     return *this;
   }
 
+  /**
+   *  @brief Swaps the contents of this tree with another one
+   */
+  void swap (box_tree &b)
+  {
+    m_objects.swap (b.m_objects);
+    m_elements.swap (b.m_elements);
+    std::swap (mp_root, b.mp_root);
+  }
+
   /**
    *  @brief The destructor
    */
@@ -909,11 +1048,14 @@ public:
    *
    *  Only after sorting the query iterators are available.
    *  Sorting complexity is approx O(N*log(N)).
+   *
+   *  If "threads" is larger than 1, the quads of large trees are sorted 
+   *  in parallel using up to the given number of threads.
    */
-  void sort (const BoxConv &conv)
+  void sort (const BoxConv &conv, unsigned int threads = 0)
   {
     typename BoxConv::complexity complexity_tag;
-    sort (conv, complexity_tag);
+    sort (conv, complexity_tag, threads);
   }
 
   /**
@@ -1104,6 +1246,7 @@ public:
   }
 
 private:
+  template <class T, class I, class P> friend class box_tree_sort_thread;
 
   /// The basic object and element vector
   obj_vector_type m_objects;
@@ -1111,7 +1254,7 @@ private:
   box_tree_node *mp_root;
 
   /// Sort implementation for simple bboxes - no caching
-  void sort (const BoxConv &conv, const db::simple_bbox_tag &/*complexity*/)
+  void sort (const BoxConv &conv, const db::simple_bbox_tag &/*complexity*/, unsigned int threads)
   {
     m_elements.clear ();
     m_elements.reserve (m_objects.size ());
@@ -1134,13 +1277,13 @@ private:
 
       //  TODO: resize m_elements to actual size ?
 
-      tree_sort (0, m_elements.begin (), m_elements.end (), picker, bbox, 0);
+      tree_sort (0, m_elements.begin (), m_elements.end (), picker, bbox, 0, threads);
 
     }
   }
 
   /// Sort implementation for complex bboxes - with caching
-  void sort (const box_conv_type &conv, const db::complex_bbox_tag &/*complexity*/)
+  void sort (const box_conv_type &conv, const db::complex_bbox_tag &/*complexity*/, unsigned int threads)
   {
     m_elements.clear ();
     m_elements.reserve (m_objects.size ());
@@ -1160,13 +1303,13 @@ private:
 
       //  TODO: resize m_elements to actual size ?
 
-      tree_sort (0, m_elements.begin (), m_elements.end (), picker, picker.bbox (), 0);
+      tree_sort (0, m_elements.begin (), m_elements.end (), picker, picker.bbox (), 0, threads);
 
     }
   }
 
   template <class CoordPicker>
-  void tree_sort (box_tree_node *parent, element_iterator from, element_iterator to, const CoordPicker &picker, const box_type &bbox, int quad)
+  void tree_sort (box_tree_node *parent, element_iterator from, element_iterator to, const CoordPicker &picker, const box_type &bbox, int quad, unsigned int threads)
   {
     size_t ntot = size_t (to - from);
     if (ntot <= min_bin || (bbox.width () < 2 && bbox.height () < 2)) {
@@ -1241,7 +1384,17 @@ private:
       for (unsigned int q = 0; q < 4; ++q) {
         if (n[q] > 0) {
           node->lenq (q, n[q]);
-          tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q));
+        }
+      }
+
+      if (threads > 1 && ntot >= box_tree_parallel_sort_threshold) {
+        //  the quads are independent, so they can be sorted in parallel
+        box_tree_sort_thread<box_tree_type, element_iterator, const CoordPicker>::sort_quads (this, node, qloc, qboxes, picker, threads);
+      } else {
+        for (unsigned int q = 0; q < 4; ++q) {
+          if (n[q] > 0) {
+            tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q), threads);
+          }
         }
       }
 
@@ -1692,6 +1845,15 @@ public:
     return *this;
   }
 
+  /**
+   *  @brief Swaps the contents of this tree with another one
+   */
+  void swap (unstable_box_tree &b)
+  {
+    m_objects.swap (b.m_objects);
+    std::swap (mp_root, b.mp_root);
+  }
+
   /**
    *  @brief The destructor
    */
@@ -1899,11 +2061,14 @@ public:
    *
    *  Only after sorting the query iterators are available.
    *  Sorting complexity is approx O(N*log(N)).
+   *
+   *  If "threads" is larger than 1, the quads of large trees are sorted 
+   *  in parallel using up to the given number of threads.
    */
-  void sort (const BoxConv &conv)
+  void sort (const BoxConv &conv, unsigned int threads = 0)
   {
     typename BoxConv::complexity complexity_tag;
-    sort (conv, complexity_tag);
+    sort (conv, complexity_tag, threads);
   }
 
   /**
@@ -2048,12 +2213,14 @@ public:
   }
 
 private:
+  template <class T, class I, class P> friend class box_tree_sort_thread;
+
   /// The basic object and element vector
   obj_vector_type m_objects;
   box_tree_node *mp_root;
 
   /// Sort implementation for simple bboxes - no caching
-  void sort (const BoxConv &conv, const db::simple_bbox_tag &/*complexity*/)
+  void sort (const BoxConv &conv, const db::simple_bbox_tag &/*complexity*/, unsigned int threads)
   {
     if (m_objects.empty ()) {
       return;
@@ -2074,11 +2241,11 @@ private:
       }
     }
 
-    tree_sort (0, m_objects.begin (), m_objects.end (), picker, bbox, 0);
+    tree_sort (0, m_objects.begin (), m_objects.end (), picker, bbox, 0, threads);
   }
 
   /// Sort implementation for complex bboxes - with caching
-  void sort (const box_conv_type &conv, const db::complex_bbox_tag &/*complexity*/)
+  void sort (const box_conv_type &conv, const db::complex_bbox_tag &/*complexity*/, unsigned int threads)
   {
     if (m_objects.empty ()) {
       return;
@@ -2091,11 +2258,11 @@ private:
     }
     mp_root = 0;
 
-    tree_sort (0, m_objects.begin (), m_objects.end (), picker, picker.bbox (), 0);
+    tree_sort (0, m_objects.begin (), m_objects.end (), picker, picker.bbox (), 0, threads);
   }
 
   template <class CoordPicker>
-  void tree_sort (box_tree_node *parent, obj_iterator from, obj_iterator to, CoordPicker &picker, const box_type &bbox, int quad)
+  void tree_sort (box_tree_node *parent, obj_iterator from, obj_iterator to, CoordPicker &picker, const box_type &bbox, int quad, unsigned int threads)
   {
     size_t ntot = size_t (to - from);
     if (ntot <= min_bin || (bbox.width () < 2 && bbox.height () < 2)) {
@@ -2175,7 +2342,17 @@ private:
       for (unsigned int q = 0; q < 4; ++q) {
         if (n[q] > 0) {
           node->lenq (q, n[q]);
-          tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q));
+        }
+      }
+
+      if (threads > 1 && ntot >= box_tree_parallel_sort_threshold) {
+        //  the quads are independent, so they can be sorted in parallel
+        box_tree_sort_thread<box_tree_type, obj_iterator, CoordPicker>::sort_quads (this, node, qloc, qboxes, picker, threads);
+      } else {
+        for (unsigned int q = 0; q < 4; ++q) {
+          if (n[q] > 0) {
+            tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q), threads);
+          }
         }
       }
 
@@ -372,10 +372,10 @@ Cell::swap (unsigned int i1, unsigned int i2)
 }
 
 void 
-Cell::sort_shapes ()
+Cell::sort_shapes (unsigned int threads)
 {
   for (shapes_map::iterator s = m_shapes_map.begin (); s != m_shapes_map.end (); ++s) {
-    s->second.sort ();
+    s->second.sort (threads);
   }
 }
 
@@ -477,8 +477,10 @@ public:
    *  on a per-shape basis. Since sorting of the shapes is
    *  guarded against redundant sorting (db::Layer::sort),
    *  we can safely call the sort method in any case.
+   *
+   *  "threads" is the number of threads to use for sorting large layers.
    */
-  void sort_shapes ();
+  void sort_shapes (unsigned int threads = 0);
 
   /**
    *  @brief Retrieve the bounding box of the cell
@@ -0,0 +1,318 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbContourArena.h"
+#include "tlThreads.h"
+#include "tlAssert.h"
+#include "atomic/atomic.h"
+
+namespace db
+{
+
+// -------------------------------------------------------------------------------------
+//  Chunks
+
+/**
+ *  @brief The part of an arena shared with its chunks
+ *
+ *  This object lives as long as the arena or chunks of it exist. "arena" is 0 
+ *  if the arena has been destroyed while chunks were still in use. The lock
+ *  protects the arena's and the chunks' members.
+ */
+struct ContourArenaShared
+{
+  ContourArenaShared (ContourArena *_arena)
+    : arena (_arena), chunks (0)
+  { }
+
+  tl::Mutex lock;
+  ContourArena *arena;
+  size_t chunks;
+};
+
+/**
+ *  @brief A chunk of arena memory
+ */
+struct ContourArenaChunk
+{
+  char *begin, *ptr, *end;
+  size_t live_bytes;
+  ContourArenaShared *shared;
+};
+
+//  The alignment of the blocks handed out (suitable for double coordinates)
+static const size_t arena_alignment = sizeof (double);
+
+//  The size of the block header (the pointer to the chunk)
+static const size_t header_size = (sizeof (ContourArenaChunk *) + arena_alignment - 1) & ~(arena_alignment - 1);
+
+//  Used to skip the lookup of the current arena if there are no arenas at all
+static atomic::atomic<size_t> s_num_arenas;
+
+static tl::ThreadStorage<ContourArena **> s_current_arena;
+
+static size_t
+aligned_size (size_t n)
+{
+  return ((n ? n : 1) + arena_alignment - 1) & ~(arena_alignment - 1);
+}
+
+static void
+free_chunk (ContourArenaChunk *chunk)
+{
+  --chunk->shared->chunks;
+  delete [] chunk->begin;
+  delete chunk;
+}
+
+// -------------------------------------------------------------------------------------
+//  ContourArena implementation
+
+ContourArena::ContourArena (size_t chunk_size)
+  : m_chunk_size (aligned_size (chunk_size)), mp_current (0), mp_shared (new ContourArenaShared (this))
+{
+  ++s_num_arenas;
+}
+
+ContourArena::~ContourArena ()
+{
+  bool last = false;
+
+  {
+    tl::MutexLocker locker (&mp_shared->lock);
+
+    for (std::set<ContourArenaChunk *>::const_iterator c = m_chunks.begin (); c != m_chunks.end (); ++c) {
+      if ((*c)->live_bytes == 0) {
+        free_chunk (*c);
+      }
+    }
+
+    m_chunks.clear ();
+    mp_current = 0;
+
+    //  the chunks still in use are freed by "release"
+    mp_shared->arena = 0;
+    last = (mp_shared->chunks == 0);
+  }
+
+  if (last) {
+    delete mp_shared;
+  }
+  mp_shared = 0;
+
+  --s_num_arenas;
+}
+
+ContourArenaChunk *
+ContourArena::new_chunk (size_t n)
+{
+  ContourArenaChunk *chunk = new ContourArenaChunk ();
+  chunk->begin = new char [n];
+  chunk->ptr = chunk->begin;
+  chunk->end = chunk->begin + n;
+  chunk->live_bytes = 0;
+  chunk->shared = mp_shared;
+
+  ++mp_shared->chunks;
+  m_chunks.insert (chunk);
+
+  return chunk;
+}
+
+void
+ContourArena::drop_chunk (ContourArenaChunk *chunk)
+{
+  m_chunks.erase (chunk);
+  if (chunk == mp_current) {
+    mp_current = 0;
+  }
+  free_chunk (chunk);
+}
+
+void *
+ContourArena::allocate (size_t n)
+{
+  n = aligned_size (n);
+  size_t nblock = n + header_size;
+
+  tl::MutexLocker locker (&mp_shared->lock);
+
+  ContourArenaChunk *chunk = mp_current;
+
+  if (! chunk || size_t (chunk->end - chunk->ptr) < nblock) {
+
+    if (nblock > m_chunk_size / 4) {
+
+      //  big blocks get a chunk of their own
+      chunk = new_chunk (nblock);
+
+    } else {
+
+      ContourArenaChunk *prev = mp_current;
+      mp_current = chunk = new_chunk (m_chunk_size);
+      if (prev && prev->live_bytes == 0) {
+        drop_chunk (prev);
+      }
+
+    }
+
+  }
+
+  char *p = chunk->ptr;
+  chunk->ptr += nblock;
+  chunk->live_bytes += n;
+
+  *(ContourArenaChunk **) p = chunk;
+  return (void *) (p + header_size);
+}
+
+size_t
+ContourArena::used_bytes () const
+{
+  tl::MutexLocker locker (&mp_shared->lock);
+
+  size_t n = 0;
+  for (std::set<ContourArenaChunk *>::const_iterator c = m_chunks.begin (); c != m_chunks.end (); ++c) {
+    n += (*c)->live_bytes;
+  }
+  return n;
+}
+
+size_t
+ContourArena::reserved_bytes () const
+{
+  tl::MutexLocker locker (&mp_shared->lock);
+
+  size_t n = 0;
+  for (std::set<ContourArenaChunk *>::const_iterator c = m_chunks.begin (); c != m_chunks.end (); ++c) {
+    n += size_t ((*c)->end - (*c)->begin);
+  }
+  return n;
+}
+
+void
+ContourArena::mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self, void *parent) const
+{
+  if (! no_self) {
+    stat->add (typeid (*this), (void *) this, sizeof (*this), sizeof (*this), parent, purpose, cat);
+  }
+
+  tl::MutexLocker locker (&mp_shared->lock);
+
+  stat->add (typeid (ContourArenaShared), (void *) mp_shared, sizeof (ContourArenaShared), sizeof (ContourArenaShared), (void *) this, purpose, cat);
+
+  for (std::set<ContourArenaChunk *>::const_iterator c = m_chunks.begin (); c != m_chunks.end (); ++c) {
+    stat->add (typeid (ContourArenaChunk), (void *) *c, sizeof (ContourArenaChunk), sizeof (ContourArenaChunk), (void *) this, purpose, cat);
+    //  the used parts are reported by the contours (the block headers are reported here)
+    stat->add (typeid (char []), (void *) (*c)->begin, size_t ((*c)->end - (*c)->begin) - (*c)->live_bytes, 0, (void *) this, purpose, cat);
+  }
+}
+
+ContourArena *
+ContourArena::current ()
+{
+  if (! s_current_arena.hasLocalData ()) {
+    return 0;
+  } else {
+    return *s_current_arena.localData ();
+  }
+}
+
+void *
+ContourArena::allocate_current (size_t n)
+{
+  if (s_num_arenas.load () == 0) {
+    return 0;
+  }
+
+  ContourArena *arena = current ();
+  return arena ? arena->allocate (n) : 0;
+}
+
+void
+ContourArena::release (void *p, size_t n)
+{
+  ContourArenaChunk *chunk = *(ContourArenaChunk **) ((char *) p - header_size);
+  ContourArenaShared *shared = chunk->shared;
+
+  bool last = false;
+
+  {
+    tl::MutexLocker locker (&shared->lock);
+
+    tl_assert (chunk->live_bytes >= aligned_size (n));
+    chunk->live_bytes -= aligned_size (n);
+
+    if (chunk->live_bytes == 0) {
+      if (! shared->arena) {
+        free_chunk (chunk);
+        last = (shared->chunks == 0);
+      } else if (chunk == shared->arena->mp_current) {
+        //  the current chunk is recycled
+        chunk->ptr = chunk->begin;
+      } else {
+        shared->arena->drop_chunk (chunk);
+      }
+    }
+  }
+
+  if (last) {
+    delete shared;
+  }
+}
+
+size_t
+ContourArena::heap_block_size (size_t n)
+{
+  //  models the typical malloc implementation: one word header, rounding to two words and
+  //  a minimum block size of four words
+  const size_t granularity = 2 * sizeof (void *);
+  size_t s = (n + sizeof (size_t) + granularity - 1) & ~(granularity - 1);
+  return s < 2 * granularity ? 2 * granularity : s;
+}
+
+// -------------------------------------------------------------------------------------
+//  ContourArenaScope implementation
+
+ContourArenaScope::ContourArenaScope (ContourArena *arena)
+  : mp_arena (arena), mp_prev (0)
+{
+  if (mp_arena) {
+    if (! s_current_arena.hasLocalData ()) {
+      s_current_arena.setLocalData (new (ContourArena *) (mp_arena));
+    } else {
+      mp_prev = *s_current_arena.localData ();
+      *s_current_arena.localData () = mp_arena;
+    }
+  }
+}
+
+ContourArenaScope::~ContourArenaScope ()
+{
+  if (mp_arena) {
+    *s_current_arena.localData () = mp_prev;
+  }
+}
+
+}
+
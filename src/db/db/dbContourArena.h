@@ -0,0 +1,166 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_dbContourArena
+#define HDR_dbContourArena
+
+#include "dbCommon.h"
+#include "dbMemStatistics.h"
+
+#include <set>
+#include <cstddef>
+
+namespace db
+{
+
+struct ContourArenaChunk;
+struct ContourArenaShared;
+
+/**
+ *  @brief A bump allocator for the point arrays of polygon contours
+ *
+ *  Every polygon contour allocates its point array separately from the heap. For
+ *  layouts with many small polygons, the malloc headers and the rounding to the
+ *  allocation granularity add a considerable amount of memory.
+ *
+ *  The arena hands out point arrays from large chunks instead. Memory released
+ *  by a contour is not reused individually - a chunk is given back to the system
+ *  as a whole once all contours allocated from it are gone (e.g. on Shapes::clear
+ *  or when the layout is destroyed). Hence the arena is intended for mostly static
+ *  data such as layouts loaded from files.
+ *
+ *  Each block starts with a header word pointing to the chunk it was allocated 
+ *  from. A contour marks arena-allocated point arrays with a flag bit in the 
+ *  point pointer. Hence no global registry is required and different arenas do 
+ *  not share a lock. A contour may safely outlive the arena it was allocated from.
+ *
+ *  Contours allocate from the arena which is "current" for the thread. An arena
+ *  is made the current one using a ContourArenaScope object.
+ */
+class DB_PUBLIC ContourArena
+{
+public:
+  /**
+   *  @brief Creates an arena with the given chunk size in bytes
+   */
+  ContourArena (size_t chunk_size = 1024 * 1024);
+
+  /**
+   *  @brief Destructor
+   *
+   *  Empty chunks are freed immediately. Chunks still in use are freed
+   *  when the last contour referring to them is destroyed.
+   */
+  ~ContourArena ();
+
+  /**
+   *  @brief Allocates a memory block of n bytes
+   *
+   *  The block is aligned suitably for points with double coordinates. The
+   *  block must be released with "release".
+   */
+  void *allocate (size_t n);
+
+  /**
+   *  @brief Gets the number of bytes currently in use by contours
+   */
+  size_t used_bytes () const;
+
+  /**
+   *  @brief Gets the number of bytes reserved by the chunks of this arena
+   */
+  size_t reserved_bytes () const;
+
+  /**
+   *  @brief Collects memory statistics
+   *
+   *  This will report the part of the chunks which is not in use by contours.
+   *  The used parts are reported by the contours themselves.
+   */
+  void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self = false, void *parent = 0) const;
+
+  /**
+   *  @brief Gets the arena which is current for the calling thread or 0 if there is none
+   */
+  static ContourArena *current ();
+
+  /**
+   *  @brief Allocates n bytes from the current arena
+   *
+   *  Returns 0 if no arena is current. In that case, the caller is supposed to
+   *  allocate the memory from the heap.
+   */
+  static void *allocate_current (size_t n);
+
+  /**
+   *  @brief Releases a block of n bytes
+   *
+   *  The block must have been allocated from an arena. The arena may have been
+   *  destroyed already.
+   */
+  static void release (void *p, size_t n);
+
+  /**
+   *  @brief Estimates the memory a heap allocation of n bytes actually occupies
+   *
+   *  This includes the allocator's header and alignment overhead.
+   */
+  static size_t heap_block_size (size_t n);
+
+private:
+  friend class ContourArenaScope;
+
+  size_t m_chunk_size;
+  ContourArenaChunk *mp_current;
+  std::set<ContourArenaChunk *> m_chunks;
+  ContourArenaShared *mp_shared;
+
+  //  no copying
+  ContourArena (const ContourArena &);
+  ContourArena &operator= (const ContourArena &);
+
+  ContourArenaChunk *new_chunk (size_t n);
+  void drop_chunk (ContourArenaChunk *chunk);
+};
+
+/**
+ *  @brief Makes an arena the current one for the calling thread while this object lives
+ *
+ *  Passing 0 for the arena does not change the current arena.
+ */
+class DB_PUBLIC ContourArenaScope
+{
+public:
+  ContourArenaScope (ContourArena *arena);
+  ~ContourArenaScope ();
+
+private:
+  ContourArena *mp_arena;
+  ContourArena *mp_prev;
+};
+
+}
+
+#endif
+
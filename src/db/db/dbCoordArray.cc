@@ -0,0 +1,361 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#include "dbCoordArray.h"
+#include "dbRegion.h"
+#include "dbEdges.h"
+#include "dbShapes.h"
+#include "tlException.h"
+#include "tlAssert.h"
+#include "tlString.h"
+#include "tlInternational.h"
+
+namespace db
+{
+
+// -------------------------------------------------------------------------------
+//  CoordArray implementation
+
+CoordArray::CoordArray ()
+  : m_columns (0)
+{
+  //  .. nothing yet ..
+}
+
+CoordArray::CoordArray (size_t rows, unsigned int columns)
+  : m_data (rows * columns, 0), m_columns (columns)
+{
+  //  .. nothing yet ..
+}
+
+CoordArray::coord_type
+CoordArray::value (size_t row, unsigned int column) const
+{
+  if (row >= rows () || column >= m_columns) {
+    throw tl::Exception (tl::to_string (tr ("Row or column index out of range: %d, %d")), row, column);
+  }
+  return m_data [row * m_columns + column];
+}
+
+void
+CoordArray::set_value (size_t row, unsigned int column, coord_type v)
+{
+  if (row >= rows () || column >= m_columns) {
+    throw tl::Exception (tl::to_string (tr ("Row or column index out of range: %d, %d")), row, column);
+  }
+  m_data [row * m_columns + column] = v;
+}
+
+void
+CoordArray::clear (unsigned int columns)
+{
+  m_data.clear ();
+  m_columns = columns;
+}
+
+void
+CoordArray::add (coord_type a)
+{
+  tl_assert (m_columns == 1);
+  m_data.push_back (a);
+}
+
+void
+CoordArray::add (coord_type a, coord_type b)
+{
+  tl_assert (m_columns == 2);
+  m_data.push_back (a);
+  m_data.push_back (b);
+}
+
+void
+CoordArray::add (coord_type a, coord_type b, coord_type c)
+{
+  tl_assert (m_columns == 3);
+  m_data.push_back (a);
+  m_data.push_back (b);
+  m_data.push_back (c);
+}
+
+void
+CoordArray::add (coord_type a, coord_type b, coord_type c, coord_type d)
+{
+  tl_assert (m_columns == 4);
+  m_data.push_back (a);
+  m_data.push_back (b);
+  m_data.push_back (c);
+  m_data.push_back (d);
+}
+
+std::string
+CoordArray::to_string () const
+{
+  std::string r;
+  for (size_t i = 0; i < m_data.size (); ++i) {
+    if (i > 0) {
+      r += (i % m_columns) == 0 ? ";" : ",";
+    }
+    r += tl::to_string (m_data [i]);
+  }
+  return r;
+}
+
+// -------------------------------------------------------------------------------
+//  packed_polygon_iterator implementation
+
+db::Polygon
+packed_polygon_iterator::operator* () const
+{
+  db::Polygon poly;
+
+  const db::Coord *c = mp_points;
+  size_t n = *mp_counts;
+  poly.assign_hull (packed_point_iterator (c), packed_point_iterator (c + 2 * n));
+  c += 2 * n;
+
+  size_t nholes = mp_holes ? mp_holes [m_index] : 0;
+  if (nholes > 0) {
+    poly.reserve_holes ((unsigned int) nholes);
+    for (size_t h = 1; h <= nholes; ++h) {
+      n = mp_counts [h];
+      poly.insert_hole (packed_point_iterator (c), packed_point_iterator (c + 2 * n));
+      c += 2 * n;
+    }
+  }
+
+  return poly;
+}
+
+packed_polygon_iterator &
+packed_polygon_iterator::operator++ ()
+{
+  size_t ncontours = 1 + (mp_holes ? mp_holes [m_index] : 0);
+  for (size_t i = 0; i < ncontours; ++i) {
+    mp_points += 2 * *mp_counts++;
+  }
+  ++m_index;
+  return *this;
+}
+
+// -------------------------------------------------------------------------------
+//  Array export functions
+
+static void
+add_points (const db::Polygon &poly, CoordArray &array)
+{
+  for (unsigned int c = 0; c <= poly.holes (); ++c) {
+    const db::Polygon::contour_type &ctr = c == 0 ? poly.hull () : poly.hole (c - 1);
+    for (size_t i = 0; i < ctr.size (); ++i) {
+      db::Point pt = ctr [i];
+      array.add (pt.x (), pt.y ());
+    }
+  }
+}
+
+static void
+add_contours (const db::Polygon &poly, size_t index, size_t &first, CoordArray &array)
+{
+  for (unsigned int c = 0; c <= poly.holes (); ++c) {
+    size_t n = (c == 0 ? poly.hull () : poly.hole (c - 1)).size ();
+    array.add (CoordArray::coord_type (index), CoordArray::coord_type (first), CoordArray::coord_type (n));
+    first += n;
+  }
+}
+
+void
+box_array (const db::Region &region, CoordArray &array)
+{
+  array.clear (4);
+  for (db::Region::const_iterator p = region.begin (); ! p.at_end (); ++p) {
+    db::Box b = p->box ();
+    array.add (b.left (), b.bottom (), b.right (), b.top ());
+  }
+}
+
+void
+point_array (const db::Region &region, CoordArray &array)
+{
+  array.clear (2);
+  for (db::Region::const_iterator p = region.begin (); ! p.at_end (); ++p) {
+    add_points (*p, array);
+  }
+}
+
+void
+contour_array (const db::Region &region, CoordArray &array)
+{
+  array.clear (3);
+  size_t index = 0, first = 0;
+  for (db::Region::const_iterator p = region.begin (); ! p.at_end (); ++p, ++index) {
+    add_contours (*p, index, first, array);
+  }
+}
+
+void
+edge_array (const db::Edges &edges, CoordArray &array)
+{
+  array.clear (4);
+  for (db::Edges::const_iterator e = edges.begin (); ! e.at_end (); ++e) {
+    array.add (e->p1 ().x (), e->p1 ().y (), e->p2 ().x (), e->p2 ().y ());
+  }
+}
+
+void
+box_array (const db::Shapes &shapes, unsigned int flags, CoordArray &array)
+{
+  array.clear (4);
+  for (db::ShapeIterator s = shapes.begin (flags); ! s.at_end (); ++s) {
+    db::Box b = s->bbox ();
+    array.add (b.left (), b.bottom (), b.right (), b.top ());
+  }
+}
+
+void
+point_array (const db::Shapes &shapes, unsigned int flags, CoordArray &array)
+{
+  array.clear (2);
+  db::Polygon poly;
+  for (db::ShapeIterator s = shapes.begin (flags); ! s.at_end (); ++s) {
+    if (s->polygon (poly)) {
+      add_points (poly, array);
+    }
+  }
+}
+
+void
+contour_array (const db::Shapes &shapes, unsigned int flags, CoordArray &array)
+{
+  array.clear (3);
+  size_t index = 0, first = 0;
+  db::Polygon poly;
+  for (db::ShapeIterator s = shapes.begin (flags); ! s.at_end (); ++s) {
+    if (s->polygon (poly)) {
+      add_contours (poly, index, first, array);
+      ++index;
+    }
+  }
+}
+
+// -------------------------------------------------------------------------------
+//  Array import functions
+
+static void
+check_columns (const CoordArray &array, unsigned int columns)
+{
+  if (array.rows () > 0 && array.columns () != columns) {
+    throw tl::Exception (tl::to_string (tr ("Coordinate array must have %d columns, but has %d")), columns, array.columns ());
+  }
+}
+
+/**
+ *  @brief Turns the contour array into point counts per contour and hole counts per polygon
+ *
+ *  The contour array either has one column (the number of hull points for each polygon) or
+ *  three columns (the format delivered by "contour_array"). "holes" is left empty in the
+ *  first case.
+ */
+static void
+decode_contours (const CoordArray &points, const CoordArray &contours, std::vector<size_t> &counts, std::vector<size_t> &holes)
+{
+  check_columns (points, 2);
+
+  size_t first = 0;
+
+  if (contours.columns () == 1 || contours.rows () == 0) {
+
+    counts.reserve (contours.rows ());
+    for (size_t i = 0; i < contours.rows (); ++i) {
+      CoordArray::coord_type n = contours.data () [i];
+      if (n < 0) {
+        throw tl::Exception (tl::to_string (tr ("Negative point count in contour array at row %d")), i);
+      }
+      counts.push_back (size_t (n));
+      first += size_t (n);
+    }
+
+  } else if (contours.columns () == 3) {
+
+    counts.reserve (contours.rows ());
+    holes.reserve (contours.rows ());
+
+    const CoordArray::coord_type *c = contours.data ();
+    for (size_t i = 0; i < contours.rows (); ++i, c += 3) {
+      if (c [2] < 0 || c [1] != CoordArray::coord_type (first)) {
+        throw tl::Exception (tl::to_string (tr ("Contour array does not match the point array at row %d")), i);
+      }
+      //  a new polygon starts when the polygon index changes
+      if (i > 0 && c [0] == c [-3]) {
+        ++holes.back ();
+      } else {
+        holes.push_back (0);
+      }
+      counts.push_back (size_t (c [2]));
+      first += size_t (c [2]);
+    }
+
+  } else {
+    throw tl::Exception (tl::to_string (tr ("Contour array must have one or three columns, but has %d")), contours.columns ());
+  }
+
+  if (first != points.rows ()) {
+    throw tl::Exception (tl::to_string (tr ("Contour array describes %d points, but the point array has %d rows")), first, points.rows ());
+  }
+}
+
+void
+insert_boxes (db::Region &region, const CoordArray &boxes)
+{
+  check_columns (boxes, 4);
+  region.insert_boxes (boxes.data (), boxes.rows ());
+}
+
+void
+insert_polygons (db::Region &region, const CoordArray &points, const CoordArray &contours)
+{
+  std::vector<size_t> counts, holes;
+  decode_contours (points, contours, counts, holes);
+  if (! counts.empty ()) {
+    region.insert_polygons (points.data (), &counts.front (), holes.empty () ? 0 : &holes.front (), holes.empty () ? counts.size () : holes.size ());
+  }
+}
+
+void
+insert_boxes (db::Shapes &shapes, const CoordArray &boxes)
+{
+  check_columns (boxes, 4);
+  shapes.insert_boxes (boxes.data (), boxes.rows ());
+}
+
+void
+insert_polygons (db::Shapes &shapes, const CoordArray &points, const CoordArray &contours)
+{
+  std::vector<size_t> counts, holes;
+  decode_contours (points, contours, counts, holes);
+  if (! counts.empty ()) {
+    shapes.insert_polygons (points.data (), &counts.front (), holes.empty () ? 0 : &holes.front (), holes.empty () ? counts.size () : holes.size ());
+  }
+}
+
+}
+
@@ -0,0 +1,427 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_dbCoordArray
+#define HDR_dbCoordArray
+
+#include "dbCommon.h"
+#include "dbTypes.h"
+#include "dbPoint.h"
+#include "dbBox.h"
+#include "dbPolygon.h"
+
+#include <vector>
+#include <string>
+#include <iterator>
+#include <cstddef>
+
+namespace db
+{
+
+class Region;
+class Edges;
+class Shapes;
+
+/**
+ *  @brief A two-dimensional array of coordinates
+ *
+ *  This array is a compact, contiguous representation of geometrical data. It is
+ *  intended for bulk transfer of geometry between the database and scripts: a script
+ *  can access the coordinates directly as a memory block (e.g. through the Python
+ *  buffer protocol) without creating an object per shape or point.
+ *
+ *  Each row holds one item, e.g. left, bottom, right and top for a box or x and y
+ *  for a point. The coordinates are stored row by row.
+ */
+class DB_PUBLIC CoordArray
+{
+public:
+  typedef db::Coord coord_type;
+
+  /**
+   *  @brief Creates an empty array
+   */
+  CoordArray ();
+
+  /**
+   *  @brief Creates an array with the given number of rows and columns
+   *
+   *  All coordinates are initialized with zero.
+   */
+  CoordArray (size_t rows, unsigned int columns);
+
+  /**
+   *  @brief Gets the number of rows
+   */
+  size_t rows () const
+  {
+    return m_columns > 0 ? m_data.size () / m_columns : 0;
+  }
+
+  /**
+   *  @brief Gets the number of columns
+   */
+  unsigned int columns () const
+  {
+    return m_columns;
+  }
+
+  /**
+   *  @brief Gets the coordinate at the given row and column
+   *
+   *  Throws an exception if row or column are out of range.
+   */
+  coord_type value (size_t row, unsigned int column) const;
+
+  /**
+   *  @brief Sets the coordinate at the given row and column
+   *
+   *  Throws an exception if row or column are out of range.
+   */
+  void set_value (size_t row, unsigned int column, coord_type v);
+
+  /**
+   *  @brief Gets the coordinate data block (rows * columns coordinates)
+   */
+  coord_type *data ()
+  {
+    return m_data.empty () ? 0 : &m_data.front ();
+  }
+
+  /**
+   *  @brief Gets the coordinate data block (const version)
+   */
+  const coord_type *data () const
+  {
+    return m_data.empty () ? 0 : &m_data.front ();
+  }
+
+  /**
+   *  @brief Clears the array and sets the number of columns
+   */
+  void clear (unsigned int columns);
+
+  /**
+   *  @brief Reserves space for the given number of rows
+   */
+  void reserve (size_t rows)
+  {
+    m_data.reserve (rows * m_columns);
+  }
+
+  /**
+   *  @brief Adds a row to an array with one column
+   */
+  void add (coord_type a);
+
+  /**
+   *  @brief Adds a row to an array with two columns
+   */
+  void add (coord_type a, coord_type b);
+
+  /**
+   *  @brief Adds a row to an array with three columns
+   */
+  void add (coord_type a, coord_type b, coord_type c);
+
+  /**
+   *  @brief Adds a row to an array with four columns
+   */
+  void add (coord_type a, coord_type b, coord_type c, coord_type d);
+
+  /**
+   *  @brief Equality
+   */
+  bool operator== (const CoordArray &other) const
+  {
+    return m_columns == other.m_columns && m_data == other.m_data;
+  }
+
+  /**
+   *  @brief Inequality
+   */
+  bool operator!= (const CoordArray &other) const
+  {
+    return ! operator== (other);
+  }
+
+  /**
+   *  @brief Converts the array to a string
+   *
+   *  Rows are separated by ";", columns by ",".
+   */
+  std::string to_string () const;
+
+private:
+  std::vector<coord_type> m_data;
+  unsigned int m_columns;
+};
+
+/**
+ *  @brief An iterator delivering points from a packed coordinate block
+ *
+ *  The block consists of x and y coordinate pairs.
+ */
+class DB_PUBLIC packed_point_iterator
+{
+public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef db::Point value_type;
+  typedef db::Point reference;
+  typedef void pointer;
+  typedef std::ptrdiff_t difference_type;
+
+  packed_point_iterator (const db::Coord *c)
+    : mp_c (c)
+  {
+    //  .. nothing yet ..
+  }
+
+  bool operator== (const packed_point_iterator &other) const
+  {
+    return mp_c == other.mp_c;
+  }
+
+  bool operator!= (const packed_point_iterator &other) const
+  {
+    return mp_c != other.mp_c;
+  }
+
+  db::Point operator* () const
+  {
+    return db::Point (mp_c [0], mp_c [1]);
+  }
+
+  packed_point_iterator &operator++ ()
+  {
+    mp_c += 2;
+    return *this;
+  }
+
+  packed_point_iterator operator++ (int)
+  {
+    packed_point_iterator i (*this);
+    mp_c += 2;
+    return i;
+  }
+
+private:
+  const db::Coord *mp_c;
+};
+
+/**
+ *  @brief An iterator delivering boxes from a packed coordinate block
+ *
+ *  The block consists of left, bottom, right and top coordinate quadruples.
+ */
+class DB_PUBLIC packed_box_iterator
+{
+public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef db::Box value_type;
+  typedef db::Box reference;
+  typedef void pointer;
+  typedef std::ptrdiff_t difference_type;
+
+  packed_box_iterator (const db::Coord *c)
+    : mp_c (c)
+  {
+    //  .. nothing yet ..
+  }
+
+  bool operator== (const packed_box_iterator &other) const
+  {
+    return mp_c == other.mp_c;
+  }
+
+  bool operator!= (const packed_box_iterator &other) const
+  {
+    return mp_c != other.mp_c;
+  }
+
+  db::Box operator* () const
+  {
+    return db::Box (mp_c [0], mp_c [1], mp_c [2], mp_c [3]);
+  }
+
+  packed_box_iterator &operator++ ()
+  {
+    mp_c += 4;
+    return *this;
+  }
+
+  packed_box_iterator operator++ (int)
+  {
+    packed_box_iterator i (*this);
+    mp_c += 4;
+    return i;
+  }
+
+private:
+  const db::Coord *mp_c;
+};
+
+/**
+ *  @brief An iterator delivering polygons from a packed coordinate block
+ *
+ *  "points" is a block of x and y coordinate pairs holding the contours of all polygons
+ *  one after another. "counts" gives the number of points for each contour. For each
+ *  polygon, the hull comes first, followed by the holes. "holes" gives the number of
+ *  holes for each polygon. If "holes" is 0, the polygons do not have holes.
+ *
+ *  The end iterator is created from the number of polygons.
+ */
+class DB_PUBLIC packed_polygon_iterator
+{
+public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef db::Polygon value_type;
+  typedef db::Polygon reference;
+  typedef void pointer;
+  typedef std::ptrdiff_t difference_type;
+
+  packed_polygon_iterator (const db::Coord *points, const size_t *counts, const size_t *holes)
+    : mp_points (points), mp_counts (counts), mp_holes (holes), m_index (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  packed_polygon_iterator (size_t n)
+    : mp_points (0), mp_counts (0), mp_holes (0), m_index (n)
+  {
+    //  .. nothing yet ..
+  }
+
+  bool operator== (const packed_polygon_iterator &other) const
+  {
+    return m_index == other.m_index;
+  }
+
+  bool operator!= (const packed_polygon_iterator &other) const
+  {
+    return m_index != other.m_index;
+  }
+
+  db::Polygon operator* () const;
+
+  packed_polygon_iterator &operator++ ();
+
+  packed_polygon_iterator operator++ (int)
+  {
+    packed_polygon_iterator i (*this);
+    ++*this;
+    return i;
+  }
+
+private:
+  const db::Coord *mp_points;
+  const size_t *mp_counts;
+  const size_t *mp_holes;
+  size_t m_index;
+};
+
+/**
+ *  @brief Delivers the bounding boxes of the polygons of a region
+ *
+ *  The array will have four columns (left, bottom, right, top) and one row per polygon.
+ *  The polygons are taken in the order "begin" delivers them (raw polygons).
+ */
+DB_PUBLIC void box_array (const db::Region &region, CoordArray &array);
+
+/**
+ *  @brief Delivers the points of the polygons of a region
+ *
+ *  The array will have two columns (x, y) and one row per point. For each polygon,
+ *  the points of the hull are delivered first, followed by the points of the holes.
+ *  "contour_array" delivers the information required to separate the contours.
+ */
+DB_PUBLIC void point_array (const db::Region &region, CoordArray &array);
+
+/**
+ *  @brief Delivers the contour index for "point_array"
+ *
+ *  The array will have three columns (polygon index, index of the first point row,
+ *  number of points) and one row per contour. For each polygon, the first row
+ *  describes the hull and the following rows describe the holes.
+ */
+DB_PUBLIC void contour_array (const db::Region &region, CoordArray &array);
+
+/**
+ *  @brief Delivers the edges of an edge collection
+ *
+ *  The array will have four columns (x1, y1, x2, y2) and one row per edge.
+ */
+DB_PUBLIC void edge_array (const db::Edges &edges, CoordArray &array);
+
+/**
+ *  @brief Delivers the bounding boxes of the shapes of a shape container
+ *
+ *  The array will have four columns (left, bottom, right, top) and one row per shape.
+ *  "flags" selects the shapes (see db::ShapeIterator).
+ */
+DB_PUBLIC void box_array (const db::Shapes &shapes, unsigned int flags, CoordArray &array);
+
+/**
+ *  @brief Delivers the points of the polygon-type shapes of a shape container
+ *
+ *  Polygons, paths and boxes are taken as polygons. The layout of the array is
+ *  the same than for the region version.
+ */
+DB_PUBLIC void point_array (const db::Shapes &shapes, unsigned int flags, CoordArray &array);
+
+/**
+ *  @brief Delivers the contour index for the shape container version of "point_array"
+ */
+DB_PUBLIC void contour_array (const db::Shapes &shapes, unsigned int flags, CoordArray &array);
+
+/**
+ *  @brief Inserts the boxes from a box array into a region
+ *
+ *  The array needs to have four columns (left, bottom, right, top). Empty boxes are skipped.
+ */
+DB_PUBLIC void insert_boxes (db::Region &region, const CoordArray &boxes);
+
+/**
+ *  @brief Inserts polygons from a point and a contour array into a region
+ *
+ *  The point array needs to have two columns (x, y). The contour array either has
+ *  one column giving the number of points for each polygon (polygons without holes) or
+ *  three columns in the format delivered by "contour_array".
+ */
+DB_PUBLIC void insert_polygons (db::Region &region, const CoordArray &points, const CoordArray &contours);
+
+/**
+ *  @brief Inserts the boxes from a box array into a shape container
+ */
+DB_PUBLIC void insert_boxes (db::Shapes &shapes, const CoordArray &boxes);
+
+/**
+ *  @brief Inserts polygons from a point and a contour array into a shape container
+ */
+DB_PUBLIC void insert_polygons (db::Shapes &shapes, const CoordArray &points, const CoordArray &contours);
+
+}
+
+#endif
+
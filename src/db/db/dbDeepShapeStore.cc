@@ -0,0 +1,503 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbDeepShapeStore.h"
+#include "dbCellMapping.h"
+#include "dbLayoutUtils.h"
+
+#include "tlException.h"
+#include "tlInternational.h"
+
+#include <set>
+
+namespace db
+{
+
+// ----------------------------------------------------------------------------------
+//  DeepLayer implementation
+
+DeepLayer::DeepLayer ()
+  : mp_store (), m_layout (0), m_layer (0)
+{
+  //  .. nothing yet ..
+}
+
+DeepLayer::DeepLayer (DeepShapeStore *store, unsigned int layout, unsigned int layer)
+  : mp_store (store), m_layout (layout), m_layer (layer)
+{
+  add_ref ();
+}
+
+DeepLayer::DeepLayer (const DeepLayer &other)
+  : mp_store (other.mp_store), m_layout (other.m_layout), m_layer (other.m_layer)
+{
+  add_ref ();
+}
+
+DeepLayer &
+DeepLayer::operator= (const DeepLayer &other)
+{
+  if (this != &other) {
+    release ();
+    mp_store = other.mp_store;
+    m_layout = other.m_layout;
+    m_layer = other.m_layer;
+    add_ref ();
+  }
+  return *this;
+}
+
+DeepLayer::~DeepLayer ()
+{
+  release ();
+}
+
+void
+DeepLayer::add_ref ()
+{
+  if (mp_store.get ()) {
+    mp_store->add_ref (m_layout, m_layer);
+  }
+}
+
+void
+DeepLayer::release ()
+{
+  if (mp_store.get ()) {
+    mp_store->remove_ref (m_layout, m_layer);
+  }
+  mp_store.reset (0);
+}
+
+bool
+DeepLayer::is_valid () const
+{
+  return mp_store.get () != 0;
+}
+
+DeepShapeStore *
+DeepLayer::store () const
+{
+  return const_cast<DeepShapeStore *> (mp_store.get ());
+}
+
+db::Layout &
+DeepLayer::layout () const
+{
+  tl_assert (is_valid ());
+  return store ()->layout (m_layout);
+}
+
+db::Cell &
+DeepLayer::initial_cell () const
+{
+  tl_assert (is_valid ());
+  return layout ().cell (store ()->initial_cell (m_layout));
+}
+
+DeepLayer
+DeepLayer::derived () const
+{
+  tl_assert (is_valid ());
+  return DeepLayer (store (), m_layout, layout ().insert_layer ());
+}
+
+bool
+DeepLayer::is_compatible (const DeepLayer &other) const
+{
+  return is_valid () && store () == other.store () && m_layout == other.m_layout;
+}
+
+db::RecursiveShapeIterator
+DeepLayer::iter () const
+{
+  if (! is_valid ()) {
+    return db::RecursiveShapeIterator ();
+  } else {
+    return db::RecursiveShapeIterator (layout (), initial_cell (), m_layer);
+  }
+}
+
+// ----------------------------------------------------------------------------------
+//  DeepShapeStore implementation
+
+struct DeepShapeStore::LayoutHolder
+{
+  LayoutHolder ()
+    : layout (false), initial_cell (0), source_layout (0), source_cell (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::Layout layout;
+  db::cell_index_type initial_cell;
+  const db::Layout *source_layout;
+  db::cell_index_type source_cell;
+  db::ICplxTrans trans;
+  //  maps source cells to working layout cells
+  std::map<db::cell_index_type, db::cell_index_type> cell_map;
+  //  maps the variant cells of the working layout to the cells they have been copied from
+  std::map<db::cell_index_type, db::cell_index_type> variants;
+  //  maps the variant cells of the working layout to their counterparts in the source layout
+  std::map<db::cell_index_type, db::cell_index_type> source_variants;
+  std::map<unsigned int, size_t> layer_refs;
+};
+
+DeepShapeStore::DeepShapeStore ()
+{
+  //  .. nothing yet ..
+}
+
+DeepShapeStore::~DeepShapeStore ()
+{
+  for (std::vector<LayoutHolder *>::const_iterator l = m_layouts.begin (); l != m_layouts.end (); ++l) {
+    delete *l;
+  }
+  m_layouts.clear ();
+}
+
+db::Layout &
+DeepShapeStore::layout (unsigned int n)
+{
+  tl_assert (n < (unsigned int) m_layouts.size () && m_layouts [n] != 0);
+  return m_layouts [n]->layout;
+}
+
+const db::Layout &
+DeepShapeStore::layout (unsigned int n) const
+{
+  tl_assert (n < (unsigned int) m_layouts.size () && m_layouts [n] != 0);
+  return m_layouts [n]->layout;
+}
+
+db::cell_index_type
+DeepShapeStore::initial_cell (unsigned int n) const
+{
+  tl_assert (n < (unsigned int) m_layouts.size () && m_layouts [n] != 0);
+  return m_layouts [n]->initial_cell;
+}
+
+size_t
+DeepShapeStore::layers_in_use () const
+{
+  size_t n = 0;
+  for (std::vector<LayoutHolder *>::const_iterator l = m_layouts.begin (); l != m_layouts.end (); ++l) {
+    if (*l) {
+      n += (*l)->layer_refs.size ();
+    }
+  }
+  return n;
+}
+
+void
+DeepShapeStore::add_ref (unsigned int layout, unsigned int layer)
+{
+  tl_assert (layout < (unsigned int) m_layouts.size () && m_layouts [layout] != 0);
+  m_layouts [layout]->layer_refs [layer] += 1;
+}
+
+void
+DeepShapeStore::remove_ref (unsigned int layout, unsigned int layer)
+{
+  tl_assert (layout < (unsigned int) m_layouts.size () && m_layouts [layout] != 0);
+
+  LayoutHolder *holder = m_layouts [layout];
+
+  std::map<unsigned int, size_t>::iterator r = holder->layer_refs.find (layer);
+  tl_assert (r != holder->layer_refs.end ());
+
+  if (--r->second == 0) {
+
+    holder->layer_refs.erase (r);
+    holder->layout.delete_layer (layer);
+
+    //  drop the working layout once no layer refers to it any longer
+    if (holder->layer_refs.empty ()) {
+      m_layout_map.erase (std::make_pair (std::make_pair (holder->source_layout, holder->source_cell), holder->trans.mag ()));
+      delete holder;
+      m_layouts [layout] = 0;
+    }
+
+  }
+}
+
+bool
+DeepShapeStore::is_supported (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans)
+{
+  if (! si.layout () || ! si.top_cell ()) {
+    return false;
+  }
+  if (si.has_complex_region () || si.region () != db::Box::world ()) {
+    return false;
+  }
+  if (si.max_depth () != std::numeric_limits<int>::max ()) {
+    return false;
+  }
+  return trans == db::ICplxTrans (trans.mag ());
+}
+
+unsigned int
+DeepShapeStore::layout_for_iter (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans)
+{
+  const db::Layout *source_layout = si.layout ();
+  db::cell_index_type source_cell = si.top_cell ()->cell_index ();
+
+  layout_key_type key (std::make_pair (source_layout, source_cell), trans.mag ());
+  std::map<layout_key_type, unsigned int>::const_iterator l = m_layout_map.find (key);
+  if (l != m_layout_map.end ()) {
+    return l->second;
+  }
+
+  LayoutHolder *holder = new LayoutHolder ();
+  holder->source_layout = source_layout;
+  holder->source_cell = source_cell;
+  holder->trans = trans;
+
+  //  the magnification is taken into account by the database unit - the
+  //  instances are scaled accordingly by the cell mapping
+  holder->layout.dbu (source_layout->dbu () / trans.mag ());
+  holder->initial_cell = holder->layout.add_cell (source_layout->cell_name (source_cell));
+
+  db::CellMapping cm;
+  cm.create_single_mapping_full (holder->layout, holder->initial_cell, *source_layout, source_cell);
+  holder->cell_map = cm.table ();
+
+  unsigned int index = (unsigned int) m_layouts.size ();
+  m_layouts.push_back (holder);
+  m_layout_map.insert (std::make_pair (key, index));
+
+  return index;
+}
+
+DeepLayer
+DeepShapeStore::create_polygon_layer (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans)
+{
+  if (! is_supported (si, trans)) {
+    throw tl::Exception (tl::to_string (tr ("Deep mode requires a shape iterator without region or depth restrictions and a magnification-only transformation")));
+  }
+
+  unsigned int layout_index = layout_for_iter (si, trans);
+  LayoutHolder *holder = m_layouts [layout_index];
+
+  const db::Layout &source_layout = *si.layout ();
+  db::Layout &layout = holder->layout;
+
+  unsigned int layer = layout.insert_layer ();
+
+  std::vector<unsigned int> source_layers;
+  if (si.multiple_layers ()) {
+    source_layers = si.layers ();
+  } else {
+    source_layers.push_back (si.layer ());
+  }
+
+  bool is_unity = trans.is_unity ();
+
+  for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator cm = holder->cell_map.begin (); cm != holder->cell_map.end (); ++cm) {
+
+    const db::Cell &source_cell = source_layout.cell (cm->first);
+    db::Shapes &shapes = layout.cell (cm->second).shapes (layer);
+
+    for (std::vector<unsigned int>::const_iterator l = source_layers.begin (); l != source_layers.end (); ++l) {
+
+      if (! source_layout.is_valid_layer (*l)) {
+        continue;
+      }
+
+      for (db::ShapeIterator s = source_cell.shapes (*l).begin (db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes); ! s.at_end (); ++s) {
+        db::Polygon poly;
+        s->polygon (poly);
+        if (! is_unity) {
+          poly.transform (trans);
+        }
+        shapes.insert (db::PolygonRef (poly, layout.shape_repository ()));
+      }
+
+    }
+
+  }
+
+  //  the variants receive the shapes of the cells they have been copied from
+  for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator v = holder->variants.begin (); v != holder->variants.end (); ++v) {
+    layout.cell (v->first).shapes (layer) = layout.cell (v->second).shapes (layer);
+  }
+
+  return DeepLayer (this, layout_index, layer);
+}
+
+void
+DeepShapeStore::add_variants (const DeepLayer &deep_layer, const std::map<db::cell_index_type, db::cell_index_type> &variants)
+{
+  tl_assert (deep_layer.store () == this);
+  LayoutHolder *holder = m_layouts [deep_layer.m_layout];
+  holder->variants.insert (variants.begin (), variants.end ());
+}
+
+void
+DeepShapeStore::map_variants (LayoutHolder *holder, db::Layout &into_layout, std::map<db::cell_index_type, db::cell_index_type> &cell_map)
+{
+  const db::Layout &source = holder->layout;
+  db::ICplxTrans to_target (source.dbu () / into_layout.dbu ());
+
+  //  maps the target cells to the target cells of the original cells
+  std::map<db::cell_index_type, db::cell_index_type> target_root;
+  for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator cm = cell_map.begin (); cm != cell_map.end (); ++cm) {
+    target_root.insert (std::make_pair (cm->second, cm->second));
+  }
+
+  std::set<db::cell_index_type> roots_with_variants;
+
+  //  get or create the variants in the target layout - a variant is created after the
+  //  cell it was copied from, so the latter is mapped already
+  for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator v = holder->variants.begin (); v != holder->variants.end (); ++v) {
+
+    std::map<db::cell_index_type, db::cell_index_type>::const_iterator b = cell_map.find (v->second);
+    if (b == cell_map.end ()) {
+      continue;
+    }
+
+    db::cell_index_type ci;
+    std::map<db::cell_index_type, db::cell_index_type>::const_iterator sv = holder->source_variants.find (v->first);
+    if (sv != holder->source_variants.end () && into_layout.is_valid_cell_index (sv->second)) {
+      ci = sv->second;
+    } else {
+      ci = into_layout.add_cell (into_layout.cell_name (b->second));
+      into_layout.cell (ci) = into_layout.cell (b->second);
+      holder->source_variants [v->first] = ci;
+    }
+
+    db::cell_index_type root = target_root [b->second];
+    cell_map.insert (std::make_pair (v->first, ci));
+    target_root.insert (std::make_pair (ci, root));
+    roots_with_variants.insert (root);
+
+  }
+
+  //  let the instances of the target cells point to the same variants than the instances of the working cells:
+  //  the instances are identified by their transformation
+
+  for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator cm = cell_map.begin (); cm != cell_map.end (); ++cm) {
+
+    const db::Cell &cell = source.cell (cm->first);
+    db::Cell &target_cell = into_layout.cell (cm->second);
+
+    std::map<db::cell_index_type, std::vector<db::Instance> > target_insts;
+    bool target_insts_collected = false;
+
+    std::vector<std::pair<db::Instance, db::cell_index_type> > to_replace;
+
+    for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+
+      std::map<db::cell_index_type, db::cell_index_type>::const_iterator tc = cell_map.find (i->cell_index ());
+      if (tc == cell_map.end ()) {
+        continue;
+      }
+
+      db::cell_index_type root = target_root [tc->second];
+      if (roots_with_variants.find (root) == roots_with_variants.end ()) {
+        continue;
+      }
+
+      if (! target_insts_collected) {
+        for (db::Cell::const_iterator ti = target_cell.begin (); ! ti.at_end (); ++ti) {
+          std::map<db::cell_index_type, db::cell_index_type>::const_iterator tr = target_root.find (ti->cell_index ());
+          if (tr != target_root.end ()) {
+            target_insts [tr->second].push_back (*ti);
+          }
+        }
+        target_insts_collected = true;
+      }
+
+      db::CellInstArray a = i->cell_inst ();
+      a.object ().cell_index (root);
+      if (! to_target.is_unity ()) {
+        a.transform_into (to_target);
+      }
+
+      std::vector<db::Instance> &candidates = target_insts [root];
+      for (std::vector<db::Instance>::iterator c = candidates.begin (); c != candidates.end (); ++c) {
+        db::CellInstArray b = c->cell_inst ();
+        b.object ().cell_index (root);
+        if (a == b) {
+          if (c->cell_index () != tc->second) {
+            to_replace.push_back (std::make_pair (*c, tc->second));
+          }
+          candidates.erase (c);
+          break;
+        }
+      }
+
+    }
+
+    for (std::vector<std::pair<db::Instance, db::cell_index_type> >::const_iterator r = to_replace.begin (); r != to_replace.end (); ++r) {
+      db::CellInstArray na = r->first.cell_inst ();
+      na.object ().cell_index (r->second);
+      target_cell.replace (r->first, na);
+    }
+
+  }
+}
+
+void
+DeepShapeStore::insert (const DeepLayer &deep_layer, db::Layout &into_layout, db::cell_index_type into_cell, unsigned int into_layer)
+{
+  tl_assert (deep_layer.store () == this);
+
+  LayoutHolder *holder = m_layouts [deep_layer.m_layout];
+  const db::Layout &source = holder->layout;
+
+  std::map<db::cell_index_type, db::cell_index_type> cell_map;
+
+  if (&into_layout == holder->source_layout && into_cell == holder->source_cell && into_layout.is_valid_cell_index (into_cell)) {
+
+    //  back into the original: use the inverse of the initial mapping
+    for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator cm = holder->cell_map.begin (); cm != holder->cell_map.end (); ++cm) {
+      if (into_layout.is_valid_cell_index (cm->first)) {
+        cell_map.insert (std::make_pair (cm->second, cm->first));
+      }
+    }
+
+    //  cell variants of the working layout need to be created in the original layout too
+    if (! holder->variants.empty ()) {
+      map_variants (holder, into_layout, cell_map);
+    }
+
+  } else {
+
+    db::CellMapping cm;
+    cm.create_from_geometry_full (into_layout, into_cell, source, holder->initial_cell);
+    cell_map = cm.table ();
+
+  }
+
+  std::map<unsigned int, unsigned int> layer_map;
+  layer_map.insert (std::make_pair (deep_layer.layer (), into_layer));
+
+  std::vector<db::cell_index_type> source_cells;
+  source_cells.push_back (holder->initial_cell);
+
+  db::copy_shapes (into_layout, source, db::ICplxTrans (source.dbu () / into_layout.dbu ()), source_cells, cell_map, layer_map);
+}
+
+}
+
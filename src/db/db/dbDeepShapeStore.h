@@ -0,0 +1,263 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_dbDeepShapeStore
+#define HDR_dbDeepShapeStore
+
+#include "dbCommon.h"
+
+#include "dbLayout.h"
+#include "dbRecursiveShapeIterator.h"
+
+#include "gsiObject.h"
+
+#include "tlObject.h"
+#include "tlTypeTraits.h"
+
+#include <map>
+#include <vector>
+
+namespace db
+{
+
+class DeepShapeStore;
+
+/**
+ *  @brief Represents a shape layer inside a deep shape store
+ *
+ *  A deep layer is a handle to a layer inside one of the working layouts
+ *  of a DeepShapeStore. The layer is reference counted: as long as deep layer
+ *  objects refer to it, the layer is kept inside the store. When the last
+ *  reference is released, the layer is deleted.
+ *
+ *  A default-constructed deep layer is not valid.
+ */
+class DB_PUBLIC DeepLayer
+{
+public:
+  /**
+   *  @brief Default constructor: creates an invalid deep layer
+   */
+  DeepLayer ();
+
+  /**
+   *  @brief Copy constructor
+   */
+  DeepLayer (const DeepLayer &other);
+
+  /**
+   *  @brief Assignment
+   */
+  DeepLayer &operator= (const DeepLayer &other);
+
+  /**
+   *  @brief Destructor
+   */
+  ~DeepLayer ();
+
+  /**
+   *  @brief Returns true, if the deep layer refers to a layer inside a (still existing) store
+   */
+  bool is_valid () const;
+
+  /**
+   *  @brief Gets the working layout the layer lives in
+   */
+  db::Layout &layout () const;
+
+  /**
+   *  @brief Gets the initial (top) cell of the working layout
+   */
+  db::Cell &initial_cell () const;
+
+  /**
+   *  @brief Gets the layer index inside the working layout
+   */
+  unsigned int layer () const
+  {
+    return m_layer;
+  }
+
+  /**
+   *  @brief Gets the store the layer lives in
+   */
+  DeepShapeStore *store () const;
+
+  /**
+   *  @brief Creates a new, empty layer inside the same working layout
+   *
+   *  This is the way to create an output layer for an operation on this layer.
+   */
+  DeepLayer derived () const;
+
+  /**
+   *  @brief Returns true, if the other layer lives in the same working layout
+   *
+   *  Only compatible layers can be combined in hierarchical operations.
+   */
+  bool is_compatible (const DeepLayer &other) const;
+
+  /**
+   *  @brief Gets a recursive shape iterator delivering the flat shapes of this layer
+   */
+  db::RecursiveShapeIterator iter () const;
+
+private:
+  friend class DeepShapeStore;
+
+  DeepLayer (DeepShapeStore *store, unsigned int layout, unsigned int layer);
+
+  void add_ref ();
+  void release ();
+
+  tl::weak_ptr<DeepShapeStore> mp_store;
+  unsigned int m_layout;
+  unsigned int m_layer;
+};
+
+/**
+ *  @brief A store for hierarchical ("deep") shape data
+ *
+ *  The deep shape store keeps working copies of the cell hierarchies which
+ *  shapes are taken from. For each original layout and initial cell, one working
+ *  layout is created. This working layout contains a copy of the cell tree below the
+ *  initial cell. Layers are created inside these layouts for the input data and
+ *  for the results of hierarchical operations.
+ *
+ *  The store must live longer than the regions derived from it.
+ *  This class is not thread-safe.
+ */
+class DB_PUBLIC DeepShapeStore
+  : public gsi::ObjectBase, public tl::Object
+{
+public:
+  /**
+   *  @brief Constructor
+   */
+  DeepShapeStore ();
+
+  /**
+   *  @brief Destructor
+   */
+  ~DeepShapeStore ();
+
+  /**
+   *  @brief Creates a polygon layer from the given recursive shape iterator
+   *
+   *  Polygons, boxes and paths are taken from the iterator's layers and converted
+   *  to polygons. The hierarchy below the iterator's top cell is preserved.
+   *  The transformation must be a pure magnification and is useful to adjust the
+   *  database unit.
+   *
+   *  Iterators with a search region or a depth limit are not supported.
+   */
+  DeepLayer create_polygon_layer (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans = db::ICplxTrans ());
+
+  /**
+   *  @brief Returns true, if the given iterator can be used to create a deep layer
+   */
+  static bool is_supported (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans = db::ICplxTrans ());
+
+  /**
+   *  @brief Inserts the shapes of a deep layer into the given layout
+   *
+   *  The shapes are inserted hierarchically. If the target is the original layout and
+   *  cell, the shapes are inserted into the original cells. Otherwise, the cell tree
+   *  is mapped into the target layout, creating new cells if required.
+   */
+  void insert (const DeepLayer &deep_layer, db::Layout &into_layout, db::cell_index_type into_cell, unsigned int into_layer);
+
+  /**
+   *  @brief Registers cell variants created inside the working layout of the given layer
+   *
+   *  Variants are copies of working layout cells created by hierarchical operations
+   *  (see LocalProcessor::variants). The keys are the variants, the values the cells they
+   *  have been copied from. Layers created later receive the shapes in the variants too.
+   *  When shapes are inserted back into the original layout, the variant cells are
+   *  created there as well.
+   */
+  void add_variants (const DeepLayer &deep_layer, const std::map<db::cell_index_type, db::cell_index_type> &variants);
+
+  /**
+   *  @brief Gets the number of working layouts
+   */
+  unsigned int layouts () const
+  {
+    return (unsigned int) m_layouts.size ();
+  }
+
+  /**
+   *  @brief Gets the nth working layout
+   */
+  db::Layout &layout (unsigned int n);
+
+  /**
+   *  @brief Gets the nth working layout (const version)
+   */
+  const db::Layout &layout (unsigned int n) const;
+
+  /**
+   *  @brief Gets the initial cell of the nth working layout
+   */
+  db::cell_index_type initial_cell (unsigned int n) const;
+
+  /**
+   *  @brief Gets the number of layers in use
+   */
+  size_t layers_in_use () const;
+
+private:
+  friend class DeepLayer;
+
+  struct LayoutHolder;
+  typedef std::pair<std::pair<const db::Layout *, db::cell_index_type>, double> layout_key_type;
+
+  std::vector<LayoutHolder *> m_layouts;
+  std::map<layout_key_type, unsigned int> m_layout_map;
+
+  unsigned int layout_for_iter (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans);
+  void map_variants (LayoutHolder *holder, db::Layout &into_layout, std::map<db::cell_index_type, db::cell_index_type> &cell_map);
+  void add_ref (unsigned int layout, unsigned int layer);
+  void remove_ref (unsigned int layout, unsigned int layer);
+
+  DeepShapeStore (const DeepShapeStore &);
+  DeepShapeStore &operator= (const DeepShapeStore &);
+};
+
+}
+
+namespace tl
+{
+
+/**
+ *  @brief Type traits
+ */
+template <> struct type_traits <db::DeepShapeStore> : public type_traits<void> {
+  typedef tl::false_tag has_copy_constructor;
+  typedef tl::true_tag has_default_constructor;
+};
+
+}
+
+#endif
+
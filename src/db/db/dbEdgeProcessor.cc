@@ -27,10 +27,12 @@
 #include "dbLayout.h"
 #include "tlTimer.h"
 #include "tlProgress.h"
+#include "tlThreadedWorkers.h"
 #include "gsi.h"
 
 #include <vector>
 #include <deque>
+#include <map>
 #include <memory>
 
 #if 0
@@ -975,7 +977,7 @@ BooleanOp2::compare_ns () const
 //  EdgeProcessor implementation
 
 EdgeProcessor::EdgeProcessor (bool report_progress, const std::string &progress_desc)
-  : m_report_progress (report_progress), m_progress_desc (progress_desc)
+  : m_report_progress (report_progress), m_progress_desc (progress_desc), m_threads (0)
 {
   mp_work_edges = new std::vector <WorkEdge> ();
   mp_cpvector = new std::vector <CutPoints> ();
@@ -1531,45 +1533,25 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
   }
 }
 
-void 
-EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
+/**
+ *  @brief Runs the scanline algorithm on the given edges
+ *
+ *  This function computes the intersections, creates new edges from the cut points and
+ *  produces the output edges by applying the evaluator along the scanline.
+ *  The progress object is optional.
+ */
+static void
+process_edges (std::vector <WorkEdge> &work_edges, std::vector <CutPoints> &cpvector, db::EdgeSink &es, EdgeEvaluatorBase &op, EdgeProcessor::property_type n_props, tl::AbsoluteProgress *progress)
 {
-  tl::SelfTimer timer (tl::verbosity () >= 31, "EdgeProcessor: process");
-
   bool prefer_touch = op.prefer_touch (); 
   bool selects_edges = op.selects_edges (); 
   
   db::Coord y;
   std::vector <WorkEdge>::iterator future;
 
-  //  step 1: preparation
-
-  if (mp_work_edges->empty ()) {
-    es.start ();
-    es.flush ();
-    return;
-  }
-
-  mp_cpvector->clear ();
-
-  property_type n_props = 0;
-  for (std::vector <WorkEdge>::iterator e = mp_work_edges->begin (); e != mp_work_edges->end (); ++e) {
-    if (e->prop > n_props) {
-      n_props = e->prop;
-    }
-  }
-  ++n_props;
-
   size_t todo_max = 1000000;
 
-  std::auto_ptr<tl::AbsoluteProgress> progress (0);
-  if (m_report_progress) {
-    if (m_progress_desc.empty ()) {
-      progress.reset (new tl::AbsoluteProgress (tl::to_string (tr ("Processing")), 1000));
-    } else {
-      progress.reset (new tl::AbsoluteProgress (m_progress_desc, 1000));
-    }
-    progress->set_format (tl::to_string (tr ("%.0f%%")));
+  if (progress) {
     progress->set_unit (todo_max / 100);
   }
 
@@ -1579,15 +1561,15 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
 
   //  step 2: find intersections
-  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+  std::sort (work_edges.begin (), work_edges.end (), edge_ymin_compare<db::Coord> ());
 
-  y = edge_ymin ((*mp_work_edges) [0]);
-  future = mp_work_edges->begin ();
+  y = edge_ymin (work_edges [0]);
+  future = work_edges.begin ();
 
-  for (std::vector <WorkEdge>::iterator current = mp_work_edges->begin (); current != mp_work_edges->end (); ) {
+  for (std::vector <WorkEdge>::iterator current = work_edges.begin (); current != work_edges.end (); ) {
 
-    if (m_report_progress) {
-      double p = double (std::distance (mp_work_edges->begin (), current)) / double (mp_work_edges->size ());
+    if (progress) {
+      double p = double (std::distance (work_edges.begin (), current)) / double (work_edges.size ());
       progress->set (size_t (double (todo_next - todo) * p) + todo);
     }
 
@@ -1598,17 +1580,17 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
     //  is an empirically determined factor)
     do {
 
-      while (future != mp_work_edges->end () && edge_ymin (*future) <= yy) {
+      while (future != work_edges.end () && edge_ymin (*future) <= yy) {
         ++future;
       }
 
-      if (future != mp_work_edges->end ()) {
+      if (future != work_edges.end ()) {
         yy = edge_ymin (*future);
       } else {
         yy = std::numeric_limits <db::Coord>::max ();
       }
 
-    } while (future != mp_work_edges->end () && std::distance (current, future) < long (n + n / 2));
+    } while (future != work_edges.end () && std::distance (current, future) < long (n + n / 2));
 
     bool is90 = true;
 
@@ -1621,9 +1603,9 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
       }
 
       if (is90) {
-        get_intersections_per_band_90 (*mp_cpvector, current, future, y, yy, selects_edges);
+        get_intersections_per_band_90 (cpvector, current, future, y, yy, selects_edges);
       } else {
-        get_intersections_per_band_any (*mp_cpvector, current, future, y, yy, selects_edges);
+        get_intersections_per_band_any (cpvector, current, future, y, yy, selects_edges);
       }
 
     }
@@ -1651,18 +1633,18 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
   todo = todo_next;
   todo_next += (todo_max - todo) / 5;
 
-  size_t n_work = mp_work_edges->size ();
+  size_t n_work = work_edges.size ();
   size_t nw = 0;
   for (size_t n = 0; n < n_work; ++n) {
 
-    if (m_report_progress) {
+    if (progress) {
       double p = double (n) / double (n_work);
       progress->set (size_t (double (todo_next - todo) * p) + todo);
     }
 
-    WorkEdge &ew = (*mp_work_edges) [n];
+    WorkEdge &ew = work_edges [n];
 
-    CutPoints *cut_points = ew.data ? & ((*mp_cpvector) [ew.data - 1]) : 0;
+    CutPoints *cut_points = ew.data ? & (cpvector [ew.data - 1]) : 0;
     ew.data = 0;
 
     if (ew.dy () == 0 && ! selects_edges) {
@@ -1674,7 +1656,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
       if (cut_points->has_cutpoints && ! cut_points->cut_points.empty ()) {
 
         db::Edge e = ew;
-        property_type p = ew.prop;
+        EdgeProcessor::property_type p = ew.prop;
         std::sort (cut_points->cut_points.begin (), cut_points->cut_points.end (), ProjectionCompare (e));
 
         db::Point pll = e.p1 ();
@@ -1693,9 +1675,9 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
             pl = *cp;
             if (selects_edges || ne.dy () != 0) {
               if (nw <= n) {
-                (*mp_work_edges) [nw++] = ne;
+                work_edges [nw++] = ne;
               } else {
-                mp_work_edges->push_back (ne);
+                work_edges.push_back (ne);
               }
             }
           }
@@ -1710,9 +1692,9 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
           }
           if (selects_edges || ne.dy () != 0) {
             if (nw <= n) {
-              (*mp_work_edges) [nw++] = ne;
+              work_edges [nw++] = ne;
             } else {
-              mp_work_edges->push_back (ne);
+              work_edges.push_back (ne);
             }
           }
         }
@@ -1720,7 +1702,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
       } else {
 
         if (nw < n) {
-          (*mp_work_edges) [nw] = (*mp_work_edges) [n];
+          work_edges [nw] = work_edges [n];
         }
         ++nw;
 
@@ -1729,7 +1711,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
     } else {
 
       if (nw < n) {
-        (*mp_work_edges) [nw] = (*mp_work_edges) [n];
+        work_edges [nw] = work_edges [n];
       }
       ++nw;
 
@@ -1738,12 +1720,12 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
   }
 
   if (nw != n_work) {
-    mp_work_edges->erase (mp_work_edges->begin () + nw, mp_work_edges->begin () + n_work);
+    work_edges.erase (work_edges.begin () + nw, work_edges.begin () + n_work);
   }
 
 #ifdef DEBUG_EDGE_PROCESSOR
   printf ("Output edges:\n");
-  for (std::vector <WorkEdge>::iterator c1 = mp_work_edges->begin (); c1 != mp_work_edges->end (); ++c1) { 
+  for (std::vector <WorkEdge>::iterator c1 = work_edges.begin (); c1 != work_edges.end (); ++c1) { 
     printf ("%s\n", c1->to_string().c_str ()); 
   } 
 #endif
@@ -1758,28 +1740,28 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
   op.reset ();
   op.reserve (n_props);
 
-  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+  std::sort (work_edges.begin (), work_edges.end (), edge_ymin_compare<db::Coord> ());
 
-  y = edge_ymin ((*mp_work_edges) [0]);
+  y = edge_ymin (work_edges [0]);
   size_t skip_unit = 1;
 
-  future = mp_work_edges->begin ();
-  for (std::vector <WorkEdge>::iterator current = mp_work_edges->begin (); current != mp_work_edges->end (); ) {
+  future = work_edges.begin ();
+  for (std::vector <WorkEdge>::iterator current = work_edges.begin (); current != work_edges.end (); ) {
 
-    if (m_report_progress) {
-      double p = double (std::distance (mp_work_edges->begin (), current)) / double (mp_work_edges->size ());
+    if (progress) {
+      double p = double (std::distance (work_edges.begin (), current)) / double (work_edges.size ());
       progress->set (size_t (double (todo_max - todo_next) * p) + todo_next);
     }
 
     std::vector <WorkEdge>::iterator f0 = future;
-    while (future != mp_work_edges->end () && edge_ymin (*future) <= y) {
+    while (future != work_edges.end () && edge_ymin (*future) <= y) {
       tl_assert (future->data == 0); // HINT: for development
       ++future;
     }
     std::sort (f0, future, EdgeXAtYCompare2 (y));
 
     db::Coord yy = std::numeric_limits <db::Coord>::max ();
-    if (future != mp_work_edges->end ()) {
+    if (future != work_edges.end ()) {
       yy = edge_ymin (*future);
     }
     for (std::vector <WorkEdge>::const_iterator c = current; c != future; ++c) {
@@ -1858,7 +1840,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
             //  treat all edges crossing the scanline in a certain point
             for (std::vector <WorkEdge>::iterator cc = c; cc != f; ) {
 
-              std::vector <WorkEdge>::iterator e = mp_work_edges->end ();
+              std::vector <WorkEdge>::iterator e = work_edges.end ();
 
               int pn = 0, ps = 0;
 
@@ -1887,7 +1869,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
                 if (cc->dy () != 0) {
 
-                  if (e == mp_work_edges->end () && edge_ymax (*cc) > y) {
+                  if (e == work_edges.end () && edge_ymax (*cc) > y) {
                     e = cc;
                   }
                   
@@ -1956,7 +1938,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
               }
 
-              if (e != mp_work_edges->end ()) {
+              if (e != work_edges.end ()) {
 
                 db::Edge edge (*e);
 
@@ -2061,6 +2043,734 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
 }
 
+// -------------------------------------------------------------------------------
+//  Band-parallel processing
+
+namespace
+{
+
+/**
+ *  @brief An edge sink which records the events for later replay
+ */
+class RecordingEdgeSink
+  : public db::EdgeSink
+{
+public:
+  RecordingEdgeSink ()
+  {
+    //  .. nothing yet ..
+  }
+
+  virtual void put (const db::Edge &e)
+  {
+    m_events.push_back (Event (Put, e, 0));
+  }
+
+  virtual void crossing_edge (const db::Edge &e)
+  {
+    m_events.push_back (Event (CrossingEdge, e, 0));
+  }
+
+  virtual void skip_n (size_t n)
+  {
+    m_events.push_back (Event (SkipN, db::Edge (), n));
+  }
+
+  virtual void begin_scanline (db::Coord y)
+  {
+    m_events.push_back (Event (BeginScanline, db::Edge (), 0, y));
+  }
+
+  virtual void end_scanline (db::Coord y)
+  {
+    m_events.push_back (Event (EndScanline, db::Edge (), 0, y));
+  }
+
+  void clear ()
+  {
+    std::vector<Event> ().swap (m_events);
+  }
+
+  enum EventType { Put, CrossingEdge, SkipN, BeginScanline, EndScanline };
+
+  struct Event
+  {
+    Event (EventType t, const db::Edge &e, size_t _n, db::Coord _y = 0)
+      : type (t), edge (e), n (_n), y (_y)
+    { }
+
+    EventType type;
+    db::Edge edge;
+    size_t n;
+    db::Coord y;
+  };
+
+  const std::vector<Event> &events () const
+  {
+    return m_events;
+  }
+
+private:
+  std::vector<Event> m_events;
+};
+
+/**
+ *  @brief The data for one band
+ *
+ *  "from" and "to" are the range of output events which is delivered. 
+ *  The scanlines at the band's boundaries are excluded as they are 
+ *  provided by the boundaries.
+ */
+struct EdgeProcessorBand
+{
+  EdgeProcessorBand ()
+    : from (0), to (0)
+  { }
+
+  std::vector <WorkEdge> edges;
+  std::vector <CutPoints> cpvector;
+  RecordingEdgeSink output;
+  size_t from, to;
+};
+
+/**
+ *  @brief The data for the boundary between two bands
+ */
+struct EdgeProcessorBandBoundary
+{
+  EdgeProcessorBandBoundary (db::Coord _y)
+    : y (_y)
+  { }
+
+  //  the y coordinate of the boundary
+  db::Coord y;
+  //  the edges ending or starting at the boundary, clipped to 1 DBU below or above
+  std::vector <WorkEdge> stubs;
+  //  the x ranges where input edges touch the boundary with one end point
+  std::vector <std::pair<db::Coord, db::Coord> > touching;
+  //  the scanline at the boundary
+  std::vector <RecordingEdgeSink::Event> events;
+};
+
+/**
+ *  @brief A piece of a vertical edge which was clipped at band boundaries
+ *
+ *  "chain" is the index of the joined edge, "continued" is true if the
+ *  piece continues an edge from the band below.
+ */
+struct EdgeProcessorJoinedPiece
+{
+  EdgeProcessorJoinedPiece (size_t _chain, bool _continued)
+    : chain (_chain), continued (_continued)
+  { }
+
+  size_t chain;
+  bool continued;
+};
+
+typedef std::map<db::Edge, EdgeProcessorJoinedPiece> edge_processor_joined_pieces;
+
+class EdgeProcessorBandTask
+  : public tl::Task
+{
+public:
+  EdgeProcessorBandTask (EdgeProcessorBand *band)
+    : mp_band (band)
+  {
+    //  .. nothing yet ..
+  }
+
+  EdgeProcessorBand *band () const
+  {
+    return mp_band;
+  }
+
+private:
+  EdgeProcessorBand *mp_band;
+};
+
+class EdgeProcessorBandJob
+  : public tl::JobBase
+{
+public:
+  EdgeProcessorBandJob (int nworkers, const EdgeEvaluatorBase *op, EdgeProcessor::property_type n_props)
+    : tl::JobBase (nworkers), mp_op (op), m_n_props (n_props), m_bands_done (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  const EdgeEvaluatorBase &op () const
+  {
+    return *mp_op;
+  }
+
+  EdgeProcessor::property_type n_props () const
+  {
+    return m_n_props;
+  }
+
+  void next_band ()
+  {
+    tl::MutexLocker locker (&m_mutex);
+    ++m_bands_done;
+  }
+
+  size_t bands_done ()
+  {
+    tl::MutexLocker locker (&m_mutex);
+    return m_bands_done;
+  }
+
+  virtual tl::Worker *create_worker ();
+
+private:
+  const EdgeEvaluatorBase *mp_op;
+  EdgeProcessor::property_type m_n_props;
+  size_t m_bands_done;
+  tl::Mutex m_mutex;
+};
+
+class EdgeProcessorBandWorker
+  : public tl::Worker
+{
+public:
+  EdgeProcessorBandWorker (EdgeProcessorBandJob *job)
+    : tl::Worker (), mp_job (job), mp_op (job->op ().clone ())
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    EdgeProcessorBandTask *band_task = dynamic_cast <EdgeProcessorBandTask *> (task);
+    if (band_task) {
+
+      EdgeProcessorBand *band = band_task->band ();
+      process_edges (band->edges, band->cpvector, band->output, *mp_op, mp_job->n_props (), 0);
+      std::vector <CutPoints> ().swap (band->cpvector);
+
+      mp_job->next_band ();
+
+    }
+  }
+
+private:
+  EdgeProcessorBandJob *mp_job;
+  std::auto_ptr<EdgeEvaluatorBase> mp_op;
+};
+
+tl::Worker *
+EdgeProcessorBandJob::create_worker ()
+{
+  return new EdgeProcessorBandWorker (this);
+}
+
+/**
+ *  @brief Sorts and merges a set of coordinate ranges
+ *
+ *  Adjacent ranges are merged too.
+ */
+static void
+merge_ranges (std::vector<std::pair<db::Coord, db::Coord> > &ranges)
+{
+  if (ranges.empty ()) {
+    return;
+  }
+
+  std::sort (ranges.begin (), ranges.end ());
+
+  std::vector<std::pair<db::Coord, db::Coord> >::iterator w = ranges.begin ();
+  for (std::vector<std::pair<db::Coord, db::Coord> >::const_iterator r = ranges.begin () + 1; r != ranges.end (); ++r) {
+    if (r->first <= w->second + 1) {
+      w->second = std::max (w->second, r->second);
+    } else {
+      *++w = *r;
+    }
+  }
+
+  ranges.erase (w + 1, ranges.end ());
+}
+
+/**
+ *  @brief Finds the merged range containing the given value
+ *
+ *  Returns ranges.end () if there is no such range.
+ */
+static std::vector<std::pair<db::Coord, db::Coord> >::const_iterator 
+find_range (const std::vector<std::pair<db::Coord, db::Coord> > &ranges, db::Coord c)
+{
+  std::vector<std::pair<db::Coord, db::Coord> >::const_iterator r = std::upper_bound (ranges.begin (), ranges.end (), std::make_pair (c, std::numeric_limits<db::Coord>::max ()));
+  if (r != ranges.begin () && (--r)->second >= c) {
+    return r;
+  } else {
+    return ranges.end ();
+  }
+}
+
+/**
+ *  @brief Clips a vertical edge to the given y range
+ */
+static WorkEdge 
+clip_vertical (const WorkEdge &e, db::Coord y1, db::Coord y2)
+{
+  tl_assert (e.dx () == 0);
+  db::Coord x = e.p1 ().x ();
+  if (e.dy () < 0) {
+    std::swap (y1, y2);
+  }
+  return WorkEdge (db::Edge (db::Point (x, y1), db::Point (x, y2)), e.prop);
+}
+
+/**
+ *  @brief Gets the range of events forming the scanline at y
+ *
+ *  "from" and "to" are set to the range including the begin_scanline and end_scanline events.
+ *  If there is no such scanline, false is returned.
+ */
+static bool
+find_scanline (const std::vector<RecordingEdgeSink::Event> &events, db::Coord y, size_t &from, size_t &to)
+{
+  for (size_t i = 0; i < events.size (); ++i) {
+    if (events [i].type == RecordingEdgeSink::BeginScanline && events [i].y == y) {
+      from = i;
+      while (i < events.size () && events [i].type != RecordingEdgeSink::EndScanline) {
+        ++i;
+      }
+      tl_assert (i < events.size ());
+      to = i + 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *  @brief Delivers a range of events, replacing the pieces of joined edges by the joined edge
+ */
+static void
+replay_events (const std::vector<RecordingEdgeSink::Event> &events, size_t from, size_t to, const edge_processor_joined_pieces &pieces, const std::vector<db::Edge> &joined, db::EdgeSink &es)
+{
+  for (std::vector<RecordingEdgeSink::Event>::const_iterator e = events.begin () + from; e != events.begin () + to; ++e) {
+
+    edge_processor_joined_pieces::const_iterator p = pieces.end ();
+    if ((e->type == RecordingEdgeSink::Put || e->type == RecordingEdgeSink::CrossingEdge) && e->edge.dx () == 0 && ! pieces.empty ()) {
+      p = pieces.find (e->edge);
+    }
+
+    switch (e->type) {
+    case RecordingEdgeSink::Put:
+      if (p == pieces.end ()) {
+        es.put (e->edge);
+      } else if (p->second.continued) {
+        es.crossing_edge (joined [p->second.chain]);
+      } else {
+        es.put (joined [p->second.chain]);
+      }
+      break;
+    case RecordingEdgeSink::CrossingEdge:
+      es.crossing_edge (p == pieces.end () ? e->edge : joined [p->second.chain]);
+      break;
+    case RecordingEdgeSink::SkipN:
+      es.skip_n (e->n);
+      break;
+    case RecordingEdgeSink::BeginScanline:
+      es.begin_scanline (e->y);
+      break;
+    case RecordingEdgeSink::EndScanline:
+      es.end_scanline (e->y);
+      break;
+    }
+
+  }
+}
+
+}
+
+bool
+EdgeProcessor::process_in_bands (db::EdgeSink &es, EdgeEvaluatorBase &op, property_type n_props)
+{
+  //  below this number of edges per band, multi-threading is not worth the effort
+  const size_t min_edges_per_band = 10000;
+
+  if (mp_work_edges->size () < 2 * min_edges_per_band) {
+    return false;
+  }
+
+  {
+    std::auto_ptr<EdgeEvaluatorBase> op_copy (op.clone ());
+    if (! op_copy.get ()) {
+      return false;
+    }
+  }
+
+  //  Determine the band boundaries: the edge set is divided into bands of equal height. A few 
+  //  bands per thread are produced for better load balancing. Edges crossing a boundary are 
+  //  clipped there. To keep this exact, only vertical and horizontal edges may come closer than 
+  //  1 DBU to a boundary. Hence the boundaries are moved out of the y ranges of all other edges.
+  //  Evaluators selecting edges deliver horizontal edges directly, so the scanline at a boundary 
+  //  cannot be computed from the edges next to it. For those, boundaries are placed in gaps 
+  //  between the edges only.
+
+  bool selects_edges = op.selects_edges ();
+
+  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+
+  db::Coord ymin = edge_ymin (mp_work_edges->front ());
+  db::Coord ymax = edge_ymax (mp_work_edges->front ());
+
+  //  NOTE: as the edges are sorted, the forbidden ranges are produced sorted and merged
+  std::vector<std::pair<db::Coord, db::Coord> > forbidden;
+  for (std::vector <WorkEdge>::const_iterator e = mp_work_edges->begin (); e != mp_work_edges->end (); ++e) {
+
+    ymax = std::max (ymax, edge_ymax (*e));
+
+    if (selects_edges || (e->dx () != 0 && e->dy () != 0)) {
+      db::Coord d = selects_edges ? 0 : 1;
+      if (! forbidden.empty () && edge_ymin (*e) - d <= forbidden.back ().second + 1) {
+        forbidden.back ().second = std::max (forbidden.back ().second, edge_ymax (*e) + d);
+      } else {
+        forbidden.push_back (std::make_pair (edge_ymin (*e) - d, edge_ymax (*e) + d));
+      }
+    }
+
+  }
+
+  size_t nbands = std::min (size_t (m_threads) * 4, mp_work_edges->size () / min_edges_per_band);
+
+  std::vector<db::Coord> boundary_y;
+  for (size_t i = 1; i < nbands; ++i) {
+
+    db::Coord y = db::Coord (ymin + (db::coord_traits<db::Coord>::area_type (ymax) - ymin) * db::coord_traits<db::Coord>::area_type (i) / db::coord_traits<db::Coord>::area_type (nbands));
+
+    std::vector<std::pair<db::Coord, db::Coord> >::const_iterator f = find_range (forbidden, y);
+    if (f != forbidden.end ()) {
+      //  take the closest position outside the forbidden range
+      y = (y - f->first < f->second - y) ? f->first - 1 : f->second + 1;
+    }
+
+    if (y > ymin && y < ymax && (boundary_y.empty () || y > boundary_y.back ())) {
+      boundary_y.push_back (y);
+    }
+
+  }
+
+  if (boundary_y.empty ()) {
+    return false;
+  }
+
+  std::vector<EdgeProcessorBand> bands;
+  bands.resize (boundary_y.size () + 1);
+
+  std::vector<EdgeProcessorBandBoundary> boundaries;
+  boundaries.reserve (boundary_y.size ());
+  for (std::vector<db::Coord>::const_iterator y = boundary_y.begin (); y != boundary_y.end (); ++y) {
+    boundaries.push_back (EdgeProcessorBandBoundary (*y));
+  }
+
+  //  Distribute the edges over the bands. An edge starting at a boundary belongs to the band above.
+  //  In addition, collect the edges next to each boundary (as 1 DBU long pieces) and the points
+  //  where edges touch the boundary.
+
+  for (std::vector <WorkEdge>::const_iterator e = mp_work_edges->begin (); e != mp_work_edges->end (); ++e) {
+
+    db::Coord y1 = edge_ymin (*e), y2 = edge_ymax (*e);
+    size_t b1 = std::upper_bound (boundary_y.begin (), boundary_y.end (), y1) - boundary_y.begin ();
+
+    if (e->dy () == 0) {
+
+      bands [b1].edges.push_back (*e);
+      if (b1 > 0 && boundary_y [b1 - 1] == y1) {
+        boundaries [b1 - 1].touching.push_back (std::make_pair (edge_xmin (*e), edge_xmax (*e)));
+      }
+
+    } else {
+
+      size_t b2 = std::lower_bound (boundary_y.begin (), boundary_y.end (), y2) - boundary_y.begin ();
+
+      if (b1 > 0 && boundary_y [b1 - 1] == y1) {
+        EdgeProcessorBandBoundary &bb = boundaries [b1 - 1];
+        bb.stubs.push_back (clip_vertical (*e, y1, y1 + 1));
+        bb.touching.push_back (std::make_pair (e->p1 ().x (), e->p1 ().x ()));
+      }
+
+      if (b2 < boundary_y.size () && boundary_y [b2] == y2) {
+        EdgeProcessorBandBoundary &bb = boundaries [b2];
+        bb.stubs.push_back (clip_vertical (*e, y2 - 1, y2));
+        bb.touching.push_back (std::make_pair (e->p1 ().x (), e->p1 ().x ()));
+      }
+
+      if (b1 == b2) {
+
+        bands [b1].edges.push_back (*e);
+
+      } else {
+
+        //  The edge crosses boundaries - by construction of the boundaries it is a vertical one
+        db::Coord yl = y1;
+        for (size_t b = b1; b <= b2; ++b) {
+          db::Coord yh = b < b2 ? boundary_y [b] : y2;
+          bands [b].edges.push_back (clip_vertical (*e, yl, yh));
+          if (b < b2) {
+            boundaries [b].stubs.push_back (clip_vertical (*e, yh - 1, yh));
+            boundaries [b].stubs.push_back (clip_vertical (*e, yh, yh + 1));
+          }
+          yl = yh;
+        }
+
+      }
+
+    }
+
+  }
+
+  std::vector <WorkEdge> ().swap (*mp_work_edges);
+
+  EdgeProcessorBandJob job (int (m_threads), &op, n_props);
+  for (std::vector<EdgeProcessorBand>::iterator b = bands.begin (); b != bands.end (); ++b) {
+    if (! b->edges.empty ()) {
+      job.schedule (new EdgeProcessorBandTask (b.operator-> ()));
+    }
+  }
+
+  std::auto_ptr<tl::RelativeProgress> progress (0);
+  if (m_report_progress) {
+    progress.reset (new tl::RelativeProgress (m_progress_desc.empty () ? tl::to_string (tr ("Processing")) : m_progress_desc, bands.size (), 1));
+  }
+
+  try {
+    job.start ();
+    while (job.is_running ()) {
+      if (progress.get ()) {
+        //  This may throw an exception, if the cancel button has been pressed.
+        progress->set (job.bands_done (), true /*force yield*/);
+      }
+      job.wait (100);
+    }
+  } catch (...) {
+    job.terminate ();
+    throw;
+  }
+
+  if (job.has_error ()) {
+    throw tl::Exception (tl::to_string (tr ("Errors occured during processing. First error message says:\n")) + job.error_messages ().front ());
+  }
+
+  for (std::vector<EdgeProcessorBand>::iterator b = bands.begin (); b != bands.end (); ++b) {
+    b->to = b->output.events ().size ();
+  }
+
+  //  Stitch the bands: the last scanline of the band below and the first scanline of the band 
+  //  above a boundary are replaced by the scanline the single-threaded processing would deliver
+  //  at the boundary. This scanline is computed from the edges next to the boundary. 
+  //  Vertical edges clipped at the boundary are joined again unless the single-threaded processing
+  //  would have split them at the boundary too (because other edges touch the boundary there).
+
+  std::vector<edge_processor_joined_pieces> pieces (bands.size ());
+  std::vector<db::Edge> joined;
+
+  for (size_t i = 0; i < boundaries.size (); ++i) {
+
+    EdgeProcessorBandBoundary &bb = boundaries [i];
+    EdgeProcessorBand &below = bands [i];
+    EdgeProcessorBand &above = bands [i + 1];
+
+    merge_ranges (bb.touching);
+
+    //  the last scanline of the band below
+    const std::vector<RecordingEdgeSink::Event> &below_events = below.output.events ();
+    if (below.to > below.from && below_events [below.to - 1].type == RecordingEdgeSink::EndScanline && below_events [below.to - 1].y == bb.y) {
+      do {
+        --below.to;
+      } while (below_events [below.to].type != RecordingEdgeSink::BeginScanline);
+    }
+
+    //  the first scanline of the band above and the edges starting there
+    std::vector<db::Edge> starting;
+    const std::vector<RecordingEdgeSink::Event> &above_events = above.output.events ();
+    if (above.from < above.to && above_events [above.from].type == RecordingEdgeSink::BeginScanline && above_events [above.from].y == bb.y) {
+      do {
+        const RecordingEdgeSink::Event &ev = above_events [above.from++];
+        if (ev.type == RecordingEdgeSink::Put && ev.edge.dy () != 0) {
+          starting.push_back (ev.edge);
+        }
+      } while (above_events [above.from - 1].type != RecordingEdgeSink::EndScanline);
+    }
+
+    if (bb.stubs.empty ()) {
+      continue;
+    }
+
+    RecordingEdgeSink boundary_output;
+    std::vector <CutPoints> cpvector;
+    process_edges (bb.stubs, cpvector, boundary_output, op, n_props, 0);
+    std::vector <WorkEdge> ().swap (bb.stubs);
+
+    size_t from = 0, to = 0;
+    if (! find_scanline (boundary_output.events (), bb.y, from, to)) {
+      continue;
+    }
+
+    bb.events.assign (boundary_output.events ().begin () + from, boundary_output.events ().begin () + to);
+
+    //  the edges starting at the boundary are pieces of the stubs - use the original ones
+
+    std::vector<db::Edge>::const_iterator s = starting.begin ();
+    for (std::vector<RecordingEdgeSink::Event>::iterator ev = bb.events.begin (); ev != bb.events.end (); ++ev) {
+      if (ev->type == RecordingEdgeSink::Put && ev->edge.dy () != 0) {
+        tl_assert (s != starting.end () && s->p1 ().x () == ev->edge.p1 ().x ());
+        ev->edge = *s++;
+      }
+    }
+    tl_assert (s == starting.end ());
+
+    //  find the edges ending at the boundary in the output of the band below (including the 
+    //  boundary scanline below this band)
+
+    std::map<db::Coord, db::Edge> ending;
+
+    for (int k = 0; k < 2; ++k) {
+
+      const std::vector<RecordingEdgeSink::Event> *events = 0;
+      size_t efrom = 0, eto = 0;
+      if (k == 0) {
+        if (i > 0) {
+          events = &boundaries [i - 1].events;
+          eto = events->size ();
+        }
+      } else {
+        events = &below.output.events ();
+        efrom = below.from;
+        eto = below.to;
+      }
+
+      for (size_t j = efrom; j < eto; ++j) {
+        const db::Edge &e = (*events) [j].edge;
+        if ((*events) [j].type == RecordingEdgeSink::Put && e.dx () == 0 && e.dy () != 0 && edge_ymax (e) == bb.y && find_range (bb.touching, e.p1 ().x ()) == bb.touching.end ()) {
+          ending.insert (std::make_pair (e.p1 ().x (), e));
+        }
+      }
+
+    }
+
+    //  join the pieces 
+
+    for (std::vector<RecordingEdgeSink::Event>::const_iterator ev = bb.events.begin (); ev != bb.events.end (); ++ev) {
+
+      if (ev->type != RecordingEdgeSink::Put || ev->edge.dx () != 0 || ev->edge.dy () == 0) {
+        continue;
+      }
+
+      const db::Edge &upper = ev->edge;
+      std::map<db::Coord, db::Edge>::const_iterator l = ending.find (upper.p1 ().x ());
+      if (l == ending.end ()) {
+        continue;
+      }
+
+      const db::Edge &lower = l->second;
+      bool up = (lower.dy () > 0);
+      if (up != (upper.dy () > 0)) {
+        continue;
+      }
+
+      size_t chain = joined.size ();
+      edge_processor_joined_pieces::const_iterator p = pieces [i].find (lower);
+      if (p != pieces [i].end ()) {
+        chain = p->second.chain;
+      } else {
+        joined.push_back (lower);
+        pieces [i].insert (std::make_pair (lower, EdgeProcessorJoinedPiece (chain, false)));
+      }
+
+      db::Edge &j = joined [chain];
+      j = up ? db::Edge (j.p1 (), upper.p2 ()) : db::Edge (upper.p1 (), j.p2 ());
+
+      pieces [i + 1].insert (std::make_pair (upper, EdgeProcessorJoinedPiece (chain, true)));
+
+    }
+
+  }
+
+  //  Deliver the results in the order of the bands (bottom to top) - this is the
+  //  order the single-threaded scanline would have produced
+
+  es.start ();
+
+  for (size_t b = 0; b < bands.size (); ++b) {
+
+    if (b > 0) {
+
+      const EdgeProcessorBandBoundary &bb = boundaries [b - 1];
+
+      //  if no input edge touches the boundary, the single-threaded processing does not have a 
+      //  scanline there. If all edges are joined, this scanline is dropped too.
+      bool has_scanline = ! bb.touching.empty ();
+      for (std::vector<RecordingEdgeSink::Event>::const_iterator ev = bb.events.begin (); ev != bb.events.end () && ! has_scanline; ++ev) {
+        if (ev->type == RecordingEdgeSink::Put) {
+          edge_processor_joined_pieces::const_iterator p = pieces [b].find (ev->edge);
+          has_scanline = (p == pieces [b].end () || ! p->second.continued);
+        }
+      }
+
+      if (has_scanline) {
+        replay_events (bb.events, 0, bb.events.size (), pieces [b], joined, es);
+      }
+
+    }
+
+    EdgeProcessorBand &band = bands [b];
+    replay_events (band.output.events (), band.from, band.to, pieces [b], joined, es);
+    band.output.clear ();
+
+    mp_work_edges->insert (mp_work_edges->end (), band.edges.begin (), band.edges.end ());
+    std::vector <WorkEdge> ().swap (band.edges);
+
+  }
+
+  es.flush ();
+
+  return true;
+}
+
+void 
+EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
+{
+  tl::SelfTimer timer (tl::verbosity () >= 31, "EdgeProcessor: process");
+
+  //  step 1: preparation
+
+  if (mp_work_edges->empty ()) {
+    es.start ();
+    es.flush ();
+    return;
+  }
+
+  mp_cpvector->clear ();
+
+  property_type n_props = 0;
+  for (std::vector <WorkEdge>::iterator e = mp_work_edges->begin (); e != mp_work_edges->end (); ++e) {
+    if (e->prop > n_props) {
+      n_props = e->prop;
+    }
+  }
+  ++n_props;
+
+  if (m_threads > 1 && process_in_bands (es, op, n_props)) {
+    return;
+  }
+
+  std::auto_ptr<tl::AbsoluteProgress> progress (0);
+  if (m_report_progress) {
+    if (m_progress_desc.empty ()) {
+      progress.reset (new tl::AbsoluteProgress (tl::to_string (tr ("Processing")), 1000));
+    } else {
+      progress.reset (new tl::AbsoluteProgress (m_progress_desc, 1000));
+    }
+    progress->set_format (tl::to_string (tr ("%.0f%%")));
+  }
+
+  process_edges (*mp_work_edges, *mp_cpvector, es, op, n_props, progress.get ());
+}
+
 void
 EdgeProcessor::simple_merge (const std::vector<db::Edge> &in, std::vector <db::Edge> &edges, int mode)
 {
@@ -209,6 +209,16 @@ public:
   virtual bool is_reset () const { return false; }
   virtual bool prefer_touch () const { return false; }
   virtual bool selects_edges () const { return false; }
+
+  /**
+   *  @brief Creates a fresh copy of this evaluator
+   *
+   *  The edge processor uses copies of the evaluator for processing independent
+   *  parts of the edge set in parallel. The default implementation returns 0 which
+   *  indicates that the evaluator cannot be copied. In that case, the edge processor
+   *  will use single-threaded processing.
+   */
+  virtual EdgeEvaluatorBase *clone () const { return 0; }
 };
 
 /**
@@ -375,6 +385,11 @@ public:
     return (m_wc_n == 0 && m_wc_s == 0);
   }
 
+  virtual EdgeEvaluatorBase *clone () const
+  {
+    return new GenericMerge<F> (*this);
+  }
+
 private:
   int m_wc_n, m_wc_s;
   F m_function;
@@ -428,6 +443,11 @@ public:
   SimpleMerge (int mode = -1)
     : GenericMerge<ParametrizedInsideFunc> (ParametrizedInsideFunc (mode))
   { }
+
+  virtual EdgeEvaluatorBase *clone () const
+  {
+    return new SimpleMerge (*this);
+  }
 };
 
 /**
@@ -459,6 +479,7 @@ public:
   virtual int edge (bool north, bool enter, property_type p);
   virtual int compare_ns () const;
   virtual bool is_reset () const { return m_zeroes == m_wcv_n.size () + m_wcv_s.size (); }
+  virtual EdgeEvaluatorBase *clone () const { return new BooleanOp (*this); }
 
 protected:
   template <class InsideFunc> bool result (int wca, int wcb, const InsideFunc &inside_a, const InsideFunc &inside_b) const;
@@ -502,6 +523,7 @@ public:
   virtual bool is_reset () const;
   virtual bool prefer_touch () const;
   virtual bool selects_edges () const;
+  virtual EdgeEvaluatorBase *clone () const { return new EdgePolygonOp (*this); }
 
 private:
   bool m_outside, m_include_touching;
@@ -531,6 +553,7 @@ public:
 
   virtual int edge (bool north, bool enter, property_type p);
   virtual int compare_ns () const;
+  virtual EdgeEvaluatorBase *clone () const { return new BooleanOp2 (*this); }
 
 private:
   int m_wc_mode_a, m_wc_mode_b;
@@ -561,6 +584,7 @@ public:
   virtual int edge (bool north, bool enter, property_type p);
   virtual int compare_ns () const;
   virtual bool is_reset () const { return m_zeroes == m_wcv_n.size () + m_wcv_s.size (); }
+  virtual EdgeEvaluatorBase *clone () const { return new MergeOp (*this); }
 
 private:
   int m_wc_n, m_wc_s;
@@ -606,6 +630,35 @@ public:
    */
   void disable_progress ();
 
+  /**
+   *  @brief Sets the number of threads to use
+   *
+   *  With more than one thread, the edge processor splits the edge set into 
+   *  horizontal bands of equal height and processes these bands in parallel. 
+   *  Edges crossing the band boundaries are clipped and joined again when the 
+   *  outputs of the bands are combined. The output is the same than for 
+   *  single-threaded processing.
+   *  Parallel processing requires an evaluator which supports "clone" and a 
+   *  sufficiently large edge set. Band boundaries are only placed where all 
+   *  edges nearby are horizontal or vertical. For evaluators selecting edges,
+   *  band boundaries are only placed in vertical gaps between the edges. If no 
+   *  boundaries can be placed, single-threaded processing is used.
+   *
+   *  A value of 0 or 1 disables multi-threaded processing (the default).
+   */
+  void set_threads (unsigned int n)
+  {
+    m_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads
+   */
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Reserve space for at least n edges
    */
@@ -943,6 +996,9 @@ private:
   std::vector <CutPoints> *mp_cpvector;
   bool m_report_progress;
   std::string m_progress_desc;
+  unsigned int m_threads;
+
+  bool process_in_bands (db::EdgeSink &es, EdgeEvaluatorBase &op, property_type n_props);
 
   static size_t count_edges (const db::Polygon &q) 
   {
@@ -274,6 +274,7 @@ Edges::edge_region_op (const Region &other, bool outside, bool include_borders)
   }
 
   db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+  ep.set_threads (m_threads);
 
   for (db::Region::const_iterator p = other.begin (); ! p.at_end (); ++p) {
     if (p->box ().touches (bbox ())) {
@@ -1088,6 +1089,7 @@ void
 Edges::init ()
 {
   m_report_progress = false;
+  m_threads = 0;
   m_bbox_valid = true;
   m_is_merged = true;
   m_merged_semantics = true;
@@ -1300,6 +1302,16 @@ Edges::size () const
   }
 }
 
+size_t
+Edges::hier_count () const
+{
+  if (! has_valid_edges ()) {
+    return db::count_shapes_hierarchically (m_iter);
+  } else {
+    return m_edges.size ();
+  }
+}
+
 void 
 Edges::set_merged_semantics (bool f)
 {
@@ -381,6 +381,28 @@ public:
    */
   void disable_progress ();
 
+  /**
+   *  @brief Sets the number of threads to use for operations which support multi-threading
+   *
+   *  Currently, only the edge-versus-region operations can make use of multiple threads for
+   *  large inputs. These are the boolean AND and NOT with a region (operator&, operator-
+   *  and their in-place versions) and inside_part, outside_part, select_inside_part and
+   *  select_outside_part. All other operations (specifically edge-versus-edge booleans and
+   *  merging) run single-threaded. 0 or 1 means single-threaded operation (the default).
+   */
+  void set_threads (unsigned int n)
+  {
+    m_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads
+   */
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Iterator of the edge set
    *
@@ -496,6 +518,16 @@ public:
    */
   size_t size () const;
 
+  /**
+   *  @brief Returns the number of edges the hierarchical way
+   *
+   *  For edge collections delivered from a layout, shapes inside cells are counted once,
+   *  regardless how often the cell is instantiated. This count can be obtained without
+   *  flattening the hierarchy, but it is an estimate only. See db::count_shapes_hierarchically
+   *  for details.
+   */
+  size_t hier_count () const;
+
   /**
    *  @brief Returns a string representing the region
    *
@@ -1204,6 +1236,7 @@ private:
   db::ICplxTrans m_iter_trans;
   bool m_report_progress;
   std::string m_progress_desc;
+  unsigned int m_threads;
 
   void init ();
   void invalidate_cache ();
@@ -36,6 +36,7 @@
 #include "dbEdgePair.h"
 #include "dbInstances.h"
 #include "dbLayout.h"
+#include "dbShapeHash.h"
 
 #include <string>
 #include <functional>
@@ -50,65 +51,6 @@
 
 namespace std
 {
-  template <class T>
-  inline size_t hfunc (const T &t)
-  {
-    hash <T> hf;
-    return hf (t);
-  }
-
-  inline size_t hcombine (size_t h1, size_t h2)
-  {
-    return (h1 << 4) ^ (h1 >> 4) ^ h2;
-  }
-
-  template <class T>
-  inline size_t hfunc (const T &t, size_t h)
-  {
-    hash <T> hf;
-    return hcombine (h, hf (t));
-  }
-
-  inline size_t hfunc_coord (db::DCoord d)
-  {
-    return hfunc (int64_t (floor (0.5 + d / db::coord_traits<db::DCoord>::prec ())));
-  }
-
-  inline size_t hfunc_coord (db::Coord d)
-  {
-    return hfunc (d);
-  }
-
-  template <class C>
-  inline size_t hfunc_coord (C d, size_t h)
-  {
-    return hcombine (hfunc_coord (d), h);
-  }
-
-  /**
-   *  @brief Hash value for a point
-   */
-  template <class C>
-  struct hash <db::point<C> >
-  {
-    size_t operator() (const db::point<C> &o) const
-    {
-      return hfunc_coord (o.x (), hfunc_coord (o.y ()));
-    }
-  };
-
-  /**
-   *  @brief Hash value for a vector
-   */
-  template <class C>
-  struct hash <db::vector<C> >
-  {
-    size_t operator() (const db::vector<C> &o) const
-    {
-      return hfunc_coord (o.x (), hfunc_coord (o.y ()));
-    }
-  };
-
   /**
    *  @brief Hash value for a box
    */
@@ -145,87 +87,6 @@ namespace std
     }
   };
 
-  /**
-   *  @brief Hash value for a text object
-   */
-  template <class C>
-  struct hash <db::text<C> >
-  {
-    size_t operator() (const db::text<C> &o) const
-    {
-      size_t h = hfunc (int (o.halign ()));
-      h = hfunc (int (o.valign ()), h);
-      h = hfunc (o.trans ().rot (), h);
-      h = hfunc (o.trans ().disp (), h);
-      //  NOTE: using std::string for the value makes sure the default hasher doesn't use the pointer value
-      h = hfunc (hfunc (std::string (o.string ())), h);
-      return h;
-    }
-  };
-
-  /**
-   *  @brief Hash value for a path
-   */
-  template <class C>
-  struct hash <db::path<C> >
-  {
-    size_t operator() (const db::path<C> &o) const
-    {
-      size_t h = hfunc (int (o.round ()));
-      h = hfunc_coord (o.bgn_ext (), h);
-      h = hfunc_coord (o.end_ext (), h);
-      h = hfunc_coord (o.width (), h);
-      for (typename db::path<C>::iterator p = o.begin (); p != o.end (); ++p) {
-        h = hfunc (*p, h);
-      }
-      return h;
-    }
-  };
-
-  /**
-   *  @brief Hash value for a polygon contour
-   */
-  template <class C>
-  struct hash <db::polygon_contour<C> >
-  {
-    size_t operator() (const db::polygon_contour<C> &o) const
-    {
-      size_t h = 0;
-      for (typename db::polygon_contour<C>::simple_iterator i = o.begin (); i != o.end (); ++i) {
-        h = hfunc (*i, h);
-      }
-      return h;
-    }
-  };
-
-  /**
-   *  @brief Hash value for a polygon
-   */
-  template <class C>
-  struct hash <db::polygon<C> >
-  {
-    size_t operator() (const db::polygon<C> &o) const
-    {
-      size_t h = hfunc (o.hull ());
-      for (size_t i = 0; i < o.holes (); ++i) {
-        h = hfunc (o.hole (int (i)), h);
-      }
-      return h;
-    }
-  };
-
-  /**
-   *  @brief Hash value for a simple polygon
-   */
-  template <class C>
-  struct hash <db::simple_polygon<C> >
-  {
-    size_t operator() (const db::simple_polygon<C> &o) const
-    {
-      return hfunc (o.hull ());
-    }
-  };
-
   /**
    *  @brief Hash value for a simple transformation
    */
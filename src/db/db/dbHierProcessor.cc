@@ -0,0 +1,773 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbHierProcessor.h"
+#include "dbBoxScanner.h"
+#include "dbBoxConvert.h"
+#include "dbCellHullGenerator.h"
+#include "dbPolygonGenerators.h"
+#include "dbPolygonTools.h"
+#include "dbClip.h"
+
+#include "tlProgress.h"
+#include "tlInternational.h"
+
+#include <set>
+#include <map>
+#include <memory>
+#include <cmath>
+
+namespace db
+{
+
+// ---------------------------------------------------------------------------------------------
+//  BoolAndOrNotLocalOperation implementation
+
+BoolAndOrNotLocalOperation::BoolAndOrNotLocalOperation (db::BooleanOp::BoolOp op, bool min_coherence)
+  : m_op (op), m_min_coherence (min_coherence)
+{
+  //  .. nothing yet ..
+}
+
+void
+BoolAndOrNotLocalOperation::compute_local (const db::ICplxTrans & /*trans*/, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> &intruders, std::vector<db::Polygon> &result) const
+{
+  if (subjects.empty () && (m_op == db::BooleanOp::And || m_op == db::BooleanOp::ANotB)) {
+    return;
+  }
+  if (intruders.empty () && m_op == db::BooleanOp::And) {
+    return;
+  }
+
+  db::EdgeProcessor ep;
+
+  size_t n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p) {
+    n += p->vertices ();
+  }
+  for (std::vector<db::Polygon>::const_iterator p = intruders.begin (); p != intruders.end (); ++p) {
+    n += p->vertices ();
+  }
+  ep.reserve (n);
+
+  n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p, n += 2) {
+    ep.insert (*p, n);
+  }
+  n = 1;
+  for (std::vector<db::Polygon>::const_iterator p = intruders.begin (); p != intruders.end (); ++p, n += 2) {
+    ep.insert (*p, n);
+  }
+
+  db::BooleanOp op (m_op);
+  db::PolygonContainer pc (result);
+  db::PolygonGenerator pg (pc, false /*don't resolve holes*/, m_min_coherence);
+  ep.process (pg, op);
+}
+
+std::string
+BoolAndOrNotLocalOperation::description () const
+{
+  if (m_op == db::BooleanOp::And) {
+    return tl::to_string (tr ("AND operation"));
+  } else if (m_op == db::BooleanOp::ANotB) {
+    return tl::to_string (tr ("NOT operation"));
+  } else if (m_op == db::BooleanOp::Xor) {
+    return tl::to_string (tr ("XOR operation"));
+  } else {
+    return tl::to_string (tr ("OR operation"));
+  }
+}
+
+// ---------------------------------------------------------------------------------------------
+//  MergeLocalOperation implementation
+
+MergeLocalOperation::MergeLocalOperation (unsigned int min_wc, bool min_coherence)
+  : m_min_wc (min_wc), m_min_coherence (min_coherence)
+{
+  //  .. nothing yet ..
+}
+
+void
+MergeLocalOperation::compute_local (const db::ICplxTrans & /*trans*/, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> & /*intruders*/, std::vector<db::Polygon> &result) const
+{
+  if (subjects.empty ()) {
+    return;
+  }
+
+  db::EdgeProcessor ep;
+
+  size_t n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p) {
+    n += p->vertices ();
+  }
+  ep.reserve (n);
+
+  n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p, ++n) {
+    ep.insert (*p, n);
+  }
+
+  db::MergeOp op (m_min_wc);
+  db::PolygonContainer pc (result);
+  db::PolygonGenerator pg (pc, false /*don't resolve holes*/, m_min_coherence);
+  ep.process (pg, op);
+}
+
+std::string
+MergeLocalOperation::description () const
+{
+  return tl::to_string (tr ("Merge operation"));
+}
+
+// ---------------------------------------------------------------------------------------------
+//  SizingLocalOperation implementation
+
+SizingLocalOperation::SizingLocalOperation (db::Coord dx, db::Coord dy, unsigned int mode, bool merge)
+  : m_dx (dx), m_dy (dy), m_mode (mode), m_merge (merge)
+{
+  //  .. nothing yet ..
+}
+
+db::ICplxTrans
+SizingLocalOperation::reduce_trans (const db::ICplxTrans &trans) const
+{
+  if (m_dx == m_dy) {
+    //  isotropic sizing only depends on the magnification
+    return db::ICplxTrans (trans.mag ());
+  } else {
+    return db::ICplxTrans (trans.mag (), trans.angle (), trans.is_mirror (), db::Vector ());
+  }
+}
+
+bool
+SizingLocalOperation::local_distances (const db::ICplxTrans &trans, db::Coord &dx, db::Coord &dy) const
+{
+  bool swap = false;
+  if (m_dx != m_dy) {
+    if (! trans.is_ortho ()) {
+      return false;
+    }
+    swap = (trans.fp_trans ().rot () % 2) != 0;
+  }
+
+  double ddx = double (swap ? m_dy : m_dx) / trans.mag ();
+  double ddy = double (swap ? m_dx : m_dy) / trans.mag ();
+  dx = db::coord_traits<db::Coord>::rounded (ddx);
+  dy = db::coord_traits<db::Coord>::rounded (ddy);
+
+  return fabs (ddx - dx) < db::epsilon && fabs (ddy - dy) < db::epsilon;
+}
+
+bool
+SizingLocalOperation::is_local_trans (const db::ICplxTrans &trans) const
+{
+  db::Coord dx = 0, dy = 0;
+  return local_distances (trans, dx, dy);
+}
+
+void
+SizingLocalOperation::compute_local (const db::ICplxTrans &trans, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> & /*intruders*/, std::vector<db::Polygon> &result) const
+{
+  if (subjects.empty ()) {
+    return;
+  }
+
+  db::Coord dx = 0, dy = 0;
+  bool is_local = local_distances (trans, dx, dy);
+  tl_assert (is_local);
+
+  db::PolygonContainer pc (result);
+  db::PolygonGenerator pg2 (pc, false /*don't resolve holes*/, true /*min. coherence*/);
+  db::SizingPolygonFilter siz (pg2, dx, dy, m_mode);
+
+  if (! m_merge) {
+
+    for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p) {
+      siz.put (*p);
+    }
+
+  } else {
+
+    db::EdgeProcessor ep;
+
+    size_t n = 0;
+    for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p) {
+      n += p->vertices ();
+    }
+    ep.reserve (n);
+
+    n = 0;
+    for (std::vector<db::Polygon>::const_iterator p = subjects.begin (); p != subjects.end (); ++p, ++n) {
+      ep.insert (*p, n);
+    }
+
+    db::PolygonGenerator pg (siz, false /*don't resolve holes*/, false /*min. coherence*/);
+    db::BooleanOp op (db::BooleanOp::Or);
+    ep.process (pg, op);
+
+  }
+}
+
+std::string
+SizingLocalOperation::description () const
+{
+  return tl::to_string (tr ("Sizing operation"));
+}
+
+// ---------------------------------------------------------------------------------------------
+//  LocalProcessor implementation
+
+namespace
+{
+
+/**
+ *  @brief A simple union-find structure for the interaction clusters
+ */
+class InteractionClusters
+{
+public:
+  InteractionClusters (size_t n)
+    : m_parent (n)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      m_parent [i] = i;
+    }
+  }
+
+  size_t find (size_t i)
+  {
+    while (m_parent [i] != i) {
+      m_parent [i] = m_parent [m_parent [i]];
+      i = m_parent [i];
+    }
+    return i;
+  }
+
+  void join (size_t a, size_t b)
+  {
+    a = find (a);
+    b = find (b);
+    if (a != b) {
+      m_parent [std::max (a, b)] = std::min (a, b);
+    }
+  }
+
+private:
+  std::vector<size_t> m_parent;
+};
+
+/**
+ *  @brief The box scanner receiver building the interaction clusters
+ *
+ *  All context polygons carry the same property ("root"), so a cluster
+ *  touching the context is joined with the root.
+ */
+class InteractionClusterReceiver
+  : public db::box_scanner_receiver<db::Polygon, size_t>
+{
+public:
+  InteractionClusterReceiver (InteractionClusters &clusters)
+    : mp_clusters (&clusters)
+  {
+    //  .. nothing yet ..
+  }
+
+  void add (const db::Polygon *o1, size_t p1, const db::Polygon *o2, size_t p2)
+  {
+    if (p1 == p2) {
+      return;
+    }
+    if (mp_clusters->find (p1) == mp_clusters->find (p2)) {
+      return;
+    }
+    if (db::interact_pp (*o1, *o2)) {
+      mp_clusters->join (p1, p2);
+    }
+  }
+
+private:
+  InteractionClusters *mp_clusters;
+};
+
+/**
+ *  @brief A polygon together with the information whether it's a subject (0) or an intruder (1)
+ */
+typedef std::pair<db::Polygon, unsigned int> tagged_polygon;
+
+/**
+ *  @brief Adds a foreign polygon to the context of a child cell
+ *
+ *  The polygon is clipped at the (slightly enlarged) bounding box of the
+ *  child instance and transformed into the child cell's coordinate space.
+ */
+void
+add_to_context (std::set<db::Polygon> &context, const db::Polygon &poly, const db::Box &clip_box, const db::ICplxTrans &ti)
+{
+  std::vector<db::Polygon> clipped;
+  if (poly.box ().inside (clip_box)) {
+    clipped.push_back (poly);
+  } else {
+    db::clip_poly (poly, clip_box, clipped);
+  }
+
+  //  Rounding effects may shrink the transformed polygon, hence we use an
+  //  enlarged bounding box for non-trivial transformations (conservative approximation)
+  bool exact = ti.is_ortho () && ! ti.is_mag ();
+
+  for (std::vector<db::Polygon>::const_iterator c = clipped.begin (); c != clipped.end (); ++c) {
+    if (exact) {
+      context.insert (c->transformed (ti));
+    } else {
+      context.insert (db::Polygon (c->box ().transformed (ti).enlarged (db::Vector (1, 1))));
+    }
+  }
+}
+
+}
+
+LocalProcessor::LocalProcessor (db::Layout *layout, db::Cell *top)
+  : mp_layout (layout), mp_top (top), m_report_progress (false), m_local_shapes (0), m_promoted_shapes (0)
+{
+  //  .. nothing yet ..
+}
+
+void
+LocalProcessor::run (const LocalOperation &op, unsigned int subject_layer, unsigned int output_layer)
+{
+  do_run (op, subject_layer, -1, output_layer);
+}
+
+void
+LocalProcessor::run (const LocalOperation &op, unsigned int subject_layer, unsigned int intruder_layer, unsigned int output_layer)
+{
+  do_run (op, subject_layer, int (intruder_layer), output_layer);
+}
+
+void
+LocalProcessor::separate_variants (const LocalOperation &op, std::map<db::cell_index_type, db::ICplxTrans> &cell_trans)
+{
+  std::set<db::cell_index_type> called;
+  mp_top->collect_called_cells (called);
+  called.insert (mp_top->cell_index ());
+
+  //  collect the reduced transformations of the cells into the top cell
+
+  std::map<db::cell_index_type, std::set<db::ICplxTrans> > variants;
+  variants [mp_top->cell_index ()].insert (op.reduce_trans (db::ICplxTrans ()));
+
+  bool needs_separation = false;
+
+  for (db::Layout::top_down_const_iterator c = mp_layout->begin_top_down (); c != mp_layout->end_top_down (); ++c) {
+
+    if (called.find (*c) == called.end () || *c == mp_top->cell_index ()) {
+      continue;
+    }
+
+    std::set<db::ICplxTrans> &vc = variants [*c];
+
+    const db::Cell &cell = mp_layout->cell (*c);
+    for (db::Cell::parent_inst_iterator pi = cell.begin_parent_insts (); ! pi.at_end (); ++pi) {
+
+      std::map<db::cell_index_type, std::set<db::ICplxTrans> >::const_iterator pv = variants.find (pi->parent_cell_index ());
+      if (pv == variants.end ()) {
+        continue;
+      }
+
+      //  all members of an array share the same rotation and magnification
+      db::ICplxTrans t = pi->child_inst ().cell_inst ().complex_trans ();
+      t.disp (db::Vector ());
+
+      for (std::set<db::ICplxTrans>::const_iterator v = pv->second.begin (); v != pv->second.end (); ++v) {
+        vc.insert (op.reduce_trans (*v * t));
+      }
+
+    }
+
+    if (vc.size () > 1) {
+      needs_separation = true;
+    }
+
+  }
+
+  if (! needs_separation) {
+    for (std::map<db::cell_index_type, std::set<db::ICplxTrans> >::const_iterator v = variants.begin (); v != variants.end (); ++v) {
+      if (! v->second.empty ()) {
+        cell_trans.insert (std::make_pair (v->first, *v->second.begin ()));
+      }
+    }
+    return;
+  }
+
+  //  create the variants: the first one is the original cell
+
+  std::map<std::pair<db::cell_index_type, db::ICplxTrans>, db::cell_index_type> variant_cells;
+
+  for (std::map<db::cell_index_type, std::set<db::ICplxTrans> >::const_iterator v = variants.begin (); v != variants.end (); ++v) {
+
+    for (std::set<db::ICplxTrans>::const_iterator t = v->second.begin (); t != v->second.end (); ++t) {
+
+      db::cell_index_type ci = v->first;
+      if (t != v->second.begin ()) {
+        ci = mp_layout->add_cell (mp_layout->cell_name (v->first));
+        mp_layout->cell (ci) = mp_layout->cell (v->first);
+        m_variants.insert (std::make_pair (ci, v->first));
+      }
+
+      variant_cells.insert (std::make_pair (std::make_pair (v->first, *t), ci));
+      cell_trans.insert (std::make_pair (ci, *t));
+
+    }
+
+  }
+
+  //  let the instances point to the variants matching the transformation of their parent
+
+  for (std::map<db::cell_index_type, db::ICplxTrans>::const_iterator ct = cell_trans.begin (); ct != cell_trans.end (); ++ct) {
+
+    db::Cell &cell = mp_layout->cell (ct->first);
+
+    std::vector<std::pair<db::Instance, db::cell_index_type> > to_replace;
+
+    for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+
+      const db::CellInstArray &cell_inst = i->cell_inst ();
+      db::cell_index_type child = cell_inst.object ().cell_index ();
+
+      db::ICplxTrans t = cell_inst.complex_trans ();
+      t.disp (db::Vector ());
+
+      std::map<std::pair<db::cell_index_type, db::ICplxTrans>, db::cell_index_type>::const_iterator vc = variant_cells.find (std::make_pair (child, op.reduce_trans (ct->second * t)));
+      if (vc != variant_cells.end () && vc->second != child) {
+        to_replace.push_back (std::make_pair (*i, vc->second));
+      }
+
+    }
+
+    for (std::vector<std::pair<db::Instance, db::cell_index_type> >::const_iterator r = to_replace.begin (); r != to_replace.end (); ++r) {
+      db::CellInstArray na = r->first.cell_inst ();
+      na.object ().cell_index (r->second);
+      cell.replace (r->first, na);
+    }
+
+  }
+
+  mp_layout->update ();
+}
+
+void
+LocalProcessor::do_run (const LocalOperation &op, unsigned int subject_layer, int intruder_layer, unsigned int output_layer)
+{
+  m_local_shapes = 0;
+  m_promoted_shapes = 0;
+  m_variants.clear ();
+
+  mp_layout->update ();
+
+  //  separate the cells into variants if the operation depends on the cell's transformation
+  std::map<db::cell_index_type, db::ICplxTrans> cell_trans;
+  separate_variants (op, cell_trans);
+
+  std::set<db::cell_index_type> called;
+  mp_top->collect_called_cells (called);
+  called.insert (mp_top->cell_index ());
+
+  std::vector<unsigned int> layers;
+  layers.push_back (subject_layer);
+  if (intruder_layer >= 0 && (unsigned int) intruder_layer != subject_layer) {
+    layers.push_back ((unsigned int) intruder_layer);
+  }
+
+  const unsigned int flags = db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes;
+
+  std::string desc = m_description.empty () ? op.description () : m_description;
+  std::auto_ptr<tl::RelativeProgress> progress;
+  if (m_report_progress) {
+    progress.reset (new tl::RelativeProgress (desc, called.size () * 2, 1));
+  }
+
+  //  The bounding boxes of the cells with respect to the layers involved
+  std::map<db::cell_index_type, db::Box> cell_boxes;
+  for (std::set<db::cell_index_type>::const_iterator c = called.begin (); c != called.end (); ++c) {
+    db::Box b;
+    for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+      b += mp_layout->cell (*c).bbox (*l);
+    }
+    cell_boxes.insert (std::make_pair (*c, b));
+  }
+
+  //  Pass 1: derive the contexts top-down
+
+  db::CellHullGenerator hull_generator (*mp_layout, layers);
+  std::map<db::cell_index_type, std::vector<db::Polygon> > hulls;
+
+  std::map<db::cell_index_type, std::set<db::Polygon> > contexts;
+
+  db::box_convert<db::CellInst> inst_bc (*mp_layout);
+
+  for (db::Layout::top_down_const_iterator c = mp_layout->begin_top_down (); c != mp_layout->end_top_down (); ++c) {
+
+    if (called.find (*c) == called.end () || *c == mp_top->cell_index ()) {
+      continue;
+    }
+
+    if (progress.get ()) {
+      ++*progress;
+    }
+
+    const db::Box &cbox = cell_boxes [*c];
+    if (cbox.empty ()) {
+      continue;
+    }
+
+    std::set<db::Polygon> &context = contexts [*c];
+    const db::Cell &cell = mp_layout->cell (*c);
+
+    for (db::Cell::parent_inst_iterator pi = cell.begin_parent_insts (); ! pi.at_end (); ++pi) {
+
+      db::cell_index_type pci = pi->parent_cell_index ();
+      if (called.find (pci) == called.end ()) {
+        continue;
+      }
+
+      const db::Cell &parent = mp_layout->cell (pci);
+      db::Instance inst = pi->child_inst ();
+      const db::CellInstArray &cell_inst = inst.cell_inst ();
+
+      std::map<db::cell_index_type, std::set<db::Polygon> >::const_iterator pctx = contexts.find (pci);
+
+      for (db::CellInstArray::iterator a = cell_inst.begin (); ! a.at_end (); ++a) {
+
+        db::ICplxTrans t = cell_inst.complex_trans (*a);
+        db::ICplxTrans ti = t.inverted ();
+        db::Box clip_box = cbox.transformed (t).enlarged (db::Vector (1, 1));
+
+        //  the parent's shapes
+        for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+          for (db::ShapeIterator s = parent.shapes (*l).begin_touching (clip_box, flags); ! s.at_end (); ++s) {
+            db::Polygon poly;
+            s->polygon (poly);
+            add_to_context (context, poly, clip_box, ti);
+          }
+        }
+
+        //  the sibling instances
+        for (db::Cell::touching_iterator si = parent.begin_touching (clip_box); ! si.at_end (); ++si) {
+
+          const db::CellInstArray &sibling_inst = si->cell_inst ();
+          db::cell_index_type sci = sibling_inst.object ().cell_index ();
+
+          const db::Box &sbox = cell_boxes [sci];
+          if (sbox.empty ()) {
+            continue;
+          }
+
+          bool same_inst = (*si == inst);
+
+          for (db::CellInstArray::iterator sa = sibling_inst.begin_touching (clip_box, inst_bc); ! sa.at_end (); ++sa) {
+
+            if (same_inst && *sa == *a) {
+              continue;
+            }
+
+            db::ICplxTrans st = sibling_inst.complex_trans (*sa);
+            if (! sbox.transformed (st).touches (clip_box)) {
+              continue;
+            }
+
+            std::map<db::cell_index_type, std::vector<db::Polygon> >::iterator h = hulls.find (sci);
+            if (h == hulls.end ()) {
+              h = hulls.insert (std::make_pair (sci, std::vector<db::Polygon> ())).first;
+              //  the hull generator only considers the local shapes, so we can use it for leaf cells only
+              if (mp_layout->cell (sci).is_leaf ()) {
+                hull_generator.generate_hull (mp_layout->cell (sci), h->second);
+              } else {
+                h->second.push_back (db::Polygon (sbox));
+              }
+            }
+
+            for (std::vector<db::Polygon>::const_iterator hp = h->second.begin (); hp != h->second.end (); ++hp) {
+              db::Polygon poly = hp->transformed (st);
+              if (poly.box ().touches (clip_box)) {
+                add_to_context (context, poly, clip_box, ti);
+              }
+            }
+
+          }
+
+        }
+
+        //  the parent's context
+        if (pctx != contexts.end ()) {
+          for (std::set<db::Polygon>::const_iterator p = pctx->second.begin (); p != pctx->second.end (); ++p) {
+            if (p->box ().touches (clip_box)) {
+              add_to_context (context, *p, clip_box, ti);
+            }
+          }
+        }
+
+      }
+
+    }
+
+  }
+
+  hulls.clear ();
+
+  //  Pass 2: compute the results bottom-up
+
+  std::map<db::cell_index_type, std::vector<tagged_polygon> > promoted;
+
+  for (db::Layout::bottom_up_const_iterator c = mp_layout->begin_bottom_up (); c != mp_layout->end_bottom_up (); ++c) {
+
+    if (called.find (*c) == called.end ()) {
+      continue;
+    }
+
+    if (progress.get ()) {
+      ++*progress;
+    }
+
+    db::Cell &cell = mp_layout->cell (*c);
+
+    std::vector<tagged_polygon> items;
+
+    for (unsigned int tag = 0; tag < 2; ++tag) {
+      if (tag == 1 && intruder_layer < 0) {
+        break;
+      }
+      unsigned int l = (tag == 0 ? subject_layer : (unsigned int) intruder_layer);
+      for (db::ShapeIterator s = cell.shapes (l).begin (flags); ! s.at_end (); ++s) {
+        items.push_back (tagged_polygon (db::Polygon (), tag));
+        s->polygon (items.back ().first);
+      }
+    }
+
+    std::map<db::cell_index_type, std::vector<tagged_polygon> >::iterator pr = promoted.find (*c);
+    if (pr != promoted.end ()) {
+      items.insert (items.end (), pr->second.begin (), pr->second.end ());
+      promoted.erase (pr);
+    }
+
+    if (items.empty ()) {
+      contexts.erase (*c);
+      continue;
+    }
+
+    //  determine the clusters interacting with the context
+
+    std::vector<bool> promote (items.size (), false);
+
+    std::map<db::cell_index_type, db::ICplxTrans>::const_iterator ct = cell_trans.find (*c);
+    db::ICplxTrans trans = (ct != cell_trans.end () ? ct->second : db::ICplxTrans ());
+
+    std::map<db::cell_index_type, std::set<db::Polygon> >::const_iterator ctx = contexts.find (*c);
+    if (*c != mp_top->cell_index () && ! op.is_local_trans (trans)) {
+
+      //  the operation cannot be computed inside this cell
+      promote = std::vector<bool> (items.size (), true);
+
+    } else if (ctx != contexts.end () && ! ctx->second.empty ()) {
+
+      size_t root = items.size ();
+      InteractionClusters clusters (root + 1);
+
+      db::box_scanner<db::Polygon, size_t> scanner;
+      scanner.reserve (items.size () + ctx->second.size ());
+
+      for (size_t i = 0; i < items.size (); ++i) {
+        scanner.insert (&items [i].first, i);
+      }
+      for (std::set<db::Polygon>::const_iterator p = ctx->second.begin (); p != ctx->second.end (); ++p) {
+        scanner.insert (&*p, root);
+      }
+
+      InteractionClusterReceiver rec (clusters);
+      scanner.process (rec, 1, db::box_convert<db::Polygon> ());
+
+      size_t root_cluster = clusters.find (root);
+      for (size_t i = 0; i < items.size (); ++i) {
+        promote [i] = (clusters.find (i) == root_cluster);
+      }
+
+    }
+
+    contexts.erase (*c);
+
+    //  compute the local part
+
+    std::vector<db::Polygon> subjects, intruders, results;
+    for (size_t i = 0; i < items.size (); ++i) {
+      if (! promote [i]) {
+        ++m_local_shapes;
+        if (items [i].second == 0) {
+          subjects.push_back (items [i].first);
+        } else {
+          intruders.push_back (items [i].first);
+        }
+      }
+    }
+
+    if (! subjects.empty () || ! intruders.empty ()) {
+      op.compute_local (trans, subjects, intruders, results);
+      db::Shapes &out = cell.shapes (output_layer);
+      for (std::vector<db::Polygon>::const_iterator r = results.begin (); r != results.end (); ++r) {
+        out.insert (db::PolygonRef (*r, mp_layout->shape_repository ()));
+      }
+    }
+
+    //  propagate the remaining shapes into the parents
+
+    for (db::Cell::parent_inst_iterator pi = cell.begin_parent_insts (); ! pi.at_end (); ++pi) {
+
+      db::cell_index_type pci = pi->parent_cell_index ();
+      if (called.find (pci) == called.end ()) {
+        continue;
+      }
+
+      std::vector<tagged_polygon> *target = 0;
+
+      const db::CellInstArray &cell_inst = pi->child_inst ().cell_inst ();
+      for (db::CellInstArray::iterator a = cell_inst.begin (); ! a.at_end (); ++a) {
+
+        db::ICplxTrans t = cell_inst.complex_trans (*a);
+
+        for (size_t i = 0; i < items.size (); ++i) {
+          if (promote [i]) {
+            if (! target) {
+              target = &promoted [pci];
+            }
+            target->push_back (tagged_polygon (items [i].first.transformed (t), items [i].second));
+            ++m_promoted_shapes;
+          }
+        }
+
+      }
+
+    }
+
+  }
+}
+
+}
+
@@ -0,0 +1,278 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_dbHierProcessor
+#define HDR_dbHierProcessor
+
+#include "dbCommon.h"
+
+#include "dbLayout.h"
+#include "dbPolygon.h"
+#include "dbEdgeProcessor.h"
+
+#include <vector>
+#include <string>
+#include <map>
+
+namespace db
+{
+
+/**
+ *  @brief The base class for the operations of the hierarchical processor
+ *
+ *  A local operation computes the result for a set of "subject" and "intruder"
+ *  polygons. The hierarchical processor guarantees that these polygons form
+ *  a closed set: no other shape touches or overlaps them. Hence the
+ *  operation must not depend on anything outside the polygons given to it.
+ */
+class DB_PUBLIC LocalOperation
+{
+public:
+  /**
+   *  @brief Constructor
+   */
+  LocalOperation () { }
+
+  /**
+   *  @brief Destructor
+   */
+  virtual ~LocalOperation () { }
+
+  /**
+   *  @brief Computes the result for the given subjects and intruders
+   *
+   *  "trans" is the reduced transformation of the cell into the top cell (see reduce_trans).
+   */
+  virtual void compute_local (const db::ICplxTrans &trans, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> &intruders, std::vector<db::Polygon> &result) const = 0;
+
+  /**
+   *  @brief Reduces the transformation of a cell into the top cell to the part the operation depends on
+   *
+   *  Cells which are instantiated with different reduced transformations are
+   *  separated into variants by the processor. The default implementation returns
+   *  the unit transformation: the result does not depend on the transformation.
+   *  The reduction must be compatible with the concatenation of transformations.
+   */
+  virtual db::ICplxTrans reduce_trans (const db::ICplxTrans & /*trans*/) const
+  {
+    return db::ICplxTrans ();
+  }
+
+  /**
+   *  @brief Returns true, if the operation can be computed inside a cell with the given (reduced) transformation
+   *
+   *  If not, the shapes of the cell are propagated into the parents.
+   */
+  virtual bool is_local_trans (const db::ICplxTrans & /*trans*/) const
+  {
+    return true;
+  }
+
+  /**
+   *  @brief Returns true, if the operation needs intruders
+   */
+  virtual bool requires_intruders () const
+  {
+    return false;
+  }
+
+  /**
+   *  @brief Gets a description of the operation (used for the progress)
+   */
+  virtual std::string description () const = 0;
+};
+
+/**
+ *  @brief A boolean operation (AND, NOT, XOR, OR) between subjects and intruders
+ */
+class DB_PUBLIC BoolAndOrNotLocalOperation
+  : public LocalOperation
+{
+public:
+  BoolAndOrNotLocalOperation (db::BooleanOp::BoolOp op, bool min_coherence);
+
+  virtual void compute_local (const db::ICplxTrans &trans, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> &intruders, std::vector<db::Polygon> &result) const;
+  virtual bool requires_intruders () const { return true; }
+  virtual std::string description () const;
+
+private:
+  db::BooleanOp::BoolOp m_op;
+  bool m_min_coherence;
+};
+
+/**
+ *  @brief A merge operation on the subjects
+ */
+class DB_PUBLIC MergeLocalOperation
+  : public LocalOperation
+{
+public:
+  MergeLocalOperation (unsigned int min_wc, bool min_coherence);
+
+  virtual void compute_local (const db::ICplxTrans &trans, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> &intruders, std::vector<db::Polygon> &result) const;
+  virtual std::string description () const;
+
+private:
+  unsigned int m_min_wc;
+  bool m_min_coherence;
+};
+
+/**
+ *  @brief A sizing operation on the subjects
+ *
+ *  If "merge" is true, the subjects are merged before they are sized (merged semantics).
+ *
+ *  The sizing distances are given in the top cell's coordinate space. Inside the
+ *  cells, the distances are scaled by the inverse magnification and - for anisotropic
+ *  sizing - dx and dy are swapped for rotations by 90 or 270 degree. Cells with
+ *  transformations which do not allow this (non-integer distances, non-orthogonal
+ *  rotations for anisotropic sizing) are computed in the parents.
+ */
+class DB_PUBLIC SizingLocalOperation
+  : public LocalOperation
+{
+public:
+  SizingLocalOperation (db::Coord dx, db::Coord dy, unsigned int mode, bool merge);
+
+  virtual void compute_local (const db::ICplxTrans &trans, const std::vector<db::Polygon> &subjects, const std::vector<db::Polygon> &intruders, std::vector<db::Polygon> &result) const;
+  virtual db::ICplxTrans reduce_trans (const db::ICplxTrans &trans) const;
+  virtual bool is_local_trans (const db::ICplxTrans &trans) const;
+  virtual std::string description () const;
+
+private:
+  db::Coord m_dx, m_dy;
+  unsigned int m_mode;
+  bool m_merge;
+
+  bool local_distances (const db::ICplxTrans &trans, db::Coord &dx, db::Coord &dy) const;
+};
+
+/**
+ *  @brief The hierarchical processor
+ *
+ *  The hierarchical processor runs a local operation on the shapes of a cell tree
+ *  while keeping the results inside the cells as far as possible.
+ *
+ *  The algorithm works in two passes:
+ *
+ *  First, the context of each cell is determined top-down. The context is the
+ *  set of foreign geometries a cell's shapes may interact with in any of its
+ *  instantiations: the parent's shapes, the hulls of sibling instances (see
+ *  CellHullGenerator) and - propagated down - the parent's context.
+ *  The context is a conservative approximation.
+ *
+ *  Second, the cells are processed bottom-up. Shapes of a cell which form
+ *  interaction clusters (computed with the box scanner) not touching the context
+ *  are computed locally - once per cell - and the results stay in that cell. Clusters
+ *  touching the context are propagated ("promoted") into the parent cells where they
+ *  are taken into account together with the parent's shapes.
+ *
+ *  Interactions are defined as touching or overlapping. Hence the processor is suitable
+ *  for operations whose results are composed from the results of non-touching
+ *  clusters, such as booleans, merge and sizing.
+ *
+ *  Before that, cells are separated into variants if the operation depends on the
+ *  transformation of the cells (see LocalOperation::reduce_trans). Each variant is a
+ *  copy of the original cell and is instantiated with a single reduced transformation.
+ */
+class DB_PUBLIC LocalProcessor
+{
+public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param layout The layout to work on
+   *  @param top The top cell of the cell tree to work on
+   */
+  LocalProcessor (db::Layout *layout, db::Cell *top);
+
+  /**
+   *  @brief Runs the operation on the subject layer only
+   */
+  void run (const LocalOperation &op, unsigned int subject_layer, unsigned int output_layer);
+
+  /**
+   *  @brief Runs the operation on the subject and intruder layers
+   *
+   *  The results are placed on the output layer.
+   */
+  void run (const LocalOperation &op, unsigned int subject_layer, unsigned int intruder_layer, unsigned int output_layer);
+
+  /**
+   *  @brief Enables or disables progress reporting
+   */
+  void set_report_progress (bool rp)
+  {
+    m_report_progress = rp;
+  }
+
+  /**
+   *  @brief Sets the description of the progress
+   */
+  void set_description (const std::string &d)
+  {
+    m_description = d;
+  }
+
+  /**
+   *  @brief Gets the number of shapes computed locally in the last run
+   */
+  size_t local_shapes () const
+  {
+    return m_local_shapes;
+  }
+
+  /**
+   *  @brief Gets the number of shapes propagated into parent cells in the last run
+   */
+  size_t promoted_shapes () const
+  {
+    return m_promoted_shapes;
+  }
+
+  /**
+   *  @brief Gets the cell variants created in the last run
+   *
+   *  The keys are the new cells, the values are the cells they have been copied from.
+   */
+  const std::map<db::cell_index_type, db::cell_index_type> &variants () const
+  {
+    return m_variants;
+  }
+
+private:
+  db::Layout *mp_layout;
+  db::Cell *mp_top;
+  bool m_report_progress;
+  std::string m_description;
+  size_t m_local_shapes, m_promoted_shapes;
+  std::map<db::cell_index_type, db::cell_index_type> m_variants;
+
+  void do_run (const LocalOperation &op, unsigned int subject_layer, int intruder_layer, unsigned int output_layer);
+  void separate_variants (const LocalOperation &op, std::map<db::cell_index_type, db::ICplxTrans> &cell_trans);
+};
+
+}
+
+#endif
+
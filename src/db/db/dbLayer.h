@@ -30,6 +30,7 @@
 #include "tlVector.h"
 
 #include <iterator>
+#include <algorithm>
 
 namespace db 
 {
@@ -123,6 +124,23 @@ struct layer
     return *this;
   }
 
+  /**
+   *  @brief Swaps the contents of this layer with another one
+   *
+   *  The manager attachment is not swapped.
+   */
+  void swap (layer &d)
+  {
+    m_box_tree.swap (d.m_box_tree);
+    std::swap (m_bbox, d.m_bbox);
+    //  NOTE: the dirty flags are bit fields and cannot be swapped with std::swap
+    bool bbox_dirty = m_bbox_dirty, tree_dirty = m_tree_dirty;
+    m_bbox_dirty = d.m_bbox_dirty;
+    m_tree_dirty = d.m_tree_dirty;
+    d.m_bbox_dirty = bbox_dirty;
+    d.m_tree_dirty = tree_dirty;
+  }
+
   /**
    *  @brief Get the iterator for an object given by a pointer 
    */
@@ -321,14 +339,16 @@ struct layer
 
   /**
    *  @brief Restore the sorted state
+   *
+   *  "threads" is the number of threads the box tree may use for sorting.
    */
-  void sort () 
+  void sort (unsigned int threads = 0) 
   {
     //  only sort if not done already
     if (m_tree_dirty) {
       //  and actually sort the tree
       box_convert bc = box_convert ();
-      m_box_tree.sort (bc);
+      m_box_tree.sort (bc, threads);
       m_tree_dirty = false;
     }
   }
@@ -36,6 +36,7 @@
 #include "tlInternational.h"
 #include "tlProgress.h"
 #include "tlAssert.h"
+#include "tlThreadedWorkers.h"
 
 
 namespace db
@@ -263,7 +264,8 @@ Layout::Layout (db::Manager *manager)
     m_properties_repository (this),
     m_guiding_shape_layer (-1),
     m_waste_layer (-1),
-    m_editable (db::default_editable_mode ())
+    m_editable (db::default_editable_mode ()),
+    m_sort_threads (db::default_sort_threads ())
 {
   // .. nothing yet ..
 }
@@ -278,7 +280,8 @@ Layout::Layout (bool editable, db::Manager *manager)
     m_properties_repository (this),
     m_guiding_shape_layer (-1),
     m_waste_layer (-1),
-    m_editable (editable)
+    m_editable (editable),
+    m_sort_threads (db::default_sort_threads ())
 {
   // .. nothing yet ..
 }
@@ -295,8 +298,10 @@ Layout::Layout (const db::Layout &layout)
     m_properties_repository (this),
     m_guiding_shape_layer (-1),
     m_waste_layer (-1),
-    m_editable (layout.m_editable)
+    m_editable (layout.m_editable),
+    m_sort_threads (layout.m_sort_threads)
 {
+  set_contour_arena_enabled (layout.is_contour_arena_enabled ());
   *this = layout;
 }
 
@@ -311,6 +316,16 @@ Layout::~Layout ()
   clear ();
 }
 
+void
+Layout::set_contour_arena_enabled (bool f)
+{
+  if (f != is_contour_arena_enabled ()) {
+    //  NOTE: contours still allocated in the old arena keep their chunks alive
+    mp_contour_arena.reset (f ? new db::ContourArena () : 0);
+    m_shape_repository.set_arena (mp_contour_arena.get ());
+  }
+}
+
 void
 Layout::dbu (double d)
 {
@@ -376,6 +391,7 @@ Layout::operator= (const Layout &d)
     m_guiding_shape_layer = d.m_guiding_shape_layer;
     m_waste_layer = d.m_waste_layer;
     m_editable = d.m_editable;
+    m_sort_threads = d.m_sort_threads;
 
     m_pcell_ids = d.m_pcell_ids;
     m_pcells.reserve (d.m_pcells.size ());
@@ -449,6 +465,9 @@ Layout::mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat
   db::mem_stat (stat, purpose, cat, m_meta_info, true, (void *) this);
   db::mem_stat (stat, purpose, cat, m_string_repository, true, (void *) this);
   db::mem_stat (stat, purpose, cat, m_shape_repository, true, (void *) this);
+  if (mp_contour_arena.get ()) {
+    mp_contour_arena->mem_stat (stat, purpose, cat, false, (void *) this);
+  }
   db::mem_stat (stat, purpose, cat, m_properties_repository, true, (void *) this);
   db::mem_stat (stat, purpose, cat, m_array_repository, true, (void *) this);
 
@@ -1268,6 +1287,165 @@ Layout::update () const
   }
 }
 
+// -----------------------------------------------------------------
+//  Multi-threaded shape sorting
+
+namespace
+{
+
+class SortShapesTask
+  : public tl::Task
+{
+public:
+  SortShapesTask (db::Cell *cell)
+    : mp_cell (cell)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::Cell *cell () const
+  {
+    return mp_cell;
+  }
+
+private:
+  db::Cell *mp_cell;
+};
+
+class SortShapesJob
+  : public tl::JobBase
+{
+public:
+  SortShapesJob (int nworkers)
+    : tl::JobBase (nworkers), m_cells_done (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  void next_cell ()
+  {
+    tl::MutexLocker locker (&m_mutex);
+    ++m_cells_done;
+  }
+
+  size_t cells_done ()
+  {
+    tl::MutexLocker locker (&m_mutex);
+    return m_cells_done;
+  }
+
+  virtual tl::Worker *create_worker ();
+
+private:
+  size_t m_cells_done;
+  tl::Mutex m_mutex;
+};
+
+class SortShapesWorker
+  : public tl::Worker
+{
+public:
+  SortShapesWorker (SortShapesJob *job)
+    : tl::Worker (), mp_job (job)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    SortShapesTask *sort_task = dynamic_cast <SortShapesTask *> (task);
+    if (sort_task) {
+      sort_task->cell ()->sort_shapes ();
+      mp_job->next_cell ();
+    }
+  }
+
+private:
+  SortShapesJob *mp_job;
+};
+
+tl::Worker *
+SortShapesJob::create_worker ()
+{
+  return new SortShapesWorker (this);
+}
+
+/**
+ *  @brief Returns true if the cell has a shape layer which is sorted with multiple threads
+ */
+static bool
+has_large_shape_layer (const db::Cell &cell, unsigned int layers)
+{
+  for (unsigned int l = 0; l < layers; ++l) {
+    if (cell.shapes (l).size () >= db::box_tree_parallel_sort_threshold) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *  @brief Returns true if the layout has enough shapes to benefit from multi-threaded sorting
+ *
+ *  Starting the threads is not worth it for small layouts which are updated often.
+ */
+static bool
+has_many_shapes (const db::Layout &layout)
+{
+  size_t n = 0;
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+    for (unsigned int l = 0; l < layout.layers (); ++l) {
+      n += c->shapes (l).size ();
+      if (n >= db::box_tree_parallel_sort_threshold) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}
+
+void
+Layout::sort_shapes_parallel (tl::RelativeProgress &progress)
+{
+  //  Cells with large layers are sorted one by one and use multiple threads for
+  //  the box trees. The other cells are independent and are sorted in parallel.
+  std::vector<cell_type *> large_cells;
+
+  SortShapesJob job ((int) m_sort_threads);
+  for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+    cell_type &cp (cell (*c));
+    if (has_large_shape_layer (cp, layers ())) {
+      large_cells.push_back (&cp);
+    } else {
+      job.schedule (new SortShapesTask (&cp));
+    }
+  }
+
+  try {
+    job.start ();
+    while (job.is_running ()) {
+      //  This may throw an exception, if the cancel button has been pressed.
+      progress.set (job.cells_done (), true /*force yield*/);
+      job.wait (100);
+    }
+  } catch (...) {
+    job.terminate ();
+    throw;
+  }
+
+  if (job.has_error ()) {
+    throw tl::Exception (tl::to_string (tr ("Errors occured during sorting. First error message says:\n")) + job.error_messages ().front ());
+  }
+
+  size_t n = job.cells_done ();
+  for (std::vector<cell_type *>::const_iterator c = large_cells.begin (); c != large_cells.end (); ++c) {
+    progress.set (++n);
+    (*c)->sort_shapes (m_sort_threads);
+  }
+}
+
 void 
 Layout::do_update ()
 {
@@ -1334,10 +1512,14 @@ Layout::do_update ()
         tl::SelfTimer timer (tl::verbosity () >= 31, "Sorting shapes");
         pr->set (0);
         pr->set_desc (tl::to_string (tr ("Sorting shapes")));
-        for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
-          ++*pr;
-          cell_type &cp (cell (*c));
-          cp.sort_shapes ();
+        if (m_sort_threads > 1 && has_many_shapes (*this)) {
+          sort_shapes_parallel (*pr);
+        } else {
+          for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+            ++*pr;
+            cell_type &cp (cell (*c));
+            cp.sort_shapes ();
+          }
         }
       }
     }
@@ -45,7 +45,12 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <memory>
 
+namespace tl
+{
+  class RelativeProgress;
+}
 
 namespace db
 {
@@ -556,6 +561,61 @@ public:
     return m_shape_repository;
   }
 
+  /**
+   *  @brief Enables or disables arena allocation of polygon contours
+   *
+   *  If enabled, the point arrays of the polygons stored in the shape repository
+   *  (i.e. the ones referred to by polygon references) are allocated from a 
+   *  layout-specific arena rather than individually from the heap. This saves the 
+   *  per-allocation overhead, but memory is only returned when all contours of an 
+   *  arena chunk are released (e.g. when the layout is cleared or destroyed). 
+   *  Hence arena allocation is mainly useful for non-editable layouts which are 
+   *  loaded once and not modified heavily.
+   *
+   *  This option should be set right after the layout has been created. Polygons 
+   *  created before will keep their heap storage. The option is disabled by default.
+   */
+  void set_contour_arena_enabled (bool f);
+
+  /**
+   *  @brief Gets a value indicating whether arena allocation of polygon contours is enabled
+   */
+  bool is_contour_arena_enabled () const
+  {
+    return mp_contour_arena.get () != 0;
+  }
+
+  /**
+   *  @brief Gets the contour arena or 0 if arena allocation is not enabled
+   */
+  db::ContourArena *contour_arena () const
+  {
+    return mp_contour_arena.get ();
+  }
+
+  /**
+   *  @brief Sets the number of threads to use for sorting the shapes
+   *
+   *  With more than one thread, the update step following the loading or 
+   *  modification of the layout sorts the shapes of different cells in parallel.
+   *  Shape layers with many shapes are sorted using multiple threads themselves.
+   *  Small layouts are always sorted in the calling thread.
+   *  A value of 0 or 1 disables multi-threaded sorting. The initial value is 
+   *  taken from db::default_sort_threads.
+   */
+  void set_sort_threads (unsigned int n)
+  {
+    m_sort_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads used for sorting the shapes
+   */
+  unsigned int sort_threads () const
+  {
+    return m_sort_threads;
+  }
+
   /**
    *  @brief Accessor to the properties repository
    */
@@ -1603,6 +1663,8 @@ protected:
   virtual void do_update ();
 
 private:
+  void sort_shapes_parallel (tl::RelativeProgress &progress);
+
   enum LayerState { Normal, Free, Special };
 
   cell_list m_cells;
@@ -1620,6 +1682,7 @@ private:
   double m_dbu;
   db::properties_id_type m_prop_id;
   StringRepository m_string_repository;
+  std::auto_ptr<db::ContourArena> mp_contour_arena;
   GenericRepository m_shape_repository;
   PropertiesRepository m_properties_repository;
   ArrayRepository m_array_repository;
@@ -1629,6 +1692,7 @@ private:
   int m_guiding_shape_layer;
   int m_waste_layer;
   bool m_editable;
+  unsigned int m_sort_threads;
   meta_info m_meta_info;
 
   /**
@@ -22,6 +22,7 @@
 
 
 #include "dbLayoutUtils.h"
+#include "dbRecursiveShapeIterator.h"
 #include "tlProgress.h"
 
 namespace db
@@ -401,5 +402,44 @@ ContextCache::find_layout_context (db::cell_index_type from, db::cell_index_type
   return c->second;
 }
 
+// ------------------------------------------------------------
+//  Implementation of "count_shapes_hierarchically"
+
+size_t
+count_shapes_hierarchically (const db::RecursiveShapeIterator &iter)
+{
+  if (iter.shapes ()) {
+    return iter.shapes ()->size ();
+  }
+
+  const db::Layout *layout = iter.layout ();
+  const db::Cell *top_cell = iter.top_cell ();
+  if (! layout || ! top_cell) {
+    return 0;
+  }
+
+  std::set<db::cell_index_type> called;
+  called.insert (top_cell->cell_index ());
+  top_cell->collect_called_cells (called, iter.max_depth ());
+
+  std::vector<unsigned int> layers;
+  if (iter.multiple_layers ()) {
+    layers = iter.layers ();
+  } else {
+    layers.push_back (iter.layer ());
+  }
+
+  size_t n = 0;
+  for (std::set<db::cell_index_type>::const_iterator c = called.begin (); c != called.end (); ++c) {
+    const db::Cell &cell = layout->cell (*c);
+    for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+      if (layout->is_valid_layer (*l)) {
+        n += cell.shapes (*l).size ();
+      }
+    }
+  }
+
+  return n;
 }
 
+}
@@ -37,6 +37,8 @@
 namespace db
 {
 
+class RecursiveShapeIterator;
+
 /**
  *  @brief A implementation of ImportLayerMapping that does a direct layer mapping
  *
@@ -183,6 +185,16 @@ move_shapes (db::Layout &target,
 std::pair<bool, db::ICplxTrans>
 DB_PUBLIC find_layout_context (const db::Layout &layout, db::cell_index_type from, db::cell_index_type to);
 
+/**
+ *  @brief Counts the shapes delivered by a recursive shape iterator the hierarchical way
+ *
+ *  Shapes inside cells are counted once, regardless how often the cell is instantiated.
+ *  All shapes on the iterator's layers are counted regardless of the shape flags and
+ *  the search region. Hence the count is an estimate only, but it can be computed
+ *  without flattening the hierarchy.
+ */
+size_t DB_PUBLIC count_shapes_hierarchically (const db::RecursiveShapeIterator &iter);
+
 /**
  *  @brief A cache for contexts
  *
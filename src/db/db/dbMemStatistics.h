@@ -33,6 +33,7 @@
 #include <map>
 #include <set>
 #include <list>
+#include <unordered_map>
 #include <typeinfo>
 #include "tlReuseVector.h"
 
@@ -216,6 +217,21 @@ void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, c
   mem_stat (stat, purpose, cat, v.second, true, (void *) &v);
 }
 
+template <class X, class Y, class H, class E>
+void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, const std::unordered_map<X, Y, H, E> &v, bool no_self = false, void *parent = 0)
+{
+  if (! no_self) {
+    stat->add (typeid (std::unordered_map<X, Y, H, E>), (void *) &v, sizeof (std::unordered_map<X, Y, H, E>), sizeof (std::unordered_map<X, Y, H, E>), parent, purpose, cat);
+  }
+  //  the bucket array and the per-node link
+  stat->add (typeid (void * []), (void *) &v, v.bucket_count () * sizeof (void *), v.bucket_count () * sizeof (void *), (void *) &v, purpose, cat);
+  for (typename std::unordered_map<X, Y, H, E>::const_iterator i = v.begin (); i != v.end (); ++i) {
+    mem_stat (stat, purpose, cat, i->first, false, (void *) &v);
+    mem_stat (stat, purpose, cat, i->second, false, (void *) &v);
+    stat->add (typeid (void *), (void *) &i->first, sizeof (void *), sizeof (void *), (void *) &v, purpose, cat);
+  }
+}
+
 }
 
 #endif
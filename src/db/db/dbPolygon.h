@@ -35,6 +35,7 @@
 #include "dbBox.h"
 #include "dbObjectTag.h"
 #include "dbShapeRepository.h"
+#include "dbContourArena.h"
 #include "tlTypeTraits.h"
 #include "tlVector.h"
 #include "tlAlgorithm.h"
@@ -140,9 +141,10 @@ public:
     if (d.mp_points == 0) {
       mp_points = 0;
     } else {
-      point_type *p = new point_type [m_size];
-      point_type *pp = (point_type *) ((size_t) d.mp_points & ~3);
-      mp_points = (point_type *)((size_t) p | ((size_t) d.mp_points & 3));
+      bool arena = false;
+      point_type *p = allocate_points (m_size, arena);
+      point_type *pp = (point_type *) ((size_t) d.mp_points & ~7);
+      mp_points = (point_type *)((size_t) p | ((size_t) d.mp_points & 3) | (arena ? 4 : 0));
       for (unsigned int i = 0; i < m_size; ++i) {
         p[i] = pp[i];
       }
@@ -348,9 +350,10 @@ public:
       }
 
       point_type *pts;
+      bool arena = false;
 
       m_size = n;
-      pts = new point_type [m_size];
+      pts = allocate_points (m_size, arena);
 
       //  copy distinct points now
       p = min;
@@ -381,9 +384,9 @@ public:
 
       }
 
-      //  and store the pointer along with the hole flag
-      tl_assert (((size_t) pts & 3) == 0);
-      mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0)); 
+      //  and store the pointer along with the hole flag and the arena flag
+      tl_assert (((size_t) pts & 7) == 0);
+      mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0) | (arena ? 4 : 0)); 
 
     } else {
 
@@ -490,6 +493,7 @@ public:
 
       point_type *pts;
       bool clockwise;
+      bool arena = false;
 
       //  in ortho mode, allocate only half the number of points and compress
       if (ortho) {
@@ -497,7 +501,7 @@ public:
         tl_assert ((n % 2) == 0);
 
         m_size = n / 2;
-        pts = new point_type [m_size];
+        pts = allocate_points (m_size, arena);
 
         //  determine orientation:
         //  it is that simple since we know that the segments attached to 
@@ -535,7 +539,7 @@ public:
       } else {
 
         m_size = n;
-        pts = new point_type [m_size];
+        pts = allocate_points (m_size, arena);
 
         //  copy distinct points now
         n = 0;
@@ -586,9 +590,9 @@ public:
         std::reverse (pts + 1, pts + n);
       }
 
-      //  and store the pointer along with two flags: ortho mode and hole flag
-      tl_assert (((size_t) pts & 3) == 0);
-      mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0) | (ortho ? 1 : 0)); 
+      //  and store the pointer along with three flags: ortho mode, hole flag and arena flag
+      tl_assert (((size_t) pts & 7) == 0);
+      mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0) | (ortho ? 1 : 0) | (arena ? 4 : 0)); 
 
     }
   }
@@ -606,7 +610,7 @@ public:
    */
   polygon_contour<C> &move (const vector_type &d)
   {
-    point_type *p = (point_type *) ((size_t) mp_points & ~3);
+    point_type *p = (point_type *) ((size_t) mp_points & ~7);
     for (size_type i = 0; i < m_size; ++i, ++p) {
       *p += d;
     }
@@ -732,9 +736,10 @@ public:
     if (m_size < 2) {
       return false;
     }
-    point_type pl = mp_points [m_size - 1];
+    const point_type *pts = (const point_type *) ((size_t) mp_points & ~7);
+    point_type pl = pts [m_size - 1];
     for (size_t i = 0; i < m_size; ++i) {
-      point_type p = mp_points [i];
+      point_type p = pts [i];
       if (! coord_traits::equals (p.x (), pl.x ()) && ! coord_traits::equals (p.y (), pl.y ())) {
         return false;
       }
@@ -803,7 +808,7 @@ public:
   point_type operator[] (size_type index) const
   {
     size_t f = (size_t) mp_points;
-    point_type *pts = (point_type *) (f & ~3);
+    point_type *pts = (point_type *) (f & ~7);
     if ((f & 1) != 0) {
       if ((index & 1) != 0) {
         if ((f & 2) != 0) {
@@ -861,7 +866,7 @@ public:
   box_type bbox () const
   {
     box_type box;
-    point_type *p = (point_type *) ((size_t) mp_points & ~3);
+    point_type *p = (point_type *) ((size_t) mp_points & ~7);
     for (size_type i = 0; i < m_size; ++i, ++p) {
       box += *p;
     }
@@ -1000,10 +1005,25 @@ private:
   point_type *mp_points;
   size_type m_size;
 
+  static point_type *allocate_points (size_type n, bool &arena)
+  {
+    point_type *p = (point_type *) db::ContourArena::allocate_current (sizeof (point_type) * n);
+    arena = (p != 0);
+    if (! p) {
+      return new point_type [n];
+    }
+    for (size_type i = 0; i < n; ++i) {
+      new (p + i) point_type ();
+    }
+    return p;
+  }
+
   void release ()
   {
-    point_type *p = (point_type *) ((size_t) mp_points & ~3);
-    if (p) {
+    point_type *p = (point_type *) ((size_t) mp_points & ~7);
+    if (((size_t) mp_points & 4) != 0) {
+      db::ContourArena::release (p, sizeof (point_type) * m_size);
+    } else if (p) {
       delete [] p;
     }
     mp_points = 0;
@@ -33,6 +33,17 @@ namespace db
 // ----------------------------------------------------------------------------------
 //  PropertiesRepository implementation
 
+size_t
+PropertiesRepository::properties_set_ptr_hash::operator() (const properties_set *ps) const
+{
+  size_t h = ps->size ();
+  for (properties_set::const_iterator p = ps->begin (); p != ps->end (); ++p) {
+    h = (h << 4) ^ (h >> 4) ^ size_t (p->first);
+    h = (h << 4) ^ (h >> 4) ^ p->second.hash ();
+  }
+  return h;
+}
+
 PropertiesRepository::PropertiesRepository (db::LayoutStateModel *state_model)
   : mp_state_model (state_model)
 {
@@ -46,11 +57,22 @@ PropertiesRepository &
 PropertiesRepository::operator= (const PropertiesRepository &d)
 {
   if (&d != this) {
-    m_propnames_by_id            = d.m_propnames_by_id;
+
+    tl::MutexLocker locker (&m_lock);
+    tl::MutexLocker other_locker (&d.m_lock);
+
+    m_propnames_by_id.assign (d.m_propnames_by_id);
     m_propname_ids_by_name       = d.m_propname_ids_by_name;
-    m_properties_by_id           = d.m_properties_by_id;
-    m_properties_ids_by_set      = d.m_properties_ids_by_set;
+    m_properties_by_id.assign (d.m_properties_by_id);
     m_properties_component_table = d.m_properties_component_table;
+
+    //  the index refers to our own sets, so we need to rebuild it
+    m_properties_ids_by_set.clear ();
+    m_properties_ids_by_set.reserve (m_properties_by_id.size ());
+    for (size_t id = 0; id < m_properties_by_id.size (); ++id) {
+      m_properties_ids_by_set.insert (std::make_pair (&m_properties_by_id [id], properties_id_type (id)));
+    }
+
   }
   return *this;
 }
@@ -58,7 +80,9 @@ PropertiesRepository::operator= (const PropertiesRepository &d)
 std::pair<bool, property_names_id_type>
 PropertiesRepository::get_id_of_name (const tl::Variant &name) const
 {
-  std::map <tl::Variant, property_names_id_type>::const_iterator pi = m_propname_ids_by_name.find (name);
+  tl::MutexLocker locker (&m_lock);
+
+  std::unordered_map <tl::Variant, property_names_id_type, variant_hash>::const_iterator pi = m_propname_ids_by_name.find (name);
   if (pi == m_propname_ids_by_name.end ()) {
     return std::make_pair (false, property_names_id_type (0));
   } else {
@@ -69,10 +93,17 @@ PropertiesRepository::get_id_of_name (const tl::Variant &name) const
 property_names_id_type 
 PropertiesRepository::prop_name_id (const tl::Variant &name)
 {
-  std::map <tl::Variant, property_names_id_type>::const_iterator pi = m_propname_ids_by_name.find (name);
+  tl::MutexLocker locker (&m_lock);
+  return prop_name_id_unlocked (name);
+}
+
+property_names_id_type 
+PropertiesRepository::prop_name_id_unlocked (const tl::Variant &name)
+{
+  std::unordered_map <tl::Variant, property_names_id_type, variant_hash>::const_iterator pi = m_propname_ids_by_name.find (name);
   if (pi == m_propname_ids_by_name.end ()) {
     property_names_id_type id = m_propnames_by_id.size ();
-    m_propnames_by_id.insert (std::make_pair (id, name));
+    m_propnames_by_id.push_back (name);
     m_propname_ids_by_name.insert (std::make_pair (name, id));
     return id;
   } else {
@@ -83,15 +114,20 @@ PropertiesRepository::prop_name_id (const tl::Variant &name)
 void 
 PropertiesRepository::change_properties (property_names_id_type id, const properties_set &new_props)
 {
-  const properties_set &old_props = properties (id);
+  {
+    tl::MutexLocker locker (&m_lock);
+
+    if (id >= m_properties_by_id.size ()) {
+      return;
+    }
 
-  std::map <properties_set, properties_id_type>::const_iterator pi = m_properties_ids_by_set.find (old_props);
-  if (pi != m_properties_ids_by_set.end ()) {
+    properties_set &props = m_properties_by_id [id];
 
     //  erase the id from the component table
-    for (properties_set::const_iterator nv = old_props.begin (); nv != old_props.end (); ++nv) {
-      if (m_properties_component_table.find (*nv) != m_properties_component_table.end ()) {
-        properties_id_vector &v = m_properties_component_table [*nv];
+    for (properties_set::const_iterator nv = props.begin (); nv != props.end (); ++nv) {
+      std::unordered_map <name_value_pair, properties_id_vector, name_value_hash>::iterator ct = m_properties_component_table.find (*nv);
+      if (ct != m_properties_component_table.end ()) {
+        properties_id_vector &v = ct->second;
         for (size_t i = 0; i < v.size (); ) {
           if (v[i] == id) {
             v.erase (v.begin () + i);
@@ -102,31 +138,26 @@ PropertiesRepository::change_properties (property_names_id_type id, const proper
       }
     }
 
-    //  and insert again
-    m_properties_ids_by_set.erase (old_props);
-    m_properties_ids_by_set.insert (std::make_pair (new_props, id));
-
-    m_properties_by_id [id] = new_props;
+    //  and insert again (the index needs to be updated as it is keyed by the set's content)
+    m_properties_ids_by_set.erase (&props);
+    props = new_props;
+    m_properties_ids_by_set.insert (std::make_pair (&props, id));
 
     for (properties_set::const_iterator nv = new_props.begin (); nv != new_props.end (); ++nv) {
       m_properties_component_table.insert (std::make_pair (*nv, properties_id_vector ())).first->second.push_back (id);
     }
-
-    //  signal the change of the properties ID's. This way for example, the layer views
-    //  can recompute the property selectors
-    if (mp_state_model) {
-      mp_state_model->prop_ids_changed ();
-    }
-
   }
+
+  prop_ids_changed ();
 }
 
 void 
 PropertiesRepository::change_name (property_names_id_type id, const tl::Variant &new_name)
 {
-  std::map <property_names_id_type, tl::Variant>::iterator pi = m_propnames_by_id.find (id);
-  tl_assert (pi != m_propnames_by_id.end ());
-  pi->second = new_name;
+  tl::MutexLocker locker (&m_lock);
+
+  tl_assert (id < m_propnames_by_id.size ());
+  m_propnames_by_id [id] = new_name;
 
   m_propname_ids_by_name.insert (std::make_pair (new_name, id));
 }
@@ -134,41 +165,65 @@ PropertiesRepository::change_name (property_names_id_type id, const tl::Variant
 const tl::Variant &
 PropertiesRepository::prop_name (property_names_id_type id) const
 {
-  return m_propnames_by_id.find (id)->second;
+  //  NOTE: no lock required - names are never moved once they are published
+  tl_assert (id < m_propnames_by_id.size ());
+  return m_propnames_by_id [id];
 }
 
 properties_id_type 
 PropertiesRepository::properties_id (const properties_set &props)
 {
-  std::map <properties_set, properties_id_type>::const_iterator pi = m_properties_ids_by_set.find (props);
+  std::pair<bool, properties_id_type> id;
+
+  {
+    tl::MutexLocker locker (&m_lock);
+    id = properties_id_unlocked (props);
+  }
+
+  if (id.first) {
+    prop_ids_changed ();
+  }
+
+  return id.second;
+}
+
+std::pair<bool, properties_id_type>
+PropertiesRepository::properties_id_unlocked (const properties_set &props)
+{
+  std::unordered_map <const properties_set *, properties_id_type, properties_set_ptr_hash, properties_set_ptr_equal>::const_iterator pi = m_properties_ids_by_set.find (&props);
   if (pi == m_properties_ids_by_set.end ()) {
 
-    properties_id_type id = m_properties_ids_by_set.size ();
-    m_properties_ids_by_set.insert (std::make_pair (props, id));
-    m_properties_by_id.insert (std::make_pair (id, props));
+    properties_id_type id = m_properties_by_id.size ();
+    const properties_set &new_props = m_properties_by_id.push_back (props);
+    m_properties_ids_by_set.insert (std::make_pair (&new_props, id));
     for (properties_set::const_iterator nv = props.begin (); nv != props.end (); ++nv) {
       m_properties_component_table.insert (std::make_pair (*nv, properties_id_vector ())).first->second.push_back (id);
     }
 
-    //  signal the change of the properties ID's. This way for example, the layer views
-    //  can recompute the property selectors
-    if (mp_state_model) {
-      mp_state_model->prop_ids_changed ();
-    }
-
-    return id;
+    return std::make_pair (true, id);
 
   } else {
-    return pi->second;
+    return std::make_pair (false, pi->second);
+  }
+}
+
+void
+PropertiesRepository::prop_ids_changed ()
+{
+  //  signal the change of the properties ID's. This way for example, the layer views
+  //  can recompute the property selectors
+  //  NOTE: this is done outside the lock, so the receivers can access the repository
+  if (mp_state_model) {
+    mp_state_model->prop_ids_changed ();
   }
 }
 
 const PropertiesRepository::properties_set &
 PropertiesRepository::properties (properties_id_type id) const
 {
-  iterator p = m_properties_by_id.find (id);
-  if (p != m_properties_by_id.end ()) {
-    return p->second;
+  //  NOTE: no lock required - sets are never moved once they are published
+  if (id < m_properties_by_id.size ()) {
+    return m_properties_by_id [id];
   } else {
     static PropertiesRepository::properties_set empty_set;
     return empty_set;
@@ -178,13 +233,15 @@ PropertiesRepository::properties (properties_id_type id) const
 bool
 PropertiesRepository::is_valid_properties_id (properties_id_type id) const
 {
-  return m_properties_by_id.find (id) != m_properties_by_id.end ();
+  return id < m_properties_by_id.size ();
 }
 
 const PropertiesRepository::properties_id_vector &
 PropertiesRepository::properties_ids_by_name_value (const name_value_pair &nv) const
 {
-  std::map <name_value_pair, properties_id_vector>::const_iterator idv = m_properties_component_table.find (nv);
+  tl::MutexLocker locker (&m_lock);
+
+  std::unordered_map <name_value_pair, properties_id_vector, name_value_hash>::const_iterator idv = m_properties_component_table.find (nv);
   if (idv == m_properties_component_table.end ()) {
     static properties_id_vector empty;
     return empty;
@@ -196,16 +253,34 @@ PropertiesRepository::properties_ids_by_name_value (const name_value_pair &nv) c
 properties_id_type 
 PropertiesRepository::translate (const PropertiesRepository &rep, properties_id_type id)
 {
+  //  NOTE: reading the source by Id does not need its lock
   const properties_set &pset = rep.properties (id);
-
-  //  create a new set by mapping the names
-  properties_set new_pset;
+  std::vector<tl::Variant> names;
+  names.reserve (pset.size ());
   for (properties_set::const_iterator pp = pset.begin (); pp != pset.end (); ++pp) {
-    new_pset.insert (std::make_pair (prop_name_id (rep.prop_name (pp->first)), pp->second));
+    names.push_back (rep.prop_name (pp->first));
+  }
+
+  std::pair<bool, properties_id_type> new_id;
+
+  {
+    tl::MutexLocker locker (&m_lock);
+
+    //  create a new set by mapping the names
+    properties_set new_pset;
+    std::vector<tl::Variant>::const_iterator n = names.begin ();
+    for (properties_set::const_iterator pp = pset.begin (); pp != pset.end (); ++pp, ++n) {
+      new_pset.insert (std::make_pair (prop_name_id_unlocked (*n), pp->second));
+    }
+
+    new_id = properties_id_unlocked (new_pset);
   }
 
-  return properties_id (new_pset);
+  if (new_id.first) {
+    prop_ids_changed ();
+  }
+
+  return new_id.second;
 }
 
 } // namespace db
-
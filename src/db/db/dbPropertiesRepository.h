@@ -29,10 +29,15 @@
 #include "dbMemStatistics.h"
 
 #include "tlVariant.h"
+#include "tlThreads.h"
+#include "tlAssert.h"
+#include "atomic/atomic.h"
 
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <algorithm>
 
 namespace db
 {
@@ -46,15 +51,21 @@ class LayoutStateModel;
  *  an unique Id which can be stored with a object_with_properties element.
  *  For performance reasons property names (which are strings) are not
  *  stored as such but as integers.
+ *
+ *  The lookup of names and property sets is implemented with hash tables.
+ *  Names and property sets are stored in append-only tables indexed by Id.
+ *  Reading a name or a property set by Id does not need a lock, so
+ *  multiple threads (i.e. readers or the tiling processor) can access them
+ *  concurrently while other threads register new Id's. Registering names and
+ *  sets and looking them up by content is serialized with a mutex.
+ *  change_name, change_properties and the assignment modify existing entries
+ *  and must not run concurrently with readers.
  */
 
 class DB_PUBLIC PropertiesRepository
 {
 public:
   typedef std::multimap <property_names_id_type, tl::Variant> properties_set;
-  typedef std::map <properties_id_type, properties_set> properties_map;
-  typedef std::map <properties_id_type, properties_set>::const_iterator iterator;
-  typedef std::map <properties_id_type, properties_set>::iterator non_const_iterator;
   typedef std::pair <property_names_id_type, tl::Variant> name_value_pair;
   typedef std::vector <properties_id_type> properties_id_vector;
 
@@ -138,52 +149,22 @@ public:
    */
   bool is_valid_properties_id (properties_id_type id) const;
 
-  /**
-   *  @brief Iterate over Id/Properties sets (non-const)
-   */
-  non_const_iterator begin_non_const () 
-  {
-    return m_properties_by_id.begin ();
-  }
-
-  /**
-   *  @brief Iterate over Id/Properties sets: end iterator (non-const)
-   */
-  non_const_iterator end_non_const () 
-  {
-    return m_properties_by_id.end ();
-  }
-
-  /**
-   *  @brief Iterate over Id/Properties sets
-   */
-  iterator begin () const
-  {
-    return m_properties_by_id.begin ();
-  }
-
-  /**
-   *  @brief Iterate over Id/Properties sets: end iterator
-   */
-  iterator end () const
-  {
-    return m_properties_by_id.end ();
-  }
-
   /**
    *  @brief Obtain the first properties id in the repository
    */
-  properties_id_type begin_id () 
+  properties_id_type begin_id () const
   {
     return 0;
   }
   
   /**
    *  @brief Obtain the last properties id in the repository plus 1
+   *
+   *  All Id's between begin_id and end_id are valid ones.
    */
-  properties_id_type end_id () 
+  properties_id_type end_id () const
   {
-    return m_properties_by_id.size ();
+    return properties_id_type (m_properties_by_id.size ());
   }
   
   /**
@@ -216,24 +197,175 @@ public:
       stat->add (typeid (*this), (void *) this, sizeof (*this), sizeof (*this), parent, purpose, cat);
     }
 
-    db::mem_stat (stat, purpose, cat, m_propnames_by_id, true, parent);
+    tl::MutexLocker locker (&m_lock);
+
+    m_propnames_by_id.mem_stat (stat, purpose, cat, parent);
     db::mem_stat (stat, purpose, cat, m_propname_ids_by_name, true, parent);
-    db::mem_stat (stat, purpose, cat, m_properties_by_id, true, parent);
+    m_properties_by_id.mem_stat (stat, purpose, cat, parent);
     db::mem_stat (stat, purpose, cat, m_properties_ids_by_set, true, parent);
     db::mem_stat (stat, purpose, cat, m_properties_component_table, true, parent);
   }
 
 private:
-  std::map <property_names_id_type, tl::Variant> m_propnames_by_id;
-  std::map <tl::Variant, property_names_id_type> m_propname_ids_by_name;
+  /**
+   *  @brief An append-only table with lock-free read access
+   *
+   *  The elements are kept in chunks of growing size (16, 32, 64, ...) which are
+   *  never reallocated, so references to elements stay valid. A new element is
+   *  published by incrementing the atomic size after it has been stored. Hence
+   *  all elements below size () can be read without a lock. Writers need to be
+   *  serialized by the caller.
+   */
+  template <class T>
+  class chunked_table
+  {
+  public:
+    chunked_table ()
+      : m_size (0)
+    {
+      for (unsigned int c = 0; c < max_chunks; ++c) {
+        mp_chunks [c] = 0;
+      }
+    }
+
+    ~chunked_table ()
+    {
+      clear ();
+    }
+
+    size_t size () const
+    {
+      return m_size.load ();
+    }
 
-  std::map <properties_id_type, properties_set> m_properties_by_id;
-  std::map <properties_set, properties_id_type> m_properties_ids_by_set;
-  std::map <name_value_pair, properties_id_vector> m_properties_component_table;
+    const T &operator[] (size_t i) const
+    {
+      unsigned int c = 0;
+      size_t o = locate (i, c);
+      return mp_chunks [c][o];
+    }
+
+    T &operator[] (size_t i)
+    {
+      unsigned int c = 0;
+      size_t o = locate (i, c);
+      return mp_chunks [c][o];
+    }
+
+    T &push_back (const T &t)
+    {
+      size_t n = m_size.load ();
+      unsigned int c = 0;
+      size_t o = locate (n, c);
+      tl_assert (c < max_chunks);
+      if (! mp_chunks [c]) {
+        mp_chunks [c] = new T [chunk_size (c)];
+      }
+      T &e = mp_chunks [c][o];
+      e = t;
+      m_size.store (n + 1);
+      return e;
+    }
+
+    void clear ()
+    {
+      m_size.store (0);
+      for (unsigned int c = 0; c < max_chunks; ++c) {
+        delete [] mp_chunks [c];
+        mp_chunks [c] = 0;
+      }
+    }
+
+    void assign (const chunked_table &other)
+    {
+      clear ();
+      for (size_t i = 0; i < other.size (); ++i) {
+        push_back (other [i]);
+      }
+    }
+
+    void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, void *parent) const
+    {
+      size_t n = size ();
+      for (unsigned int c = 0; c < max_chunks && mp_chunks [c]; ++c) {
+        size_t start = (((size_t) 1 << c) - 1) << base_bits;
+        size_t used = n > start ? std::min (n - start, chunk_size (c)) : 0;
+        stat->add (typeid (T []), (void *) mp_chunks [c], sizeof (T) * chunk_size (c), sizeof (T) * used, parent, purpose, cat);
+      }
+      for (size_t i = 0; i < n; ++i) {
+        db::mem_stat (stat, purpose, cat, (*this) [i], true, parent);
+      }
+    }
+
+  private:
+    enum { base_bits = 4, max_chunks = 48 };
+
+    atomic::atomic<size_t> m_size;
+    T *mp_chunks [max_chunks];
+
+    static size_t chunk_size (unsigned int c)
+    {
+      return (size_t) 1 << (c + base_bits);
+    }
+
+    //  chunk c holds the elements from 16 * (2^c - 1) to 16 * (2^(c+1) - 1) - 1
+    static size_t locate (size_t i, unsigned int &c)
+    {
+      for (size_t n = (i >> base_bits) + 1; n > 1; n >>= 1) {
+        ++c;
+      }
+      return i - ((((size_t) 1 << c) - 1) << base_bits);
+    }
+
+    chunked_table (const chunked_table &);
+    chunked_table &operator= (const chunked_table &);
+  };
+
+  struct variant_hash
+  {
+    size_t operator() (const tl::Variant &v) const
+    {
+      return v.hash ();
+    }
+  };
+
+  struct name_value_hash
+  {
+    size_t operator() (const name_value_pair &nv) const
+    {
+      return (size_t (nv.first) << 4) ^ (size_t (nv.first) >> 4) ^ nv.second.hash ();
+    }
+  };
+
+  //  the properties set index refers to the sets stored in m_properties_by_id (they never move)
+  struct properties_set_ptr_hash
+  {
+    size_t operator() (const properties_set *ps) const;
+  };
+
+  struct properties_set_ptr_equal
+  {
+    bool operator() (const properties_set *a, const properties_set *b) const
+    {
+      return *a == *b;
+    }
+  };
+
+  chunked_table<tl::Variant> m_propnames_by_id;
+  std::unordered_map <tl::Variant, property_names_id_type, variant_hash> m_propname_ids_by_name;
+
+  chunked_table<properties_set> m_properties_by_id;
+  std::unordered_map <const properties_set *, properties_id_type, properties_set_ptr_hash, properties_set_ptr_equal> m_properties_ids_by_set;
+  std::unordered_map <name_value_pair, properties_id_vector, name_value_hash> m_properties_component_table;
 
   db::LayoutStateModel *mp_state_model;
+  mutable tl::Mutex m_lock;
 
   PropertiesRepository (const PropertiesRepository &d);
+
+  property_names_id_type prop_name_id_unlocked (const tl::Variant &name);
+  std::pair<bool, properties_id_type> properties_id_unlocked (const properties_set &props);
+  void prop_ids_changed ();
 };
 
 /**
@@ -31,6 +31,8 @@
 #include "dbBoxScanner.h"
 #include "dbClip.h"
 #include "dbPolygonTools.h"
+#include "dbHierProcessor.h"
+#include "dbCoordArray.h"
 
 #include "tlVariant.h"
 
@@ -63,6 +65,20 @@ Region::Region (const RecursiveShapeIterator &si, const db::ICplxTrans &trans, b
   m_merged_semantics = merged_semantics;
 }
 
+Region::Region (const RecursiveShapeIterator &si, DeepShapeStore &dss, const db::ICplxTrans &trans)
+  : m_polygons (false), m_merged_polygons (false)
+{
+  init ();
+  set_deep_layer (dss.create_polygon_layer (si, trans));
+}
+
+Region::Region (const DeepLayer &dl)
+  : m_polygons (false), m_merged_polygons (false)
+{
+  init ();
+  set_deep_layer (dl);
+}
+
 bool  
 Region::operator== (const db::Region &other) const
 {
@@ -120,6 +136,16 @@ Region::size () const
   }
 }
 
+size_t
+Region::hier_count () const
+{
+  if (! has_valid_polygons ()) {
+    return db::count_shapes_hierarchically (m_iter);
+  } else {
+    return m_polygons.size ();
+  }
+}
+
 void 
 Region::set_strict_handling (bool f)
 {
@@ -340,6 +366,7 @@ Region::swap (Region &other)
   std::swap (m_merged_polygons_valid, other.m_merged_polygons_valid);
   std::swap (m_iter, other.m_iter);
   std::swap (m_iter_trans, other.m_iter_trans);
+  std::swap (m_deep_layer, other.m_deep_layer);
 }
 
 Region &
@@ -378,11 +405,17 @@ Region::merge (bool min_coherence, unsigned int min_wc)
       clear ();
     }
 
+  } else if (is_deep ()) {
+
+    run_deep (db::MergeLocalOperation (min_wc, min_coherence), 0);
+    m_is_merged = true;
+
   } else {
 
     invalidate_cache ();
 
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -438,6 +471,11 @@ Region::size (Region::coord_type dx, Region::coord_type dy, unsigned int mode)
     m_merged_polygons_valid = false;
     set_valid_polygons ();
 
+  } else if (is_deep ()) {
+
+    run_deep (db::SizingLocalOperation (dx, dy, mode, m_merged_semantics), 0);
+    m_is_merged = false;
+
   } else if (! m_merged_semantics) {
 
     invalidate_cache ();
@@ -463,6 +501,7 @@ Region::size (Region::coord_type dx, Region::coord_type dy, unsigned int mode)
 
     //  Generic case - the size operation will merge first
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -504,6 +543,11 @@ Region::operator&= (const Region &other)
 
     clear ();
 
+  } else if (is_deep_compatible (other)) {
+
+    run_deep (db::BoolAndOrNotLocalOperation (db::BooleanOp::And, m_merge_min_coherence), &other);
+    m_is_merged = true;
+
   } else if (is_box () && other.is_box ()) {
 
     //  Simplified handling for boxes
@@ -568,6 +612,7 @@ Region::operator&= (const Region &other)
 
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -614,6 +659,11 @@ Region::operator-= (const Region &other)
 
     //  Nothing to do
 
+  } else if (is_deep_compatible (other)) {
+
+    run_deep (db::BoolAndOrNotLocalOperation (db::BooleanOp::ANotB, m_merge_min_coherence), &other);
+    m_is_merged = true;
+
   } else if (! bbox ().overlaps (other.bbox ()) && ! m_strict_handling) {
 
     //  Nothing to do
@@ -624,6 +674,7 @@ Region::operator-= (const Region &other)
 
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -670,6 +721,11 @@ Region::operator^= (const Region &other)
 
     //  Nothing to do
 
+  } else if (is_deep_compatible (other)) {
+
+    run_deep (db::BoolAndOrNotLocalOperation (db::BooleanOp::Xor, m_merge_min_coherence), &other);
+    m_is_merged = true;
+
   } else if (! bbox ().overlaps (other.bbox ()) && ! m_strict_handling && ! other.strict_handling ()) {
 
     //  Simplified handling for disjunct case
@@ -681,6 +737,7 @@ Region::operator^= (const Region &other)
 
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -727,6 +784,11 @@ Region::operator|= (const Region &other)
 
     //  Nothing to do
 
+  } else if (is_deep_compatible (other)) {
+
+    run_deep (db::BoolAndOrNotLocalOperation (db::BooleanOp::Or, m_merge_min_coherence), &other);
+    m_is_merged = true;
+
   } else if (! bbox ().overlaps (other.bbox ()) && ! m_strict_handling && ! other.strict_handling ()) {
 
     //  Simplified handling for disjunct case
@@ -738,6 +800,7 @@ Region::operator|= (const Region &other)
 
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -826,6 +889,7 @@ Region
 Region::selected_interacting_generic (const Region &other, int mode, bool touching, bool inverse) const
 {
   db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+  ep.set_threads (m_threads);
 
   //  shortcut
   if (empty ()) {
@@ -897,6 +961,7 @@ Region::select_interacting_generic (const Region &other, int mode, bool touching
   }
 
   db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+  ep.set_threads (m_threads);
 
   for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
     if (p->box ().touches (bbox ())) {
@@ -956,6 +1021,12 @@ class region_to_edge_interaction_filter
   : public db::box_scanner_receiver<char, size_t>
 {
 public:
+  region_to_edge_interaction_filter ()
+    : mp_output (0), m_inverse (false)
+  {
+    //  .. nothing yet ..
+  }
+
   region_to_edge_interaction_filter (OutputContainer &output)
     : mp_output (&output), m_inverse (false)
   {
@@ -1005,7 +1076,9 @@ public:
           m_seen.erase (p);
         } else {
           m_seen.insert (p);
-          mp_output->insert (*p);
+          if (mp_output) {
+            mp_output->insert (*p);
+          }
         }
       }
 
@@ -1019,6 +1092,14 @@ public:
     }
   }
 
+  /**
+   *  @brief Gets the polygons found to interact so far (non-inverse mode)
+   */
+  const std::set<const db::Polygon *> &seen () const
+  {
+    return m_seen;
+  }
+
 private:
   OutputContainer *mp_output;
   std::set<const db::Polygon *> m_seen;
@@ -1048,6 +1129,44 @@ struct EdgeOrRegionBoxConverter
   }
 };
 
+/**
+ *  @brief Collects the polygons interacting with edges using multiple threads
+ *
+ *  The scanner needs to be filled with the polygons and edges as described for
+ *  region_to_edge_interaction_filter.
+ */
+static void
+collect_interacting_polygons (db::box_scanner<char, size_t> &scanner, unsigned int threads, std::set<const db::Polygon *> &interacting)
+{
+  //  a few strips per thread for better load balancing
+  size_t nstrips = size_t (threads) * 4;
+
+  std::vector<region_to_edge_interaction_filter<db::Shapes> *> filters;
+
+  try {
+
+    for (size_t i = 0; i < nstrips; ++i) {
+      filters.push_back (new region_to_edge_interaction_filter<db::Shapes> ());
+    }
+
+    scanner.process_parallel (filters, threads, 1, EdgeOrRegionBoxConverter ());
+
+    for (size_t i = 0; i < nstrips; ++i) {
+      interacting.insert (filters [i]->seen ().begin (), filters [i]->seen ().end ());
+    }
+
+  } catch (...) {
+    for (size_t i = 0; i < filters.size (); ++i) {
+      delete filters [i];
+    }
+    throw;
+  }
+
+  for (size_t i = 0; i < filters.size (); ++i) {
+    delete filters [i];
+  }
+}
+
 }
 
 Region
@@ -1079,7 +1198,18 @@ Region::selected_interacting_generic (const Edges &other, bool inverse) const
   Region output;
   EdgeOrRegionBoxConverter bc;
 
-  if (! inverse) {
+  if (m_threads > 1) {
+
+    std::set<const db::Polygon *> interacting;
+    collect_interacting_polygons (scanner, m_threads, interacting);
+
+    for (const_iterator p = begin_merged (); ! p.at_end (); ++p) {
+      if ((interacting.find (&*p) == interacting.end ()) == inverse) {
+        output.insert (*p);
+      }
+    }
+
+  } else if (! inverse) {
     region_to_edge_interaction_filter<Region> filter (output);
     scanner.process (filter, 1, bc);
   } else {
@@ -1120,7 +1250,18 @@ Region::select_interacting_generic (const Edges &other, bool inverse)
   db::Shapes output (false);
   EdgeOrRegionBoxConverter bc;
 
-  if (! inverse) {
+  if (m_threads > 1) {
+
+    std::set<const db::Polygon *> interacting;
+    collect_interacting_polygons (scanner, m_threads, interacting);
+
+    for (const_iterator p = begin_merged (); ! p.at_end (); ++p) {
+      if ((interacting.find (&*p) == interacting.end ()) == inverse) {
+        output.insert (*p);
+      }
+    }
+
+  } else if (! inverse) {
     region_to_edge_interaction_filter<db::Shapes> filter (output);
     scanner.process (filter, 1, bc);
   } else {
@@ -1326,6 +1467,7 @@ void
 Region::init ()
 {
   m_report_progress = false;
+  m_threads = 0;
   m_bbox_valid = true;
   m_is_merged = true;
   m_merged_semantics = true;
@@ -1387,6 +1529,7 @@ Region::ensure_valid_polygons () const
 
     //  set valid polygons
     m_iter = db::RecursiveShapeIterator ();
+    m_deep_layer = db::DeepLayer ();
 
   }
 }
@@ -1395,6 +1538,62 @@ void
 Region::set_valid_polygons ()
 {
   m_iter = db::RecursiveShapeIterator ();
+  m_deep_layer = db::DeepLayer ();
+}
+
+void
+Region::set_deep_layer (const db::DeepLayer &dl)
+{
+  m_polygons.clear ();
+  m_merged_polygons.clear ();
+  m_merged_polygons_valid = false;
+  m_bbox_valid = false;
+  m_is_merged = false;
+
+  m_iter = dl.iter ();
+  m_iter_trans = db::ICplxTrans ();
+  m_deep_layer = dl;
+}
+
+bool
+Region::is_deep_compatible (const Region &other) const
+{
+  return is_deep () && other.is_deep () && m_deep_layer.is_compatible (other.m_deep_layer);
+}
+
+void
+Region::run_deep (const db::LocalOperation &op, const Region *other)
+{
+  db::DeepLayer dl_out = m_deep_layer.derived ();
+
+  db::LocalProcessor proc (&m_deep_layer.layout (), &m_deep_layer.initial_cell ());
+  proc.set_report_progress (m_report_progress);
+  proc.set_description (m_progress_desc);
+
+  if (other) {
+    proc.run (op, m_deep_layer.layer (), other->m_deep_layer.layer (), dl_out.layer ());
+  } else {
+    proc.run (op, m_deep_layer.layer (), dl_out.layer ());
+  }
+
+  if (! proc.variants ().empty ()) {
+    m_deep_layer.store ()->add_variants (m_deep_layer, proc.variants ());
+  }
+
+  set_deep_layer (dl_out);
+}
+
+void
+Region::insert_into (db::Layout *layout, db::cell_index_type into_cell, unsigned int into_layer) const
+{
+  if (is_deep ()) {
+    m_deep_layer.store ()->insert (m_deep_layer, *layout, into_cell, into_layer);
+  } else {
+    db::Shapes &shapes = layout->cell (into_cell).shapes (into_layer);
+    for (const_iterator p = begin (); ! p.at_end (); ++p) {
+      shapes.insert (*p);
+    }
+  }
 }
 
 void 
@@ -1449,6 +1648,7 @@ Region::ensure_merged_polygons_valid () const
     m_merged_polygons.clear ();
 
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -1507,6 +1707,48 @@ Region::insert (const db::Polygon &polygon)
   }
 }
 
+void
+Region::insert_boxes (const db::Coord *coords, size_t n)
+{
+  if (n > 0) {
+
+    ensure_valid_polygons ();
+    reserve (m_polygons.size () + n);
+
+    for (db::packed_box_iterator b (coords), e (coords + 4 * n); b != e; ++b) {
+      db::Box box = *b;
+      if (! box.empty () && box.width () > 0 && box.height () > 0) {
+        m_polygons.insert (db::Polygon (box));
+      }
+    }
+
+    m_is_merged = false;
+    invalidate_cache ();
+
+  }
+}
+
+void
+Region::insert_polygons (const db::Coord *points, const size_t *counts, const size_t *holes, size_t n)
+{
+  if (n > 0) {
+
+    ensure_valid_polygons ();
+    reserve (m_polygons.size () + n);
+
+    for (db::packed_polygon_iterator p (points, counts, holes), e (n); p != e; ++p) {
+      db::Polygon poly = *p;
+      if (poly.holes () > 0 || poly.vertices () > 0) {
+        m_polygons.insert (poly);
+      }
+    }
+
+    m_is_merged = false;
+    invalidate_cache ();
+
+  }
+}
+
 void 
 Region::insert (const db::SimplePolygon &polygon)
 {
@@ -1544,6 +1786,7 @@ Region::clear ()
   m_merged_polygons_valid = true;
   m_iter = db::RecursiveShapeIterator ();
   m_iter_trans = db::ICplxTrans ();
+  m_deep_layer = db::DeepLayer ();
 }
 
 namespace {
@@ -1557,7 +1800,7 @@ class Edge2EdgeCheck
 public:
   Edge2EdgeCheck (const EdgeRelationFilter &check, EdgePairs &output, bool different_polygons, bool requires_different_layers)
     : mp_check (&check), mp_output (&output), m_requires_different_layers (requires_different_layers), m_different_polygons (different_polygons), 
-      m_pass (0)
+      m_pass (0), mp_violations (this)
   {
     m_distance = check.distance ();
   }
@@ -1591,6 +1834,52 @@ public:
     return false;
   }
   
+  /**
+   *  @brief Takes over the violations found by another checker in the first pass
+   *
+   *  This method is used for multi-threaded checks where each thread uses its own
+   *  checker. After the first pass, the violations are collected in one checker.
+   */
+  void join_violations (Edge2EdgeCheck &other)
+  {
+    size_t offset = m_ep.size ();
+    m_ep.insert (m_ep.end (), other.m_ep.begin (), other.m_ep.end ());
+    for (std::multimap<std::pair<db::Edge, size_t>, size_t>::const_iterator i = other.m_e2ep.begin (); i != other.m_e2ep.end (); ++i) {
+      m_e2ep.insert (std::make_pair (i->first, i->second + offset));
+    }
+
+    other.m_ep.clear ();
+    other.m_e2ep.clear ();
+  }
+
+  /**
+   *  @brief Prepares the second pass with the violations collected in the given checker
+   *
+   *  After this method was called, this checker will use the violations of the
+   *  given one for the shielding test. It needs to be called after "prepare_next_pass" 
+   *  was called on the given checker.
+   */
+  void share_violations (const Edge2EdgeCheck &other)
+  {
+    mp_violations = &other;
+    m_pass = other.m_pass;
+    m_ep_discarded.clear ();
+    m_ep_discarded.resize (other.m_ep.size (), false);
+  }
+
+  /**
+   *  @brief Takes over the discarded flags from another checker after the second pass
+   */
+  void join_discarded (const Edge2EdgeCheck &other)
+  {
+    tl_assert (other.m_ep_discarded.size () == m_ep_discarded.size ());
+    for (size_t i = 0; i < m_ep_discarded.size (); ++i) {
+      if (other.m_ep_discarded [i]) {
+        m_ep_discarded [i] = true;
+      }
+    }
+  }
+
   void add (const db::Edge *o1, size_t p1, const db::Edge *o2, size_t p2)
   { 
     if (m_pass == 0) {
@@ -1632,7 +1921,8 @@ public:
       for (unsigned int p = 0; p < 2; ++p) {
 
         std::pair<db::Edge, size_t> k (*o1, p1);
-        for (std::multimap<std::pair<db::Edge, size_t>, size_t>::const_iterator i = m_e2ep.find (k); i != m_e2ep.end () && i->first == k; ++i) {
+        const std::multimap<std::pair<db::Edge, size_t>, size_t> &e2ep = mp_violations->m_e2ep;
+        for (std::multimap<std::pair<db::Edge, size_t>, size_t>::const_iterator i = e2ep.find (k); i != e2ep.end () && i->first == k; ++i) {
           n1.push_back (i->second);
         }
 
@@ -1651,7 +1941,7 @@ public:
 
         for (std::vector<size_t>::const_iterator i = nn.begin (); i != nn.end (); ++i) {
           if (! m_ep_discarded [*i]) {
-            db::EdgePair ep = m_ep [*i].normalized ();
+            db::EdgePair ep = mp_violations->m_ep [*i].normalized ();
             if (db::Edge (ep.first ().p1 (), ep.second ().p2 ()).intersect (*o2) && 
                 db::Edge (ep.second ().p1 (), ep.first ().p2 ()).intersect (*o2)) {
               m_ep_discarded [*i] = true;
@@ -1719,6 +2009,7 @@ private:
   std::multimap<std::pair<db::Edge, size_t>, size_t> m_e2ep;
   std::vector<bool> m_ep_discarded;
   unsigned int m_pass;
+  const Edge2EdgeCheck *mp_violations;
 };
 
 /**
@@ -1798,6 +2089,101 @@ private:
   std::vector<db::Edge> m_edges;
 };
 
+/**
+ *  @brief A box scanner receiver for the single-polygon checks
+ *
+ *  This receiver ignores the interactions between polygons and performs the 
+ *  intra-polygon check when a polygon is finished.
+ */
+class SinglePolygonCheck
+  : public db::box_scanner_receiver<db::Polygon, size_t>
+{
+public:
+  SinglePolygonCheck (Poly2PolyCheck &check)
+    : mp_check (&check)
+  {
+    //  .. nothing yet ..
+  }
+
+  void finish (const db::Polygon *o, size_t p)
+  {
+    mp_check->finish (o, p);
+  }
+
+private:
+  Poly2PolyCheck *mp_check;
+};
+
+/**
+ *  @brief Runs a check on the polygons of the scanner using multiple threads
+ *
+ *  Each strip of the parallel box scanner uses its own checkers. After the first pass,
+ *  the violations are collected in the first checker. The shielding pass then uses
+ *  these violations in all strips and the discarded flags are combined again.
+ */
+static void
+run_parallel_check (db::box_scanner<db::Polygon, size_t> &scanner, db::Coord enl, bool single_polygon, unsigned int threads, const EdgeRelationFilter &check, EdgePairs &result, bool different_polygons, bool requires_different_layers)
+{
+  //  a few strips per thread for better load balancing
+  size_t nstrips = size_t (threads) * 4;
+
+  std::vector<Edge2EdgeCheck *> edge_checks;
+  std::vector<Poly2PolyCheck *> poly_checks;
+  std::vector<SinglePolygonCheck *> single_checks;
+
+  try {
+
+    for (size_t i = 0; i < nstrips; ++i) {
+      edge_checks.push_back (new Edge2EdgeCheck (check, result, different_polygons, requires_different_layers));
+      poly_checks.push_back (new Poly2PolyCheck (*edge_checks.back ()));
+      single_checks.push_back (new SinglePolygonCheck (*poly_checks.back ()));
+    }
+
+    Edge2EdgeCheck &first = *edge_checks.front ();
+
+    unsigned int pass = 0;
+    do {
+
+      if (pass > 0) {
+        for (size_t i = 1; i < nstrips; ++i) {
+          edge_checks [i]->share_violations (first);
+        }
+      }
+
+      if (single_polygon) {
+        scanner.process_parallel (single_checks, threads, enl, db::box_convert<db::Polygon> ());
+      } else {
+        scanner.process_parallel (poly_checks, threads, enl, db::box_convert<db::Polygon> ());
+      }
+
+      for (size_t i = 1; i < nstrips; ++i) {
+        if (pass == 0) {
+          first.join_violations (*edge_checks [i]);
+        } else {
+          first.join_discarded (*edge_checks [i]);
+        }
+      }
+
+      ++pass;
+
+    } while (first.prepare_next_pass ());
+
+  } catch (...) {
+    for (size_t i = 0; i < edge_checks.size (); ++i) {
+      delete single_checks [i];
+      delete poly_checks [i];
+      delete edge_checks [i];
+    }
+    throw;
+  }
+
+  for (size_t i = 0; i < edge_checks.size (); ++i) {
+    delete single_checks [i];
+    delete poly_checks [i];
+    delete edge_checks [i];
+  }
+}
+
 }
 
 EdgePairs 
@@ -1831,6 +2217,11 @@ Region::run_check (db::edge_relation_type rel, bool different_polygons, const Re
   check.set_min_projection (min_projection);
   check.set_max_projection (max_projection);
 
+  if (m_threads > 1) {
+    run_parallel_check (scanner, d, false, m_threads, check, result, different_polygons, other != 0);
+    return result;
+  }
+
   Edge2EdgeCheck edge_check (check, result, different_polygons, other != 0);
   Poly2PolyCheck poly_check (edge_check);
 
@@ -1852,6 +2243,24 @@ Region::run_single_polygon_check (db::edge_relation_type rel, db::Coord d, bool
   check.set_min_projection (min_projection);
   check.set_max_projection (max_projection);
 
+  if (m_threads > 1) {
+
+    //  the polygons are independent, so the scanner is only used to distribute them over the threads
+    db::box_scanner<db::Polygon, size_t> scanner (m_report_progress, m_progress_desc);
+    scanner.reserve (size ());
+
+    ensure_valid_merged_polygons ();
+    size_t n = 0;
+    for (const_iterator p = begin_merged (); ! p.at_end (); ++p) {
+      scanner.insert (&*p, n); 
+      n += 2;
+    }
+
+    run_parallel_check (scanner, 0, true, m_threads, check, result, false, false);
+    return result;
+
+  }
+
   Edge2EdgeCheck edge_check (check, result, false, false);
   Poly2PolyCheck poly_check (edge_check);
 
@@ -38,11 +38,14 @@
 #include "dbEdges.h"
 #include "dbRecursiveShapeIterator.h"
 #include "dbEdgePairs.h"
+#include "dbDeepShapeStore.h"
 #include "tlString.h"
 #include "gsiObject.h"
 
 namespace db {
 
+class LocalOperation;
+
 /**
  *  @brief A perimeter filter for use with Region::filter or Region::filtered
  *
@@ -475,6 +478,26 @@ public:
    */
   Region (const RecursiveShapeIterator &si, const db::ICplxTrans &trans, bool merged_semantics = true);
 
+  /**
+   *  @brief Constructor from a RecursiveShapeIterator creating a deep region
+   *
+   *  Creates a hierarchical ("deep") region: the shapes are copied into a working layout
+   *  inside the given deep shape store, preserving the cell hierarchy. Boolean operations, 
+   *  merge and sizing between deep regions of the same store are performed hierarchically.
+   *  Other operations will work on the flat representation.
+   *
+   *  The transformation must be a pure magnification. The store must live longer than
+   *  the region.
+   */
+  Region (const RecursiveShapeIterator &si, DeepShapeStore &dss, const db::ICplxTrans &trans = db::ICplxTrans ());
+
+  /**
+   *  @brief Constructor from a deep layer
+   *
+   *  Creates a deep region representing the given layer.
+   */
+  explicit Region (const DeepLayer &dl);
+
   /**
    *  @brief Enable progress reporting
    *
@@ -487,6 +510,26 @@ public:
    */
   void disable_progress ();
 
+  /**
+   *  @brief Sets the number of threads to use for operations which support multi-threading
+   *
+   *  Currently, the scanline-based operations (booleans, merge, sizing), the DRC checks
+   *  and the selection of polygons interacting with edges can make use of multiple threads 
+   *  for large inputs. 0 or 1 means single-threaded operation (the default).
+   */
+  void set_threads (unsigned int n)
+  {
+    m_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads
+   */
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Iterator of the region
    *
@@ -561,6 +604,23 @@ public:
     }
   }
 
+  /**
+   *  @brief Inserts boxes from a packed coordinate block
+   *
+   *  "coords" holds n left, bottom, right and top coordinate quadruples.
+   *  Like for "insert", empty boxes are skipped. This method is much faster than
+   *  inserting the boxes one by one.
+   */
+  void insert_boxes (const db::Coord *coords, size_t n);
+
+  /**
+   *  @brief Inserts polygons from a packed coordinate block
+   *
+   *  See db::Shapes::insert_polygons for a description of the arguments.
+   *  Like for "insert", empty polygons are skipped.
+   */
+  void insert_polygons (const db::Coord *points, const size_t *counts, const size_t *holes, size_t n);
+
   /**
    *  @brief Returns true if the region is empty
    */
@@ -574,6 +634,15 @@ public:
    */
   size_t size () const;
 
+  /**
+   *  @brief Returns the number of polygons in the region the hierarchical way
+   *
+   *  For regions delivered from a layout, polygons inside cells are counted once, regardless
+   *  how often the cell is instantiated. This count can be obtained without flattening the
+   *  hierarchy, but it is an estimate only. See db::count_shapes_hierarchically for details.
+   */
+  size_t hier_count () const;
+
   /**
    *  @brief Returns a string representing the region
    *
@@ -1515,6 +1584,35 @@ public:
     return db::RecursiveShapeIterator (m_iter).at_end ();
   }
 
+  /**
+   *  @brief Returns true, if the region is a hierarchical ("deep") region
+   *
+   *  A region stops being a deep region once it is modified by a
+   *  flat operation or converted into a flat polygon set.
+   */
+  bool is_deep () const
+  {
+    return m_deep_layer.is_valid ();
+  }
+
+  /**
+   *  @brief Gets the deep layer
+   *
+   *  The deep layer is valid only if the region is a deep region.
+   */
+  const db::DeepLayer &deep_layer () const
+  {
+    return m_deep_layer;
+  }
+
+  /**
+   *  @brief Inserts the region's polygons into the given layout, cell and layer
+   *
+   *  For deep regions the polygons are inserted hierarchically. Otherwise, 
+   *  the polygons are inserted into the given cell.
+   */
+  void insert_into (db::Layout *layout, db::cell_index_type into_cell, unsigned int into_layer) const;
+
   /**
    *  @brief Gets the internal iterator
    *
@@ -1575,8 +1673,13 @@ private:
   db::ICplxTrans m_iter_trans;
   bool m_report_progress;
   std::string m_progress_desc;
+  unsigned int m_threads;
+  mutable db::DeepLayer m_deep_layer;
 
   void init ();
+  void set_deep_layer (const db::DeepLayer &dl);
+  bool is_deep_compatible (const Region &other) const;
+  void run_deep (const db::LocalOperation &op, const Region *other);
   void invalidate_cache ();
   void set_valid_polygons ();
   void ensure_bbox_valid () const;
@@ -0,0 +1,198 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_dbShapeHash
+#define HDR_dbShapeHash
+
+#include "dbTypes.h"
+
+#include <string>
+#include <functional>
+#include <cmath>
+#include <stdint.h>
+
+namespace db
+{
+  template <class C> class point;
+  template <class C> class vector;
+  template <class C> class text;
+  template <class C> class path;
+  template <class C> class polygon_contour;
+  template <class C> class polygon;
+  template <class C> class simple_polygon;
+}
+
+/**
+ *  This header defines the hash functions for the basic geometrical objects
+ *  for use with std::unordered_map and std::unordered_set. 
+ *
+ *  In contrast to dbHash.h, this header does not require the object
+ *  declarations and can be used inside the basic headers (i.e. for 
+ *  the shape repository).
+ */
+
+namespace std
+{
+  template <class T>
+  inline size_t hfunc (const T &t)
+  {
+    hash <T> hf;
+    return hf (t);
+  }
+
+  inline size_t hcombine (size_t h1, size_t h2)
+  {
+    return (h1 << 4) ^ (h1 >> 4) ^ h2;
+  }
+
+  template <class T>
+  inline size_t hfunc (const T &t, size_t h)
+  {
+    hash <T> hf;
+    return hcombine (h, hf (t));
+  }
+
+  inline size_t hfunc_coord (db::DCoord d)
+  {
+    return hfunc (int64_t (floor (0.5 + d / db::coord_traits<db::DCoord>::prec ())));
+  }
+
+  inline size_t hfunc_coord (db::Coord d)
+  {
+    return hfunc (d);
+  }
+
+  template <class C>
+  inline size_t hfunc_coord (C d, size_t h)
+  {
+    return hcombine (hfunc_coord (d), h);
+  }
+
+  /**
+   *  @brief Hash value for a point
+   */
+  template <class C>
+  struct hash <db::point<C> >
+  {
+    size_t operator() (const db::point<C> &o) const
+    {
+      return hfunc_coord (o.x (), hfunc_coord (o.y ()));
+    }
+  };
+
+  /**
+   *  @brief Hash value for a vector
+   */
+  template <class C>
+  struct hash <db::vector<C> >
+  {
+    size_t operator() (const db::vector<C> &o) const
+    {
+      return hfunc_coord (o.x (), hfunc_coord (o.y ()));
+    }
+  };
+
+  /**
+   *  @brief Hash value for a text object
+   */
+  template <class C>
+  struct hash <db::text<C> >
+  {
+    size_t operator() (const db::text<C> &o) const
+    {
+      size_t h = hfunc (int (o.halign ()));
+      h = hfunc (int (o.valign ()), h);
+      h = hfunc (o.trans ().rot (), h);
+      h = hfunc (o.trans ().disp (), h);
+      //  NOTE: using std::string for the value makes sure the default hasher doesn't use the pointer value
+      h = hfunc (hfunc (std::string (o.string ())), h);
+      return h;
+    }
+  };
+
+  /**
+   *  @brief Hash value for a path
+   */
+  template <class C>
+  struct hash <db::path<C> >
+  {
+    size_t operator() (const db::path<C> &o) const
+    {
+      size_t h = hfunc (int (o.round ()));
+      h = hfunc_coord (o.bgn_ext (), h);
+      h = hfunc_coord (o.end_ext (), h);
+      h = hfunc_coord (o.width (), h);
+      for (typename db::path<C>::iterator p = o.begin (); p != o.end (); ++p) {
+        h = hfunc (*p, h);
+      }
+      return h;
+    }
+  };
+
+  /**
+   *  @brief Hash value for a polygon contour
+   */
+  template <class C>
+  struct hash <db::polygon_contour<C> >
+  {
+    size_t operator() (const db::polygon_contour<C> &o) const
+    {
+      size_t h = 0;
+      for (typename db::polygon_contour<C>::simple_iterator i = o.begin (); i != o.end (); ++i) {
+        h = hfunc (*i, h);
+      }
+      return h;
+    }
+  };
+
+  /**
+   *  @brief Hash value for a polygon
+   */
+  template <class C>
+  struct hash <db::polygon<C> >
+  {
+    size_t operator() (const db::polygon<C> &o) const
+    {
+      size_t h = hfunc (o.hull ());
+      for (size_t i = 0; i < o.holes (); ++i) {
+        h = hfunc (o.hole (int (i)), h);
+      }
+      return h;
+    }
+  };
+
+  /**
+   *  @brief Hash value for a simple polygon
+   */
+  template <class C>
+  struct hash <db::simple_polygon<C> >
+  {
+    size_t operator() (const db::simple_polygon<C> &o) const
+    {
+      return hfunc (o.hull ());
+    }
+  };
+
+}
+
+#endif
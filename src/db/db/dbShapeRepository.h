@@ -30,8 +30,14 @@
 #include "dbTrans.h"
 #include "dbBox.h"
 #include "dbMemStatistics.h"
+#include "dbShapeHash.h"
+#include "dbContourArena.h"
+#include "tlAssert.h"
 
-#include <set>
+#include <deque>
+#include <vector>
+#include <limits>
+#include <stdint.h>
 
 namespace db {
 
@@ -48,6 +54,16 @@ template <class C> class user_object;
  *  The repository is basically a set of shapes that
  *  can be used to store duplicates of shapes in an
  *  efficient way.
+ *
+ *  The shapes are kept in a container delivering stable pointers.
+ *  The lookup is implemented by a hash table with open addressing
+ *  (linear probing). Each slot holds 32 bits of the hash value and 
+ *  the 32 bit index of the shape in the container, so full shape 
+ *  comparisons are only required for shapes with the same hash value.
+ *  The table is kept filled to 80% at most.
+ *
+ *  If an arena is set, the point arrays of the shapes stored in the
+ *  repository are allocated from this arena.
  */
 
 template <class Sh>
@@ -55,14 +71,14 @@ class repository
 {
 public:
   typedef typename Sh::coord_type coord_type;
-  typedef std::set<Sh> set_type;
-  typedef typename set_type::const_iterator iterator;
+  typedef std::deque<Sh> container_type;
+  typedef typename container_type::const_iterator iterator;
 
   /** 
    *  @brief The standard constructor
    */
   repository ()
-    : m_set ()
+    : m_shapes (), m_table (), mp_arena (0)
   {
     //  .. nothing yet ..
   }
@@ -71,9 +87,24 @@ public:
    *  @brief The copy constructor
    */
   repository (const repository<Sh> &d)
-    : m_set (d.m_set)
+    : m_shapes (), m_table (), mp_arena (0)
   {
-    //  .. nothing yet ..
+    operator= (d);
+  }
+
+  /** 
+   *  @brief Assignment
+   */
+  repository<Sh> &operator= (const repository<Sh> &d)
+  {
+    if (this != &d) {
+      m_shapes.clear ();
+      m_table.clear ();
+      for (iterator s = d.begin (); s != d.end (); ++s) {
+        insert (*s);
+      }
+    }
+    return *this;
   }
 
   /**
@@ -85,8 +116,40 @@ public:
    */
   const Sh *insert (const Sh &shape)
   {
-    typename std::set<Sh>::iterator f = m_set.insert (shape).first;
-    return &(*f);
+    if ((m_shapes.size () + 1) * 5 > m_table.size () * 4) {
+      rehash (m_table.empty () ? size_t (16) : m_table.size () * 2);
+    }
+
+    uint32_t h = hash_value (shape);
+    size_t mask = m_table.size () - 1;
+
+    for (size_t i = h & mask; ; i = (i + 1) & mask) {
+
+      entry_type &e = m_table [i];
+
+      if (! e.index) {
+        tl_assert (m_shapes.size () < std::numeric_limits<uint32_t>::max ());
+        db::ContourArenaScope arena_scope (mp_arena);
+        m_shapes.push_back (shape);
+        e.hash = h;
+        e.index = uint32_t (m_shapes.size ());
+        return &m_shapes.back ();
+      } else if (e.hash == h && m_shapes [e.index - 1] == shape) {
+        return &m_shapes [e.index - 1];
+      }
+
+    }
+  }
+
+  /**
+   *  @brief Sets the arena from which the shapes' point arrays are allocated
+   *
+   *  The arena is not owned by the repository. Passing 0 will make the
+   *  repository allocate the point arrays from the heap.
+   */
+  void set_arena (db::ContourArena *arena)
+  {
+    mp_arena = arena;
   }
 
   /**
@@ -94,15 +157,17 @@ public:
    */
   size_t size () const
   {
-    return m_set.size ();
+    return m_shapes.size ();
   }
 
   /**
    *  @brief begin iterator of the repository
+   *
+   *  The shapes are delivered in the order they have been inserted.
    */
   iterator begin () const
   {
-    return m_set.begin ();
+    return m_shapes.begin ();
   }
 
   /**
@@ -110,16 +175,66 @@ public:
    */
   iterator end () const
   {
-    return m_set.end ();
+    return m_shapes.end ();
   }
 
   void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self, void *parent) const
   {
-    db::mem_stat (stat, purpose, cat, m_set, no_self, parent);
+    if (! no_self) {
+      stat->add (typeid (repository<Sh>), (void *) this, sizeof (repository<Sh>), sizeof (repository<Sh>), parent, purpose, cat);
+    }
+    db::mem_stat (stat, purpose, cat, m_table, true, (void *) this);
+    for (iterator s = m_shapes.begin (); s != m_shapes.end (); ++s) {
+      db::mem_stat (stat, purpose, cat, *s, false, (void *) this);
+    }
   }
 
 private:
-  set_type m_set;
+  /**
+   *  @brief A hash table slot
+   *
+   *  "index" is the index of the shape in the container plus one. 0 indicates an empty slot.
+   */
+  struct entry_type
+  {
+    entry_type () : hash (0), index (0) { }
+
+    uint32_t hash;
+    uint32_t index;
+  };
+
+  container_type m_shapes;
+  std::vector<entry_type> m_table;
+  db::ContourArena *mp_arena;
+
+  static uint32_t hash_value (const Sh &shape)
+  {
+    //  scramble the bits since the table index is taken from the lower bits
+    size_t hf = std::hfunc (shape);
+    uint32_t h = uint32_t (hf ^ (hf >> 16 >> 16));
+    h ^= (h >> 16);
+    h *= uint32_t (0x85ebca6b);
+    h ^= (h >> 13);
+    return h;
+  }
+
+  void rehash (size_t n)
+  {
+    std::vector<entry_type> table (n);
+    size_t mask = n - 1;
+
+    for (typename std::vector<entry_type>::const_iterator e = m_table.begin (); e != m_table.end (); ++e) {
+      if (e->index) {
+        size_t i = e->hash & mask;
+        while (table [i].index) {
+          i = (i + 1) & mask;
+        }
+        table [i] = *e;
+      }
+    }
+
+    m_table.swap (table);
+  }
 };
 
 /**
@@ -176,6 +291,15 @@ public:
     return m_text_repository;
   }
 
+  /**
+   *  @brief Sets the arena from which the polygon contours are allocated
+   */
+  void set_arena (db::ContourArena *arena)
+  {
+    m_polygon_repository.set_arena (arena);
+    m_simple_polygon_repository.set_arena (arena);
+  }
+
   void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self, void *parent) const
   {
     db::mem_stat (stat, purpose, cat, m_polygon_repository, no_self, parent);
@@ -27,9 +27,13 @@
 #include "dbShapes2.h"
 #include "dbTrans.h"
 #include "dbUserObject.h"
+#include "dbCoordArray.h"
 #include "dbLayout.h"
 
 #include <limits>
+#include <map>
+#include <set>
+#include <algorithm>
 
 namespace db
 {
@@ -159,7 +163,9 @@ void
 Shapes::insert (const Shapes &d)
 {
   //  no undo support for this currently
-  tl_assert (! manager () || ! manager ()->transacting ());
+  if (manager () && manager ()->transacting ()) {
+    throw tl::Exception (tl::to_string (tr ("Function 'compact' cannot be used inside a transaction (it does not support undo)")));
+  }
   do_insert (d);
 }
 
@@ -196,6 +202,22 @@ Shapes::do_insert (const Shapes &d)
   }
 }
 
+void
+Shapes::insert_boxes (const coord_type *coords, size_t n)
+{
+  if (n > 0) {
+    insert (db::packed_box_iterator (coords), db::packed_box_iterator (coords + 4 * n));
+  }
+}
+
+void
+Shapes::insert_polygons (const coord_type *points, const size_t *counts, const size_t *holes, size_t n)
+{
+  if (n > 0) {
+    insert (db::packed_polygon_iterator (points, counts, holes), db::packed_polygon_iterator (n));
+  }
+}
+
 //  get the shape repository associated with this container
 db::GenericRepository &
 Shapes::shape_repository () const 
@@ -889,6 +911,254 @@ Shapes::clear ()
   }
 }
 
+// -------------------------------------------------------------------------------
+//  Shapes::compact implementation
+
+namespace
+{
+
+/**
+ *  @brief Describes the array which is formed by a group of displacements
+ */
+struct CompactArraySpec
+{
+  CompactArraySpec () : regular (false), na (0), nb (0) { }
+
+  db::Vector o;
+  bool regular;
+  db::Vector a, b;
+  unsigned long na, nb;
+  db::iterated_array<db::Coord> iterated;
+};
+
+/**
+ *  @brief Returns true if the given coordinates are equally spaced
+ *
+ *  "d" receives the spacing. It is left unchanged if there is a single coordinate only.
+ */
+static bool
+is_equidistant (const std::set<db::Coord> &c, db::Coord &d)
+{
+  if (c.size () < 2) {
+    return true;
+  }
+
+  std::set<db::Coord>::const_iterator i = c.begin ();
+  db::Coord c0 = *i;
+  d = *++i - c0;
+
+  for ( ; i != c.end (); ++i) {
+    if (*i - c0 != d) {
+      return false;
+    }
+    c0 = *i;
+  }
+
+  return true;
+}
+
+/**
+ *  @brief Computes the array specification for a group of displacements
+ *
+ *  If the displacements form a complete and regular grid, a regular
+ *  array is specified. Otherwise an iterated array is formed.
+ */
+static void
+make_array_spec (std::vector<db::Vector> &d, CompactArraySpec &spec)
+{
+  std::sort (d.begin (), d.end ());
+
+  std::set<db::Coord> xs, ys;
+  for (std::vector<db::Vector>::const_iterator i = d.begin (); i != d.end (); ++i) {
+    xs.insert (i->x ());
+    ys.insert (i->y ());
+  }
+
+  spec.o = db::Vector (*xs.begin (), *ys.begin ());
+
+  //  the grid is complete if there are no duplicates and as many displacements as grid points
+  bool regular = (std::adjacent_find (d.begin (), d.end ()) == d.end () && xs.size () * ys.size () == d.size ());
+
+  db::Coord dx = 1, dy = 1;
+  if (regular) {
+    regular = is_equidistant (xs, dx) && is_equidistant (ys, dy);
+  }
+
+  if (regular) {
+    spec.regular = true;
+    spec.a = db::Vector (dx, 0);
+    spec.b = db::Vector (0, dy);
+    spec.na = (unsigned long) xs.size ();
+    spec.nb = (unsigned long) ys.size ();
+  } else {
+    spec.regular = false;
+    spec.iterated.reserve (d.size ());
+    for (std::vector<db::Vector>::const_iterator i = d.begin (); i != d.end (); ++i) {
+      spec.iterated.insert (*i - spec.o);
+    }
+    spec.iterated.sort ();
+  }
+}
+
+}
+
+template <class Ref, class PtrArray>
+static size_t
+compact_polygon_refs (db::Shapes &shapes, db::layer<Ref, db::unstable_layer_tag> &layer, db::ArrayRepository &array_rep, size_t min_count)
+{
+  typedef typename Ref::shape_type shape_type;
+  typedef typename PtrArray::object_type ptr_type;
+
+  std::map<const shape_type *, std::vector<db::Vector> > groups;
+  for (typename db::layer<Ref, db::unstable_layer_tag>::iterator s = layer.begin (); s != layer.end (); ++s) {
+    groups [&s->obj ()].push_back (s->trans ().disp ());
+  }
+
+  std::vector<Ref> remaining;
+  size_t n = 0;
+
+  for (typename std::map<const shape_type *, std::vector<db::Vector> >::iterator g = groups.begin (); g != groups.end (); ++g) {
+    if (g->second.size () >= min_count) {
+      n += g->second.size ();
+    }
+  }
+
+  if (n == 0) {
+    return 0;
+  }
+
+  for (typename db::layer<Ref, db::unstable_layer_tag>::iterator s = layer.begin (); s != layer.end (); ++s) {
+    if (groups [&s->obj ()].size () < min_count) {
+      remaining.push_back (*s);
+    }
+  }
+
+  //  NOTE: swapping with a new layer releases the memory of the old one
+  db::layer<Ref, db::unstable_layer_tag> new_layer;
+  new_layer.insert (remaining.begin (), remaining.end ());
+  layer.swap (new_layer);
+
+  for (typename std::map<const shape_type *, std::vector<db::Vector> >::iterator g = groups.begin (); g != groups.end (); ++g) {
+
+    if (g->second.size () < min_count) {
+      continue;
+    }
+
+    CompactArraySpec spec;
+    make_array_spec (g->second, spec);
+
+    ptr_type ptr (g->first, typename ptr_type::trans_type ());
+    if (spec.regular) {
+      shapes.insert (PtrArray (ptr, db::Disp (spec.o), array_rep, spec.a, spec.b, spec.na, spec.nb));
+    } else {
+      shapes.insert (PtrArray (ptr, db::Disp (spec.o), array_rep.insert (spec.iterated)));
+    }
+
+  }
+
+  return n;
+}
+
+static size_t
+compact_boxes (db::Shapes &shapes, db::layer<db::Box, db::unstable_layer_tag> &layer, db::ArrayRepository &array_rep, size_t min_count)
+{
+  //  boxes are grouped by their dimensions
+  std::map<db::Vector, std::vector<db::Vector> > groups;
+  for (db::layer<db::Box, db::unstable_layer_tag>::iterator s = layer.begin (); s != layer.end (); ++s) {
+    if (! s->empty ()) {
+      groups [s->p2 () - s->p1 ()].push_back (s->p1 () - db::Point ());
+    }
+  }
+
+  std::vector<db::Box> remaining;
+  size_t n = 0;
+
+  for (std::map<db::Vector, std::vector<db::Vector> >::iterator g = groups.begin (); g != groups.end (); ++g) {
+    if (g->second.size () >= min_count) {
+      n += g->second.size ();
+    }
+  }
+
+  if (n == 0) {
+    return 0;
+  }
+
+  for (db::layer<db::Box, db::unstable_layer_tag>::iterator s = layer.begin (); s != layer.end (); ++s) {
+    if (s->empty () || groups [s->p2 () - s->p1 ()].size () < min_count) {
+      remaining.push_back (*s);
+    }
+  }
+
+  //  NOTE: swapping with a new layer releases the memory of the old one
+  db::layer<db::Box, db::unstable_layer_tag> new_layer;
+  new_layer.insert (remaining.begin (), remaining.end ());
+  layer.swap (new_layer);
+
+  for (std::map<db::Vector, std::vector<db::Vector> >::iterator g = groups.begin (); g != groups.end (); ++g) {
+
+    if (g->second.size () < min_count) {
+      continue;
+    }
+
+    CompactArraySpec spec;
+    make_array_spec (g->second, spec);
+
+    db::Box box (db::Point () + spec.o, db::Point () + spec.o + g->first);
+    if (spec.regular) {
+      shapes.insert (db::Shape::box_array_type (box, db::UnitTrans (), array_rep, spec.a, spec.b, spec.na, spec.nb));
+    } else {
+      shapes.insert (db::Shape::box_array_type (box, db::UnitTrans (), array_rep.insert (spec.iterated)));
+    }
+
+  }
+
+  return n;
+}
+
+size_t
+Shapes::compact (size_t min_count)
+{
+  //  no undo support for this currently
+  if (manager () && manager ()->transacting ()) {
+    throw tl::Exception (tl::to_string (tr ("Function 'compact' cannot be used inside a transaction (it does not support undo)")));
+  }
+
+  //  arrays are not supported in editable mode and need an array repository
+  if (is_editable () || ! layout ()) {
+    return 0;
+  }
+
+  if (min_count < 2) {
+    min_count = 2;
+  }
+
+  invalidate_state ();  //  HINT: must come before the change is done!
+
+  const Shapes *cthis = this;
+  db::ArrayRepository &array_rep = array_repository ();
+
+  size_t n = 0;
+
+  if (cthis->get_layer<db::Shape::box_type, db::unstable_layer_tag> ().size () >= min_count) {
+    n += compact_boxes (*this, get_layer<db::Shape::box_type, db::unstable_layer_tag> (), array_rep, min_count);
+  }
+
+  if (cthis->get_layer<db::Shape::polygon_ref_type, db::unstable_layer_tag> ().size () >= min_count) {
+    n += compact_polygon_refs<db::Shape::polygon_ref_type, db::Shape::polygon_ptr_array_type> (*this, get_layer<db::Shape::polygon_ref_type, db::unstable_layer_tag> (), array_rep, min_count);
+  }
+
+  if (cthis->get_layer<db::Shape::simple_polygon_ref_type, db::unstable_layer_tag> ().size () >= min_count) {
+    n += compact_polygon_refs<db::Shape::simple_polygon_ref_type, db::Shape::simple_polygon_ptr_array_type> (*this, get_layer<db::Shape::simple_polygon_ref_type, db::unstable_layer_tag> (), array_rep, min_count);
+  }
+
+  //  the undo history refers to the shapes before they have been converted
+  if (n > 0 && manager ()) {
+    manager ()->clear ();
+  }
+
+  return n;
+}
+
 void Shapes::update_bbox ()
 {
   for (tl::vector<LayerBase *>::const_iterator l = m_layers.begin (); l != m_layers.end (); ++l) {
@@ -928,10 +1198,10 @@ Shapes::box_type Shapes::bbox () const
   return box;
 }
 
-void Shapes::sort () 
+void Shapes::sort (unsigned int threads) 
 {
   for (tl::vector<LayerBase *>::const_iterator l = m_layers.begin (); l != m_layers.end (); ++l) {
-    (*l)->sort ();
+    (*l)->sort (threads);
   }
 }
 
@@ -447,7 +447,7 @@ public:
   virtual bool is_bbox_dirty () const = 0;
   virtual size_t size () const = 0;
   virtual bool empty () const = 0;
-  virtual void sort () = 0;
+  virtual void sort (unsigned int threads = 0) = 0;
   virtual void clear (Shapes *target, db::Manager *manager) = 0;
   virtual LayerBase *clone (Shapes *target, db::Manager *manager) const = 0;
   virtual void translate_into (Shapes *target, GenericRepository &rep, ArrayRepository &array_rep) const = 0;
@@ -738,7 +738,7 @@ public:
       } else {
         //  translate and transform into this
         for (tl::vector<LayerBase *>::const_iterator l = d.m_layers.begin (); l != d.m_layers.end (); ++l) {
-          (*l)->transform_into (this, shape_repository (), array_repository (), pm_delegate);
+          (*l)->translate_into (this, shape_repository (), array_repository (), pm_delegate);
         }
       }
 
@@ -881,6 +881,25 @@ public:
     }
   }
 
+  /**
+   *  @brief Inserts boxes from a packed coordinate block
+   *
+   *  "coords" holds n left, bottom, right and top coordinate quadruples.
+   *  The boxes are inserted in a single step which is much faster than
+   *  inserting them one by one.
+   */
+  void insert_boxes (const coord_type *coords, size_t n);
+
+  /**
+   *  @brief Inserts polygons from a packed coordinate block
+   *
+   *  "points" holds the x and y coordinates of all contours one after another.
+   *  "counts" gives the number of points for each contour. For each polygon, the hull
+   *  comes first, followed by the holes. "holes" gives the number of holes for each
+   *  polygon. It can be 0 for polygons without holes. "n" is the number of polygons.
+   */
+  void insert_polygons (const coord_type *points, const size_t *counts, const size_t *holes, size_t n);
+
   /**
    *  @brief Insert an element from the shape reference
    *
@@ -1163,14 +1182,40 @@ public:
    *
    *  Sorting the trees is required after insert operations
    *  and is performed only as far as necessary.
+   *  With "threads" larger than 1, large layers are sorted using
+   *  up to the given number of threads.
    */
-  void sort ();
+  void sort (unsigned int threads = 0);
 
   /**
    *  @brief Clears the collection
    */
   void clear ();
 
+  /**
+   *  @brief Converts repeated boxes and polygon references into shape arrays
+   *
+   *  This method provides a compact storage mode for layers with many identical
+   *  shapes (e.g. vias or fill). Boxes of identical size and references to the 
+   *  same polygon are grouped. A group with at least "min_count" members is 
+   *  replaced by a single shape array: a regular array if the shapes are placed 
+   *  on a complete grid and an iterated array otherwise. The latter stores one
+   *  displacement per shape along with a sorted spatial index. Hence the memory
+   *  savings are large for regular grids, but moderate for irregular placements.
+   *
+   *  Shape arrays are delivered member by member by the shape iterators, so
+   *  iteration, rendering and the writers are not affected.
+   *
+   *  Shape arrays are not available in editable mode - in that case, this 
+   *  method does nothing. Shapes with properties are not compacted.
+   *  This method does not support undo: it must not be called inside a transaction
+   *  (an exception is thrown in that case) and clears the undo history of the
+   *  manager if shapes have been converted.
+   *
+   *  @return The number of shapes that have been converted into arrays
+   */
+  size_t compact (size_t min_count = 4);
+
   /**
    *  @brief Report the type mask of the objects stored herein
    *
@@ -136,9 +136,9 @@ public:
     return m_layer.empty ();
   }
 
-  virtual void sort () 
+  virtual void sort (unsigned int threads = 0) 
   {
-    m_layer.sort ();
+    m_layer.sort (threads);
   }
 
   virtual void clear (Shapes *target, db::Manager *manager);
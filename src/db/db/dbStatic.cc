@@ -23,6 +23,7 @@
 
 #include "dbStatic.h"
 #include "tlException.h"
+#include "tlThreads.h"
 
 #include <cstdio>
 
@@ -73,5 +74,15 @@ void enable_transactions (bool enable)
   ms_transactions_enabled = enable;
 }
 
+// -----------------------------------------------------------
+//  sorting threads
+
+DB_PUBLIC unsigned int ms_sort_threads = tl::cpu_count ();
+
+void set_default_sort_threads (unsigned int n)
+{
+  ms_sort_threads = n;
+}
+
 }
 
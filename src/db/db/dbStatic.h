@@ -89,6 +89,28 @@ inline bool transactions_enabled ()
  */
 void DB_PUBLIC enable_transactions (bool enable);
 
+// -----------------------------------------------------------
+//  sorting threads
+
+/**
+ *  @brief Returns the number of threads new layouts use for sorting the shapes
+ *
+ *  This value is the initial value of Layout::sort_threads.
+ *  By default it is the number of processor cores.
+ */
+inline unsigned int default_sort_threads ()
+{
+  extern DB_PUBLIC unsigned int ms_sort_threads;
+  return ms_sort_threads;
+}
+
+/**
+ *  @brief Sets the number of threads new layouts use for sorting the shapes
+ *
+ *  A value of 0 or 1 disables multi-threaded sorting.
+ */
+void DB_PUBLIC set_default_sort_threads (unsigned int n);
+
 }
 
 #endif
@@ -27,9 +27,12 @@
 #include "tlProgress.h"
 #include "tlThreadedWorkers.h"
 #include "tlThreads.h"
+#include "tlTimer.h"
 #include "gsiDecl.h"
 
 #include <cmath>
+#include <map>
+#include <algorithm>
 
 namespace db
 {
@@ -164,6 +167,44 @@ private:
   const db::ICplxTrans m_trans;
 };
 
+/**
+ *  @brief A filter for the edge pair insert functionality which selects the edge pairs owned by a tile
+ *
+ *  Edge pairs are not clipped, so an edge pair touching several tiles would be delivered
+ *  multiple times. Instead, an edge pair is taken only from the tile which owns the lower-left
+ *  corner of its bounding box. The tiles own their box except the right and top edge. The 
+ *  outermost tiles own the space beyond the tile array too.
+ */
+class EdgePairsTileOwnerFilter
+{
+public:
+  EdgePairsTileOwnerFilter (EdgePairsInserter *inserter, const db::Box &tile, size_t ix, size_t iy, size_t nx, size_t ny)
+    : mp_inserter (inserter), m_tile (tile), m_ix (ix), m_iy (iy), m_nx (nx), m_ny (ny)
+  {
+    //  .. nothing yet ..
+  }
+
+  template <class T>
+  void operator() (const T &)
+  {
+    //  .. discard anything except EdgePairs ..
+  }
+
+  void operator() (const db::EdgePair &ep)
+  {
+    db::Point p = ep.bbox ().lower_left ();
+    if ((m_ix == 0 || p.x () >= m_tile.left ()) && (m_ix + 1 >= m_nx || p.x () < m_tile.right ()) &&
+        (m_iy == 0 || p.y () >= m_tile.bottom ()) && (m_iy + 1 >= m_ny || p.y () < m_tile.top ())) {
+      (*mp_inserter) (ep);
+    }
+  }
+
+private:
+  EdgePairsInserter *mp_inserter;
+  db::Box m_tile;
+  size_t m_ix, m_iy, m_nx, m_ny;
+};
+
 class TileLayoutOutputReceiver
   : public db::TileOutputReceiver
 {
@@ -256,19 +297,31 @@ class TileEdgePairsOutputReceiver
 {
 public:
   TileEdgePairsOutputReceiver (db::EdgePairs *edge_pairs)
-    : mp_edge_pairs (edge_pairs)
+    : mp_edge_pairs (edge_pairs), m_nx (0), m_ny (0)
   {
     //  .. nothing yet ..
   }
 
-  void put (size_t /*ix*/, size_t /*iy*/, const db::Box &tile, size_t /*id*/, const tl::Variant &obj, double /*dbu*/, const db::ICplxTrans &trans, bool clip)
+  void begin (size_t nx, size_t ny, const db::DPoint & /*p0*/, double /*dx*/, double /*dy*/, const db::DBox & /*frame*/)
+  {
+    m_nx = nx;
+    m_ny = ny;
+  }
+
+  void put (size_t ix, size_t iy, const db::Box &tile, size_t /*id*/, const tl::Variant &obj, double /*dbu*/, const db::ICplxTrans &trans, bool clip)
   {
     EdgePairsInserter inserter (mp_edge_pairs, trans);
-    insert_var (inserter, obj, tile, clip);
+    if (clip && m_nx > 0 && m_ny > 0) {
+      EdgePairsTileOwnerFilter filter (&inserter, tile, ix, iy, m_nx, m_ny);
+      insert_var (filter, obj, tile, false);
+    } else {
+      insert_var (inserter, obj, tile, clip);
+    }
   }
 
 private:
   db::EdgePairs *mp_edge_pairs;
+  size_t m_nx, m_ny;
 };
 
 class TilingProcessorJob
@@ -279,7 +332,8 @@ public:
     : tl::JobBase (nworkers),
       mp_proc (proc),
       m_has_tiles (has_tiles),
-      m_progress (0)
+      m_progress (0),
+      m_parse_time (0.0), m_eval_time (0.0), m_output_time (0.0)
   {
     //  .. nothing yet ..
   }
@@ -289,10 +343,28 @@ public:
     return m_has_tiles;
   }
 
-  void next_progress () 
+  void next_progress (double parse_time, double eval_time, double output_time) 
   {
     tl::MutexLocker locker (&m_mutex);
     ++m_progress;
+    m_parse_time += parse_time;
+    m_eval_time += eval_time;
+    m_output_time += output_time;
+  }
+
+  double parse_time () const
+  {
+    return m_parse_time;
+  }
+
+  double eval_time () const
+  {
+    return m_eval_time;
+  }
+
+  double output_time () const
+  {
+    return m_output_time;
   }
 
   void update_progress (tl::RelativeProgress &progress) 
@@ -317,6 +389,7 @@ private:
   TilingProcessor *mp_proc;
   bool m_has_tiles;
   unsigned int m_progress;
+  double m_parse_time, m_eval_time, m_output_time;
   tl::Mutex m_mutex;
 };
 
@@ -373,15 +446,13 @@ private:
   size_t m_script_index;
 };
 
+class TilingProcessorOutputFunction;
+
 class TilingProcessorWorker
   : public tl::Worker
 {
 public:
-  TilingProcessorWorker (TilingProcessorJob *job)
-    : tl::Worker (), mp_job (job)
-  {
-    //  .. nothing yet ..
-  }
+  TilingProcessorWorker (TilingProcessorJob *job);
 
   void perform_task (tl::Task *task) 
   {
@@ -393,6 +464,12 @@ public:
 
 private:
   TilingProcessorJob *mp_job;
+  //  The worker's evaluation context: the scripts are parsed once per worker and
+  //  executed for every tile with fresh variables.
+  tl::Eval m_eval;
+  std::map<size_t, tl::Expression> m_expressions;
+  TilingProcessorOutputFunction *mp_output_function;
+  double m_output_time;
 
   void do_perform (const TilingProcessorTask *task);
 };
@@ -420,21 +497,31 @@ class TilingProcessorOutputFunction
   : public tl::EvalFunction
 {
 public:
-  TilingProcessorOutputFunction (TilingProcessor *proc, size_t ix, size_t iy, const db::Box &tile_box)
-    : mp_proc (proc), m_ix (ix), m_iy (iy), m_tile_box (tile_box)
+  TilingProcessorOutputFunction (TilingProcessor *proc, double *output_time)
+    : mp_proc (proc), m_ix (0), m_iy (0), m_tile_box (db::Box::world ()), mp_output_time (output_time)
   {
     //  .. nothing yet ..
   }
 
+  void set_tile (size_t ix, size_t iy, const db::Box &tile_box)
+  {
+    m_ix = ix;
+    m_iy = iy;
+    m_tile_box = tile_box;
+  }
+
   void execute (const tl::ExpressionParserContext & /*context*/, tl::Variant & /*out*/, const std::vector<tl::Variant> &args) const 
   {
+    tl::Clock t0 = tl::Clock::current ();
     mp_proc->put (m_ix, m_iy, m_tile_box, args);
+    *mp_output_time += (tl::Clock::current () - t0).seconds ();
   }
 
 private:
   TilingProcessor *mp_proc;
   size_t m_ix, m_iy;
   db::Box m_tile_box; 
+  double *mp_output_time;
 };
 
 class TilingProcessorCountFunction
@@ -452,10 +539,23 @@ public:
   }
 };
 
+TilingProcessorWorker::TilingProcessorWorker (TilingProcessorJob *job)
+  : tl::Worker (), mp_job (job), m_eval (&job->processor ()->top_eval ()), mp_output_function (0), m_output_time (0.0)
+{
+  mp_output_function = new TilingProcessorOutputFunction (mp_job->processor (), &m_output_time);
+  m_eval.define_function ("_output", mp_output_function);
+  m_eval.define_function ("_rec", new TilingProcessorReceiverFunction (mp_job->processor ()));
+  m_eval.define_function ("_count", new TilingProcessorCountFunction (mp_job->processor ()));
+}
+
 void
 TilingProcessorWorker::do_perform (const TilingProcessorTask *tile_task)
 {
-  tl::Eval eval (&mp_job->processor ()->top_eval ());
+  tl::Eval &eval = m_eval;
+
+  //  NOTE: the variables are only reset, not removed - the parsed expressions
+  //  refer to them.
+  eval.reset_vars ();
 
   db::Box clip_box_dbu = db::Box::world ();
 
@@ -519,9 +619,7 @@ TilingProcessorWorker::do_perform (const TilingProcessorTask *tile_task)
 
   }
 
-  eval.define_function ("_output", new TilingProcessorOutputFunction (mp_job->processor (), tile_task->ix (), tile_task->iy (), clip_box_dbu));
-  eval.define_function ("_rec", new TilingProcessorReceiverFunction (mp_job->processor ()));
-  eval.define_function ("_count", new TilingProcessorCountFunction (mp_job->processor ()));
+  mp_output_function->set_tile (tile_task->ix (), tile_task->iy (), clip_box_dbu);
 
   if (tl::verbosity () >= (mp_job->has_tiles () ? 20 : 10)) {
     tl::info << "TilingProcessor: script #" << (tile_task->script_index () + 1) << ", tile " << tile_task->tile_desc ();
@@ -529,11 +627,29 @@ TilingProcessorWorker::do_perform (const TilingProcessorTask *tile_task)
 
   tl::SelfTimer timer (tl::verbosity () >= (mp_job->has_tiles () ? 21 : 11), "Elapsed time");
 
-  tl::Expression ex;
-  eval.parse (ex, tile_task->script ());
-  ex.execute ();
+  tl::Clock t0 = tl::Clock::current ();
+
+  //  the script is parsed once per worker and reused for the following tiles
+  std::map<size_t, tl::Expression>::iterator e = m_expressions.find (tile_task->script_index ());
+  if (e == m_expressions.end ()) {
+    e = m_expressions.insert (std::make_pair (tile_task->script_index (), tl::Expression ())).first;
+    try {
+      eval.parse (e->second, tile_task->script ());
+    } catch (...) {
+      m_expressions.erase (e);
+      throw;
+    }
+  }
+
+  tl::Clock t1 = tl::Clock::current ();
 
-  mp_job->next_progress ();
+  m_output_time = 0.0;
+  e->second.execute ();
+
+  tl::Clock t2 = tl::Clock::current ();
+
+  //  the clock has a millisecond resolution, so the sum of the output times may exceed the total
+  mp_job->next_progress ((t1 - t0).seconds (), std::max (0.0, (t2 - t1).seconds () - m_output_time), m_output_time);
 }
 
 tl::Worker *
@@ -553,7 +669,8 @@ TilingProcessor::TilingProcessor ()
     m_tile_origin_given (false),
     m_tile_bx (0.0), m_tile_by (0.0),
     m_threads (0), m_dbu (0.001), m_dbu_specific (0.001), m_dbu_specific_set (false),
-    m_scale_to_dbu (true)
+    m_scale_to_dbu (true),
+    m_parse_time (0.0), m_eval_time (0.0), m_output_time (0.0)
 {
   //  .. nothing yet ..
 }
@@ -753,6 +870,9 @@ TilingProcessor::put (size_t ix, size_t iy, const db::Box &tile, const std::vect
 void  
 TilingProcessor::execute (const std::string &desc)
 {
+  m_parse_time = m_eval_time = m_output_time = 0.0;
+  m_statistics.clear ();
+
   db::DBox tot_box = m_frame;
 
   if (tot_box.empty ()) {
@@ -832,6 +952,12 @@ TilingProcessor::execute (const std::string &desc)
     }
 
     //  create the TilingProcessor tasks
+    //  The tiles are dealt out to the workers in contiguous runs along the columns, so
+    //  neighboring tiles (which share much of their input) are processed by the same
+    //  thread unless another thread runs out of work and steals them.
+    size_t nworkers = std::max (size_t (1), m_threads);
+    size_t ntiles = ntiles_w * ntiles_h;
+
     for (size_t ix = 0; ix < ntiles_w; ++ix) {
 
       for (size_t iy = 0; iy < ntiles_h; ++iy) {
@@ -841,9 +967,11 @@ TilingProcessor::execute (const std::string &desc)
 
         std::string tile_desc = tl::sprintf ("%d/%d,%d/%d", ix + 1, ntiles_w, iy + 1, ntiles_h);
 
+        int affinity = int (((ix * ntiles_h + iy) * nworkers) / ntiles);
+
         size_t si = 0;
         for (std::vector <std::string>::const_iterator s = m_scripts.begin (); s != m_scripts.end (); ++s, ++si) {
-          job.schedule (new TilingProcessorTask (tile_desc, ix, iy, clip_box, region, *s, si));
+          job.schedule (new TilingProcessorTask (tile_desc, ix, iy, clip_box, region, *s, si), affinity);
         }
 
       }
@@ -891,6 +1019,15 @@ TilingProcessor::execute (const std::string &desc)
         }
       }
 
+      m_parse_time = job.parse_time ();
+      m_eval_time = job.eval_time ();
+      m_output_time = job.output_time ();
+      m_statistics = job.statistics ();
+
+      if (tl::verbosity () >= 11) {
+        tl::info << "TilingProcessor: parse time " << tl::sprintf ("%.3f", m_parse_time) << "s, evaluation time " << tl::sprintf ("%.3f", m_eval_time) << "s, output time " << tl::sprintf ("%.3f", m_output_time) << "s";
+      }
+
     } catch (...) {
       for (std::vector<OutputSpec>::iterator o = m_outputs.begin (); o != m_outputs.end (); ++o) {
         if (o->receiver) {
@@ -37,6 +37,7 @@
 #include "tlExpression.h"
 #include "tlTypeTraits.h"
 #include "tlThreads.h"
+#include "tlThreadedWorkers.h"
 
 namespace db
 {
@@ -617,6 +618,49 @@ public:
    */
   void execute (const std::string &desc);
 
+  /**
+   *  @brief Gets the time spent for parsing the scripts in the last "execute" call
+   *
+   *  The times are given in seconds and are summed over all tiles and threads.
+   *  The scripts are parsed once per thread and reused for the following tiles.
+   */
+  double parse_time () const
+  {
+    return m_parse_time;
+  }
+
+  /**
+   *  @brief Gets the time spent for evaluating the scripts in the last "execute" call
+   *
+   *  This time does not include the time spent in the output receivers (see "output_time").
+   */
+  double eval_time () const
+  {
+    return m_eval_time;
+  }
+
+  /**
+   *  @brief Gets the time spent for delivering output in the last "execute" call
+   *
+   *  This is the time spent inside the "_output" function, including the output
+   *  receivers and the time waiting for other threads delivering output.
+   */
+  double output_time () const
+  {
+    return m_output_time;
+  }
+
+  /**
+   *  @brief Gets the scheduler statistics of the last "execute" call
+   *
+   *  The statistics are given per thread. The vector is empty if no threads
+   *  have been used.
+   */
+  const std::vector<tl::WorkerStatistics> &statistics () const
+  {
+    return m_statistics;
+  }
+
 private:
   friend class TilingProcessorWorker;
   friend class TilingProcessorOutputFunction;
@@ -662,6 +706,8 @@ private:
   bool m_dbu_specific_set;
   bool m_scale_to_dbu;
   std::vector<std::string> m_scripts;
+  double m_parse_time, m_eval_time, m_output_time;
+  std::vector<tl::WorkerStatistics> m_statistics;
   tl::Mutex m_output_mutex;
   tl::Eval m_top_eval;
 };
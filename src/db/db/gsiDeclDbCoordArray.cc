@@ -0,0 +1,135 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#include "gsiDecl.h"
+
+#include "dbCoordArray.h"
+
+namespace gsi
+{
+
+static db::CoordArray *new_v ()
+{
+  return new db::CoordArray ();
+}
+
+static db::CoordArray *new_rc (size_t rows, unsigned int columns)
+{
+  return new db::CoordArray (rows, columns);
+}
+
+/**
+ *  @brief The class declaration for CoordArray
+ *
+ *  This declaration exposes the coordinate block as a buffer, so script
+ *  languages can access the coordinates directly.
+ */
+class CoordArrayClass
+  : public gsi::Class<db::CoordArray>
+{
+public:
+  CoordArrayClass (const std::string &module, const std::string &name, const gsi::Methods &mm, const std::string &doc)
+    : gsi::Class<db::CoordArray> (module, name, mm, doc)
+  {
+    //  .. nothing yet ..
+  }
+
+  virtual bool provides_buffer () const
+  {
+    return true;
+  }
+
+  virtual bool get_buffer (void *obj, gsi::BufferInfo &info) const
+  {
+    db::CoordArray *a = (db::CoordArray *) obj;
+    info.data = (void *) a->data ();
+    info.item_size = sizeof (db::CoordArray::coord_type);
+    info.format = sizeof (db::CoordArray::coord_type) == sizeof (long long) ? "q" : "i";
+    info.rows = a->rows ();
+    info.columns = a->columns ();
+    info.readonly = false;
+    return true;
+  }
+};
+
+CoordArrayClass decl_CoordArray ("db", "CoordArray",
+  constructor ("new", &new_v,
+    "@brief Creates an empty array\n"
+  ) +
+  constructor ("new", &new_rc, gsi::arg ("rows"), gsi::arg ("columns"),
+    "@brief Creates an array with the given number of rows and columns\n"
+    "All coordinates are initialized with zero."
+  ) +
+  method ("rows", &db::CoordArray::rows,
+    "@brief Gets the number of rows\n"
+  ) +
+  method ("columns", &db::CoordArray::columns,
+    "@brief Gets the number of columns\n"
+  ) +
+  method ("value", &db::CoordArray::value, gsi::arg ("row"), gsi::arg ("column"),
+    "@brief Gets the coordinate at the given row and column\n"
+  ) +
+  method ("set_value", &db::CoordArray::set_value, gsi::arg ("row"), gsi::arg ("column"), gsi::arg ("value"),
+    "@brief Sets the coordinate at the given row and column\n"
+  ) +
+  method ("==", &db::CoordArray::operator==, gsi::arg ("other"),
+    "@brief Returns true, if the arrays are identical\n"
+  ) +
+  method ("!=", &db::CoordArray::operator!=, gsi::arg ("other"),
+    "@brief Returns true, if the arrays are not identical\n"
+  ) +
+  method ("to_s", &db::CoordArray::to_string,
+    "@brief Converts the array to a string\n"
+    "Rows are separated by \";\", columns by \",\"."
+  ),
+  "@brief A two-dimensional array of integer coordinates\n"
+  "\n"
+  "This array is a compact representation of geometrical data for bulk transfer between "
+  "the database and scripts. Methods like \\Region#box_array, \\Region#point_array or \\Edges#edge_array "
+  "deliver such arrays. Each row holds one item, e.g. left, bottom, right and top of a box or "
+  "x and y of a point. The coordinates are given in database units.\n"
+  "\n"
+  "In Python, the array supports the buffer protocol. NumPy can use the coordinates directly "
+  "without copying them. The NumPy array keeps a reference to the coordinate array:\n"
+  "\n"
+  "@code\n"
+  "boxes = numpy.asarray(region.box_array())\n"
+  "widths = boxes[:, 2] - boxes[:, 0]\n"
+  "@/code\n"
+  "\n"
+  "The buffer is writable, so an array can also be filled from NumPy data with a single copy:\n"
+  "\n"
+  "@code\n"
+  "a = pya.CoordArray(len(data), 4)\n"
+  "numpy.asarray(a)[:] = data\n"
+  "@/code\n"
+  "\n"
+  "Arrays of this kind can be inserted in one step with \\Region#insert_boxes, \\Region#insert_polygons "
+  "and the corresponding methods of \\Shapes.\n"
+  "\n"
+  "This class has been introduced in version 0.26.\n"
+);
+
+}
+
@@ -0,0 +1,55 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "gsiDecl.h"
+#include "dbDeepShapeStore.h"
+
+namespace gsi
+{
+
+Class<db::DeepShapeStore> decl_dbDeepShapeStore ("db", "DeepShapeStore",
+  gsi::method ("layers_in_use", &db::DeepShapeStore::layers_in_use,
+    "@brief Gets the number of layers currently held by the store\n"
+    "Layers are released when the last deep region referring to them is destroyed."
+  ),
+  "@brief An opaque layout heap for the deep region processor\n"
+  "\n"
+  "This class is used for keeping intermediate, hierarchical data for the "
+  "deep region processor. It is used in conjunction with the region "
+  "constructor to create a deep (hierarchical) region."
+  "\n"
+  "@code\n"
+  "layout = ... # a layout\n"
+  "layer = ...  # a layer\n"
+  "cell = ...   # a cell (initial cell for the deep region)\n"
+  "dss = RBA::DeepShapeStore::new\n"
+  "region = RBA::Region::new(cell.begin(layer), dss)\n"
+  "@/code\n"
+  "\n"
+  "The DeepShapeStore object must be kept alive while the regions derived from it are in use.\n"
+  "\n"
+  "This class has been introduced in version 0.26.\n"
+);
+
+}
+
@@ -585,6 +585,20 @@ Class<db::EdgeProcessor> decl_EdgeProcessor ("db", "EdgeProcessor",
     "\n"
     "This method has been introduced in version 0.23.\n"
   ) +
+  method ("threads=", &db::EdgeProcessor::set_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use\n"
+    "With more than one thread, the edge processor splits large edge sets into horizontal bands "
+    "and processes them in parallel. The results are the same as for single-threaded "
+    "processing. A value of 0 or 1 disables multi-threading (the default).\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
+  method ("threads", &db::EdgeProcessor::threads,
+    "@brief Gets the number of threads to use\n"
+    "See \\threads= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
   method ("ModeAnd|#mode_and", &gsi::mode_and, "@brief boolean method's mode value for AND operation") +
   method ("ModeOr|#mode_or", &gsi::mode_or, "@brief boolean method's mode value for OR operation") +
   method ("ModeXor|#mode_xor", &gsi::mode_xor, "@brief boolean method's mode value for XOR operation") +
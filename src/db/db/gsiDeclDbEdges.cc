@@ -26,6 +26,9 @@
 #include "dbEdges.h"
 #include "dbRegion.h"
 #include "dbLayoutUtils.h"
+#include "dbCoordArray.h"
+
+#include <memory>
 
 namespace gsi
 {
@@ -362,6 +365,13 @@ static void insert_s (db::Edges *e, const db::Shapes &a)
   insert_st (e, a, db::UnitTrans ());
 }
 
+static db::CoordArray *edge_array (const db::Edges *e)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::edge_array (*e, *a);
+  return a.release ();
+}
+
 Class<db::Edges> dec_Edges ("db", "Edges",
   constructor ("new", &new_v, 
     "@brief Default constructor\n"
@@ -1422,6 +1432,16 @@ Class<db::Edges> dec_Edges ("db", "Edges",
   method ("size", (size_t (db::Edges::*) () const) &db::Edges::size,
     "@brief Returns the number of edges in the edge collection\n"
   ) +
+  method ("hier_count", &db::Edges::hier_count,
+    "@brief Returns the (hierarchical) number of edges in the edge collection\n"
+    "\n"
+    "For edge collections delivered from a layout, the shapes inside cells are counted once, regardless how often the cell is instantiated. "
+    "All shapes on the source layers are counted, irrespective of the search region or the shape types. "
+    "Hence this count is a cheap estimate which does not require flattening the hierarchy. "
+    "For other edge collections, the count is the same as \\size.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   gsi::iterator ("each", &db::Edges::begin,
     "@brief Returns each edge of the region\n"
   ) +
@@ -1432,6 +1452,16 @@ Class<db::Edges> dec_Edges ("db", "Edges",
     "\n"
     "This method has been introduced in version 0.25."
   ) +
+  factory_ext ("edge_array", &edge_array,
+    "@brief Returns the edges as a \\CoordArray object\n"
+    "\n"
+    "The array has four columns (x1, y1, x2, y2) and one row per edge. "
+    "This method is intended for bulk access to the geometry. In Python, the array can be used "
+    "as a NumPy array without copying the coordinates.\n"
+    "This method delivers the original edges like \\each.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   method ("[]", &db::Edges::nth,
     "@brief Returns the nth edge of the edge collection\n"
     "@args n\n"
@@ -1470,6 +1500,23 @@ Class<db::Edges> dec_Edges ("db", "Edges",
     "@brief Disable progress reporting\n"
     "Calling this method will disable progress reporting. See \\enable_progress.\n"
   ) +
+  method ("threads=", &db::Edges::set_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for operations which support multi-threading\n"
+    "Only the edge-versus-region operations can make use of multiple CPU cores for large inputs. These are "
+    "the & and - operators with a \\Region argument (including their in-place versions &= and -=), \\inside_part, \\outside_part, "
+    "\\select_inside_part and \\select_outside_part. All other operations, specifically the booleans between edge "
+    "collections and merging, are single-threaded. "
+    "A value of 0 or 1 disables multi-threading (the default). "
+    "The results are the same as for single-threaded operation.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method ("threads", &db::Edges::threads,
+    "@brief Gets the number of threads to use for operations which support multi-threading\n"
+    "See \\threads= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   method ("Euclidian", &euclidian_metrics,
     "@brief Specifies Euclidian metrics for the check functions\n"
     "This value can be used for the metrics parameter in the check functions, i.e. \\width_check. "
@@ -953,7 +953,38 @@ Class<db::Layout> decl_Layout ("db", "Layout",
     "\n"
     "This method has been introduced in version 0.22.\n"
   ) +
-  gsi::method ("clear", &db::Layout::clear, 
+  gsi::method ("contour_arena_enabled=", &db::Layout::set_contour_arena_enabled, gsi::arg ("flag"),
+    "@brief Enables or disables arena allocation of polygon contours\n"
+    "If enabled, the point lists of the polygons referenced by polygon references (such as the ones created by the "
+    "stream readers in non-editable mode) are allocated in big blocks rather than "
+    "individually. This saves memory for layouts with many small polygons. On the other hand, memory is "
+    "only released when the layout is cleared or destroyed. Hence this option is intended for layouts which "
+    "are loaded and not modified heavily. This option should be set right after the layout has been created.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
+  gsi::method ("is_contour_arena_enabled?", &db::Layout::is_contour_arena_enabled,
+    "@brief Returns a value indicating whether arena allocation of polygon contours is enabled\n"
+    "See \\contour_arena_enabled= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
+  gsi::method ("sort_threads=", &db::Layout::set_sort_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for sorting the shapes\n"
+    "After loading or modifying a layout, the shapes are sorted into spatial trees. With more than one "
+    "thread, the shapes of different cells are sorted in parallel and big shape layers are sorted using "
+    "multiple threads themselves. Small layouts are always sorted in a single thread. A value of 0 or 1 disables "
+    "multi-threaded sorting. The default is the number of processor cores.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
+  gsi::method ("sort_threads", &db::Layout::sort_threads,
+    "@brief Gets the number of threads to use for sorting the shapes\n"
+    "See \\sort_threads= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
+  gsi::method ("clear", &db::Layout::clear,
     "@brief Clears the layout\n"
     "\n"
     "Clears the layout completely."
@@ -26,6 +26,7 @@
 #include "dbPolygonTools.h"
 #include "dbLayoutUtils.h"
 #include "dbShapes.h"
+#include "dbCoordArray.h"
 #include "tlGlobPattern.h"
 
 #include <memory>
@@ -218,6 +219,21 @@ static db::Region *new_si2 (const db::RecursiveShapeIterator &si, const db::ICpl
   return new db::Region (si, trans);
 }
 
+static db::Region *new_sid (const db::RecursiveShapeIterator &si, db::DeepShapeStore &dss)
+{
+  return new db::Region (si, dss);
+}
+
+static db::Region *new_si2d (const db::RecursiveShapeIterator &si, db::DeepShapeStore &dss, const db::ICplxTrans &trans)
+{
+  return new db::Region (si, dss, trans);
+}
+
+static void insert_into (const db::Region *r, db::Layout *layout, db::cell_index_type cell_index, unsigned int layer)
+{
+  r->insert_into (layout, cell_index, layer);
+}
+
 static std::string to_string0 (const db::Region *r)
 {
   return r->to_string ();
@@ -712,6 +728,37 @@ static Container *decompose_trapezoids (const db::Region *r, int mode)
 int td_simple ();
 int po_any ();
 
+static db::CoordArray *box_array (const db::Region *r)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::box_array (*r, *a);
+  return a.release ();
+}
+
+static db::CoordArray *point_array (const db::Region *r)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::point_array (*r, *a);
+  return a.release ();
+}
+
+static db::CoordArray *contour_array (const db::Region *r)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::contour_array (*r, *a);
+  return a.release ();
+}
+
+static void insert_boxes (db::Region *r, const db::CoordArray &boxes)
+{
+  db::insert_boxes (*r, boxes);
+}
+
+static void insert_polygons (db::Region *r, const db::CoordArray &points, const db::CoordArray &contours)
+{
+  db::insert_polygons (*r, points, contours);
+}
+
 Class<db::Region> decl_Region ("db", "Region",
   constructor ("new", &new_v, 
     "@brief Default constructor\n"
@@ -789,6 +836,30 @@ Class<db::Region> decl_Region ("db", "Region",
     "r = RBA::Region::new(layout.begin_shapes(cell, layer), RBA::ICplxTrans::new(layout.dbu / dbu))\n"
     "@/code\n"
   ) +
+  constructor ("new", &new_sid, gsi::arg ("shape_iterator"), gsi::arg ("deep_shape_store"),
+    "@brief Constructor for a deep region from a hierarchical shape set\n"
+    "\n"
+    "This constructor creates a hierarchical region. Use a \\DeepShapeStore object to "
+    "supply the hierarchical heap. See \\DeepShapeStore for more details.\n"
+    "\n"
+    "Boolean operations, merge and sizing between deep regions of the same store are performed "
+    "hierarchically - the results stay inside the cells as far as possible. Other operations will "
+    "work on the flat representation and turn the region into a flat one.\n"
+    "\n"
+    "The shape iterator must not have a search region or a depth limit.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
+  constructor ("new", &new_si2d, gsi::arg ("shape_iterator"), gsi::arg ("deep_shape_store"), gsi::arg ("trans"),
+    "@brief Constructor for a deep region from a hierarchical shape set with a magnification\n"
+    "\n"
+    "This constructor creates a hierarchical region. Use a \\DeepShapeStore object to "
+    "supply the hierarchical heap. See \\DeepShapeStore for more details.\n"
+    "\n"
+    "The transformation must be a pure magnification. It is useful to scale to a specific database unit.\n"
+    "\n"
+    "This method has been introduced in version 0.26.\n"
+  ) +
   constructor ("new", &new_texts<BoxDelivery>, gsi::arg("shape_iterator"), gsi::arg ("expr"), gsi::arg ("as_pattern", true),
     "@brief Constructor from a text set\n"
     "\n"
@@ -817,6 +888,19 @@ Class<db::Region> decl_Region ("db", "Region",
     "@hide\n"
     "This method is provided for DRC implementation only."
   ) +
+  method ("is_deep?", &db::Region::is_deep,
+    "@brief Returns true if the region is a deep (hierarchical) one\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method_ext ("insert_into", &insert_into, gsi::arg ("layout"), gsi::arg ("cell_index"), gsi::arg ("layer"),
+    "@brief Inserts this region into the given layout, below the given cell and into the given layer.\n"
+    "If the region is a hierarchical one, a suitable hierarchy will be built below the top cell or "
+    "the existing hierarchy will be used if the target is the original layout the region was taken from. "
+    "For flat regions, the polygons are inserted into the given cell.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   method ("merged_semantics=", &db::Region::set_merged_semantics,
     "@brief Enables or disables merged semantics\n"
     "@args f\n"
@@ -1179,15 +1263,15 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This function has been introduced in version 0.25.\n"
   ) +
-  method ("merge", (db::Region &(db::Region::*) ()) &db::Region::merge,
+  long_running (method ("merge", (db::Region &(db::Region::*) ()) &db::Region::merge,
     "@brief Merge the region\n"
     "\n"
     "@return The region after is has been merged (self).\n"
     "\n"
     "Merging removes overlaps and joins touching polygons.\n"
     "If the region is already merged, this method does nothing\n"
-  ) +
-  method_ext ("merge", &merge_ext1,
+  )) +
+  long_running (method_ext ("merge", &merge_ext1,
     "@brief Merge the region with options\n"
     "\n"
     "@args min_wc\n"
@@ -1200,8 +1284,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "means that output is only produced if two or more polygons overlap.\n"
     "\n"
     "This method is equivalent to \"merge(false, min_wc).\n"
-  ) +
-  method_ext ("merge", &merge_ext2,
+  )) +
+  long_running (method_ext ("merge", &merge_ext2,
     "@brief Merge the region with options\n"
     "\n"
     "@args min_coherence, min_wc\n"
@@ -1214,8 +1298,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "resolved by producing separate polygons. \"min_wc\" controls whether output is only produced if multiple "
     "polygons overlap. The value specifies the number of polygons that need to overlap. A value of 2 "
     "means that output is only produced if two or more polygons overlap.\n"
-  ) +
-  method ("merged", (db::Region (db::Region::*) () const) &db::Region::merged,
+  )) +
+  long_running (method ("merged", (db::Region (db::Region::*) () const) &db::Region::merged,
     "@brief Returns the merged region\n"
     "\n"
     "@return The region after is has been merged.\n"
@@ -1223,8 +1307,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "Merging removes overlaps and joins touching polygons.\n"
     "If the region is already merged, this method does nothing.\n"
     "In contrast to \\merge, this method does not modify the region but returns a merged copy.\n"
-  ) +
-  method_ext ("merged", &merged_ext1,
+  )) +
+  long_running (method_ext ("merged", &merged_ext1,
     "@brief Returns the merged region (with options)\n"
     "@args min_wc\n"
     "\n"
@@ -1237,8 +1321,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "This method is equivalent to \"merged(false, min_wc)\".\n"
     "\n"
     "In contrast to \\merge, this method does not modify the region but returns a merged copy.\n"
-  ) +
-  method_ext ("merged", &merged_ext2,
+  )) +
+  long_running (method_ext ("merged", &merged_ext2,
     "@brief Returns the merged region (with options)\n"
     "\n"
     "@args min_coherence, min_wc\n"
@@ -1253,7 +1337,7 @@ Class<db::Region> decl_Region ("db", "Region",
     "means that output is only produced if two or more polygons overlap.\n"
     "\n"
     "In contrast to \\merge, this method does not modify the region but returns a merged copy.\n"
-  ) +
+  )) +
   method ("round_corners", &db::Region::round_corners,
     "@brief Corner rounding\n"
     "@args r_inner, r_outer, n\n"
@@ -1298,7 +1382,7 @@ Class<db::Region> decl_Region ("db", "Region",
     "See \\smooth for a description of this method. This version returns a new region instead of "
     "modifying self (out-of-place). It has been introduced in version 0.25."
   ) +
-  method ("size", (db::Region & (db::Region::*) (db::Coord, db::Coord, unsigned int)) &db::Region::size,
+  long_running (method ("size", (db::Region & (db::Region::*) (db::Coord, db::Coord, unsigned int)) &db::Region::size,
     "@brief Anisotropic sizing (biasing)\n"
     "\n"
     "@args dx, dy, mode\n"
@@ -1327,8 +1411,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "r.merge(false, 1)\n"
     "# r now is (50,-50;50,100;100,100;100,-50)\n"
     "@/code\n"
-  ) + 
-  method ("size", (db::Region & (db::Region::*) (db::Coord, unsigned int)) &db::Region::size,
+  )) + 
+  long_running (method ("size", (db::Region & (db::Region::*) (db::Coord, unsigned int)) &db::Region::size,
     "@brief Isotropic sizing (biasing)\n"
     "\n"
     "@args d, mode\n"
@@ -1337,8 +1421,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "This method is equivalent to \"size(d, d, mode)\".\n"
     "\n"
     "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
-  ) + 
-  method_ext ("size", size_ext,
+  )) + 
+  long_running (method_ext ("size", size_ext,
     "@brief Isotropic sizing (biasing)\n"
     "\n"
     "@args d, mode\n"
@@ -1347,8 +1431,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "This method is equivalent to \"size(d, d, 2)\".\n"
     "\n"
     "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
-  ) + 
-  method ("sized", (db::Region (db::Region::*) (db::Coord, db::Coord, unsigned int) const) &db::Region::sized,
+  )) + 
+  long_running (method ("sized", (db::Region (db::Region::*) (db::Coord, db::Coord, unsigned int) const) &db::Region::sized,
     "@brief Returns the anisotropically sized region\n"
     "\n"
     "@args dx, dy, mode\n"
@@ -1357,8 +1441,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "This method is returns the sized region (see \\size), but does not modify self.\n"
     "\n"
     "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
-  ) + 
-  method ("sized", (db::Region (db::Region::*) (db::Coord, unsigned int) const) &db::Region::sized,
+  )) + 
+  long_running (method ("sized", (db::Region (db::Region::*) (db::Coord, unsigned int) const) &db::Region::sized,
     "@brief Returns the isotropically sized region\n"
     "\n"
     "@args d, mode\n"
@@ -1367,8 +1451,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "This method is returns the sized region (see \\size), but does not modify self.\n"
     "\n"
     "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
-  ) + 
-  method_ext ("sized", sized_ext,
+  )) + 
+  long_running (method_ext ("sized", sized_ext,
     "@brief Isotropic sizing (biasing)\n"
     "\n"
     "@args d, mode\n"
@@ -1377,8 +1461,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "This method is equivalent to \"sized(d, d, 2)\".\n"
     "\n"
     "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
-  ) + 
-  method ("&", &db::Region::operator&,
+  )) + 
+  long_running (method ("&", &db::Region::operator&,
     "@brief Returns the boolean AND between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1386,8 +1470,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This method will compute the boolean AND (intersection) between two regions. "
     "The result is often but not necessarily always merged.\n"
-  ) + 
-  method ("&=", &db::Region::operator&=,
+  )) + 
+  long_running (method ("&=", &db::Region::operator&=,
     "@brief Performs the boolean AND between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1395,8 +1479,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This method will compute the boolean AND (intersection) between two regions. "
     "The result is often but not necessarily always merged.\n"
-  ) + 
-  method ("-", &db::Region::operator-,
+  )) + 
+  long_running (method ("-", &db::Region::operator-,
     "@brief Returns the boolean NOT between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1404,8 +1488,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This method will compute the boolean NOT (intersection) between two regions. "
     "The result is often but not necessarily always merged.\n"
-  ) + 
-  method ("-=", &db::Region::operator-=,
+  )) + 
+  long_running (method ("-=", &db::Region::operator-=,
     "@brief Performs the boolean NOT between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1413,8 +1497,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This method will compute the boolean NOT (intersection) between two regions. "
     "The result is often but not necessarily always merged.\n"
-  ) + 
-  method ("^", &db::Region::operator^,
+  )) + 
+  long_running (method ("^", &db::Region::operator^,
     "@brief Returns the boolean NOT between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1422,8 +1506,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This method will compute the boolean XOR (intersection) between two regions. "
     "The result is often but not necessarily always merged.\n"
-  ) + 
-  method ("^=", &db::Region::operator^=,
+  )) + 
+  long_running (method ("^=", &db::Region::operator^=,
     "@brief Performs the boolean XOR between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1431,8 +1515,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This method will compute the boolean XOR (intersection) between two regions. "
     "The result is often but not necessarily always merged.\n"
-  ) + 
-  method ("\\|", &db::Region::operator|,
+  )) + 
+  long_running (method ("\\|", &db::Region::operator|,
     "@brief Returns the boolean OR between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1440,8 +1524,8 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "The boolean OR is implemented by merging the polygons of both regions. To simply join the regions "
     "without merging, the + operator is more efficient."
-  ) + 
-  method ("\\|=", &db::Region::operator|=,
+  )) + 
+  long_running (method ("\\|=", &db::Region::operator|=,
     "@brief Performs the boolean OR between self and the other region\n"
     "\n"
     "@args other\n"
@@ -1449,7 +1533,7 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "The boolean OR is implemented by merging the polygons of both regions. To simply join the regions "
     "without merging, the + operator is more efficient."
-  ) + 
+  )) + 
   method ("+", &db::Region::operator+,
     "@brief Returns the combined region of self and the other region\n"
     "\n"
@@ -2306,6 +2390,16 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This returns the number of raw polygons (not merged polygons if merged semantics is enabled).\n"
   ) +
+  method ("hier_count", &db::Region::hier_count,
+    "@brief Returns the (hierarchical) number of polygons in the region\n"
+    "\n"
+    "For regions delivered from a layout, the shapes inside cells are counted once, regardless how often the cell is instantiated. "
+    "All shapes on the source layers are counted, irrespective of the search region or the shape types. "
+    "Hence this count is a cheap estimate which does not require flattening the hierarchy. "
+    "For other regions, the count is the same as \\size.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   iterator ("each", &db::Region::begin,
     "@brief Returns each polygon of the region\n"
     "\n"
@@ -2316,6 +2410,61 @@ Class<db::Region> decl_Region ("db", "Region",
     "\n"
     "This returns the raw polygons if merged semantics is disabled or the merged ones if merged semantics is enabled.\n"
   ) +
+  factory_ext ("box_array", &box_array,
+    "@brief Returns the bounding boxes of the polygons as a \\CoordArray object\n"
+    "\n"
+    "The array has four columns (left, bottom, right, top) and one row per polygon. "
+    "This method is intended for bulk access to the geometry. In Python, the array can be used "
+    "as a NumPy array without copying the coordinates.\n"
+    "This method delivers the raw polygons like \\each.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  factory_ext ("point_array", &point_array,
+    "@brief Returns the points of the polygons as a \\CoordArray object\n"
+    "\n"
+    "The array has two columns (x, y) and one row per point. For each polygon, the points of the hull "
+    "are delivered first, followed by the points of the holes. Use \\contour_array to separate the contours.\n"
+    "This method delivers the raw polygons like \\each.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  factory_ext ("contour_array", &contour_array,
+    "@brief Returns the contour index for \\point_array as a \\CoordArray object\n"
+    "\n"
+    "The array has three columns (polygon index, index of the first point in \\point_array, number of points) "
+    "and one row per contour. For each polygon, the first row describes the hull and the following rows "
+    "describe the holes.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method_ext ("insert_boxes", &insert_boxes, gsi::arg ("boxes"),
+    "@brief Inserts the boxes from a \\CoordArray object\n"
+    "\n"
+    "The array needs to have four columns (left, bottom, right, top) and one row per box - i.e. the "
+    "format delivered by \\box_array. Like for \\insert, empty boxes are skipped. "
+    "This method is intended for bulk insertion of many boxes: it is much faster than inserting "
+    "the boxes one by one. In Python, the array can be filled from a NumPy array, e.g.\n"
+    "\n"
+    "@code\n"
+    "a = pya.CoordArray(len(boxes), 4)\n"
+    "numpy.asarray(a)[:] = boxes\n"
+    "region.insert_boxes(a)\n"
+    "@/code\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method_ext ("insert_polygons", &insert_polygons, gsi::arg ("points"), gsi::arg ("contours"),
+    "@brief Inserts polygons from a point and a contour \\CoordArray object\n"
+    "\n"
+    "The point array needs to have two columns (x, y) and holds the points of all contours one after "
+    "another. The contour array either has one column with the number of points for each polygon "
+    "(for polygons without holes) or three columns in the format delivered by \\contour_array. "
+    "Hence, the output of \\point_array and \\contour_array can be fed back into this method. "
+    "Like for \\insert, empty polygons are skipped.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   method ("[]", &db::Region::nth,
     "@brief Returns the nth polygon of the region\n"
     "@args n\n"
@@ -2348,6 +2497,23 @@ Class<db::Region> decl_Region ("db", "Region",
     "@brief Disable progress reporting\n"
     "Calling this method will disable progress reporting. See \\enable_progress.\n"
   ) +
+  method ("threads=", &db::Region::set_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for operations which support multi-threading\n"
+    "Boolean operations, merge, sizing, the DRC checks (i.e. \\width_check or \\space_check) and the "
+    "selection of polygons interacting with edges can make use of multiple CPU cores for large inputs. "
+    "A value of 0 or 1 disables multi-threading (the default). "
+    "The results are the same as for single-threaded operation, but the order of the results "
+    "may be different for the checks and interaction selections. For checks on a single layer, the edges "
+    "of an edge pair may be swapped.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method ("threads", &db::Region::threads,
+    "@brief Gets the number of threads to use for operations which support multi-threading\n"
+    "See \\threads= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   method ("Euclidian", &euclidian_metrics,
     "@brief Specifies Euclidian metrics for the check functions\n"
     "This value can be used for the metrics parameter in the check functions, i.e. \\width_check. "
@@ -30,6 +30,9 @@
 #include "dbRegion.h"
 #include "dbEdgePairs.h"
 #include "dbEdges.h"
+#include "dbCoordArray.h"
+
+#include <memory>
 
 namespace gsi
 {
@@ -406,6 +409,37 @@ static unsigned int s_paths ()               { return db::ShapeIterator::Paths;
 static unsigned int s_texts ()               { return db::ShapeIterator::Texts; }
 static unsigned int s_user_objects ()        { return db::ShapeIterator::UserObjects; }
 
+static db::CoordArray *box_array (const db::Shapes *s, unsigned int flags)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::box_array (*s, flags, *a);
+  return a.release ();
+}
+
+static db::CoordArray *point_array (const db::Shapes *s, unsigned int flags)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::point_array (*s, flags, *a);
+  return a.release ();
+}
+
+static db::CoordArray *contour_array (const db::Shapes *s, unsigned int flags)
+{
+  std::auto_ptr<db::CoordArray> a (new db::CoordArray ());
+  db::contour_array (*s, flags, *a);
+  return a.release ();
+}
+
+static void insert_boxes (db::Shapes *s, const db::CoordArray &boxes)
+{
+  db::insert_boxes (*s, boxes);
+}
+
+static void insert_polygons (db::Shapes *s, const db::CoordArray &points, const db::CoordArray &contours)
+{
+  db::insert_polygons (*s, points, contours);
+}
+
 Class<db::Shapes> decl_Shapes ("db", "Shapes",
   gsi::method ("insert", (db::Shape (db::Shapes::*)(const db::Shape &)) &db::Shapes::insert,
     "@brief Inserts a shape from a shape reference into the shapes list\n"
@@ -1016,6 +1050,52 @@ Class<db::Shapes> decl_Shapes ("db", "Shapes",
     "\n"
     "This call is equivalent to each(SAll). This convenience method has been introduced in version 0.16\n"
   ) +
+  gsi::factory_ext ("box_array", &box_array, gsi::arg ("flags", db::ShapeIterator::All),
+    "@brief Returns the bounding boxes of the shapes as a \\CoordArray object\n"
+    "@param flags An \"or\"-ed combination of the S... constants\n"
+    "\n"
+    "The array has four columns (left, bottom, right, top) and one row per shape. "
+    "This method is intended for bulk access to the geometry. In Python, the array can be used "
+    "as a NumPy array without copying the coordinates.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  gsi::factory_ext ("point_array", &point_array, gsi::arg ("flags", db::ShapeIterator::All),
+    "@brief Returns the points of the polygon-type shapes as a \\CoordArray object\n"
+    "@param flags An \"or\"-ed combination of the S... constants\n"
+    "\n"
+    "Polygons, paths and boxes are delivered as polygons, other shapes are skipped. "
+    "The layout of the array is the same than for \\Region#point_array. Use \\contour_array to separate the contours.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  gsi::factory_ext ("contour_array", &contour_array, gsi::arg ("flags", db::ShapeIterator::All),
+    "@brief Returns the contour index for \\point_array as a \\CoordArray object\n"
+    "@param flags An \"or\"-ed combination of the S... constants\n"
+    "\n"
+    "The layout of the array is the same than for \\Region#contour_array. The polygon index counts "
+    "the polygon-type shapes only.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  gsi::method_ext ("insert_boxes", &insert_boxes, gsi::arg ("boxes"),
+    "@brief Inserts boxes from a \\CoordArray object\n"
+    "\n"
+    "The array needs to have four columns (left, bottom, right, top) and one row per box - i.e. the "
+    "format delivered by \\box_array. "
+    "This method is intended for bulk insertion of many boxes: it is much faster than inserting "
+    "the boxes one by one.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  gsi::method_ext ("insert_polygons", &insert_polygons, gsi::arg ("points"), gsi::arg ("contours"),
+    "@brief Inserts polygons from a point and a contour \\CoordArray object\n"
+    "\n"
+    "The layout of the arrays is the same than for \\Region#insert_polygons. "
+    "The output of \\point_array and \\contour_array can be fed back into this method.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   gsi::iterator_ext ("each_touching", &begin_touching,
     "@brief Gets all shapes that touch the search box (region)\n"
     "@args flags,region\n"
@@ -1105,6 +1185,22 @@ Class<db::Shapes> decl_Shapes ("db", "Shapes",
     "@brief Clears the shape container\n"
     "This method has been introduced in version 0.16. It can only be used in editable mode."
   ) +
+  gsi::method ("compact", &db::Shapes::compact, gsi::arg ("min_count", size_t (4)),
+    "@brief Converts repeated boxes and polygon references into shape arrays\n"
+    "@return The number of shapes which have been converted into array members\n"
+    "Boxes of the same size and polygon references to the same polygon are grouped. Groups with at least "
+    "'min_count' members are replaced by a regular array if they form a complete grid or by an "
+    "iterated array otherwise. A regular array is stored as a single entry, while an iterated array still "
+    "keeps one displacement per member. Hence the memory footprint is reduced considerably for shapes on "
+    "regular grids, but only moderately for irregularly placed shapes. "
+    "Shapes with properties are not converted.\n"
+    "\n"
+    "This method can only be used in non-editable mode. In editable mode, it does nothing. It is not "
+    "undoable: it cannot be used inside a transaction and it clears the undo history if shapes have been "
+    "converted.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
   gsi::method_ext ("size", &shapes_size,
     "@brief Gets the number of shapes in this container\n"
     "This method was introduced in version 0.16\n"
@@ -334,6 +334,33 @@ static void tp_input11 (db::TilingProcessor *proc, const std::string &name, cons
   proc->input (name, it.first, trans * it.second, false /*not as polygons*/, edges.merged_semantics ());
 }
 
+static std::vector<size_t> tp_thread_tasks (const db::TilingProcessor *proc)
+{
+  std::vector<size_t> r;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = proc->statistics ().begin (); s != proc->statistics ().end (); ++s) {
+    r.push_back (s->tasks);
+  }
+  return r;
+}
+
+static std::vector<size_t> tp_thread_stolen_tasks (const db::TilingProcessor *proc)
+{
+  std::vector<size_t> r;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = proc->statistics ().begin (); s != proc->statistics ().end (); ++s) {
+    r.push_back (s->stolen);
+  }
+  return r;
+}
+
+static std::vector<double> tp_thread_idle_times (const db::TilingProcessor *proc)
+{
+  std::vector<double> r;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = proc->statistics ().begin (); s != proc->statistics ().end (); ++s) {
+    r.push_back (s->idle_time);
+  }
+  return r;
+}
+
 Class<db::TilingProcessor> decl_TilingProcessor ("db", "TilingProcessor",
   method_ext ("input", &tp_input2,
     "@brief Specifies input for the tiling processor\n"
@@ -538,6 +565,10 @@ Class<db::TilingProcessor> decl_TilingProcessor ("db", "TilingProcessor",
     "will be put into the specified edge pair collection.\n"
     "Only \\EdgePair objects are accepted. Other objects are discarded.\n"
     "\n"
+    "Edge pairs are not clipped. If clipping is requested, an edge pair is taken only from the tile which "
+    "contains the lower-left corner of its bounding box. Hence edge pairs touching several tiles are not "
+    "reported multiple times. This feature has been introduced in version 0.26.\n"
+    "\n"
     "The name is the name which must be used in the _output function of the scripts in order to "
     "address that channel.\n"
     "\n"
@@ -640,12 +671,59 @@ Class<db::TilingProcessor> decl_TilingProcessor ("db", "TilingProcessor",
     "The scripts have \"Expressions\" syntax and can make use of several predefined variables and functions.\n"
     "See the \\TilingProcessor class description for details.\n"
   ) + 
-  method ("execute", &db::TilingProcessor::execute,
+  long_running (method ("execute", &db::TilingProcessor::execute,
     "@brief Runs the job\n"
     "@args desc\n"
     "\n"
     "This method will initiate execution of the queued scripts, once for every tile. The desc is a text "
     "shown in the progress bar for example.\n"
+  )) + 
+  method ("parse_time", &db::TilingProcessor::parse_time,
+    "@brief Gets the time spent for parsing the scripts in the last \\execute call\n"
+    "\n"
+    "The time is given in seconds and summed over all threads. The scripts are parsed once per thread "
+    "and reused for all tiles processed by this thread.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) + 
+  method ("eval_time", &db::TilingProcessor::eval_time,
+    "@brief Gets the time spent for evaluating the scripts in the last \\execute call\n"
+    "\n"
+    "The time is given in seconds and summed over all tiles and threads. It does not include the "
+    "time spent for delivering output (see \\output_time).\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) + 
+  method ("output_time", &db::TilingProcessor::output_time,
+    "@brief Gets the time spent for delivering output in the last \\execute call\n"
+    "\n"
+    "This is the time spent inside the \"_output\" function, including the time spent in the "
+    "output receivers. The time is given in seconds and summed over all tiles and threads.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method_ext ("thread_tasks", &tp_thread_tasks,
+    "@brief Gets the number of tasks performed by each thread in the last \\execute call\n"
+    "\n"
+    "A task is one script executed on one tile. The array has one entry per thread. It is empty if "
+    "no threads have been used (see \\threads=).\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method_ext ("thread_stolen_tasks", &tp_thread_stolen_tasks,
+    "@brief Gets the number of tasks each thread took over from other threads in the last \\execute call\n"
+    "\n"
+    "Neighboring tiles are preferably assigned to the same thread. A thread which has run out of work "
+    "takes over tasks assigned to other threads. A high number of such tasks indicates an unbalanced load.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
+  ) +
+  method_ext ("thread_idle_times", &tp_thread_idle_times,
+    "@brief Gets the time each thread spent waiting for work in the last \\execute call\n"
+    "\n"
+    "The times are given in seconds.\n"
+    "\n"
+    "This method has been introduced in version 0.26."
   ),
   "@brief A processor for layout which distributes tasks over tiles\n"
   "\n"
@@ -260,6 +260,81 @@ TEST(2)
   run_test2(_this, 10000, 2, 10000);
 }
 
+struct BoxScannerTestRecorder3
+{
+  void finish (const db::Box *, size_t p)
+  {
+    finished.push_back (p);
+  }
+
+  void add (const db::Box * /*b1*/, size_t p1, const db::Box * /*b2*/, size_t p2)
+  {
+    interactions.push_back (std::make_pair (std::min (p1, p2), std::max (p1, p2)));
+  }
+
+  std::vector<size_t> finished;
+  std::vector<std::pair<size_t, size_t> > interactions;
+};
+
+void run_test2a (tl::TestBase *_this, size_t n, db::Coord spread, db::Coord enl, unsigned int threads)
+{
+  std::vector<db::Box> bb;
+  for (size_t i = 0; i < n; ++i) {
+    db::Coord x = rand () % spread;
+    db::Coord y = rand () % spread;
+    bb.push_back (db::Box (x, y, x + 1 + rand () % 200, y + 100));
+  }
+
+  db::box_scanner<db::Box, size_t> bs;
+  for (std::vector<db::Box>::const_iterator b = bb.begin (); b != bb.end (); ++b) {
+    bs.insert (&*b, b - bb.begin ());
+  }
+
+  db::box_convert<db::Box> bc;
+
+  BoxScannerTestRecorder3 tr_single;
+  bs.process (tr_single, enl, bc);
+
+  std::vector<BoxScannerTestRecorder3> trs;
+  trs.resize (threads * 4);
+  std::vector<BoxScannerTestRecorder3 *> recs;
+  for (std::vector<BoxScannerTestRecorder3>::iterator t = trs.begin (); t != trs.end (); ++t) {
+    recs.push_back (t.operator-> ());
+  }
+
+  {
+    tl::SelfTimer timer ("box-scanner (parallel)");
+    bs.process_parallel (recs, threads, enl, bc);
+  }
+
+  BoxScannerTestRecorder3 tr;
+  for (std::vector<BoxScannerTestRecorder3>::const_iterator t = trs.begin (); t != trs.end (); ++t) {
+    tr.finished.insert (tr.finished.end (), t->finished.begin (), t->finished.end ());
+    tr.interactions.insert (tr.interactions.end (), t->interactions.begin (), t->interactions.end ());
+  }
+
+  //  every interaction is reported once and every object is finished once
+  std::sort (tr_single.finished.begin (), tr_single.finished.end ());
+  std::sort (tr_single.interactions.begin (), tr_single.interactions.end ());
+  std::sort (tr.finished.begin (), tr.finished.end ());
+  std::sort (tr.interactions.begin (), tr.interactions.end ());
+
+  EXPECT_EQ (tr.finished.size (), n);
+  EXPECT_EQ (tr.finished == tr_single.finished, true);
+  EXPECT_EQ (tr.interactions.size (), tr_single.interactions.size ());
+  EXPECT_EQ (tr.interactions == tr_single.interactions, true);
+}
+
+TEST(2a)
+{
+  run_test2a (_this, 10, 1000, 1, 4);
+  run_test2a (_this, 10000, 10000, 1, 4);
+  run_test2a (_this, 10000, 10000, 0, 2);
+  run_test2a (_this, 10000, 10000, 300, 4);
+  run_test2a (_this, 2000, 100, 1, 4);
+  run_test2a (_this, 100000, 100000, 20, 8);
+}
+
 
 struct TestCluster
   : public db::cluster<db::Box, size_t>
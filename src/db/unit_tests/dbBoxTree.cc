@@ -1032,3 +1032,71 @@ TEST(6U)
 }
 
 
+
+//  multi-threaded sorting
+TEST(7)
+{
+  Box2BoxCmplx conv;
+  TestTreeCmplxL t, tp;
+
+  int n = 500000;
+  for (int i = 0; i < n; ++i) {
+    db::Box bx = rbox ();
+    t.insert (bx);
+    tp.insert (bx);
+  }
+
+  {
+    tl::SelfTimer timer ("test 7 sort (single-threaded)");
+    t.sort (conv);
+  }
+  {
+    tl::SelfTimer timer ("test 7 sort (4 threads)");
+    tp.sort (conv, 4);
+  }
+
+  //  the result is the same than for single-threaded sorting
+  EXPECT_EQ (t.elements () == tp.elements (), true);
+
+  for (unsigned int i = 0; i < 10; ++i) {
+    db::Box b = rbox ();
+    test_tree_overlap (_this, tp, b, conv);
+    test_tree_touching (_this, tp, b, conv);
+  }
+}
+
+TEST(7U)
+{
+  Box2Box conv;
+  UnstableTestTreeL t, tp;
+
+  int n = 500000;
+  for (int i = 0; i < n; ++i) {
+    db::Box bx = rbox ();
+    t.insert (bx);
+    tp.insert (bx);
+  }
+
+  {
+    tl::SelfTimer timer ("test 7U sort (single-threaded)");
+    t.sort (conv);
+  }
+  {
+    tl::SelfTimer timer ("test 7U sort (16 threads)");
+    tp.sort (conv, 16);
+  }
+
+  //  the result is the same than for single-threaded sorting
+  bool equal = true;
+  UnstableTestTreeL::const_iterator i = t.begin (), ip = tp.begin ();
+  for ( ; i != t.end () && ip != tp.end () && equal; ++i, ++ip) {
+    equal = (*i == *ip);
+  }
+  EXPECT_EQ (equal, true);
+
+  for (unsigned int i = 0; i < 10; ++i) {
+    db::Box b = rbox ();
+    test_tree_overlap (_this, tp, b, conv);
+    test_tree_touching (_this, tp, b, conv);
+  }
+}
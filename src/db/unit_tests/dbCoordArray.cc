@@ -0,0 +1,216 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#include "dbCoordArray.h"
+#include "dbRegion.h"
+#include "dbEdges.h"
+#include "dbShapes.h"
+#include "tlUnitTest.h"
+
+TEST(1)
+{
+  db::CoordArray a (2, 3);
+  EXPECT_EQ (a.rows (), size_t (2));
+  EXPECT_EQ (a.columns (), 3u);
+  EXPECT_EQ (a.to_string (), "0,0,0;0,0,0");
+
+  a.set_value (1, 1, 5);
+  EXPECT_EQ (a.value (1, 1), 5);
+  EXPECT_EQ (a.data () [4], 5);
+  EXPECT_EQ (a.to_string (), "0,0,0;0,5,0");
+
+  bool error = false;
+  try {
+    a.value (2, 0);
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+
+  error = false;
+  try {
+    a.set_value (0, 3, 1);
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+
+  db::CoordArray b;
+  EXPECT_EQ (b.rows (), size_t (0));
+  EXPECT_EQ (b.data () == 0, true);
+  EXPECT_EQ (a == b, false);
+
+  b.clear (3);
+  b.add (0, 0, 0);
+  b.add (0, 5, 0);
+  EXPECT_EQ (a == b, true);
+  EXPECT_EQ (a != b, false);
+}
+
+TEST(2)
+{
+  db::Polygon p (db::Box (0, 0, 1000, 1000));
+  db::Point hole[] = { db::Point (100, 100), db::Point (200, 100), db::Point (200, 200), db::Point (100, 200) };
+  p.insert_hole (hole + 0, hole + sizeof (hole) / sizeof (hole [0]));
+
+  db::Region r;
+  r.insert (db::Box (-10, -20, 30, 40));
+  r.insert (p);
+
+  db::CoordArray a;
+
+  db::box_array (r, a);
+  EXPECT_EQ (a.to_string (), "-10,-20,30,40;0,0,1000,1000");
+
+  db::point_array (r, a);
+  EXPECT_EQ (a.columns (), 2u);
+  EXPECT_EQ (a.to_string (), "-10,-20;-10,40;30,40;30,-20;0,0;0,1000;1000,1000;1000,0;100,100;200,100;200,200;100,200");
+
+  db::contour_array (r, a);
+  EXPECT_EQ (a.to_string (), "0,0,4;1,4,4;1,8,4");
+
+  db::Edges e;
+  e.insert (db::Edge (0, 0, 100, 200));
+  e.insert (db::Edge (-1, 2, 3, -4));
+
+  db::edge_array (e, a);
+  EXPECT_EQ (a.to_string (), "0,0,100,200;-1,2,3,-4");
+}
+
+TEST(3)
+{
+  db::Shapes s;
+  s.insert (db::Box (0, 0, 100, 200));
+  s.insert (db::Text ("A", db::Trans (db::Vector (10, 20))));
+  s.insert (db::Path ());
+
+  db::CoordArray a;
+
+  db::box_array (s, db::ShapeIterator::Boxes, a);
+  EXPECT_EQ (a.to_string (), "0,0,100,200");
+
+  db::box_array (s, db::ShapeIterator::Boxes | db::ShapeIterator::Texts, a);
+  EXPECT_EQ (a.rows (), size_t (2));
+
+  db::point_array (s, db::ShapeIterator::All, a);
+  EXPECT_EQ (a.to_string (), "0,0;0,200;100,200;100,0");
+
+  db::contour_array (s, db::ShapeIterator::All, a);
+  EXPECT_EQ (a.to_string (), "0,0,0;1,0,4");
+}
+
+
+TEST(4)
+{
+  db::CoordArray boxes;
+  boxes.clear (4);
+  boxes.add (0, 0, 100, 200);
+  boxes.add (10, 10, 10, 20);
+  boxes.add (-10, -20, 30, 40);
+
+  db::Region r;
+  db::insert_boxes (r, boxes);
+  //  the empty box is skipped
+  EXPECT_EQ (r.to_string (), "(0,0;0,200;100,200;100,0);(-10,-20;-10,40;30,40;30,-20)");
+  EXPECT_EQ (r.is_merged (), false);
+
+  db::Shapes s;
+  db::insert_boxes (s, boxes);
+  db::CoordArray a;
+  db::box_array (s, db::ShapeIterator::All, a);
+  EXPECT_EQ (a.to_string (), "0,0,100,200;10,10,10,20;-10,-20,30,40");
+
+  bool error = false;
+  try {
+    db::insert_boxes (r, db::CoordArray (1, 2));
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+}
+
+TEST(5)
+{
+  db::Polygon p (db::Box (0, 0, 1000, 1000));
+  db::Point hole[] = { db::Point (100, 100), db::Point (200, 100), db::Point (200, 200), db::Point (100, 200) };
+  p.insert_hole (hole + 0, hole + sizeof (hole) / sizeof (hole [0]));
+
+  db::Region r;
+  r.insert (db::Box (-10, -20, 30, 40));
+  r.insert (p);
+  r.insert (db::Box (0, 0, 10, 10));
+
+  db::CoordArray points, contours;
+  db::point_array (r, points);
+  db::contour_array (r, contours);
+
+  //  round trip with the contour index
+  db::Region r2;
+  db::insert_polygons (r2, points, contours);
+  EXPECT_EQ (r2.to_string (), r.to_string ());
+
+  db::Shapes s;
+  db::insert_polygons (s, points, contours);
+  db::CoordArray points2, contours2;
+  db::point_array (s, db::ShapeIterator::All, points2);
+  db::contour_array (s, db::ShapeIterator::All, contours2);
+  EXPECT_EQ (points2 == points, true);
+  EXPECT_EQ (contours2 == contours, true);
+
+  //  hull counts only
+  db::CoordArray counts;
+  counts.clear (1);
+  counts.add (4);
+  counts.add (8);
+
+  points.clear (2);
+  points.add (0, 0);
+  points.add (0, 100);
+  points.add (100, 100);
+  points.add (100, 0);
+  points.add (0, 0);
+  points.add (0, 300);
+  points.add (100, 300);
+  points.add (100, 200);
+  points.add (200, 200);
+  points.add (200, 100);
+  points.add (300, 100);
+  points.add (300, 0);
+
+  db::Region r3;
+  db::insert_polygons (r3, points, counts);
+  EXPECT_EQ (r3.to_string (), "(0,0;0,100;100,100;100,0);(0,0;0,300;100,300;100,200;200,200;200,100;300,100;300,0)");
+
+  //  point count mismatch
+  counts.clear (1);
+  counts.add (5);
+
+  bool error = false;
+  try {
+    db::insert_polygons (r3, points, counts);
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+}
@@ -0,0 +1,332 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#include "dbRegion.h"
+#include "dbDeepShapeStore.h"
+#include "dbLayout.h"
+#include "tlUnitTest.h"
+
+namespace
+{
+
+//  Sets up a small hierarchy: a child cell "A" with shapes on two layers
+//  placed as an overlapping array and as a separate instance plus some shapes
+//  in the top cell touching the array
+struct TestLayout
+{
+  TestLayout ()
+    : layout (false)
+  {
+    l1 = layout.insert_layer (db::LayerProperties (1, 0));
+    l2 = layout.insert_layer (db::LayerProperties (2, 0));
+
+    db::Cell &a = layout.cell (layout.add_cell ("A"));
+    a.shapes (l1).insert (db::Box (0, 0, 1000, 1000));
+    a.shapes (l1).insert (db::Box (2000, 0, 3000, 500));
+    a.shapes (l2).insert (db::Box (500, 500, 1500, 1500));
+    a.shapes (l2).insert (db::Box (5000, 5000, 6000, 6000));
+
+    db::Cell &b = layout.cell (layout.add_cell ("B"));
+    b.shapes (l1).insert (db::Box (0, 0, 100, 100));
+    b.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (db::Vector (200, 0))));
+
+    db::Cell &c = layout.cell (layout.add_cell ("C"));
+    c.shapes (l1).insert (db::Box (0, 0, 1000, 1000));
+    c.shapes (l2).insert (db::Box (500, 500, 1500, 1500));
+
+    db::Cell &top = layout.cell (layout.add_cell ("TOP"));
+    top_index = top.cell_index ();
+    top.shapes (l1).insert (db::Box (-500, -500, 100, 100));
+    top.shapes (l2).insert (db::Box (20000, 0, 21000, 1000));
+
+    //  overlapping array (the pitch is smaller than the cell)
+    top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (), db::Vector (2500, 0), db::Vector (0, 10000), 3, 2));
+    //  a rotated, isolated instance
+    top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (1, false, db::Vector (50000, 0))));
+    top.insert (db::CellInstArray (db::CellInst (b.cell_index ()), db::Trans (db::Vector (0, 50000))));
+    //  a sparse array
+    top.insert (db::CellInstArray (db::CellInst (c.cell_index ()), db::Trans (db::Vector (0, 100000)), db::Vector (10000, 0), db::Vector (0, 10000), 2, 2));
+  }
+
+  db::Layout layout;
+  unsigned int l1, l2;
+  db::cell_index_type top_index;
+};
+
+bool same (const db::Region &a, const db::Region &b)
+{
+  return (a ^ b).empty ();
+}
+
+}
+
+TEST(1_DeepRegionBasics)
+{
+  TestLayout tl;
+  db::DeepShapeStore dss;
+
+  db::Region r1 (db::RecursiveShapeIterator (tl.layout, tl.layout.cell (tl.top_index), tl.l1), dss);
+  db::Region r1_flat (db::RecursiveShapeIterator (tl.layout, tl.layout.cell (tl.top_index), tl.l1));
+
+  EXPECT_EQ (r1.is_deep (), true);
+  EXPECT_EQ (r1_flat.is_deep (), false);
+  EXPECT_EQ (r1.size (), r1_flat.size ());
+  EXPECT_EQ (r1.bbox ().to_string (), r1_flat.bbox ().to_string ());
+  EXPECT_EQ (dss.layouts (), (unsigned int) 1);
+  EXPECT_EQ (dss.layers_in_use (), size_t (1));
+
+  db::Region r2 (db::RecursiveShapeIterator (tl.layout, tl.layout.cell (tl.top_index), tl.l2), dss);
+  EXPECT_EQ (dss.layouts (), (unsigned int) 1);
+  EXPECT_EQ (dss.layers_in_use (), size_t (2));
+
+  //  flat operations turn the region into a flat one
+  db::Region r1_copy = r1;
+  r1_copy.insert (db::Box (0, 0, 10, 10));
+  EXPECT_EQ (r1_copy.is_deep (), false);
+  EXPECT_EQ (r1.is_deep (), true);
+
+  r1.clear ();
+  EXPECT_EQ (r1.is_deep (), false);
+  EXPECT_EQ (dss.layers_in_use (), size_t (1));
+
+  r2.clear ();
+  EXPECT_EQ (dss.layers_in_use (), size_t (0));
+}
+
+TEST(2_DeepRegionBooleans)
+{
+  TestLayout tl;
+  db::DeepShapeStore dss;
+
+  db::RecursiveShapeIterator i1 (tl.layout, tl.layout.cell (tl.top_index), tl.l1);
+  db::RecursiveShapeIterator i2 (tl.layout, tl.layout.cell (tl.top_index), tl.l2);
+
+  db::Region r1 (i1, dss), r2 (i2, dss);
+  db::Region r1_flat (i1), r2_flat (i2);
+
+  db::Region r;
+
+  r = r1 & r2;
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat & r2_flat), true);
+
+  r = r1 - r2;
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat - r2_flat), true);
+
+  r = r2 - r1;
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r2_flat - r1_flat), true);
+
+  r = r1 ^ r2;
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat ^ r2_flat), true);
+
+  r = r1 | r2;
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat | r2_flat), true);
+
+  //  mixed operations fall back to flat mode
+  r = r1 & r2_flat;
+  EXPECT_EQ (r.is_deep (), false);
+  EXPECT_EQ (same (r, r1_flat & r2_flat), true);
+}
+
+TEST(3_DeepRegionMergeAndSize)
+{
+  TestLayout tl;
+  db::DeepShapeStore dss;
+
+  db::RecursiveShapeIterator i1 (tl.layout, tl.layout.cell (tl.top_index), tl.l1);
+  db::RecursiveShapeIterator i2 (tl.layout, tl.layout.cell (tl.top_index), tl.l2);
+
+  db::Region r1 (i1, dss), r2 (i2, dss);
+  db::Region r1_flat (i1), r2_flat (i2);
+
+  db::Region r;
+
+  r = r1.merged ();
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat.merged ()), true);
+  EXPECT_EQ (r.size (), r1_flat.merged ().size ());
+
+  r = (r1 + r2).merged ();
+  EXPECT_EQ (same (r, (r1_flat + r2_flat).merged ()), true);
+
+  r = r1.sized (100);
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat.sized (100)), true);
+
+  r = r2.sized (-100);
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r2_flat.sized (-100)), true);
+
+  r = r1.sized (600, 50, 2);
+  EXPECT_EQ (same (r, r1_flat.sized (600, 50, 2)), true);
+}
+
+TEST(4_DeepRegionOutputIsHierarchical)
+{
+  TestLayout tl;
+
+  db::cell_index_type c_index = tl.layout.cell_by_name ("C").second;
+
+  {
+    db::DeepShapeStore dss;
+
+    db::RecursiveShapeIterator i1 (tl.layout, tl.layout.cell (tl.top_index), tl.l1);
+    db::RecursiveShapeIterator i2 (tl.layout, tl.layout.cell (tl.top_index), tl.l2);
+
+    db::Region r1 (i1, dss), r2 (i2, dss);
+    db::Region r1_flat (i1), r2_flat (i2);
+
+    db::Region r = r1 & r2;
+
+    //  back into the original layout
+    unsigned int lout = tl.layout.insert_layer (db::LayerProperties (100, 0));
+    r.insert_into (&tl.layout, tl.top_index, lout);
+
+    //  the box (500,500;1000,1000) inside C does not interact with anything outside and stays in C
+    EXPECT_EQ (tl.layout.cell (c_index).shapes (lout).size (), size_t (1));
+    EXPECT_EQ (tl.layout.cell (tl.top_index).shapes (lout).size () > 0, true);
+
+    db::Region r_out (db::RecursiveShapeIterator (tl.layout, tl.layout.cell (tl.top_index), lout));
+    EXPECT_EQ (same (r_out, r1_flat & r2_flat), true);
+
+    //  into a new layout
+    db::Layout target;
+    db::cell_index_type target_top = target.add_cell ("TOP");
+    unsigned int ltarget = target.insert_layer (db::LayerProperties (1, 0));
+    r.insert_into (&target, target_top, ltarget);
+
+    EXPECT_EQ (target.cells () > 1, true);
+
+    db::Region r_target (db::RecursiveShapeIterator (target, target.cell (target_top), ltarget));
+    EXPECT_EQ (same (r_target, r1_flat & r2_flat), true);
+  }
+}
+
+TEST(5_DeepRegionUnsupportedIterator)
+{
+  TestLayout tl;
+  db::DeepShapeStore dss;
+
+  db::RecursiveShapeIterator i1 (tl.layout, tl.layout.cell (tl.top_index), tl.l1, db::Box (0, 0, 1000, 1000));
+
+  bool error = false;
+  try {
+    db::Region r (i1, dss);
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+}
+
+TEST(6_DeepRegionSizingVariants)
+{
+  db::Layout layout (false);
+  unsigned int l1 = layout.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = layout.insert_layer (db::LayerProperties (2, 0));
+
+  //  "A" has an isolated box and a box touching the neighbor instances of the arrays below
+  db::Cell &a = layout.cell (layout.add_cell ("A"));
+  a.shapes (l1).insert (db::Box (0, 0, 1000, 200));
+  a.shapes (l1).insert (db::Box (2000, 0, 2200, 1000));
+  a.shapes (l2).insert (db::Box (0, 0, 3000, 3000));
+
+  //  "B" places "A" rotated
+  db::Cell &b = layout.cell (layout.add_cell ("B"));
+  b.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (1, false, db::Vector (0, 0))));
+
+  //  "C" is isolated and placed with and without magnification
+  db::Cell &c = layout.cell (layout.add_cell ("C"));
+  c.shapes (l1).insert (db::Box (0, 0, 500, 500));
+
+  db::Cell &top = layout.cell (layout.add_cell ("TOP"));
+  top.shapes (l1).insert (db::Box (-100, -100, 0, 0));
+  top.insert (db::CellInstArray (db::CellInst (c.cell_index ()), db::Trans (db::Vector (50000, 0))));
+  top.insert (db::CellInstArray (db::CellInst (c.cell_index ()), db::ICplxTrans (2.0, 0.0, false, db::Vector (60000, 0))));
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans ()));
+  //  rotated, interacting array members
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (1, false, db::Vector (10000, 0)), db::Vector (0, 2200), db::Vector (0, 10000), 3, 1));
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (4, false, db::Vector (20000, 0))));
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (5, false, db::Vector (30000, 0))));
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::ICplxTrans (2.0, 0.0, false, db::Vector (0, 20000))));
+  top.insert (db::CellInstArray (db::CellInst (b.cell_index ()), db::Trans (db::Vector (0, 40000))));
+  top.insert (db::CellInstArray (db::CellInst (b.cell_index ()), db::Trans (1, false, db::Vector (10000, 40000))));
+
+  db::cell_index_type top_index = top.cell_index ();
+  db::RecursiveShapeIterator i1 (layout, top, l1);
+  db::RecursiveShapeIterator i2 (layout, top, l2);
+
+  db::DeepShapeStore dss;
+  db::Region r1 (i1, dss);
+  db::Region r1_flat (i1);
+
+  db::Region r;
+
+  //  anisotropic sizing depends on the orientation and magnification of the instances
+  r = r1.sized (300, 50);
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat.sized (300, 50)), true);
+
+  r = r1.sized (-50, 100);
+  EXPECT_EQ (same (r, r1_flat.sized (-50, 100)), true);
+
+  //  isotropic sizing only depends on the magnification - 101 can't be computed inside the magnified cell
+  r = r1.sized (100);
+  EXPECT_EQ (same (r, r1_flat.sized (100)), true);
+  r = r1.sized (101);
+  EXPECT_EQ (same (r, r1_flat.sized (101)), true);
+
+  //  layers created later see the variants too
+  db::Region r2 (i2, dss);
+  db::Region r2_flat (i2);
+  EXPECT_EQ (same (r2, r2_flat), true);
+
+  r = r1.sized (300, 50) & r2;
+  EXPECT_EQ (r.is_deep (), true);
+  EXPECT_EQ (same (r, r1_flat.sized (300, 50) & r2_flat), true);
+
+  //  back into the original layout: the variants are created there as well
+  size_t cells_before = layout.cells ();
+  unsigned int lout = layout.insert_layer (db::LayerProperties (100, 0));
+  r1.sized (300, 50).insert_into (&layout, top_index, lout);
+  EXPECT_EQ (layout.cells () > cells_before, true);
+
+  db::Region r_out (db::RecursiveShapeIterator (layout, layout.cell (top_index), lout));
+  EXPECT_EQ (same (r_out, r1_flat.sized (300, 50)), true);
+  EXPECT_EQ (same (db::Region (db::RecursiveShapeIterator (layout, layout.cell (top_index), l1)), r1_flat), true);
+
+  //  a second insert reuses the variants
+  size_t cells_after = layout.cells ();
+  unsigned int lout2 = layout.insert_layer (db::LayerProperties (101, 0));
+  r1.sized (-50, 100).insert_into (&layout, top_index, lout2);
+  EXPECT_EQ (layout.cells (), cells_after);
+
+  db::Region r_out2 (db::RecursiveShapeIterator (layout, layout.cell (top_index), lout2));
+  EXPECT_EQ (same (r_out2, r1_flat.sized (-50, 100)), true);
+  r_out = db::Region (db::RecursiveShapeIterator (layout, layout.cell (top_index), lout));
+  EXPECT_EQ (same (r_out, r1_flat.sized (300, 50)), true);
+}
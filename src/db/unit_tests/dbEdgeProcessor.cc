@@ -2483,3 +2483,211 @@ TEST(135b)
   EXPECT_EQ (run_test135b (_this, db::Trans (db::Trans::m90)), "(-78,25;-33,34;-36,33;-37,33)");
   EXPECT_EQ (run_test135b (_this, db::Trans (db::Trans::m135)), "(-26,-78;-35,-33;-33,-36;-33,-37)");
 }
+
+static std::vector<db::Polygon> band_test_input (bool all_angle)
+{
+  std::vector<db::Polygon> in;
+
+  //  rows of overlapping shapes with vertical gaps between the rows
+  unsigned int seed = 17;
+  for (int row = 0; row < 40; ++row) {
+    for (int i = 0; i < 200; ++i) {
+
+      seed = seed * 1103515245 + 12345;
+      db::Coord x = db::Coord ((seed >> 8) % 20000);
+      seed = seed * 1103515245 + 12345;
+      db::Coord y = row * 1000 + db::Coord ((seed >> 8) % 500);
+      seed = seed * 1103515245 + 12345;
+      db::Coord w = 10 + db::Coord ((seed >> 8) % 300);
+
+      if (all_angle && (i % 3) == 0) {
+        db::Point pts[] = { db::Point (x, y), db::Point (x + w, y + w), db::Point (x + 2 * w, y), db::Point (x + w / 3, y + w / 7) };
+        db::Polygon p;
+        p.assign_hull (&pts[0], &pts[sizeof (pts) / sizeof (pts[0])]);
+        in.push_back (p);
+      } else {
+        in.push_back (db::Polygon (db::Box (x, y, x + w, y + w / 2 + 1)));
+      }
+
+    }
+  }
+
+  return in;
+}
+
+static std::vector<db::Polygon> band_test_merge (const std::vector<db::Polygon> &in, unsigned int threads)
+{
+  db::EdgeProcessor ep;
+  ep.set_threads (threads);
+
+  size_t n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = in.begin (); p != in.end (); ++p, ++n) {
+    ep.insert (*p, n);
+  }
+
+  std::vector<db::Polygon> out;
+  db::PolygonContainer pc (out);
+  db::PolygonGenerator pg (pc, false /*don't resolve holes*/, false /*min. coherence*/);
+  db::MergeOp op (0);
+  ep.process (pg, op);
+
+  return out;
+}
+
+static std::vector<db::Polygon> band_test_boolean (const std::vector<db::Polygon> &in, unsigned int threads, db::BooleanOp::BoolOp mode)
+{
+  db::EdgeProcessor ep;
+  ep.set_threads (threads);
+
+  size_t n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = in.begin (); p != in.end (); ++p, ++n) {
+    ep.insert (*p, n);
+  }
+
+  std::vector<db::Polygon> out;
+  db::PolygonContainer pc (out);
+  db::PolygonGenerator pg (pc, true /*resolve holes*/, true /*min. coherence*/);
+  db::BooleanOp op (mode);
+  ep.process (pg, op);
+
+  return out;
+}
+
+//  multi-threaded, band-parallel processing
+TEST(200)
+{
+  for (int aa = 0; aa < 2; ++aa) {
+
+    std::vector<db::Polygon> in = band_test_input (aa != 0);
+
+    std::vector<db::Polygon> ref = band_test_merge (in, 0);
+    EXPECT_EQ (ref.empty (), false);
+
+    std::vector<db::Polygon> out = band_test_merge (in, 4);
+    EXPECT_EQ (out.size (), ref.size ());
+    EXPECT_EQ (out == ref, true);
+
+    ref = band_test_boolean (in, 0, db::BooleanOp::Xor);
+    out = band_test_boolean (in, 3, db::BooleanOp::Xor);
+    EXPECT_EQ (out.size (), ref.size ());
+    EXPECT_EQ (out == ref, true);
+
+  }
+}
+
+//  multi-threaded processing with shapes crossing the band boundaries
+TEST(201)
+{
+  std::vector<db::Polygon> in = band_test_input (false);
+  //  a big box covering everything
+  in.push_back (db::Polygon (db::Box (-10, -10, 10, 50000)));
+
+  std::vector<db::Polygon> ref = band_test_merge (in, 0);
+  std::vector<db::Polygon> out = band_test_merge (in, 4);
+  EXPECT_EQ (out.size (), ref.size ());
+  EXPECT_EQ (out == ref, true);
+}
+
+static std::vector<db::Polygon> band_test_dense_input (bool all_angle)
+{
+  std::vector<db::Polygon> in;
+
+  //  overlapping shapes without gaps, some of them on a coarse grid so they share 
+  //  edges and end points and some tall ones crossing many bands
+  unsigned int seed = 5;
+  for (int i = 0; i < 8000; ++i) {
+
+    seed = seed * 1103515245 + 12345;
+    db::Coord x = db::Coord ((seed >> 8) % 20000);
+    seed = seed * 1103515245 + 12345;
+    db::Coord y = db::Coord ((seed >> 8) % 20000);
+    seed = seed * 1103515245 + 12345;
+    db::Coord w = 1 + db::Coord ((seed >> 8) % 400);
+
+    if (all_angle && (i % 5) == 0) {
+      db::Point pts[] = { db::Point (x, y), db::Point (x + w, y + w), db::Point (x + 2 * w, y), db::Point (x + w / 3, y + w / 7) };
+      db::Polygon p;
+      p.assign_hull (&pts[0], &pts[sizeof (pts) / sizeof (pts[0])]);
+      in.push_back (p);
+    } else if ((i % 3) == 0) {
+      x = (x / 100) * 100;
+      y = (y / 100) * 100;
+      in.push_back (db::Polygon (db::Box (x, y, x + 100 * (1 + w % 5), y + 100 * (1 + w % 7))));
+    } else if ((i % 500) == 0) {
+      in.push_back (db::Polygon (db::Box (x, -10, x + w, 20500)));
+    } else {
+      in.push_back (db::Polygon (db::Box (x, y, x + w, y + 2 * w)));
+    }
+
+  }
+
+  return in;
+}
+
+static void band_test_sinks (tl::TestBase *_this, const std::vector<db::Polygon> &in, db::EdgeEvaluatorBase &op, unsigned int threads)
+{
+  for (int sink = 0; sink < 4; ++sink) {
+
+    std::vector<db::Polygon> ref, out;
+    std::vector<db::Edge> ref_edges, out_edges;
+
+    for (int pass = 0; pass < 2; ++pass) {
+
+      db::EdgeProcessor ep;
+      ep.set_threads (pass == 0 ? 0 : threads);
+
+      size_t n = 0;
+      for (std::vector<db::Polygon>::const_iterator p = in.begin (); p != in.end (); ++p, ++n) {
+        ep.insert (*p, n % 2);
+      }
+
+      std::vector<db::Polygon> &polygons = (pass == 0 ? ref : out);
+      std::vector<db::Edge> &edges = (pass == 0 ? ref_edges : out_edges);
+
+      db::PolygonContainer pc (polygons);
+      db::EdgeContainer ec (edges);
+
+      if (sink == 0) {
+        ep.process (ec, op);
+      } else if (sink == 1) {
+        db::TrapezoidGenerator tg (pc);
+        ep.process (tg, op);
+      } else {
+        db::PolygonGenerator pg (pc, sink == 2 /*resolve holes*/, sink == 2 /*min. coherence*/);
+        //  without compression, vertexes where edges were clipped would show up
+        pg.enable_compression (sink == 2);
+        ep.process (pg, op);
+      }
+
+    }
+
+    EXPECT_EQ (ref.size () + ref_edges.size () > 0, true);
+    EXPECT_EQ (out.size (), ref.size ());
+    EXPECT_EQ (out == ref, true);
+    EXPECT_EQ (out_edges.size (), ref_edges.size ());
+    EXPECT_EQ (out_edges == ref_edges, true);
+
+  }
+}
+
+//  multi-threaded processing with clipping and stitching at the band boundaries
+TEST(202)
+{
+  for (int aa = 0; aa < 2; ++aa) {
+
+    std::vector<db::Polygon> in = band_test_dense_input (aa != 0);
+
+    db::MergeOp merge (0);
+    band_test_sinks (_this, in, merge, 4);
+
+    db::BooleanOp xor_op (db::BooleanOp::Xor);
+    band_test_sinks (_this, in, xor_op, 3);
+
+    db::BooleanOp and_op (db::BooleanOp::And);
+    band_test_sinks (_this, in, and_op, 16);
+
+    db::SimpleMerge simple_merge (-1);
+    band_test_sinks (_this, in, simple_merge, 2);
+
+  }
+}
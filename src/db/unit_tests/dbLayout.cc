@@ -23,6 +23,8 @@
 
 
 #include "dbLayout.h"
+#include "dbMemStatistics.h"
+#include "dbStatic.h"
 #include "tlString.h"
 #include "tlUnitTest.h"
 
@@ -464,3 +466,157 @@ TEST(4)
   prop_id = g.properties_repository ().properties_id (ps);
   EXPECT_EQ (el.property_ids_dirty, true);
 }
+
+namespace
+{
+
+class TotalMemStatistics
+  : public db::MemStatistics
+{
+public:
+  TotalMemStatistics () : size (0), used (0) { }
+
+  virtual void add (const std::type_info & /*ti*/, void * /*ptr*/, size_t s, size_t u, void * /*parent*/, purpose_t /*purpose*/, int /*cat*/)
+  {
+    size += s;
+    used += u;
+  }
+
+  size_t size, used;
+};
+
+}
+
+static void fill_small_polygons (db::Layout &ly)
+{
+  unsigned int l = ly.insert_layer (db::LayerProperties (1, 0));
+  db::Cell &top = ly.cell (ly.add_cell ("TOP"));
+
+  for (int i = 0; i < 200000; ++i) {
+    db::Point pts[] = { db::Point (0, 0), db::Point (0, 100 + i % 1000), db::Point (30, 50), db::Point (100 + i / 1000, 0) };
+    db::Polygon p;
+    p.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+    top.shapes (l).insert (db::PolygonRef (p, ly.shape_repository ()));
+  }
+}
+
+TEST(5)
+{
+  //  contour arena allocation
+  db::Layout heap_layout (false);
+  EXPECT_EQ (heap_layout.is_contour_arena_enabled (), false);
+  EXPECT_EQ (heap_layout.contour_arena () == 0, true);
+
+  db::Layout arena_layout (false);
+  arena_layout.set_contour_arena_enabled (true);
+  EXPECT_EQ (arena_layout.is_contour_arena_enabled (), true);
+  EXPECT_EQ (arena_layout.contour_arena () != 0, true);
+
+  fill_small_polygons (heap_layout);
+  fill_small_polygons (arena_layout);
+
+  db::Layout copy (arena_layout);
+  EXPECT_EQ (copy.is_contour_arena_enabled (), true);
+  EXPECT_EQ (copy.contour_arena () != arena_layout.contour_arena (), true);
+
+  const db::Shapes &hs = heap_layout.cell (0).shapes (0);
+  const db::Shapes &as = arena_layout.cell (0).shapes (0);
+  EXPECT_EQ (hs.size (), size_t (200000));
+  EXPECT_EQ (as.size (), size_t (200000));
+
+  db::ShapeIterator h = hs.begin (db::ShapeIterator::All);
+  db::ShapeIterator a = as.begin (db::ShapeIterator::All);
+  for ( ; ! h.at_end () && ! a.at_end (); ++h, ++a) {
+    EXPECT_EQ (h->to_string (), a->to_string ());
+  }
+  EXPECT_EQ (h.at_end () && a.at_end (), true);
+
+  //  the unique polygons in the shape repository with 4 points each
+  size_t n = arena_layout.shape_repository ().repository (db::Polygon::tag ()).size ();
+  EXPECT_EQ (n, size_t (200000));
+  EXPECT_EQ (arena_layout.contour_arena ()->used_bytes (), n * 4 * sizeof (db::Point));
+
+  TotalMemStatistics heap_stat, arena_stat;
+  heap_layout.mem_stat (&heap_stat, db::MemStatistics::LayoutInfo, 0);
+  arena_layout.mem_stat (&arena_stat, db::MemStatistics::LayoutInfo, 0);
+
+  //  the memory statistics do not include the heap allocator overhead, but the unused part of the arena
+  size_t heap_blocks = n * db::ContourArena::heap_block_size (4 * sizeof (db::Point));
+  size_t arena_blocks = arena_layout.contour_arena ()->reserved_bytes ();
+
+  tl::info << "Memory with heap allocation: " << heap_stat.size << " bytes (+" << heap_blocks - n * 4 * sizeof (db::Point) << " bytes estimated allocator overhead)";
+  tl::info << "Memory with arena allocation: " << arena_stat.size << " bytes";
+
+  EXPECT_EQ (arena_stat.size > heap_stat.size + (arena_blocks - n * 4 * sizeof (db::Point)), true);
+  EXPECT_EQ (arena_blocks < heap_blocks, true);
+
+  arena_layout.clear ();
+  EXPECT_EQ (arena_layout.contour_arena ()->used_bytes (), size_t (0));
+}
+
+static void
+fill_for_sorting (db::Layout &ly)
+{
+  unsigned int l = ly.insert_layer (db::LayerProperties (1, 0));
+
+  //  one cell with a big layer which is sorted with multiple threads itself
+  db::Cell &big = ly.cell (ly.add_cell ("BIG"));
+  for (int i = 0; i < 150000; ++i) {
+    int x = (i * 7919) % 100000, y = (i * 104729) % 100000;
+    big.shapes (l).insert (db::Box (x, y, x + 10 + i % 50, y + 10 + i % 30));
+  }
+
+  //  many small cells which are sorted in parallel
+  for (int c = 0; c < 20; ++c) {
+    db::Cell &small = ly.cell (ly.add_cell (("C" + tl::to_string (c)).c_str ()));
+    for (int i = 0; i < 2000; ++i) {
+      int x = (i * 7919 + c * 17) % 20000, y = (i * 104729 + c * 13) % 20000;
+      small.shapes (l).insert (db::Box (x, y, x + 100, y + 100));
+    }
+  }
+}
+
+static std::string
+touching_shapes (const db::Layout &ly, const db::Box &region)
+{
+  std::string r;
+  for (db::Layout::const_iterator c = ly.begin (); c != ly.end (); ++c) {
+    r += c->get_basic_name ();
+    r += ":";
+    for (db::ShapeIterator s = c->shapes (0).begin_touching (region, db::ShapeIterator::All); ! s.at_end (); ++s) {
+      r += s->to_string ();
+      r += ";";
+    }
+  }
+  return r;
+}
+
+TEST(6)
+{
+  //  multi-threaded sorting
+  EXPECT_EQ (db::Layout ().sort_threads (), db::default_sort_threads ());
+  EXPECT_EQ (db::default_sort_threads () >= 1, true);
+
+  db::Layout ly_single (false), ly_multi (false);
+  ly_single.set_sort_threads (1);
+  ly_multi.set_sort_threads (4);
+
+  fill_for_sorting (ly_single);
+  fill_for_sorting (ly_multi);
+
+  ly_single.update ();
+  ly_multi.update ();
+
+  //  the trees are identical, hence the queries deliver the shapes in the same order
+  db::Box regions[] = { db::Box (0, 0, 1000, 1000), db::Box (5000, 15000, 5100, 25000), db::Box (99000, 0, 100000, 100000) };
+  for (unsigned int i = 0; i < sizeof (regions) / sizeof (regions[0]); ++i) {
+    std::string s = touching_shapes (ly_single, regions [i]);
+    EXPECT_EQ (s.size () > 1000, true);
+    EXPECT_EQ (touching_shapes (ly_multi, regions [i]) == s, true);
+  }
+
+  //  modifications are sorted again
+  ly_multi.cell (0).shapes (0).insert (db::Box (-100, -100, -50, -50));
+  ly_multi.update ();
+  EXPECT_EQ (touching_shapes (ly_multi, db::Box (-200, -200, -40, -40)), "BIG:box (-100,-100;-50,-50);C0:C1:C2:C3:C4:C5:C6:C7:C8:C9:C10:C11:C12:C13:C14:C15:C16:C17:C18:C19:");
+}
@@ -29,9 +29,11 @@
 #include "dbText.h"
 #include "dbShapeRepository.h"
 #include "tlReuseVector.h"
+#include "tlThreads.h"
 #include "tlUnitTest.h"
 
 #include <vector>
+#include <memory>
 
 namespace
 {
@@ -1339,3 +1341,124 @@ TEST(28)
   db::Polygon b (db::Box (-1000000000, -1000000000, 1000000000, 1000000000));
   EXPECT_EQ (b.perimeter (), 8000000000.0);
 }
+
+TEST(29)
+{
+  //  contour arena
+  std::auto_ptr<db::ContourArena> arena (new db::ContourArena (1024));
+
+  EXPECT_EQ (db::ContourArena::current () == 0, true);
+
+  std::vector<db::Polygon> polygons;
+
+  {
+    db::ContourArenaScope scope (arena.get ());
+    EXPECT_EQ (db::ContourArena::current () == arena.get (), true);
+
+    for (int i = 0; i < 100; ++i) {
+      db::Point pts[] = { db::Point (0, 0), db::Point (0, 100 + i), db::Point (100, 0) };
+      db::Polygon p;
+      p.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+      polygons.push_back (p);
+    }
+
+    //  a null scope does not change the current arena
+    db::ContourArenaScope null_scope (0);
+    EXPECT_EQ (db::ContourArena::current () == arena.get (), true);
+
+    EXPECT_EQ (arena->used_bytes (), size_t (100 * 3 * sizeof (db::Point)));
+    EXPECT_EQ (arena->reserved_bytes () >= arena->used_bytes (), true);
+  }
+
+  EXPECT_EQ (db::ContourArena::current () == 0, true);
+  EXPECT_EQ (polygons [17].to_string (), "(0,0;0,117;100,0)");
+
+  //  copies made outside the scope live on the heap
+  std::vector<db::Polygon> copies (polygons.begin (), polygons.end ());
+  EXPECT_EQ (arena->used_bytes (), size_t (100 * 3 * sizeof (db::Point)));
+  polygons.erase (polygons.begin () + 50, polygons.end ());
+  EXPECT_EQ (arena->used_bytes (), size_t (50 * 3 * sizeof (db::Point)));
+  EXPECT_EQ (copies [77].to_string (), "(0,0;0,177;100,0)");
+
+  //  the contours may outlive the arena
+  arena.reset (0);
+  EXPECT_EQ (polygons [42].to_string (), "(0,0;0,142;100,0)");
+  polygons.clear ();
+
+  //  big blocks
+  arena.reset (new db::ContourArena (1024));
+  {
+    db::ContourArenaScope scope (arena.get ());
+    std::vector<db::Point> pts;
+    for (int i = 0; i < 1000; ++i) {
+      pts.push_back (db::Point (i, i * i));
+    }
+    db::Polygon p;
+    p.assign_hull (pts.begin (), pts.end (), false /*don't compress*/);
+    EXPECT_EQ (arena->used_bytes (), size_t (1000 * sizeof (db::Point)));
+    EXPECT_EQ (p.hull ().size (), size_t (1000));
+  }
+  EXPECT_EQ (arena->used_bytes (), size_t (0));
+  EXPECT_EQ (arena->reserved_bytes (), size_t (0));
+}
+
+namespace
+{
+
+class ArenaTestThread
+  : public tl::Thread
+{
+public:
+  ArenaTestThread (std::vector<db::Polygon> *polygons)
+    : mp_polygons (polygons)
+  { }
+
+  virtual void run ()
+  {
+    //  each thread works on its own arena and releases contours of a foreign one
+    db::ContourArena arena (1024);
+    db::ContourArenaScope scope (&arena);
+    for (int n = 0; n < 100; ++n) {
+      std::vector<db::Polygon> polygons;
+      for (int i = 0; i < 100; ++i) {
+        polygons.push_back (db::Polygon (db::Box (0, 0, 100, 100 + i)));
+      }
+    }
+    mp_polygons->clear ();
+  }
+
+private:
+  std::vector<db::Polygon> *mp_polygons;
+};
+
+}
+
+TEST(30)
+{
+  //  contour arenas used from multiple threads
+  std::vector<std::vector<db::Polygon> > polygons (4);
+
+  {
+    db::ContourArena arena (1024);
+    db::ContourArenaScope scope (&arena);
+    for (size_t t = 0; t < polygons.size (); ++t) {
+      for (int i = 0; i < 100; ++i) {
+        polygons [t].push_back (db::Polygon (db::Box (0, 0, 100, 100 + i)));
+      }
+    }
+    EXPECT_EQ (arena.used_bytes (), size_t (400 * 4 * sizeof (db::Point)));
+  }
+
+  //  the arena is gone: the contours are released by the threads
+  std::vector<ArenaTestThread *> threads;
+  for (size_t t = 0; t < polygons.size (); ++t) {
+    threads.push_back (new ArenaTestThread (&polygons [t]));
+    threads.back ()->start ();
+  }
+
+  for (size_t t = 0; t < threads.size (); ++t) {
+    threads [t]->wait ();
+    delete threads [t];
+    EXPECT_EQ (polygons [t].empty (), true);
+  }
+}
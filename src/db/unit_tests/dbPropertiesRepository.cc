@@ -24,6 +24,8 @@
 #include "dbPropertiesRepository.h"
 #include "tlString.h"
 #include "tlUnitTest.h"
+#include "tlThreads.h"
+#include "tlTimer.h"
 
 
 TEST(1) 
@@ -259,3 +261,239 @@ TEST(6)
   EXPECT_EQ (pid2, size_t (2));
 }
 
+
+TEST(7)
+{
+  //  change_properties and translate with the hashed index
+  db::PropertiesRepository rep;
+
+  db::PropertiesRepository::properties_set set1;
+  set1.insert (std::make_pair (rep.prop_name_id (tl::Variant ("net")), tl::Variant ("VDD")));
+  db::properties_id_type pid1 = rep.properties_id (set1);
+
+  db::PropertiesRepository::properties_set set2;
+  set2.insert (std::make_pair (rep.prop_name_id (tl::Variant ("net")), tl::Variant ("VSS")));
+
+  rep.change_properties (pid1, set2);
+  EXPECT_EQ (rep.properties (pid1) == set2, true);
+  EXPECT_EQ (rep.properties_id (set2), pid1);
+  EXPECT_EQ (rep.properties_id (set1) != pid1, true);
+  EXPECT_EQ (rep.properties_ids_by_name_value (*set2.begin ()).size (), size_t (1));
+  EXPECT_EQ (rep.properties_ids_by_name_value (*set1.begin ()).size (), size_t (1));
+
+  //  numerical values are equal irrespective of their type
+  db::PropertiesRepository::properties_set set3;
+  set3.insert (std::make_pair (rep.prop_name_id (tl::Variant (17)), tl::Variant (42)));
+  db::PropertiesRepository::properties_set set4;
+  set4.insert (std::make_pair (rep.prop_name_id (tl::Variant (17.0)), tl::Variant (42.0)));
+  EXPECT_EQ (rep.properties_id (set3), rep.properties_id (set4));
+
+  db::PropertiesRepository rep2;
+  rep2.prop_name_id (tl::Variant ("other"));
+  db::properties_id_type pid2 = rep2.translate (rep, pid1);
+  EXPECT_EQ (rep2.prop_name (rep2.properties (pid2).begin ()->first).to_string (), std::string ("net"));
+  EXPECT_EQ (rep2.properties (pid2).begin ()->second.to_string (), std::string ("VSS"));
+
+  db::PropertiesRepository rep3;
+  rep3 = rep;
+  EXPECT_EQ (rep3.properties_id (set2), pid1);
+  EXPECT_EQ (rep3.properties_id (set3), rep.properties_id (set3));
+}
+
+namespace
+{
+
+class PropertiesIdThread
+  : public tl::Thread
+{
+public:
+  PropertiesIdThread (db::PropertiesRepository *rep, int offset, int n)
+    : mp_rep (rep), m_offset (offset), m_n (n), m_errors (0)
+  { }
+
+  void run ()
+  {
+    db::property_names_id_type name_id = mp_rep->prop_name_id (tl::Variant ("net"));
+    for (int i = 0; i < m_n; ++i) {
+      //  the threads use overlapping sets
+      int v = (i + m_offset) % m_n;
+      db::PropertiesRepository::properties_set ps;
+      ps.insert (std::make_pair (name_id, tl::Variant (v)));
+      db::properties_id_type id = mp_rep->properties_id (ps);
+      if (mp_rep->properties (id) != ps) {
+        ++m_errors;
+      }
+    }
+  }
+
+  int errors () const
+  {
+    return m_errors;
+  }
+
+private:
+  db::PropertiesRepository *mp_rep;
+  int m_offset, m_n, m_errors;
+};
+
+class PropertiesReaderThread
+  : public tl::Thread
+{
+public:
+  PropertiesReaderThread (const db::PropertiesRepository *rep, db::property_names_id_type name_id, int n)
+    : mp_rep (rep), m_name_id (name_id), m_n (n), m_errors (0)
+  { }
+
+  void run ()
+  {
+    //  reads the sets by Id while they are being registered
+    db::properties_id_type id = 1;
+    while (id <= db::properties_id_type (m_n)) {
+      db::properties_id_type end_id = mp_rep->end_id ();
+      for ( ; id < end_id; ++id) {
+        if (! mp_rep->is_valid_properties_id (id)) {
+          ++m_errors;
+        }
+        const db::PropertiesRepository::properties_set &ps = mp_rep->properties (id);
+        if (ps.size () != 1 || ps.begin ()->first != m_name_id || ps.begin ()->second != tl::Variant (int (id) - 1)) {
+          ++m_errors;
+        }
+        if (mp_rep->prop_name (m_name_id) != tl::Variant ("net")) {
+          ++m_errors;
+        }
+      }
+    }
+  }
+
+  int errors () const
+  {
+    return m_errors;
+  }
+
+private:
+  const db::PropertiesRepository *mp_rep;
+  db::property_names_id_type m_name_id;
+  int m_n, m_errors;
+};
+
+}
+
+TEST(8)
+{
+  //  concurrent lookup and insert
+  db::PropertiesRepository rep;
+
+  const int n = 20000;
+  const int nthreads = 4;
+
+  std::vector<PropertiesIdThread *> threads;
+  for (int i = 0; i < nthreads; ++i) {
+    threads.push_back (new PropertiesIdThread (&rep, i * 1000, n));
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    threads [i]->start ();
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    threads [i]->wait ();
+    EXPECT_EQ (threads [i]->errors (), 0);
+    delete threads [i];
+  }
+
+  //  empty set plus n distinct ones
+  EXPECT_EQ (size_t (rep.end_id ()), size_t (n + 1));
+
+  db::property_names_id_type name_id = rep.prop_name_id (tl::Variant ("net"));
+  for (int i = 0; i < n; ++i) {
+    db::PropertiesRepository::properties_set ps;
+    ps.insert (std::make_pair (name_id, tl::Variant (i)));
+    EXPECT_EQ (rep.properties_ids_by_name_value (*ps.begin ()).size (), size_t (1));
+  }
+}
+
+TEST(8b)
+{
+  //  lock-free reading by Id while new sets are registered
+  db::PropertiesRepository rep;
+
+  const int n = 100000;
+  const int nthreads = 4;
+
+  db::property_names_id_type name_id = rep.prop_name_id (tl::Variant ("net"));
+
+  std::vector<PropertiesReaderThread *> threads;
+  for (int i = 0; i < nthreads; ++i) {
+    threads.push_back (new PropertiesReaderThread (&rep, name_id, n));
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    threads [i]->start ();
+  }
+
+  for (int i = 0; i < n; ++i) {
+    db::PropertiesRepository::properties_set ps;
+    ps.insert (std::make_pair (name_id, tl::Variant (i)));
+    rep.properties_id (ps);
+    //  more names, so the name table grows too
+    rep.prop_name_id (tl::Variant (i));
+  }
+
+  for (int i = 0; i < nthreads; ++i) {
+    threads [i]->wait ();
+    EXPECT_EQ (threads [i]->errors (), 0);
+    delete threads [i];
+  }
+
+  EXPECT_EQ (size_t (rep.end_id ()), size_t (n + 1));
+  EXPECT_EQ (rep.is_valid_properties_id (db::properties_id_type (n + 1)), false);
+  EXPECT_EQ (rep.properties (db::properties_id_type (n + 1)).empty (), true);
+
+  //  the copy holds the same sets under the same Id's
+  db::PropertiesRepository rep2;
+  rep2 = rep;
+  EXPECT_EQ (size_t (rep2.end_id ()), size_t (n + 1));
+  for (int i = 0; i < n; i += 997) {
+    db::PropertiesRepository::properties_set ps;
+    ps.insert (std::make_pair (name_id, tl::Variant (i)));
+    EXPECT_EQ (rep2.properties_id (ps), db::properties_id_type (i + 1));
+    EXPECT_EQ (rep2.properties (db::properties_id_type (i + 1)) == ps, true);
+  }
+  EXPECT_EQ (size_t (rep2.end_id ()), size_t (n + 1));
+}
+
+TEST(9)
+{
+  //  benchmark: one properties set per shape as for net-annotated layouts
+  db::PropertiesRepository rep;
+
+  const int n = 1000000;
+
+  db::property_names_id_type net_id = rep.prop_name_id (tl::Variant ("net"));
+  db::property_names_id_type index_id = rep.prop_name_id (tl::Variant (1));
+
+  {
+    tl::SelfTimer timer (tl::verbosity () >= 11, "properties_id (insert)");
+    for (int i = 0; i < n; ++i) {
+      db::PropertiesRepository::properties_set ps;
+      ps.insert (std::make_pair (net_id, tl::Variant ("NET_" + tl::to_string (i / 4))));
+      ps.insert (std::make_pair (index_id, tl::Variant (i)));
+      rep.properties_id (ps);
+    }
+  }
+
+  EXPECT_EQ (size_t (rep.end_id ()), size_t (n + 1));
+
+  int mismatches = 0;
+
+  {
+    tl::SelfTimer timer (tl::verbosity () >= 11, "properties_id (lookup)");
+    for (int i = 0; i < n; ++i) {
+      db::PropertiesRepository::properties_set ps;
+      ps.insert (std::make_pair (net_id, tl::Variant ("NET_" + tl::to_string (i / 4))));
+      ps.insert (std::make_pair (index_id, tl::Variant (i)));
+      if (rep.properties_id (ps) != db::properties_id_type (i + 1)) {
+        ++mismatches;
+      }
+    }
+  }
+
+  EXPECT_EQ (mismatches, 0);
+}
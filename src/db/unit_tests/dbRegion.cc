@@ -24,6 +24,8 @@
 #include "tlUnitTest.h"
 
 #include "dbRegion.h"
+#include "dbEdges.h"
+#include "dbLayout.h"
 #include "dbBoxScanner.h"
 
 #include <cstdio>
@@ -1329,6 +1331,118 @@ TEST(30c)
   EXPECT_EQ (r.to_string (), "(-100,-100;-100,0;0,0;0,200;100,200;100,0;0,0;0,-100)");
 }
 
+static std::vector<db::EdgePair> sorted_edge_pairs (const db::EdgePairs &ep)
+{
+  //  NOTE: for single-layer checks, the order of the edges inside the edge pair depends on
+  //  the scan order, so we compare a canonical form
+  std::vector<db::EdgePair> v;
+  for (db::EdgePairs::const_iterator e = ep.begin (); e != ep.end (); ++e) {
+    db::EdgePair swapped (e->second (), e->first ());
+    v.push_back (swapped < *e ? swapped : *e);
+  }
+  std::sort (v.begin (), v.end ());
+  return v;
+}
+
+static std::vector<db::Polygon> sorted_polygons (const db::Region &r)
+{
+  std::vector<db::Polygon> v;
+  for (db::Region::const_iterator p = r.begin (); ! p.at_end (); ++p) {
+    v.push_back (*p);
+  }
+  std::sort (v.begin (), v.end ());
+  return v;
+}
+
+TEST(31)
+{
+  //  multi-threaded checks and edge interactions deliver the same results than single-threaded ones
+  srand (1);
+
+  db::Region r, rr;
+  for (unsigned int i = 0; i < 5000; ++i) {
+    db::Coord x = rand () % 40000, y = rand () % 40000;
+    r.insert (db::Box (x, y, x + 20 + rand () % 200, y + 20 + rand () % 200));
+    x = rand () % 40000, y = rand () % 40000;
+    rr.insert (db::Box (x, y, x + 20 + rand () % 200, y + 20 + rand () % 200));
+  }
+
+  db::Edges e;
+  for (unsigned int i = 0; i < 3000; ++i) {
+    db::Coord x = rand () % 40000, y = rand () % 40000;
+    e.insert (db::Edge (x, y, x + rand () % 100, y + rand () % 100));
+  }
+
+  db::Region rmt (r);
+  rmt.set_threads (4);
+
+  EXPECT_EQ (r.space_check (100).size () > 0, true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.space_check (100)) == sorted_edge_pairs (r.space_check (100)), true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.space_check (100, true)) == sorted_edge_pairs (r.space_check (100, true)), true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.isolated_check (150)) == sorted_edge_pairs (r.isolated_check (150)), true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.width_check (50)) == sorted_edge_pairs (r.width_check (50)), true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.notch_check (100)) == sorted_edge_pairs (r.notch_check (100)), true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.separation_check (rr, 100)) == sorted_edge_pairs (r.separation_check (rr, 100)), true);
+  EXPECT_EQ (sorted_edge_pairs (rmt.inside_check (rr, 100)) == sorted_edge_pairs (r.inside_check (rr, 100)), true);
+
+  EXPECT_EQ (r.selected_interacting (e).size () > 0, true);
+  EXPECT_EQ (sorted_polygons (rmt.selected_interacting (e)) == sorted_polygons (r.selected_interacting (e)), true);
+  EXPECT_EQ (sorted_polygons (rmt.selected_not_interacting (e)) == sorted_polygons (r.selected_not_interacting (e)), true);
+
+  db::Region rsel (rmt);
+  rsel.select_interacting (e);
+  EXPECT_EQ (sorted_polygons (rsel) == sorted_polygons (r.selected_interacting (e)), true);
+}
+
+TEST(32)
+{
+  //  hierarchical count
+  db::Layout ly;
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = ly.insert_layer (db::LayerProperties (2, 0));
+  unsigned int l3 = ly.insert_layer (db::LayerProperties (3, 0));
+
+  db::Cell &top = ly.cell (ly.add_cell ("TOP"));
+  db::Cell &child = ly.cell (ly.add_cell ("CHILD"));
+
+  child.shapes (l1).insert (db::Box (0, 0, 100, 100));
+  child.shapes (l1).insert (db::Box (200, 0, 300, 100));
+  child.shapes (l1).insert (db::Box (0, 200, 100, 300));
+  child.shapes (l2).insert (db::Box (0, 0, 100, 100));
+  child.shapes (l3).insert (db::Edge (0, 0, 100, 100));
+  child.shapes (l3).insert (db::Edge (0, 100, 100, 0));
+  top.shapes (l1).insert (db::Box (-1000, -1000, -500, -500));
+  top.insert (db::CellInstArray (db::CellInst (child.cell_index ()), db::Trans (), db::Vector (1000, 0), db::Vector (0, 1000), 10, 10));
+
+  db::Region r (db::RecursiveShapeIterator (ly, top, l1));
+  EXPECT_EQ (r.hier_count (), size_t (4));
+  EXPECT_EQ (r.size (), size_t (301));
+
+  std::vector<unsigned int> layers;
+  layers.push_back (l1);
+  layers.push_back (l2);
+  db::Region r12 (db::RecursiveShapeIterator (ly, top, layers));
+  EXPECT_EQ (r12.hier_count (), size_t (5));
+
+  db::Region rc (db::RecursiveShapeIterator (ly, child, l1));
+  EXPECT_EQ (rc.hier_count (), size_t (3));
+
+  db::Edges e (db::RecursiveShapeIterator (ly, top, l3), false /*as edges*/);
+  EXPECT_EQ (e.hier_count (), size_t (2));
+  EXPECT_EQ (e.size (), size_t (200));
+
+  //  polygons are converted into edges immediately
+  db::Edges ep (db::RecursiveShapeIterator (ly, top, l1));
+  EXPECT_EQ (ep.hier_count (), size_t (1204));
+
+  //  flat collections count their polygons or edges
+  r.insert (db::Box (0, 0, 10, 10));
+  EXPECT_EQ (r.hier_count (), size_t (302));
+  EXPECT_EQ (db::Region ().hier_count (), size_t (0));
+  e.insert (db::Edge (0, 0, 10, 10));
+  EXPECT_EQ (e.hier_count (), size_t (201));
+}
+
 TEST(issue_228)
 {
   db::Region r;
@@ -31,7 +31,9 @@
 #include "dbText.h"
 #include "dbEdge.h"
 #include "dbUserObject.h"
+#include "dbMemStatistics.h"
 #include "tlUnitTest.h"
+#include "tlTimer.h"
 
 
 TEST(1) 
@@ -408,3 +410,76 @@ TEST(4)
 
 }
 
+
+namespace
+{
+
+class TotalMemStatistics
+  : public db::MemStatistics
+{
+public:
+  TotalMemStatistics ()
+    : size (0), used (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  virtual void add (const std::type_info & /*ti*/, void * /*ptr*/, size_t s, size_t u, void * /*parent*/, purpose_t /*purpose*/, int /*cat*/)
+  {
+    size += s;
+    used += u;
+  }
+
+  size_t size, used;
+};
+
+}
+
+//  Performance and memory footprint of the polygon repository
+TEST(5)
+{
+  db::GenericRepository rep;
+
+  std::vector<db::PolygonRef> refs;
+  refs.reserve (400000);
+
+  {
+    tl::SelfTimer timer ("Insert 400000 polygons (100000 unique ones)");
+
+    for (unsigned int n = 0; n < 4; ++n) {
+      for (unsigned int i = 0; i < 100000; ++i) {
+
+        db::Coord w = 100 + db::Coord (i % 1000);
+        db::Coord h = 100 + db::Coord (i / 1000);
+
+        //  an L shape
+        db::Point pts[] = {
+          db::Point (0, 0), db::Point (0, h), db::Point (w / 2, h), 
+          db::Point (w / 2, h / 2), db::Point (w, h / 2), db::Point (w, 0)
+        };
+
+        db::Polygon poly;
+        poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+        poly.move (db::Vector (db::Coord (n * 10000), db::Coord (i)));
+
+        refs.push_back (db::PolygonRef (poly, rep));
+
+      }
+    }
+  }
+
+  EXPECT_EQ (rep.repository (db::Polygon::tag ()).size (), size_t (100000));
+  EXPECT_EQ (refs [17].ptr () == refs [200017].ptr (), true);
+  EXPECT_EQ (refs [17].ptr () == refs [18].ptr (), false);
+  EXPECT_EQ (refs [200017].instantiate ().box (), db::Box (20000, 17, 20117, 117));
+
+  //  the shapes are delivered in the order they have been inserted
+  db::repository<db::Polygon>::iterator p = rep.repository (db::Polygon::tag ()).begin ();
+  EXPECT_EQ (&*p == refs [0].ptr (), true);
+  ++p;
+  EXPECT_EQ (&*p == refs [1].ptr (), true);
+
+  TotalMemStatistics ms;
+  rep.mem_stat (&ms, db::MemStatistics::ShapesInfo, 0, false, 0);
+  tl::info << "Repository memory: " << ms.size << " bytes (" << ms.used << " used)";
+}
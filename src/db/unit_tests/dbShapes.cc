@@ -26,6 +26,9 @@
 #include "tlTimer.h"
 #include "tlUnitTest.h"
 #include "dbStatic.h"
+#include "dbMemStatistics.h"
+
+#include <algorithm>
 
 
 TEST(1) 
@@ -3263,6 +3266,144 @@ TEST(22)
   EXPECT_EQ (shapes.find (*s).to_string (), "null");
 }
 
+namespace
+{
+
+class TotalShapesMemStatistics
+  : public db::MemStatistics
+{
+public:
+  TotalShapesMemStatistics () : size (0) { }
+
+  virtual void add (const std::type_info & /*ti*/, void * /*ptr*/, size_t s, size_t /*u*/, void * /*parent*/, purpose_t /*purpose*/, int /*cat*/)
+  {
+    size += s;
+  }
+
+  size_t size;
+};
+
+}
+
+static std::vector<std::string> flat_shapes (const db::Shapes &shapes)
+{
+  std::vector<std::string> res;
+  for (db::Shapes::shape_iterator s = shapes.begin (db::ShapeIterator::All); ! s.at_end (); ++s) {
+    db::Polygon poly;
+    s->polygon (poly);
+    res.push_back (poly.to_string ());
+  }
+  std::sort (res.begin (), res.end ());
+  return res;
+}
+
+//  Shapes::compact
+TEST(23)
+{
+  db::Manager m;
+  db::Layout layout (false, &m);
+  unsigned int l = layout.insert_layer (db::LayerProperties (1, 0));
+  db::Cell &top = layout.cell (layout.add_cell ("TOP"));
+  db::Shapes &shapes = top.shapes (l);
+
+  //  a complete via grid (regular array)
+  for (int i = 0; i < 100; ++i) {
+    for (int j = 0; j < 100; ++j) {
+      shapes.insert (db::Box (i * 200, j * 300, i * 200 + 100, j * 300 + 120));
+    }
+  }
+
+  //  irregularly placed boxes (iterated array)
+  for (int i = 0; i < 50; ++i) {
+    shapes.insert (db::Box (-1000 - i * i, 0, -900 - i * i, 50));
+  }
+
+  //  single boxes stay as they are
+  shapes.insert (db::Box (0, -1000, 10, -900));
+  shapes.insert (db::Box (0, -2000, 20, -1900));
+
+  //  polygon references
+  db::SimplePolygon sp (db::Box (0, 0, 50, 50));
+  db::Polygon p;
+  db::Point pts[] = { db::Point (0, 0), db::Point (0, 100), db::Point (50, 150), db::Point (100, 0) };
+  p.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+  for (int i = 0; i < 20; ++i) {
+    shapes.insert (db::SimplePolygonRef (sp.moved (db::Vector (50000 + i * 100, 0)), layout.shape_repository ()));
+    shapes.insert (db::PolygonRef (p.moved (db::Vector (60000, i * 7 + i * i)), layout.shape_repository ()));
+  }
+  shapes.insert (db::PolygonRef (p.moved (db::Vector (70000, 0)), layout.shape_repository ()));
+
+  shapes.update ();
+  std::vector<std::string> before = flat_shapes (shapes);
+  db::Box bbox_before = shapes.bbox ();
+
+  TotalShapesMemStatistics stat_before;
+  layout.mem_stat (&stat_before, db::MemStatistics::LayoutInfo, 0);
+
+  EXPECT_EQ (shapes.compact (), size_t (100 * 100 + 50 + 20 + 21));
+  EXPECT_EQ (shapes.size (), size_t (2 + 2 + 1 + 1));
+
+  shapes.update ();
+  EXPECT_EQ (shapes.bbox () == bbox_before, true);
+
+  std::vector<std::string> after = flat_shapes (shapes);
+  EXPECT_EQ (before.size (), after.size ());
+  EXPECT_EQ (before == after, true);
+
+  TotalShapesMemStatistics stat_after;
+  layout.mem_stat (&stat_after, db::MemStatistics::LayoutInfo, 0);
+  tl::info << "Memory before compaction: " << stat_before.size << " bytes, after: " << stat_after.size << " bytes";
+  //  NOTE: the reduction is that large because most shapes are on a regular grid
+  EXPECT_EQ (stat_after.size * 10 < stat_before.size, true);
+
+  //  a second pass does not change anything
+  EXPECT_EQ (shapes.compact (), size_t (0));
+  EXPECT_EQ (flat_shapes (shapes) == before, true);
+
+  //  editable layouts are not compacted
+  db::Layout elayout (true, &m);
+  unsigned int el = elayout.insert_layer (db::LayerProperties (1, 0));
+  db::Cell &etop = elayout.cell (elayout.add_cell ("TOP"));
+  for (int i = 0; i < 10; ++i) {
+    etop.shapes (el).insert (db::Box (i * 200, 0, i * 200 + 100, 100));
+  }
+  EXPECT_EQ (etop.shapes (el).compact (), size_t (0));
+  EXPECT_EQ (etop.shapes (el).size (), size_t (10));
+}
+
+//  Shapes::compact and undo
+TEST(24)
+{
+  db::Manager m;
+  db::Layout layout (false, &m);
+  unsigned int l = layout.insert_layer (db::LayerProperties (1, 0));
+  db::Cell &top = layout.cell (layout.add_cell ("TOP"));
+  db::Shapes &shapes = top.shapes (l);
+
+  m.transaction ("insert");
+  for (int i = 0; i < 10; ++i) {
+    shapes.insert (db::Box (i * 200, 0, i * 200 + 100, 100));
+  }
+
+  //  not permitted inside a transaction
+  bool error = false;
+  try {
+    shapes.compact ();
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+  EXPECT_EQ (shapes.size (), size_t (10));
+
+  m.commit ();
+  EXPECT_EQ (m.available_undo ().first, true);
+
+  //  the undo history is cleared as it refers to the uncompacted shapes
+  EXPECT_EQ (shapes.compact (), size_t (10));
+  EXPECT_EQ (shapes.size (), size_t (1));
+  EXPECT_EQ (m.available_undo ().first, false);
+}
+
 //  Bug #107
 TEST(100)
 {
@@ -31,6 +31,7 @@
 #include "dbSaveLayoutOptions.h"
 
 #include <cstdlib>
+#include <set>
 #include <QMutex>
 #include <QMutexLocker>
 
@@ -448,3 +449,84 @@ TEST(5)
   EXPECT_EQ (sum, 2500000000);
   EXPECT_EQ (num, 134225);
 }
+
+//  The scripts are parsed once per thread and reused: variables
+//  must not survive from one tile to the next one.
+TEST(6)
+{
+  db::Layout ly1;
+  ly1.dbu (0.001);
+  unsigned int l11 = ly1.insert_layer (db::LayerProperties (1, 0));
+  db::cell_index_type top1 = ly1.add_cell ("TOP");
+  ly1.cell (top1).shapes (l11).insert (db::Box (0, 0, 10000, 10000));
+
+  db::Layout out;
+  unsigned int o1 = out.insert_layer ();
+  db::cell_index_type otop = out.add_cell ("TOP");
+
+  db::TilingProcessor tp;
+  tp.set_threads (2);
+  tp.tile_size (1.0, 1.0);
+  tp.input ("i1", db::RecursiveShapeIterator (ly1, ly1.cell (top1), l11));
+  tp.output ("o1", out, otop, o1);
+  tp.queue ("var n; n || _output(o1, _tile.bbox); n = 1");
+  tp.execute ("test");
+
+  EXPECT_EQ (out.cell (otop).shapes (o1).size (), size_t (100));
+
+  EXPECT_EQ (tp.parse_time () >= 0.0, true);
+  EXPECT_EQ (tp.eval_time () >= 0.0, true);
+  EXPECT_EQ (tp.output_time () > 0.0, true);
+
+  //  scheduler statistics: one entry per thread
+  EXPECT_EQ (tp.statistics ().size (), size_t (2));
+  size_t ntasks = 0;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = tp.statistics ().begin (); s != tp.statistics ().end (); ++s) {
+    ntasks += s->tasks;
+    EXPECT_EQ (s->stolen <= s->tasks, true);
+  }
+  EXPECT_EQ (ntasks, size_t (100));
+}
+
+static std::set<std::string> edge_pair_set (const db::EdgePairs &ep)
+{
+  std::set<std::string> s;
+  for (db::EdgePairs::const_iterator e = ep.begin (); e != ep.end (); ++e) {
+    std::string a = e->first ().to_string (), b = e->second ().to_string ();
+    s.insert (a < b ? a + ";" + b : b + ";" + a);
+  }
+  return s;
+}
+
+//  Edge pairs touching several tiles are delivered once
+TEST(7)
+{
+  db::Layout ly;
+  ly.dbu (0.001);
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+  db::cell_index_type top = ly.add_cell ("TOP");
+
+  //  pairs of boxes with a 20 DBU gap - some of them straddle the tile boundaries
+  for (int i = 0; i < 500; ++i) {
+    db::Coord x = db::Coord (get_rand () % 9900), y = db::Coord (get_rand () % 9900);
+    ly.cell (top).shapes (l1).insert (db::Box (x, y, x + 40, y + 40));
+    ly.cell (top).shapes (l1).insert (db::Box (x + 60, y, x + 100, y + 40));
+  }
+
+  db::Region r (db::RecursiveShapeIterator (ly, ly.cell (top), l1));
+  db::EdgePairs ref = r.space_check (50);
+
+  db::EdgePairs ep;
+
+  db::TilingProcessor tp;
+  tp.set_threads (2);
+  tp.tile_size (1.0, 1.0);
+  tp.tile_border (0.1, 0.1);
+  tp.input ("i1", db::RecursiveShapeIterator (ly, ly.cell (top), l1));
+  tp.output ("o1", ep);
+  tp.queue ("_output(o1, i1.space_check(50))");
+  tp.execute ("test");
+
+  EXPECT_EQ (ep.size (), ref.size ());
+  EXPECT_EQ (edge_pair_set (ep) == edge_pair_set (ref), true);
+}
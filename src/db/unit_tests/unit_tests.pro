@@ -16,6 +16,8 @@ SOURCES = \
   dbCellHullGenerator.cc \
   dbCellMapping.cc \
   dbClip.cc \
+  dbCoordArray.cc \
+  dbDeepRegion.cc \
   dbExpression.cc \
   dbEdge.cc \
   dbEdgePair.cc \
@@ -141,3 +141,31 @@ TEST(3)
 
   db::compare_layouts (_this, layout, au, db::NoNormalization);
 }
+
+TEST(4)
+{
+  std::string rs = tl::testsrc ();
+  rs += "/testdata/drc/drcSimpleTests_4.drc";
+
+  std::string input = tl::testsrc ();
+  input += "/testdata/drc/drctest.gds";
+
+  std::string output = this->tmp_file ("tmp.gds");
+
+  {
+    //  Set some variables
+    lym::Macro config;
+    config.set_text (tl::sprintf (
+        "$drc_test_source = '%s'\n"
+        "$drc_test_target = '%s'\n"
+      , input, output)
+    );
+    config.set_interpreter (lym::Macro::Ruby);
+    EXPECT_EQ (config.run (), 0);
+  }
+
+  //  the script compares the automatically tiled results against the flat ones
+  lym::Macro drc;
+  drc.load_from (rs);
+  EXPECT_EQ (drc.run (), 0);
+}
@@ -66,6 +66,27 @@ public:
   }
 };
 
+/**
+ *  @brief Describes a contiguous block of memory provided by an object
+ *
+ *  The block is a two-dimensional array of items. "format" is the item format
+ *  in the notation of the Python struct module (e.g. "i" for int, "q" for long long).
+ */
+struct GSI_PUBLIC BufferInfo
+{
+  BufferInfo ()
+    : data (0), item_size (0), format (0), rows (0), columns (0), readonly (true)
+  {
+    //  .. nothing yet ..
+  }
+
+  void *data;
+  size_t item_size;
+  const char *format;
+  size_t rows, columns;
+  bool readonly;
+};
+
 /**
  *  @brief The basic object to declare a class
  *
@@ -523,6 +544,28 @@ public:
     return 0;
   }
 
+  /**
+   *  @brief Returns true, if the objects of this class provide their data as a contiguous block of memory
+   *
+   *  Script languages can use this block for direct access to the data (e.g. through the
+   *  Python buffer protocol). See get_buffer.
+   */
+  virtual bool provides_buffer () const
+  {
+    return false;
+  }
+
+  /**
+   *  @brief Gets the data block of the given object
+   *
+   *  Returns false, if the object does not provide a data block. The block stays valid
+   *  as long as the object lives and is not modified otherwise.
+   */
+  virtual bool get_buffer (void * /*obj*/, BufferInfo & /*info*/) const
+  {
+    return false;
+  }
+
   /**
    *  @brief Returns true, if the class is an external class provided by Python or Ruby code
    */
@@ -32,14 +32,14 @@ namespace gsi
 //  Implementation of MethodBase
 
 MethodBase::MethodBase (const std::string &name, const std::string &doc, bool c, bool s)
-  : m_doc (doc), m_const (c), m_static (s), m_protected (false), m_argsize (0)
+  : m_doc (doc), m_const (c), m_static (s), m_protected (false), m_long_running (false), m_argsize (0)
 { 
   reset_called ();
   parse_name (name);
 }
 
 MethodBase::MethodBase (const std::string &name, const std::string &doc)
-  : m_doc (doc), m_const (false), m_static (false), m_protected (false), m_argsize (0)
+  : m_doc (doc), m_const (false), m_static (false), m_protected (false), m_long_running (false), m_argsize (0)
 { 
   reset_called ();
   parse_name (name);
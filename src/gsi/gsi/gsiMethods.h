@@ -268,6 +268,26 @@ public:
     m_const = c;
   }
 
+  /**
+   *  @brief Gets a value indicating whether the method is a long-running one
+   *
+   *  Script interpreters may use this hint to let other script threads run while
+   *  the method executes (e.g. by releasing the Python GIL). Callbacks into the
+   *  script are still possible, but the interpreter needs to take care of them.
+   */
+  bool is_long_running () const
+  {
+    return m_long_running;
+  }
+
+  /**
+   *  @brief Sets a value indicating whether the method is a long-running one
+   */
+  void set_long_running (bool lr)
+  {
+    m_long_running = lr;
+  }
+
   /**
    *  @brief Gets a value indicating whether the method is a static method
    */
@@ -525,6 +545,7 @@ private:
   bool m_const : 1;
   bool m_static : 1;
   bool m_protected : 1;
+  bool m_long_running : 1;
   unsigned int m_argsize;
   std::vector<MethodSynonym> m_method_synonyms;
 
@@ -685,6 +706,21 @@ inline Methods operator+ (const Methods &a, const Methods &b)
   return Methods (a) + b;
 }
 
+/**
+ *  @brief Marks the given methods as long-running ones
+ *
+ *  Use this function to wrap method declarations of expensive operations, e.g.
+ *  "long_running (method (...))". See MethodBase::is_long_running for details.
+ */
+inline Methods long_running (const Methods &m)
+{
+  Methods lr (m);
+  for (Methods::iterator i = lr.begin (); i != lr.end (); ++i) {
+    (*i)->set_long_running (true);
+  }
+  return lr;
+}
+
 template <class X>
 class MethodSpecificBase 
   : public MethodBase
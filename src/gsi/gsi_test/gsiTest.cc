@@ -1098,7 +1098,9 @@ static gsi::Class<F> decl_f ("", "F",
   gsi::method ("icref", &F::icref) +
   gsi::method ("incref", &F::incref) +
   gsi::method ("x=", &F::set_x) +
-  gsi::method ("x", &F::get_x) 
+  gsi::method ("x", &F::get_x) +
+  gsi::method ("ov", &F::ov_ref) +
+  gsi::method ("ov", &F::ov_int)
 );
 
 static gsi::Class<G> decl_g ("", "G",
@@ -927,6 +927,8 @@ struct F
   static F &incref();
   void set_x(int i) { x = i; }
   int get_x() const { return x; }
+  static std::string ov_ref(F &) { return "F&"; }
+  static std::string ov_int(int) { return "int"; }
 
   int x;
   static std::auto_ptr<F> f_inst;
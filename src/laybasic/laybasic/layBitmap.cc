@@ -23,9 +23,12 @@
 
 #include "layBitmap.h"
 #include "layBitmapRenderer.h"
+#include "layBitmapSIMD.h"
 #include "layFixedFont.h"
 #include "tlAlgorithm.h"
 
+#include <cstring>
+
 namespace lay {
 
 Bitmap::Bitmap ()
@@ -63,11 +66,7 @@ Bitmap::operator= (const Bitmap &d)
 
     for (unsigned int i = 0; i < m_height; ++i) {
       if (! d.m_scanlines.empty () && d.m_scanlines [i] != 0) {
-        uint32_t *sl = scanline (i);
-        uint32_t *ss = d.m_scanlines [i];
-        for (unsigned int b = (m_width + 31) / 32; b > 0; --b) {
-          *sl++ = *ss++;
-        }
+        memcpy (scanline (i), d.m_scanlines [i], sizeof (uint32_t) * ((m_width + 31) / 32));
       } else if (! m_scanlines.empty () && m_scanlines [i] != 0) {
         m_free.push_back (m_scanlines [i]);
         m_scanlines [i] = 0;
@@ -102,9 +101,7 @@ Bitmap::scanline (unsigned int n)
     } else {
       sl = m_scanlines [n] = new uint32_t [b];
     }
-    for (uint32_t *p = sl; b > 0; --b) {
-      *p++ = 0;
-    }
+    bitmap_fill_words (sl, b, 0);
     if (m_first_sl > n) {
       m_first_sl = n;
     }
@@ -221,14 +218,11 @@ Bitmap::merge (const lay::Bitmap *from, int dx, int dy)
       uint32_t *sl_to = scanline (n + dy);
 
       if (! s1) {
-        for (unsigned int i = 0; i < m; ++i) {
-          *sl_to++ |= *sl_from++;
-        }
+        bitmap_or_words (sl_to, sl_from, m);
       } else if (m) {
-        for (unsigned int i = 1; i < m; ++i) {
-          *sl_to++ |= (sl_from[1] << s2) | (sl_from[0] >> s1);
-          ++sl_from;
-        }
+        bitmap_or_words_shifted (sl_to, sl_from + 1, m - 1, s2);
+        sl_to += m - 1;
+        sl_from += m - 1;
         if (mm > m - 1) {
           *sl_to++ |= (sl_from[0] >> s1);
         }
@@ -255,15 +249,12 @@ Bitmap::merge (const lay::Bitmap *from, int dx, int dy)
       uint32_t *sl_to = scanline (n + dy) + mo;
 
       if (! s1) {
-        for (unsigned int i = 0; i < m; ++i) {
-          *sl_to++ |= *sl_from++;
-        }
+        bitmap_or_words (sl_to, sl_from, m);
       } else if (m) {
         *sl_to++ |= (sl_from[0] << s1);
-        for (unsigned int i = 1; i < m; ++i) {
-          *sl_to++ |= (sl_from[0] >> s2) | (sl_from[1] << s1);
-          ++sl_from;
-        }
+        bitmap_or_words_shifted (sl_to, sl_from + 1, m - 1, s1);
+        sl_to += m - 1;
+        sl_from += m - 1;
         if (mm > m) {
           *sl_to++ |= (sl_from[0] >> s2);
         }
@@ -290,6 +281,9 @@ Bitmap::fill_pattern (int y, int x, const uint32_t *pp, unsigned int stride, uns
 
     while (n > 0 && y >= 0) {
 
+      //  the scanline is fetched once per line and only if required
+      uint32_t *sl0 = 0;
+
       for (unsigned int s = 0; s < stride; ++s) {
 
         int x1 = x + s * 32;
@@ -308,8 +302,11 @@ Bitmap::fill_pattern (int y, int x, const uint32_t *pp, unsigned int stride, uns
 
           unsigned int bx = ((unsigned int) x1) & ~(32 - 1);
 
-          uint32_t *sl = scanline (y);
-          sl += bx / 32;
+          if (! sl0) {
+            sl0 = scanline (y);
+          }
+
+          uint32_t *sl = sl0 + bx / 32;
 
           *sl |= (p << ((unsigned int)x1 - bx));
 
@@ -365,9 +362,10 @@ Bitmap::fill (unsigned int y, unsigned int x1, unsigned int x2)
   } else if (b > 0) {
 
     *sl++ |= ~masks [x1 % 32];
-    while (b > 1) {
-      *sl++ |= all_ones;
-      b--;
+    if (b > 1) {
+      //  NOTE: or'ing with all ones is the same than setting the words
+      bitmap_fill_words (sl, b - 1, all_ones);
+      sl += b - 1;
     }
 
     unsigned int m = masks [x2 % 32];
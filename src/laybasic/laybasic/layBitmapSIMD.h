@@ -0,0 +1,182 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_layBitmapSIMD
+#define HDR_layBitmapSIMD
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define LAY_BITMAP_SSE2
+#  include <emmintrin.h>
+#endif
+
+/**
+ *  @brief Scanline primitives for the bitmap renderers
+ *
+ *  These functions operate on runs of 32 bit scanline words. They use SSE2
+ *  (available on every x86_64 CPU) if the compiler supports it and fall back
+ *  to plain word loops otherwise. All functions accept unaligned pointers.
+ */
+
+namespace lay
+{
+
+/**
+ *  @brief Sets n words starting at p to the value v
+ */
+inline void
+bitmap_fill_words (uint32_t *p, unsigned int n, uint32_t v)
+{
+#if defined(LAY_BITMAP_SSE2)
+  __m128i vv = _mm_set1_epi32 (int (v));
+  for ( ; n >= 4; n -= 4, p += 4) {
+    _mm_storeu_si128 ((__m128i *) p, vv);
+  }
+#endif
+  for ( ; n > 0; --n) {
+    *p++ = v;
+  }
+}
+
+/**
+ *  @brief Or's n words from "from" into "to"
+ */
+inline void
+bitmap_or_words (uint32_t *to, const uint32_t *from, unsigned int n)
+{
+#if defined(LAY_BITMAP_SSE2)
+  for ( ; n >= 4; n -= 4, to += 4, from += 4) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) to);
+    __m128i b = _mm_loadu_si128 ((const __m128i *) from);
+    _mm_storeu_si128 ((__m128i *) to, _mm_or_si128 (a, b));
+  }
+#endif
+  for ( ; n > 0; --n) {
+    *to++ |= *from++;
+  }
+}
+
+/**
+ *  @brief Or's n words from "from" into "to" with a bit shift
+ *
+ *  This function computes "to[i] |= (from[i] << s) | (from[i - 1] >> (32 - s))".
+ *  Hence from[-1] must be a valid word. s must be between 1 and 31.
+ */
+inline void
+bitmap_or_words_shifted (uint32_t *to, const uint32_t *from, unsigned int n, unsigned int s)
+{
+#if defined(LAY_BITMAP_SSE2)
+  __m128i sl = _mm_cvtsi32_si128 (int (s));
+  __m128i sr = _mm_cvtsi32_si128 (int (32 - s));
+  for ( ; n >= 4; n -= 4, to += 4, from += 4) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) to);
+    __m128i b = _mm_sll_epi32 (_mm_loadu_si128 ((const __m128i *) from), sl);
+    __m128i c = _mm_srl_epi32 (_mm_loadu_si128 ((const __m128i *) (from - 1)), sr);
+    _mm_storeu_si128 ((__m128i *) to, _mm_or_si128 (a, _mm_or_si128 (b, c)));
+  }
+#endif
+  for ( ; n > 0; --n, ++from) {
+    *to++ |= (from [0] << s) | (from [-1] >> (32 - s));
+  }
+}
+
+/**
+ *  @brief Stores n words of "from" masked with a constant pattern into "to"
+ *
+ *  This function computes "to[i] = from[i] & pattern".
+ */
+inline void
+bitmap_and_words (uint32_t *to, const uint32_t *from, unsigned int n, uint32_t pattern)
+{
+#if defined(LAY_BITMAP_SSE2)
+  __m128i pp = _mm_set1_epi32 (int (pattern));
+  for ( ; n >= 4; n -= 4, to += 4, from += 4) {
+    __m128i b = _mm_loadu_si128 ((const __m128i *) from);
+    _mm_storeu_si128 ((__m128i *) to, _mm_and_si128 (b, pp));
+  }
+#endif
+  for ( ; n > 0; --n) {
+    *to++ = *from++ & pattern;
+  }
+}
+
+/**
+ *  @brief Applies one plane's word to a run of 32 color pixels
+ *
+ *  For each bit k set in "d", this function computes
+ *  "y[k] |= (first & z[k]) | fill" and "z[k] &= second".
+ *  n is the number of valid pixels (up to 32).
+ */
+inline void
+bitmap_merge_pixels (uint32_t *y, uint32_t *z, uint32_t d, uint32_t first, uint32_t second, uint32_t fill, unsigned int n)
+{
+  unsigned int k = 0;
+
+#if defined(LAY_BITMAP_SSE2)
+  if (n == 32) {
+
+    const __m128i vbits = _mm_set_epi32 (8, 4, 2, 1);
+    const __m128i vfirst = _mm_set1_epi32 (int (first));
+    const __m128i vsecond = _mm_set1_epi32 (int (second));
+    const __m128i vfill = _mm_set1_epi32 (int (fill));
+
+    for ( ; k < 32; k += 4, d >>= 4) {
+
+      if ((d & 0xf) == 0) {
+        continue;
+      }
+
+      //  expand the 4 bits into lane masks
+      __m128i m = _mm_cmpeq_epi32 (_mm_and_si128 (_mm_set1_epi32 (int (d & 0xf)), vbits), vbits);
+
+      __m128i vy = _mm_loadu_si128 ((const __m128i *) (y + k));
+      __m128i vz = _mm_loadu_si128 ((const __m128i *) (z + k));
+
+      vy = _mm_or_si128 (vy, _mm_and_si128 (m, _mm_or_si128 (_mm_and_si128 (vfirst, vz), vfill)));
+      vz = _mm_and_si128 (vz, _mm_or_si128 (vsecond, _mm_andnot_si128 (m, _mm_set1_epi32 (-1))));
+
+      _mm_storeu_si128 ((__m128i *) (y + k), vy);
+      _mm_storeu_si128 ((__m128i *) (z + k), vz);
+
+    }
+
+    return;
+
+  }
+#endif
+
+  uint32_t m = 1;
+  for ( ; k < n; ++k, m <<= 1) {
+    if ((d & m) != 0) {
+      y [k] |= (first & z [k]) | fill;
+      z [k] &= second;
+    }
+  }
+}
+
+}
+
+#endif
+
@@ -23,6 +23,7 @@
 
 #include "layBitmapsToImage.h"
 #include "layBitmap.h"
+#include "layBitmapSIMD.h"
 #include "layDitherPattern.h"
 #include "layLineStyles.h"
 #include "tlTimer.h"
@@ -31,6 +32,8 @@
 #include <QMutex>
 #include <QImage>
 
+#include <algorithm>
+
 namespace lay
 {
 
@@ -40,6 +43,12 @@ render_scanline_std (const uint32_t *dp, unsigned int ds, const lay::Bitmap *pbi
   const uint32_t *ps = pbitmap->scanline (y);
   const uint32_t *dm = dp;
 
+  if (ds == 1) {
+    //  single-word patterns are the common case
+    bitmap_and_words (data, ps, (w + lay::wordlen - 1) / lay::wordlen, *dp);
+    return;
+  }
+
   unsigned int x = w;
   while (x >= lay::wordlen) {
     *data++ = *ps++ & *dm++;
@@ -621,25 +630,7 @@ bitmaps_to_image_rgb (const std::vector<lay::ViewOp> &view_ops_in,
 
           uint32_t d = *dptr;
           if (d != 0) {
-
-            if (transparent) {
-              uint32_t m = 1;
-              for (unsigned int k = 0; k < 32 && x + k < width; ++k, m <<= 1) {
-                if ((d & m) != 0) {
-                  y [k] |= (masks [j].first & z [k]) | fill_bits;
-                  z [k] &= masks [j].second;
-                }
-              }
-            } else {
-              uint32_t m = 1;
-              for (unsigned int k = 0; k < 32 && x + k < width; ++k, m <<= 1) {
-                if ((d & m) != 0) {
-                  y [k] |= masks [j].first & z [k];
-                  z [k] &= masks [j].second;
-                }
-              }
-            }
-
+            bitmap_merge_pixels (y, z, d, masks [j].first, masks [j].second, transparent ? fill_bits : 0, std::min (32u, width - x));
           }
 
           dptr -= nwords;
@@ -836,18 +827,15 @@ bitmaps_to_image_mono (const std::vector<lay::ViewOp> &view_ops_in,
 
         dptr = dptr_end - nwords + i;
         for (int j = int (masks.size () - 1); j >= 0; --j) {
-          uint32_t d = *dptr;
-          if (d != 0) {
-            uint32_t m = 1;
-            for (unsigned int k = 0; k < 32 && x + k < width; ++k, m <<= 1) {
-              if ((d & m) != 0) { 
-                if (masks [j].first & needed_bits) {
-                  y |= (z & m);
-                }
-                if (! (masks [j].second & needed_bits)) {
-                  z &= ~m;
-                }
-              }
+          //  mask out the bits beyond the image width
+          uint32_t d = *dptr & (width - x < 32 ? (uint32_t (1) << (width - x)) - 1 : lay::wordones);
+          if (d != 0) { 
+            //  the pixels are independent, so the whole word can be processed at once
+            if (masks [j].first & needed_bits) {
+              y |= (z & d);
+            }
+            if (! (masks [j].second & needed_bits)) {
+              z &= ~d;
             }
           }
           dptr -= nwords;
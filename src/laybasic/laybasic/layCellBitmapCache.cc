@@ -0,0 +1,197 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layCellBitmapCache.h"
+
+#include <math.h>
+
+namespace lay
+{
+
+// -------------------------------------------------------------
+//  CellBitmapCacheKey implementation
+
+static int
+cache_phase (double c)
+{
+  return int (floor ((c - floor (c)) * cell_bitmap_cache_phase_steps + 0.5)) % cell_bitmap_cache_phase_steps;
+}
+
+CellBitmapCacheKey::CellBitmapCacheKey (int cv, unsigned int l, bool xf, const CellCacheKey &k, const db::DPoint &offset)
+  : cv_index (cv), layer (l), xfill (xf), phase_x (cache_phase (offset.x ())), phase_y (cache_phase (offset.y ())), key (k)
+{
+  //  .. nothing yet ..
+}
+
+bool
+CellBitmapCacheKey::operator< (const CellBitmapCacheKey &other) const
+{
+  if (cv_index != other.cv_index) {
+    return cv_index < other.cv_index;
+  }
+  if (layer != other.layer) {
+    return layer < other.layer;
+  }
+  if (xfill != other.xfill) {
+    return xfill < other.xfill;
+  }
+  if (phase_x != other.phase_x) {
+    return phase_x < other.phase_x;
+  }
+  if (phase_y != other.phase_y) {
+    return phase_y < other.phase_y;
+  }
+  return key < other.key;
+}
+
+// -------------------------------------------------------------
+//  CellBitmapCache implementation
+
+static size_t
+bitmap_memory (const lay::Bitmap *bitmap)
+{
+  return bitmap ? size_t ((bitmap->width () + 31) / 32) * sizeof (uint32_t) * bitmap->height () : 0;
+}
+
+CellBitmapCache::CellBitmapCache ()
+  : m_size (0), m_max_size (cell_bitmap_cache_default_size), m_generation (0)
+{
+  //  .. nothing yet ..
+}
+
+CellBitmapCache::~CellBitmapCache ()
+{
+  do_clear ();
+}
+
+void
+CellBitmapCache::set_max_size (size_t bytes)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  m_max_size = bytes;
+  while (m_size > m_max_size && ! m_lru.empty ()) {
+    erase (m_cache.find (m_lru.front ()));
+  }
+}
+
+void
+CellBitmapCache::clear ()
+{
+  tl::MutexLocker locker (&m_lock);
+  do_clear ();
+}
+
+void
+CellBitmapCache::validate (const std::string &state)
+{
+  tl::MutexLocker locker (&m_lock);
+  if (state != m_state) {
+    m_state = state;
+    do_clear ();
+  }
+}
+
+size_t
+CellBitmapCache::size () const
+{
+  tl::MutexLocker locker (&m_lock);
+  return m_size;
+}
+
+size_t
+CellBitmapCache::generation () const
+{
+  tl::MutexLocker locker (&m_lock);
+  return m_generation;
+}
+
+bool
+CellBitmapCache::take (const CellBitmapCacheKey &key, CellCacheInfo &info)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  cache_t::iterator e = m_cache.find (key);
+  if (e == m_cache.end ()) {
+    return false;
+  }
+
+  std::swap (info.fill, e->second.info.fill);
+  std::swap (info.frame, e->second.info.frame);
+  std::swap (info.vertex, e->second.info.vertex);
+  std::swap (info.text, e->second.info.text);
+
+  erase (e);
+  return true;
+}
+
+void
+CellBitmapCache::put (const CellBitmapCacheKey &key, CellCacheInfo &info, size_t generation)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  size_t size = bitmap_memory (info.fill) + bitmap_memory (info.frame) + bitmap_memory (info.vertex) + bitmap_memory (info.text);
+  if (generation != m_generation || size > m_max_size) {
+    return;
+  }
+
+  cache_t::iterator e = m_cache.find (key);
+  if (e != m_cache.end ()) {
+    erase (e);
+  }
+
+  while (m_size + size > m_max_size && ! m_lru.empty ()) {
+    erase (m_cache.find (m_lru.front ()));
+  }
+
+  e = m_cache.insert (std::make_pair (key, Entry ())).first;
+  std::swap (info.fill, e->second.info.fill);
+  std::swap (info.frame, e->second.info.frame);
+  std::swap (info.vertex, e->second.info.vertex);
+  std::swap (info.text, e->second.info.text);
+  e->second.info.offset = info.offset;
+  e->second.size = size;
+  e->second.lru = m_lru.insert (m_lru.end (), key);
+
+  m_size += size;
+}
+
+void
+CellBitmapCache::do_clear ()
+{
+  m_cache.clear ();
+  m_lru.clear ();
+  m_size = 0;
+  ++m_generation;
+}
+
+void
+CellBitmapCache::erase (cache_t::iterator e)
+{
+  m_size -= e->second.size;
+  m_lru.erase (e->second.lru);
+  m_cache.erase (e);
+}
+
+}
+
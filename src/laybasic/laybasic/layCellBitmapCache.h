@@ -0,0 +1,222 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef HDR_layCellBitmapCache
+#define HDR_layCellBitmapCache
+
+#include "laybasicCommon.h"
+#include "layBitmap.h"
+#include "dbTypes.h"
+#include "dbTrans.h"
+#include "dbPoint.h"
+#include "tlThreads.h"
+
+#include <map>
+#include <list>
+#include <string>
+
+namespace lay
+{
+
+//  the sub-pixel resolution of the persistent cell bitmap cache
+const int cell_bitmap_cache_phase_steps = 16;
+//  the default memory limit of the persistent cell bitmap cache
+const size_t cell_bitmap_cache_default_size = 128 * 1024 * 1024;
+
+/**
+ *  @brief An entry in the drawing cache
+ */
+struct CellCacheKey 
+{
+public:
+  CellCacheKey (int n, db::cell_index_type c, const db::CplxTrans &t) 
+    : nlevels (n), ci (c), trans (t)
+  { }
+
+  int nlevels;
+  db::cell_index_type ci;
+  db::CplxTrans trans;
+
+  bool operator< (const CellCacheKey &other) const
+  {
+    if (nlevels != other.nlevels) {
+      return nlevels < other.nlevels;
+    }
+    if (ci != other.ci) {
+      return ci < other.ci;
+    }
+    if (! trans.equal (other.trans)) {
+      return trans.less (other.trans);
+    }
+    return false;
+  }
+};
+
+/**
+ *  @brief An value in the drawing cache
+ */
+struct CellCacheInfo 
+{
+public:
+  CellCacheInfo ()
+    : hits (0), fill (0), frame (0), vertex (0), text (0)
+  { }
+
+  ~CellCacheInfo () 
+  {
+    delete fill;
+    fill = 0;
+    delete frame;
+    frame = 0;
+    delete vertex;
+    vertex = 0;
+    delete text;
+    text = 0;
+  }
+
+  size_t hits;
+  db::DPoint offset;
+  lay::Bitmap *fill, *frame, *vertex, *text;
+};
+
+/**
+ *  @brief The key for the persistent cell bitmap cache
+ *
+ *  In addition to the per-redraw cache key, this key identifies the cellview, layer
+ *  and fill mode and the sub-pixel phase of the bitmap's offset. The phase is
+ *  quantized to 1/cell_bitmap_cache_phase_steps pixels.
+ */
+struct LAYBASIC_PUBLIC CellBitmapCacheKey
+{
+public:
+  CellBitmapCacheKey (int cv, unsigned int l, bool xf, const CellCacheKey &k, const db::DPoint &offset);
+
+  int cv_index;
+  unsigned int layer;
+  bool xfill;
+  int phase_x, phase_y;
+  CellCacheKey key;
+
+  bool operator< (const CellBitmapCacheKey &other) const;
+};
+
+/**
+ *  @brief A persistent cache for rasterized cell bitmaps
+ *
+ *  This cache keeps the bitmaps of cached cell variants across redraws, so
+ *  repeated pans and zooms don't need to rasterize the same cell variants again.
+ *  The cache is bounded in memory: when the limit is exceeded, the least recently
+ *  used bitmaps are discarded.
+ *
+ *  Entries are taken out of the cache by the workers during drawing and given
+ *  back when the drawing task has finished. Every "clear" increments a generation
+ *  counter: bitmaps drawn in an earlier generation are not accepted.
+ *
+ *  The cache is thread-safe.
+ */
+class LAYBASIC_PUBLIC CellBitmapCache
+{
+public:
+  CellBitmapCache ();
+  ~CellBitmapCache ();
+
+  /**
+   *  @brief Sets the maximum memory used by the cache in bytes
+   */
+  void set_max_size (size_t bytes);
+
+  /**
+   *  @brief Gets the maximum memory used by the cache in bytes
+   */
+  size_t max_size () const
+  {
+    return m_max_size;
+  }
+
+  /**
+   *  @brief Gets the memory presently used by the cache in bytes
+   */
+  size_t size () const;
+
+  /**
+   *  @brief Discards all cached bitmaps
+   */
+  void clear ();
+
+  /**
+   *  @brief Discards all cached bitmaps if the given drawing state is different from the previous one
+   *
+   *  The state is an arbitrary string which represents all settings affecting the
+   *  bitmaps.
+   */
+  void validate (const std::string &state);
+
+  /**
+   *  @brief Gets the current generation
+   */
+  size_t generation () const;
+
+  /**
+   *  @brief Takes the bitmaps for the given key out of the cache
+   *
+   *  If there is an entry for this key, its bitmaps are transferred into "info" and
+   *  the entry is removed from the cache. In that case, this method returns true.
+   */
+  bool take (const CellBitmapCacheKey &key, CellCacheInfo &info);
+
+  /**
+   *  @brief Gives the bitmaps of "info" to the cache
+   *
+   *  The bitmaps are transferred into the cache and removed from "info". "generation" is
+   *  the generation at which the bitmaps were drawn. If the cache has been cleared since then,
+   *  the bitmaps are discarded.
+   */
+  void put (const CellBitmapCacheKey &key, CellCacheInfo &info, size_t generation);
+
+private:
+  struct Entry
+  {
+    Entry () : size (0) { }
+    CellCacheInfo info;
+    size_t size;
+    std::list<CellBitmapCacheKey>::iterator lru;
+  };
+
+  typedef std::map<CellBitmapCacheKey, Entry> cache_t;
+
+  mutable tl::Mutex m_lock;
+  cache_t m_cache;
+  std::list<CellBitmapCacheKey> m_lru;
+  size_t m_size, m_max_size;
+  size_t m_generation;
+  std::string m_state;
+
+  void do_clear ();
+  void erase (cache_t::iterator e);
+
+  CellBitmapCache (const CellBitmapCache &);
+  CellBitmapCache &operator= (const CellBitmapCache &);
+};
+
+}
+
+#endif
@@ -0,0 +1,349 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layDensityPyramid.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace lay
+{
+
+// -------------------------------------------------------------
+//  DensityPyramid implementation
+
+DensityPyramid::DensityPyramid (const db::Box &region, unsigned int max_size)
+  : m_region (region), m_pixel_size (1.0)
+{
+  double w = region.empty () ? 0.0 : double (region.width ());
+  double h = region.empty () ? 0.0 : double (region.height ());
+
+  m_pixel_size = std::max (1.0, std::max (w, h) / double (std::max ((unsigned int) 1, max_size)));
+
+  unsigned int nx = (unsigned int) floor (w / m_pixel_size + 0.5) + 1;
+  unsigned int ny = (unsigned int) floor (h / m_pixel_size + 0.5) + 1;
+  m_levels.push_back (lay::Bitmap (nx, ny, 1.0));
+}
+
+db::CplxTrans
+DensityPyramid::pixel_trans () const
+{
+  return db::CplxTrans (1.0 / m_pixel_size, 0.0, false, db::DVector (-m_region.left () / m_pixel_size, -m_region.bottom () / m_pixel_size));
+}
+
+void
+DensityPyramid::mark (const db::DBox &box)
+{
+  lay::Bitmap &bitmap = m_levels.front ();
+
+  //  HINT: pixel centers are located at integer coordinates
+  double l = floor (box.left () + 0.5), r = floor (box.right () + 0.5);
+  double b = floor (box.bottom () + 0.5), t = floor (box.top () + 0.5);
+  if (r < 0.0 || t < 0.0 || l >= double (bitmap.width ()) || b >= double (bitmap.height ())) {
+    return;
+  }
+
+  unsigned int x1 = (unsigned int) std::max (0.0, l);
+  unsigned int x2 = (unsigned int) std::min (double (bitmap.width () - 1), r);
+  unsigned int y1 = (unsigned int) std::max (0.0, b);
+  unsigned int y2 = (unsigned int) std::min (double (bitmap.height () - 1), t);
+
+  for (unsigned int y = y1; y <= y2; ++y) {
+    bitmap.fill (y, x1, x2 + 1);
+  }
+}
+
+void
+DensityPyramid::mark_array (const db::DBox &box, const db::DVector &a, const db::DVector &b, unsigned long na, unsigned long nb)
+{
+  na = std::max ((unsigned long) 1, na);
+  nb = std::max ((unsigned long) 1, nb);
+
+  db::DVector ea = a * double (na - 1), eb = b * double (nb - 1);
+  db::DBox hull = box;
+  hull += box.moved (ea);
+  hull += box.moved (eb);
+  hull += box.moved (ea + eb);
+
+  //  an orthogonal array with steps of one pixel or less covers its bounding box
+  bool a_dense = (na == 1 || ((a.x () == 0.0 || a.y () == 0.0) && a.length () <= 1.0));
+  bool b_dense = (nb == 1 || ((b.x () == 0.0 || b.y () == 0.0) && b.length () <= 1.0));
+  bool orthogonal = (na == 1 || nb == 1 || (a.x () == 0.0 && b.y () == 0.0) || (a.y () == 0.0 && b.x () == 0.0));
+
+  //  with more members than pixels, the marking is approximated by the bounding box
+  double pixels = (floor (hull.width ()) + 1.0) * (floor (hull.height ()) + 1.0);
+
+  if ((orthogonal && a_dense && b_dense) || double (na) * double (nb) >= pixels) {
+    mark (hull);
+    return;
+  }
+
+  for (unsigned long j = 0; j < nb; ++j) {
+    for (unsigned long i = 0; i < na; ++i) {
+      mark (box.moved (a * double (i) + b * double (j)));
+    }
+  }
+}
+
+/**
+ *  @brief Reduces "from" to half the size by or'ing 2x2 pixel blocks into "to"
+ */
+static void
+downsample (const lay::Bitmap &from, lay::Bitmap &to)
+{
+  unsigned int words = (from.width () + 31) / 32;
+
+  for (unsigned int y = 0; y < to.height (); ++y) {
+
+    bool e1 = from.is_scanline_empty (y * 2);
+    bool e2 = (y * 2 + 1 >= from.height () || from.is_scanline_empty (y * 2 + 1));
+    if (e1 && e2) {
+      continue;
+    }
+
+    const uint32_t *s1 = e1 ? from.empty_scanline () : from.scanline (y * 2);
+    const uint32_t *s2 = e2 ? from.empty_scanline () : from.scanline (y * 2 + 1);
+    uint32_t *d = to.scanline (y);
+
+    for (unsigned int x = 0; x < words; ++x) {
+
+      uint32_t w = s1 [x] | s2 [x];
+      if (w == 0) {
+        continue;
+      }
+
+      //  or the bit pairs and compact the even bits into 16 bits
+      uint32_t p = (w | (w >> 1)) & 0x55555555;
+      p = (p | (p >> 1)) & 0x33333333;
+      p = (p | (p >> 2)) & 0x0f0f0f0f;
+      p = (p | (p >> 4)) & 0x00ff00ff;
+      p = (p | (p >> 8)) & 0x0000ffff;
+
+      d [x / 2] |= p << ((x % 2) * 16);
+
+    }
+
+  }
+}
+
+void
+DensityPyramid::finish ()
+{
+  while (m_levels.back ().width () > density_pyramid_min_size || m_levels.back ().height () > density_pyramid_min_size) {
+    lay::Bitmap next ((m_levels.back ().width () + 1) / 2, (m_levels.back ().height () + 1) / 2, 1.0);
+    downsample (m_levels.back (), next);
+    m_levels.push_back (next);
+  }
+}
+
+bool
+DensityPyramid::draw (const db::CplxTrans &trans, const std::vector<db::Box> &regions, lay::Bitmap *bitmap) const
+{
+  //  use the coarsest level whose pixels are not larger than the target pixels
+  double target_pixel_size = 1.0 / trans.mag ();
+  if (m_pixel_size > target_pixel_size || m_region.empty ()) {
+    return false;
+  }
+
+  unsigned int n = 0;
+  double ps = m_pixel_size;
+  while (n + 1 < levels () && ps * 2.0 <= target_pixel_size) {
+    ps *= 2.0;
+    ++n;
+  }
+
+  const lay::Bitmap &lb = m_levels [n];
+
+  //  transforms level pixel indexes into target pixel coordinates (for the pixel center)
+  double c = (ps - m_pixel_size) * 0.5;
+  db::DCplxTrans pt = db::DCplxTrans (trans) * db::DCplxTrans (ps, 0.0, false, db::DVector (m_region.left () + c, m_region.bottom () + c));
+  db::DCplxTrans pti = pt.inverted ();
+
+  db::Box bitmap_box (0, 0, bitmap->width () - 1, bitmap->height () - 1);
+
+  for (std::vector<db::Box>::const_iterator r = regions.begin (); r != regions.end (); ++r) {
+
+    db::Box rr = *r & bitmap_box;
+    if (rr.empty ()) {
+      continue;
+    }
+
+    //  the range of level pixels to consider
+    db::DBox lr = pti * db::DBox (db::DPoint (rr.left () - 0.5, rr.bottom () - 0.5), db::DPoint (rr.right () + 0.5, rr.top () + 0.5));
+    double l = std::max (0.0, floor (lr.left ()));
+    double b = std::max (0.0, floor (lr.bottom ()));
+    double ri = std::min (double (lb.width () - 1), ceil (lr.right ()));
+    double t = std::min (double (lb.height () - 1), ceil (lr.top ()));
+    if (l > ri || b > t) {
+      continue;
+    }
+
+    unsigned int x1 = (unsigned int) l, x2 = (unsigned int) ri;
+    unsigned int y1 = (unsigned int) b, y2 = (unsigned int) t;
+
+    for (unsigned int y = y1; y <= y2; ++y) {
+
+      if (lb.is_scanline_empty (y)) {
+        continue;
+      }
+
+      const uint32_t *sl = lb.scanline (y);
+
+      for (unsigned int x = x1; x <= x2; ) {
+
+        uint32_t w = sl [x / 32] >> (x % 32);
+        if (w == 0) {
+          x = (x / 32 + 1) * 32;
+          continue;
+        }
+        if ((w & 1) == 0) {
+          ++x;
+          continue;
+        }
+
+        db::DPoint p = pt * db::DPoint (x, y);
+        db::Point pp (db::Coord (floor (p.x () + 0.5)), db::Coord (floor (p.y () + 0.5)));
+        if (rr.contains (pp)) {
+          bitmap->fill ((unsigned int) pp.y (), (unsigned int) pp.x (), (unsigned int) pp.x () + 1);
+        }
+
+        ++x;
+
+      }
+
+    }
+
+  }
+
+  return true;
+}
+
+size_t
+DensityPyramid::memory () const
+{
+  size_t m = 0;
+  for (std::vector<lay::Bitmap>::const_iterator l = m_levels.begin (); l != m_levels.end (); ++l) {
+    unsigned int words = (l->width () + 31) / 32;
+    for (unsigned int y = 0; y < l->height (); ++y) {
+      if (! l->is_scanline_empty (y)) {
+        m += words * sizeof (uint32_t);
+      }
+    }
+  }
+  return m;
+}
+
+// -------------------------------------------------------------
+//  DensityPyramidCache implementation
+
+DensityPyramidCache::DensityPyramidCache ()
+{
+  //  .. nothing yet ..
+}
+
+DensityPyramidCache::~DensityPyramidCache ()
+{
+  clear ();
+}
+
+const DensityPyramid *
+DensityPyramidCache::get (int cv_index, db::cell_index_type ci, unsigned int layer) const
+{
+  tl::MutexLocker locker (&m_lock);
+
+  pyramid_map::const_iterator p = m_pyramids.find (std::make_pair (cv_index, std::make_pair (ci, layer)));
+  return p != m_pyramids.end () ? p->second : 0;
+}
+
+void
+DensityPyramidCache::put_partial (int cv_index, db::cell_index_type ci, unsigned int layer, DensityPyramid *pyramid)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  DensityPyramid *&p = m_partial_pyramids [std::make_pair (cv_index, std::make_pair (ci, layer))];
+  if (p != pyramid) {
+    delete p;
+    p = pyramid;
+  }
+}
+
+DensityPyramid *
+DensityPyramidCache::take_partial (int cv_index, db::cell_index_type ci, unsigned int layer)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  pyramid_map::iterator p = m_partial_pyramids.find (std::make_pair (cv_index, std::make_pair (ci, layer)));
+  if (p == m_partial_pyramids.end ()) {
+    return 0;
+  }
+
+  DensityPyramid *pyramid = p->second;
+  m_partial_pyramids.erase (p);
+  return pyramid;
+}
+
+const DensityPyramid *
+DensityPyramidCache::put (int cv_index, db::cell_index_type ci, unsigned int layer, DensityPyramid *pyramid)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  std::pair<pyramid_map::iterator, bool> p = m_pyramids.insert (std::make_pair (std::make_pair (cv_index, std::make_pair (ci, layer)), pyramid));
+  if (! p.second) {
+    delete pyramid;
+  }
+  return p.first->second;
+}
+
+void
+DensityPyramidCache::clear ()
+{
+  tl::MutexLocker locker (&m_lock);
+
+  for (pyramid_map::iterator p = m_pyramids.begin (); p != m_pyramids.end (); ++p) {
+    delete p->second;
+  }
+  m_pyramids.clear ();
+
+  for (pyramid_map::iterator p = m_partial_pyramids.begin (); p != m_partial_pyramids.end (); ++p) {
+    delete p->second;
+  }
+  m_partial_pyramids.clear ();
+}
+
+size_t
+DensityPyramidCache::memory () const
+{
+  tl::MutexLocker locker (&m_lock);
+
+  size_t m = 0;
+  for (pyramid_map::const_iterator p = m_pyramids.begin (); p != m_pyramids.end (); ++p) {
+    m += p->second->memory ();
+  }
+  for (pyramid_map::const_iterator p = m_partial_pyramids.begin (); p != m_partial_pyramids.end (); ++p) {
+    m += p->second->memory ();
+  }
+  return m;
+}
+
+}
+
@@ -0,0 +1,246 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_layDensityPyramid
+#define HDR_layDensityPyramid
+
+#include "laybasicCommon.h"
+#include "layBitmap.h"
+#include "dbBox.h"
+#include "dbTrans.h"
+#include "dbTypes.h"
+#include "tlThreads.h"
+
+#include <vector>
+#include <map>
+
+namespace lay
+{
+
+/**
+ *  @brief The maximum size of the finest level of a density pyramid in pixels
+ */
+const unsigned int density_pyramid_max_size = 4096;
+
+/**
+ *  @brief The minimum size of the coarsest level of a density pyramid in pixels
+ */
+const unsigned int density_pyramid_min_size = 16;
+
+/**
+ *  @brief A level-of-detail pyramid of coverage bitmaps for one layer
+ *
+ *  The pyramid consists of coverage bitmaps at power-of-two scales for a
+ *  rectangular region of the layout. A pixel is set if some shape touches it.
+ *  The finest level is drawn through "base" and "mark" and the coarser levels
+ *  are computed by "finish".
+ *
+ *  The pyramid can be drawn into the bitmap planes of a view instead of the
+ *  layout when a view pixel is larger than the finest pyramid pixel.
+ */
+class LAYBASIC_PUBLIC DensityPyramid
+{
+public:
+  /**
+   *  @brief Creates a pyramid for the given region
+   *
+   *  max_size is the maximum dimension of the finest level in pixels.
+   */
+  DensityPyramid (const db::Box &region, unsigned int max_size = density_pyramid_max_size);
+
+  /**
+   *  @brief Gets the region covered by the pyramid
+   */
+  const db::Box &region () const
+  {
+    return m_region;
+  }
+
+  /**
+   *  @brief Gets the size of a pixel of the finest level in database units
+   */
+  double pixel_size () const
+  {
+    return m_pixel_size;
+  }
+
+  /**
+   *  @brief Gets the transformation from database units to the pixels of the finest level
+   */
+  db::CplxTrans pixel_trans () const;
+
+  /**
+   *  @brief Gets the bitmap of the finest level
+   *
+   *  The bitmap can be drawn into using pixel_trans as the transformation.
+   */
+  lay::Bitmap &base ()
+  {
+    return m_levels.front ();
+  }
+
+  /**
+   *  @brief Marks all pixels of the finest level touched by the given box
+   *
+   *  The box is given in pixel units of the finest level.
+   */
+  void mark (const db::DBox &box);
+
+  /**
+   *  @brief Marks the pixels touched by the members of a regular array
+   *
+   *  "box" is the box of the first member and "a" and "b" are the array vectors,
+   *  all in pixel units of the finest level. "na" and "nb" are the member counts.
+   *  Arrays with at least one member per pixel are marked by their bounding box.
+   *  Otherwise the member boxes are marked one by one.
+   */
+  void mark_array (const db::DBox &box, const db::DVector &a, const db::DVector &b, unsigned long na, unsigned long nb);
+
+  /**
+   *  @brief Computes the coarser levels from the finest one
+   */
+  void finish ();
+
+  /**
+   *  @brief Gets the number of levels
+   */
+  unsigned int levels () const
+  {
+    return (unsigned int) m_levels.size ();
+  }
+
+  /**
+   *  @brief Gets the bitmap for the given level
+   *
+   *  Level 0 is the finest one. The pixel size of level n is pixel_size () * 2^n.
+   */
+  const lay::Bitmap &level (unsigned int n) const
+  {
+    return m_levels [n];
+  }
+
+  /**
+   *  @brief Draws the pyramid into the given bitmap
+   *
+   *  "trans" is the transformation from database units into the pixel space of the
+   *  bitmap. Only the parts inside the given regions (in pixel space) are drawn.
+   *  This method returns false if the pyramid is not fine enough for the given
+   *  transformation. In this case, nothing is drawn.
+   */
+  bool draw (const db::CplxTrans &trans, const std::vector<db::Box> &regions, lay::Bitmap *bitmap) const;
+
+  /**
+   *  @brief Gets the memory used by the pyramid in bytes (approximately)
+   */
+  size_t memory () const;
+
+  /**
+   *  @brief Gets the build position
+   *
+   *  The pyramid can be built in several steps if the build is interrupted.
+   *  The position tells where to continue. It is a path of element indexes
+   *  through the hierarchy (one per level). It is empty for a new pyramid.
+   */
+  std::vector<size_t> &build_position ()
+  {
+    return m_build_position;
+  }
+
+private:
+  db::Box m_region;
+  double m_pixel_size;
+  std::vector<lay::Bitmap> m_levels;
+  std::vector<size_t> m_build_position;
+};
+
+/**
+ *  @brief A thread-safe collection of density pyramids
+ *
+ *  The pyramids are identified by cellview index, cell and layer. They are built
+ *  on demand by the redraw workers and kept until "clear" is called.
+ *  Pyramids must only be cleared when no redraw worker is active.
+ *  Pyramids whose build was interrupted are kept separately, so the next
+ *  redraw can continue building them.
+ */
+class LAYBASIC_PUBLIC DensityPyramidCache
+{
+public:
+  DensityPyramidCache ();
+  ~DensityPyramidCache ();
+
+  /**
+   *  @brief Gets the pyramid for the given cellview, cell and layer or 0 if there is none
+   */
+  const DensityPyramid *get (int cv_index, db::cell_index_type ci, unsigned int layer) const;
+
+  /**
+   *  @brief Stores a pyramid
+   *
+   *  The cache takes over the pyramid. If there already is a pyramid for this key, the new
+   *  one is discarded. The method returns the pyramid stored in the cache.
+   */
+  const DensityPyramid *put (int cv_index, db::cell_index_type ci, unsigned int layer, DensityPyramid *pyramid);
+
+  /**
+   *  @brief Stores a pyramid whose build was interrupted
+   *
+   *  The cache takes over the pyramid. If there already is a partial pyramid for
+   *  this key, it is replaced.
+   */
+  void put_partial (int cv_index, db::cell_index_type ci, unsigned int layer, DensityPyramid *pyramid);
+
+  /**
+   *  @brief Takes a partial pyramid from the cache
+   *
+   *  Returns 0 if there is no partial pyramid for this key. Otherwise the pyramid
+   *  is removed from the cache and the caller becomes owner of it.
+   */
+  DensityPyramid *take_partial (int cv_index, db::cell_index_type ci, unsigned int layer);
+
+  /**
+   *  @brief Deletes all pyramids
+   */
+  void clear ();
+
+  /**
+   *  @brief Gets the memory used by all pyramids in bytes (approximately)
+   */
+  size_t memory () const;
+
+private:
+  typedef std::pair<int, std::pair<db::cell_index_type, unsigned int> > key_type;
+  typedef std::map<key_type, DensityPyramid *> pyramid_map;
+
+  mutable tl::Mutex m_lock;
+  pyramid_map m_pyramids;
+  pyramid_map m_partial_pyramids;
+
+  DensityPyramidCache (const DensityPyramidCache &);
+  DensityPyramidCache &operator= (const DensityPyramidCache &);
+};
+
+}
+
+#endif
+
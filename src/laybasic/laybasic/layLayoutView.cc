@@ -380,6 +380,8 @@ LayoutView::init (db::Manager *mgr, lay::PluginRoot *root, QWidget * /*parent*/)
   m_default_font_size = lay::FixedFont::default_font_size ();
   m_text_lazy_rendering = true;
   m_bitmap_caching = true;
+  m_lod_pyramid = false;
+  m_lod_pyramid_threshold = 0.001;
   m_show_properties = false;
   m_apply_text_trans = true;
   m_default_text_size = 0.1;
@@ -1137,6 +1139,20 @@ LayoutView::configure (const std::string &name, const std::string &value)
     bitmap_caching (flag);
     return true;
 
+  } else if (name == cfg_lod_pyramid) {
+
+    bool flag;
+    tl::from_string (value, flag);
+    lod_pyramid (flag);
+    return true;
+
+  } else if (name == cfg_lod_pyramid_threshold) {
+
+    double t;
+    tl::from_string (value, t);
+    lod_pyramid_threshold (t);
+    return true;
+
   } else if (name == cfg_text_lazy_rendering) {
 
     bool flag;
@@ -4839,6 +4855,26 @@ LayoutView::bitmap_caching (bool l)
   }
 }
 
+void 
+LayoutView::lod_pyramid (bool l)
+{
+  if (m_lod_pyramid != l) {
+    m_lod_pyramid = l;
+    redraw ();
+  }
+}
+
+void 
+LayoutView::lod_pyramid_threshold (double t)
+{
+  if (fabs (t - m_lod_pyramid_threshold) > 1e-12) {
+    m_lod_pyramid_threshold = t;
+    if (m_lod_pyramid) {
+      redraw ();
+    }
+  }
+}
+
 void 
 LayoutView::text_lazy_rendering (bool l)
 {
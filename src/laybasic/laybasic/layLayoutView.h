@@ -1028,6 +1028,39 @@ public:
     return m_bitmap_caching;
   }
 
+  /** 
+   *  @brief Enable or disable the level-of-detail pyramid
+   *
+   *  If enabled, coverage bitmaps at power-of-two scales are computed per layer
+   *  once and drawn instead of the layout when the view is zoomed out below
+   *  the LOD threshold.
+   */
+  void lod_pyramid (bool en);
+
+  /** 
+   *  @brief Gets a value indicating whether the level-of-detail pyramid is enabled
+   */
+  bool lod_pyramid () const
+  {
+    return m_lod_pyramid;
+  }
+
+  /** 
+   *  @brief Sets the LOD threshold
+   *
+   *  The threshold is the scale in pixels per database unit below which the
+   *  level-of-detail pyramid is used.
+   */
+  void lod_pyramid_threshold (double t);
+
+  /** 
+   *  @brief Gets the LOD threshold
+   */
+  double lod_pyramid_threshold () const
+  {
+    return m_lod_pyramid_threshold;
+  }
+
   /** 
    *  @brief Lazy rendering of text objects
    */
@@ -2684,6 +2717,8 @@ private:
   bool m_text_visible;
   bool m_text_lazy_rendering;
   bool m_bitmap_caching;
+  bool m_lod_pyramid;
+  double m_lod_pyramid_threshold;
   bool m_show_properties;
   QColor m_text_color;
   bool m_apply_text_trans;
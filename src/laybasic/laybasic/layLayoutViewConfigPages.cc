@@ -1491,6 +1491,8 @@ public:
     options.push_back (std::pair<std::string, std::string> (cfg_text_visible, "true"));
     options.push_back (std::pair<std::string, std::string> (cfg_text_lazy_rendering, "true"));
     options.push_back (std::pair<std::string, std::string> (cfg_bitmap_caching, "true"));
+    options.push_back (std::pair<std::string, std::string> (cfg_lod_pyramid, "false"));
+    options.push_back (std::pair<std::string, std::string> (cfg_lod_pyramid_threshold, "0.001"));
     options.push_back (std::pair<std::string, std::string> (cfg_show_properties, "false"));
     options.push_back (std::pair<std::string, std::string> (cfg_apply_text_trans, "true"));
     options.push_back (std::pair<std::string, std::string> (cfg_global_trans, "r0"));
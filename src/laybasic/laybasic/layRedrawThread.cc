@@ -32,10 +32,30 @@
 #include "dbShape.h"
 
 #include <memory>
+#include <algorithm>
 
 namespace lay 
 {
 
+/**
+ *  @brief The number of layer groups formed per worker if there are many layers
+ *
+ *  With many layers, layers are combined into groups which are drawn with a single
+ *  traversal of the hierarchy. A couple of groups per worker keeps the load balanced.
+ */
+const int layer_groups_per_worker = 4;
+
+/**
+ *  @brief Returns true, if the layer can be drawn as part of a layer group
+ */
+static bool
+is_groupable_layer (const lay::RedrawLayerInfo &li)
+{
+  return li.layer_index >= 0 &&
+         ! li.hier_levels.has_from_level () && ! li.hier_levels.has_to_level () &&
+         li.prop_sel.empty () && li.inverse_prop_sel;
+}
+
 // -------------------------------------------------------------
 //  RedrawThread implementation
 
@@ -60,6 +80,55 @@ RedrawThread::~RedrawThread ()
   // .. nothing yet ..
 }
 
+void 
+RedrawThread::schedule_layer_tasks ()
+{
+  std::vector<int> layers;
+  for (int i = 0; i < m_nlayers; ++i) {
+    if (m_layers [i].needs_drawing ()) {
+      layers.push_back (i);
+    }
+  }
+
+  //  form layer groups only if there are clearly more layers than tasks required to keep the workers busy
+  size_t ntasks = size_t (std::max (1, num_workers ()) * layer_groups_per_worker);
+  size_t group_size = 1;
+  if (layers.size () >= ntasks * 2) {
+    group_size = (layers.size () + ntasks - 1) / ntasks;
+  }
+
+  std::vector<int> group;
+
+  for (std::vector<int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+
+    const lay::RedrawLayerInfo &li = m_layers [*l];
+
+    bool compatible = false;
+    if (! group.empty () && group.size () < group_size && is_groupable_layer (li)) {
+      const lay::RedrawLayerInfo &gi = m_layers [group.front ()];
+      compatible = is_groupable_layer (gi) && gi.cellview_index == li.cellview_index && gi.trans == li.trans;
+    }
+
+    if (! compatible && ! group.empty ()) {
+      if (group.size () == 1) {
+        schedule (new RedrawThreadTask (group.front ()));
+      } else {
+        schedule (new RedrawThreadTask (group));
+      }
+      group.clear ();
+    }
+
+    group.push_back (*l);
+
+  }
+
+  if (group.size () == 1) {
+    schedule (new RedrawThreadTask (group.front ()));
+  } else if (! group.empty ()) {
+    schedule (new RedrawThreadTask (group));
+  }
+}
+
 void RedrawThread::layout_changed ()
 {
   if (is_running () && tl::verbosity () >= 30) {
@@ -68,6 +137,41 @@ void RedrawThread::layout_changed ()
 
   //  if something changed on the layouts we observe, stop the redraw thread
   stop ();
+
+  //  and drop the cell bitmaps and LOD pyramids which no longer represent the layout
+  m_cell_bitmap_cache.clear ();
+  m_density_pyramids.clear ();
+}
+
+std::string
+RedrawThread::cell_bitmap_cache_state () const
+{
+  //  collects all view settings which affect the rendering of cell bitmaps
+  std::string state;
+
+  state += tl::to_string (mp_view->bitmap_caching ());
+  state += ";" + tl::to_string (m_resolution);
+  state += ";" + tl::to_string (mp_view->text_font ());
+  state += ";" + tl::to_string (mp_view->text_visible ());
+  state += ";" + tl::to_string (mp_view->text_lazy_rendering ());
+  state += ";" + tl::to_string (mp_view->show_properties_as_text ());
+  state += ";" + tl::to_string (mp_view->apply_text_trans ());
+  state += ";" + tl::to_string (mp_view->default_text_size ());
+  state += ";" + tl::to_string (mp_view->drop_small_cells ());
+  state += ";" + tl::to_string (mp_view->drop_small_cells_value ());
+  state += ";" + tl::to_string (int (mp_view->drop_small_cells_cond ()));
+  state += ";" + tl::to_string (mp_view->draw_array_border_instances ());
+  state += ";" + tl::to_string (mp_view->abstract_mode_width ());
+
+  const std::vector <std::set <lay::LayoutView::cell_index_type> > &hidden_cells = mp_view->hidden_cells ();
+  for (std::vector <std::set <lay::LayoutView::cell_index_type> >::const_iterator h = hidden_cells.begin (); h != hidden_cells.end (); ++h) {
+    state += ";";
+    for (std::set <lay::LayoutView::cell_index_type>::const_iterator c = h->begin (); c != h->end (); ++c) {
+      state += "," + tl::to_string (*c);
+    }
+  }
+
+  return state;
 }
 
 void
@@ -235,6 +339,9 @@ RedrawThread::do_start (bool clear, const db::Vector *shift_vector, const std::v
     //  detach from all layout objects 
     tl::Object::detach_from_all_events ();
 
+    //  drop the cached cell bitmaps if the drawing settings have changed
+    m_cell_bitmap_cache.validate (cell_bitmap_cache_state ());
+
     //  Update all relevant layout objects.
     for (unsigned int i = 0; i < mp_view->cellviews (); ++i) {
       const lay::CellView &cv = mp_view->cellview (i);
@@ -243,6 +350,10 @@ RedrawThread::do_start (bool clear, const db::Vector *shift_vector, const std::v
         //  attach to the layout object to receive change notifications to stop the redraw thread
         cv->layout ().hier_changed_event.add (this, &RedrawThread::layout_changed);
         cv->layout ().bboxes_changed_any_event.add (this, &RedrawThread::layout_changed);
+      } else if (cv.is_valid ()) {
+        //  we don't get notified about changes of this layout, so we can't keep its cell bitmaps
+        m_cell_bitmap_cache.clear ();
+        m_density_pyramids.clear ();
       }
     }
     mp_view->annotation_shapes ().update ();
@@ -306,11 +417,7 @@ RedrawThread::do_start (bool clear, const db::Vector *shift_vector, const std::v
         schedule (new RedrawThreadTask (draw_custom_queue_entry));
       }
 
-      for (int i = 0; i < m_nlayers; ++i) {
-        if (m_layers [i].needs_drawing ()) {
-          schedule (new RedrawThreadTask (i));
-        }
-      }
+      schedule_layer_tasks ();
 
       //  cell box drawing
       if (! m_boxes_already_drawn) {
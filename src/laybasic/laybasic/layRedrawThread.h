@@ -39,6 +39,8 @@
 #include "layLayoutView.h"
 #include "layRedrawThreadCanvas.h"
 #include "layRedrawLayerInfo.h"
+#include "layRedrawThreadWorker.h"
+#include "layDensityPyramid.h"
 #include "layCanvasPlane.h"
 #include "tlTimer.h"
 #include "tlThreadedWorkers.h"
@@ -83,6 +85,36 @@ public:
 
   void task_finished (int id);
 
+  /**
+   *  @brief Gets the persistent cell bitmap cache
+   *
+   *  This cache holds rasterized cell bitmaps across redraws. It is cleared when the
+   *  layouts change or when drawing settings change.
+   */
+  CellBitmapCache &cell_bitmap_cache ()
+  {
+    return m_cell_bitmap_cache;
+  }
+
+  /**
+   *  @brief Sets the memory limit (in bytes) for the persistent cell bitmap cache
+   */
+  void set_cell_bitmap_cache_size (size_t bytes)
+  {
+    m_cell_bitmap_cache.set_max_size (bytes);
+  }
+
+  /**
+   *  @brief Gets the level-of-detail pyramids
+   *
+   *  The pyramids are built by the workers on demand and are cleared when the
+   *  layouts change.
+   */
+  DensityPyramidCache &density_pyramids ()
+  {
+    return m_density_pyramids;
+  }
+
 protected:
   tl::Worker *create_worker ();
   void setup_worker (tl::Worker *worker);
@@ -95,6 +127,8 @@ private:
   void done ();
 
   void layout_changed ();
+  std::string cell_bitmap_cache_state () const;
+  void schedule_layer_tasks ();
 
   void layout_changed_with_int (int)
   {
@@ -124,6 +158,8 @@ private:
   QWaitCondition m_initial_wait_cond;
 
   std::auto_ptr<tl::SelfTimer> m_main_timer;
+  CellBitmapCache m_cell_bitmap_cache;
+  DensityPyramidCache m_density_pyramids;
 };
 
 }
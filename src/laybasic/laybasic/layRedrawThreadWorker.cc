@@ -23,6 +23,8 @@
 
 #include "layRedrawThreadWorker.h"
 #include "layRedrawThread.h"
+#include "layDensityPyramid.h"
+#include "layBitmapRenderer.h"
 
 namespace lay
 {
@@ -55,6 +57,8 @@ RedrawThreadWorker::RedrawThreadWorker (RedrawThread *redraw_thread)
   m_text_visible = false;
   m_text_lazy_rendering = false;
   m_bitmap_caching = false;
+  m_lod_pyramid = false;
+  m_lod_pyramid_threshold = 0.0;
   m_show_properties = false;
   m_apply_text_trans = false;
   m_default_text_size = 0.0;
@@ -68,6 +72,9 @@ RedrawThreadWorker::RedrawThreadWorker (RedrawThread *redraw_thread)
   m_xfill = false;
   mp_prop_sel = 0;
   m_inv_prop_sel = false;
+  m_persistent_cell_cache = false;
+  m_cell_cache_generation = 0;
+  m_current_slot = -1;
   m_clock = tl::Clock::current ();
 
   for (unsigned int i = 0; i < sizeof (m_planes) / sizeof (m_planes[0]); ++i) {
@@ -83,6 +90,11 @@ RedrawThreadWorker::~RedrawThreadWorker ()
       m_planes[i] = 0;
     }
   }
+
+  for (std::vector<lay::CanvasPlane *>::const_iterator p = m_group_planes.begin (); p != m_group_planes.end (); ++p) {
+    delete *p;
+  }
+  m_group_planes.clear ();
 }
 
 void 
@@ -97,58 +109,25 @@ RedrawThreadWorker::perform_task (tl::Task *task)
   m_mi_cache.clear ();
   m_mi_text_cache.clear ();
 
+  m_persistent_cell_cache = false;
+  m_cell_cache_generation = mp_redraw_thread->cell_bitmap_cache ().generation ();
+
   m_from_level = m_from_level_default;
   m_to_level = m_to_level_default;
 
   int task_id = redraw_thread_task->id ();
 
-  if (task_id >= 0) {
+  if (task_id >= 0 && redraw_thread_task->ids ().size () > 1) {
 
-    //  draw a layer
+    //  draw a group of layers with a single traversal of the hierarchy
+    perform_layer_group_task (redraw_thread_task->ids ());
 
-    //  HINT: the order in which the planes are delivered (the index stored in the first member of the pair below)
-    //  must correspond with the order by which the ViewOp's are created inside LayoutView::set_view_ops
-    m_buffers.clear ();
-    for (unsigned int i = 0; i < (unsigned int) planes_per_layer / 3; ++i) {
-
-      //  context level planes
-      unsigned int i1 = task_id * (planes_per_layer / 3) + special_planes_before + i;
-      mp_canvas->initialize_plane (m_planes[i], i1); 
-      m_buffers.push_back (std::make_pair (i1, m_planes [i]));
+  } else if (task_id >= 0) {
 
-      //  child level planes (if used)
-      unsigned int i2 = (task_id + m_nlayers) * (planes_per_layer / 3) + special_planes_before + i;
-      mp_canvas->initialize_plane (m_planes [i + planes_per_layer / 3], i2); 
-      m_buffers.push_back (std::make_pair (i2, m_planes [i + planes_per_layer / 3]));
-
-      //  current level planes
-      unsigned int i3 = (task_id + m_nlayers * 2) * (planes_per_layer / 3) + special_planes_before + i;
-      mp_canvas->initialize_plane (m_planes [i + 2 * (planes_per_layer / 3)], i3); 
-      m_buffers.push_back (std::make_pair (i3, m_planes [i + 2 * (planes_per_layer / 3)]));
-
-    }
-
-    //  detect whether the text planes are empty. If not, the whole text plane must be redrawn to account for clipped texts
-    bool text_planes_empty = true;
-    for (unsigned int i = 0; i < (unsigned int) planes_per_layer && text_planes_empty; i += (unsigned int) planes_per_layer / 3) {
-      lay::Bitmap *text = dynamic_cast<lay::Bitmap *> (m_planes[i + 2]);
-      if (text && ! text->empty ()) {
-        text_planes_empty = false;
-      }
-    }
+    //  draw a layer
 
-    std::vector<db::Box> text_redraw_regions = m_redraw_region;
-    if (! text_planes_empty) {
-      //  if there are non-empty text planes, redraw the whole area for texts
-      text_redraw_regions.clear ();
-      text_redraw_regions.push_back(db::Box(0, 0, mp_canvas->canvas_width (), mp_canvas->canvas_height ()));
-      for (unsigned int i = 0; i < (unsigned int) planes_per_layer; i += (unsigned int) planes_per_layer / 3) {
-        lay::Bitmap *text = dynamic_cast<lay::Bitmap *> (m_planes[i + 2]);
-        if (text) {
-          text->clear ();
-        }
-      }
-    }
+    m_buffers.clear ();
+    std::vector<db::Box> text_redraw_regions = init_layer_planes (task_id, m_planes);
 
     const RedrawLayerInfo &li = mp_redraw_thread->get_layer_info (task_id);
 
@@ -183,6 +162,10 @@ RedrawThreadWorker::perform_task (tl::Task *task)
         if (li.layer_index >= 0) {
 
           m_layer = li.layer_index;
+
+          //  cell bitmaps are kept across redraws unless a property selection applies
+          //  (the selection is not part of the cache key)
+          m_persistent_cell_cache = (m_bitmap_caching && mp_prop_sel == 0);
        
           if (tl::verbosity () >= 40) {
             tl::info << tl::to_string (QObject::tr ("Drawing layer: ")) << mp_layout->get_properties (m_layer).name;
@@ -200,7 +183,9 @@ RedrawThreadWorker::perform_task (tl::Task *task)
 
           for (std::vector<db::DCplxTrans>::const_iterator t = li.trans.begin (); t != li.trans.end (); ++t) {
             db::CplxTrans trans = m_vp_trans * *t * db::CplxTrans (mp_layout->dbu ());
-            iterate_variants (m_redraw_region, ci, trans, &RedrawThreadWorker::draw_layer);
+            if (! draw_density_pyramid (ci, trans)) {
+              iterate_variants (m_redraw_region, ci, trans, &RedrawThreadWorker::draw_layer);
+            }
             iterate_variants (text_redraw_regions, ci, trans, &RedrawThreadWorker::draw_text_layer);
           }
 
@@ -451,9 +436,234 @@ RedrawThreadWorker::perform_task (tl::Task *task)
     }
   }
 
+  //  give the cell bitmaps to the persistent cache, so the next redraw can use them
+  if (m_persistent_cell_cache) {
+    for (cell_cache_t::iterator cc = m_cell_cache.begin(); cc != m_cell_cache.end (); ++cc) {
+      mp_redraw_thread->cell_bitmap_cache ().put (CellBitmapCacheKey (m_cv_index, m_layer, m_xfill, cc->first, cc->second.offset), cc->second, m_cell_cache_generation);
+    }
+    m_persistent_cell_cache = false;
+  }
+
   m_cell_cache.clear ();
 
-  mp_redraw_thread->task_finished (task_id);
+  for (std::vector<int>::const_iterator id = redraw_thread_task->ids ().begin (); id != redraw_thread_task->ids ().end (); ++id) {
+    mp_redraw_thread->task_finished (*id);
+  }
+}
+
+std::vector<db::Box>
+RedrawThreadWorker::init_layer_planes (int task_id, lay::CanvasPlane **planes)
+{
+  //  HINT: the order in which the planes are delivered (the index stored in the first member of the pair below)
+  //  must correspond with the order by which the ViewOp's are created inside LayoutView::set_view_ops
+  for (unsigned int i = 0; i < (unsigned int) planes_per_layer / 3; ++i) {
+
+    //  context level planes
+    unsigned int i1 = task_id * (planes_per_layer / 3) + special_planes_before + i;
+    mp_canvas->initialize_plane (planes[i], i1); 
+    m_buffers.push_back (std::make_pair (i1, planes [i]));
+
+    //  child level planes (if used)
+    unsigned int i2 = (task_id + m_nlayers) * (planes_per_layer / 3) + special_planes_before + i;
+    mp_canvas->initialize_plane (planes [i + planes_per_layer / 3], i2); 
+    m_buffers.push_back (std::make_pair (i2, planes [i + planes_per_layer / 3]));
+
+    //  current level planes
+    unsigned int i3 = (task_id + m_nlayers * 2) * (planes_per_layer / 3) + special_planes_before + i;
+    mp_canvas->initialize_plane (planes [i + 2 * (planes_per_layer / 3)], i3); 
+    m_buffers.push_back (std::make_pair (i3, planes [i + 2 * (planes_per_layer / 3)]));
+
+  }
+
+  //  detect whether the text planes are empty. If not, the whole text plane must be redrawn to account for clipped texts
+  bool text_planes_empty = true;
+  for (unsigned int i = 0; i < (unsigned int) planes_per_layer && text_planes_empty; i += (unsigned int) planes_per_layer / 3) {
+    lay::Bitmap *text = dynamic_cast<lay::Bitmap *> (planes[i + 2]);
+    if (text && ! text->empty ()) {
+      text_planes_empty = false;
+    }
+  }
+
+  std::vector<db::Box> text_redraw_regions = m_redraw_region;
+  if (! text_planes_empty) {
+    //  if there are non-empty text planes, redraw the whole area for texts
+    text_redraw_regions.clear ();
+    text_redraw_regions.push_back(db::Box(0, 0, mp_canvas->canvas_width (), mp_canvas->canvas_height ()));
+    for (unsigned int i = 0; i < (unsigned int) planes_per_layer; i += (unsigned int) planes_per_layer / 3) {
+      lay::Bitmap *text = dynamic_cast<lay::Bitmap *> (planes[i + 2]);
+      if (text) {
+        text->clear ();
+      }
+    }
+  }
+
+  return text_redraw_regions;
+}
+
+void
+RedrawThreadWorker::select_layer (int slot)
+{
+  if (slot == m_current_slot) {
+    return;
+  }
+
+  //  park the caches of the current layer and fetch the ones of the new layer
+  if (m_current_slot >= 0) {
+    LayerGroupSlot &current = m_group [m_current_slot];
+    current.cell_cache.swap (m_cell_cache);
+    current.mi_cache.swap (m_mi_cache);
+    current.mi_text_cache.swap (m_mi_text_cache);
+  }
+
+  m_current_slot = slot;
+
+  if (m_current_slot >= 0) {
+
+    LayerGroupSlot &current = m_group [m_current_slot];
+    current.cell_cache.swap (m_cell_cache);
+    current.mi_cache.swap (m_mi_cache);
+    current.mi_text_cache.swap (m_mi_text_cache);
+
+    m_layer = current.layer;
+    m_xfill = current.xfill;
+    for (unsigned int i = 0; i < (unsigned int) planes_per_layer; ++i) {
+      m_planes [i] = current.planes [i];
+    }
+
+    mp_renderer->set_xfill (m_xfill);
+
+  }
+}
+
+void
+RedrawThreadWorker::perform_layer_group_task (const std::vector<int> &ids)
+{
+  //  HINT: the scheduler only groups layers with a layer index, the same cellview and transformations
+  //  and no hierarchy level or property selection overrides.
+  lay::CanvasPlane *planes [planes_per_layer];
+  for (unsigned int i = 0; i < (unsigned int) planes_per_layer; ++i) {
+    planes [i] = m_planes [i];
+  }
+
+  while (m_group_planes.size () < ids.size () * planes_per_layer) {
+    m_group_planes.push_back (mp_canvas->create_drawing_plane ());
+  }
+
+  m_buffers.clear ();
+  m_group.clear ();
+  m_group.resize (ids.size ());
+
+  std::vector<std::vector<db::Box> > text_redraw_regions;
+  text_redraw_regions.reserve (ids.size ());
+
+  for (unsigned int s = 0; s < (unsigned int) ids.size (); ++s) {
+
+    const RedrawLayerInfo &li = mp_redraw_thread->get_layer_info (ids [s]);
+
+    LayerGroupSlot &slot = m_group [s];
+    slot.task_id = ids [s];
+    slot.layer = (unsigned int) li.layer_index;
+    slot.xfill = li.xfill;
+    for (unsigned int i = 0; i < (unsigned int) planes_per_layer; ++i) {
+      slot.planes [i] = m_group_planes [s * planes_per_layer + i];
+    }
+
+    text_redraw_regions.push_back (init_layer_planes (ids [s], slot.planes));
+
+  }
+
+  const RedrawLayerInfo &li = mp_redraw_thread->get_layer_info (ids.front ());
+  if (li.cellview_index < 0) {
+    return;
+  }
+
+  //  determine layout and cell associated with this layer ..
+  const lay::CellView &cv = m_cellviews [li.cellview_index];
+  if (! cv.is_valid () || cv->layout ().under_construction () || (cv->layout ().manager () && cv->layout ().manager ()->transacting ())) {
+    return;
+  }
+
+  mp_layout = &cv->layout ();
+  m_cv_index = li.cellview_index;
+  db::cell_index_type ci = cv.cell_index ();
+
+  mp_prop_sel = 0;
+  m_inv_prop_sel = false;
+
+  m_persistent_cell_cache = m_bitmap_caching;
+
+  if (tl::verbosity () >= 40) {
+    std::string names;
+    for (std::vector<LayerGroupSlot>::const_iterator s = m_group.begin (); s != m_group.end (); ++s) {
+      if (! names.empty ()) {
+        names += ",";
+      }
+      names += mp_layout->get_properties (s->layer).name;
+    }
+    tl::info << tl::to_string (QObject::tr ("Drawing layer group: ")) << names;
+  }
+  tl::SelfTimer timer (tl::verbosity () >= 41, tl::to_string (QObject::tr ("Drawing layer group")));
+
+  //  configure renderer ..
+  mp_renderer->draw_texts (m_text_visible);
+  mp_renderer->draw_properties (m_show_properties);
+  mp_renderer->draw_description_property (false);
+  mp_renderer->default_text_size (db::Coord (m_default_text_size / mp_layout->dbu ()));
+  mp_renderer->set_font (db::Font (m_text_font));
+  mp_renderer->apply_text_trans (m_apply_text_trans);
+
+  try {
+
+    for (std::vector<db::DCplxTrans>::const_iterator t = li.trans.begin (); t != li.trans.end (); ++t) {
+
+      db::CplxTrans trans = m_vp_trans * *t * db::CplxTrans (mp_layout->dbu ());
+
+      //  walk the hierarchy once for all layers not served by a density pyramid
+      m_group_walk.clear ();
+      for (unsigned int s = 0; s < (unsigned int) m_group.size (); ++s) {
+        select_layer (int (s));
+        if (! draw_density_pyramid (ci, trans)) {
+          m_group_walk.push_back (s);
+        }
+      }
+
+      if (! m_group_walk.empty ()) {
+        iterate_variants (m_redraw_region, ci, trans, &RedrawThreadWorker::draw_layer_group);
+      }
+
+      //  texts are drawn per layer as they are subject to lazy rendering
+      for (unsigned int s = 0; s < (unsigned int) m_group.size (); ++s) {
+        select_layer (int (s));
+        iterate_variants (text_redraw_regions [s], ci, trans, &RedrawThreadWorker::draw_text_layer);
+      }
+
+    }
+
+  } catch (...) {
+    select_layer (-1);
+    for (unsigned int i = 0; i < (unsigned int) planes_per_layer; ++i) {
+      m_planes [i] = planes [i];
+    }
+    m_persistent_cell_cache = false;
+    throw;
+  }
+
+  select_layer (-1);
+  for (unsigned int i = 0; i < (unsigned int) planes_per_layer; ++i) {
+    m_planes [i] = planes [i];
+  }
+
+  //  give the cell bitmaps to the persistent cache, so the next redraw can use them
+  for (std::vector<LayerGroupSlot>::iterator s = m_group.begin (); s != m_group.end (); ++s) {
+    if (m_persistent_cell_cache) {
+      for (cell_cache_t::iterator cc = s->cell_cache.begin(); cc != s->cell_cache.end (); ++cc) {
+        mp_redraw_thread->cell_bitmap_cache ().put (CellBitmapCacheKey (m_cv_index, s->layer, s->xfill, cc->first, cc->second.offset), cc->second, m_cell_cache_generation);
+      }
+    }
+    s->cell_cache.clear ();
+  }
+
+  m_persistent_cell_cache = false;
 }
 
 void 
@@ -469,6 +679,12 @@ RedrawThreadWorker::finish ()
       m_planes[i] = 0;
     }
   }
+
+  for (std::vector<lay::CanvasPlane *>::const_iterator p = m_group_planes.begin (); p != m_group_planes.end (); ++p) {
+    delete *p;
+  }
+  m_group_planes.clear ();
+  m_group.clear ();
 }
 
 void
@@ -496,6 +712,12 @@ RedrawThreadWorker::setup (LayoutView *view, RedrawThreadCanvas *canvas, const s
     m_planes[i] = mp_canvas->create_drawing_plane ();
   }
 
+  //  the planes for layer groups are created on demand
+  for (std::vector<lay::CanvasPlane *>::const_iterator p = m_group_planes.begin (); p != m_group_planes.end (); ++p) {
+    delete *p;
+  }
+  m_group_planes.clear ();
+
   mp_renderer.reset (mp_canvas->create_renderer ());
 
   //  copy everything that we need so there is no need to access 
@@ -514,6 +736,8 @@ RedrawThreadWorker::setup (LayoutView *view, RedrawThreadCanvas *canvas, const s
   m_text_visible = view->text_visible ();
   m_text_lazy_rendering = view->text_lazy_rendering ();
   m_bitmap_caching = view->bitmap_caching ();
+  m_lod_pyramid = view->lod_pyramid ();
+  m_lod_pyramid_threshold = view->lod_pyramid_threshold ();
   m_show_properties = view->show_properties_as_text ();
   m_apply_text_trans = view->apply_text_trans ();
   m_default_text_size = view->default_text_size ();
@@ -1555,6 +1779,202 @@ bool draw_array_simplified (lay::Renderer *r, const db::Shape &array_shape, lay:
   return false;
 }
  
+bool
+RedrawThreadWorker::draw_density_pyramid (db::cell_index_type ci, const db::CplxTrans &trans)
+{
+  if (! m_lod_pyramid || trans.mag () > m_lod_pyramid_threshold) {
+    return false;
+  }
+
+  //  The pyramid represents the flat content of the cell. Hence it can't be used when the hierarchy
+  //  is drawn partially or inside a context, with hidden cells or with a property selection.
+  if (mp_prop_sel || m_child_context_enabled || m_from_level != 0 || m_from_level_default < 0 ||
+      ! m_cellviews [m_cv_index].specific_path ().empty () ||
+      int (mp_layout->cell (ci).hierarchy_levels ()) >= m_to_level ||
+      (m_cv_index < int (m_hidden_cells.size ()) && ! m_hidden_cells [m_cv_index].empty ())) {
+    return false;
+  }
+
+  int plane_group = 2;
+  lay::Bitmap *frame = dynamic_cast<lay::Bitmap *> (m_planes[1 + plane_group * (planes_per_layer / 3)]);
+  if (! frame) {
+    return false;
+  }
+
+  lay::DensityPyramidCache &pyramids = mp_redraw_thread->density_pyramids ();
+
+  const lay::DensityPyramid *pyramid = pyramids.get (m_cv_index, ci, m_layer);
+  if (! pyramid) {
+
+    //  continue a build which was interrupted before
+    std::auto_ptr<lay::DensityPyramid> new_pyramid (pyramids.take_partial (m_cv_index, ci, m_layer));
+    if (! new_pyramid.get ()) {
+
+      db::Box bbox = mp_layout->cell (ci).bbox (m_layer);
+      if (bbox.empty ()) {
+        return false;
+      }
+
+      new_pyramid.reset (new lay::DensityPyramid (bbox));
+
+    }
+
+    //  don't build the pyramid if it is not fine enough for this view anyway
+    if (new_pyramid->pixel_size () * trans.mag () > 1.0) {
+      if (! new_pyramid->build_position ().empty ()) {
+        pyramids.put_partial (m_cv_index, ci, m_layer, new_pyramid.release ());
+      }
+      return false;
+    }
+
+    if (tl::verbosity () >= 40) {
+      tl::info << tl::to_string (QObject::tr ("Building LOD pyramid for layer: ")) << mp_layout->get_properties (m_layer).name;
+    }
+    tl::SelfTimer timer (tl::verbosity () >= 41, tl::to_string (QObject::tr ("Building LOD pyramid")));
+
+    std::vector<size_t> resume;
+    resume.swap (new_pyramid->build_position ());
+
+    lay::BitmapRenderer renderer (new_pyramid->base ().width (), new_pyramid->base ().height (), 1.0);
+    try {
+      build_density_pyramid (*new_pyramid, renderer, ci, new_pyramid->pixel_trans (), 0, resume);
+    } catch (...) {
+      //  keep what has been built so far - the next redraw continues from the recorded position
+      pyramids.put_partial (m_cv_index, ci, m_layer, new_pyramid.release ());
+      throw;
+    }
+
+    new_pyramid->build_position ().clear ();
+    new_pyramid->finish ();
+
+    pyramid = pyramids.put (m_cv_index, ci, m_layer, new_pyramid.release ());
+
+  }
+
+  return pyramid->draw (trans, m_redraw_region, frame);
+}
+
+void
+RedrawThreadWorker::build_density_pyramid (lay::DensityPyramid &pyramid, lay::BitmapRenderer &renderer, db::cell_index_type ci, const db::CplxTrans &trans, unsigned int level, std::vector<size_t> &resume)
+{
+  //  The elements of a cell are numbered: shapes first, then the instance array members.
+  //  The pyramid's build position records the element in progress per hierarchy level,
+  //  so an interrupted build can continue there. "resume" is the position to continue from.
+  //  Marking is idempotent, hence drawing an element twice is harmless.
+  //  No interruption happens on the way back to the resume position, so every
+  //  build step makes progress.
+  if (resume.empty ()) {
+    checkpoint ();
+  }
+
+  size_t start = level < resume.size () ? resume [level] : 0;
+
+  std::vector<size_t> &position = pyramid.build_position ();
+  position.resize (level + 1, 0);
+
+  const db::Cell &cell = mp_layout->cell (ci);
+  db::Box bbox = cell.bbox (m_layer);
+  if (bbox.empty ()) {
+    return;
+  }
+
+  //  cells smaller than a pixel are represented by their bounding box
+  db::DBox dbbox = trans * bbox;
+  if (dbbox.width () < 1.0 && dbbox.height () < 1.0) {
+    pyramid.mark (dbbox);
+    return;
+  }
+
+  lay::Bitmap &base = pyramid.base ();
+
+  size_t index = 0;
+
+  unsigned int flags = db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes | db::ShapeIterator::Edges;
+  for (db::ShapeIterator s = cell.shapes (m_layer).begin (flags); ! s.at_end (); ++s, ++index) {
+
+    if (index < start) {
+      continue;
+    }
+
+    db::DBox sbox = trans * s->bbox ();
+    if (sbox.width () < 1.0 && sbox.height () < 1.0) {
+      pyramid.mark (sbox);
+    } else {
+      renderer.draw (*s, trans, &base, &base, 0, 0);
+    }
+
+  }
+
+  for (db::Cell::const_iterator inst = cell.begin (); ! inst.at_end (); ++inst) {
+
+    const db::Cell::cell_inst_array_type &cell_inst = inst->cell_inst ();
+
+    size_t n = cell_inst.size ();
+    if (index + n <= start) {
+      index += n;
+      continue;
+    }
+
+    db::cell_index_type new_ci = cell_inst.object ().cell_index ();
+    const db::Box &cell_box = mp_layout->cell (new_ci).bbox (m_layer);
+    if (cell_box.empty ()) {
+      index += n;
+      continue;
+    }
+
+    //  regular arrays of members smaller than a pixel are marked as a whole
+    db::Vector a, b;
+    unsigned long amax = 0, bmax = 0;
+    if (cell_inst.is_regular_array (a, b, amax, bmax)) {
+
+      db::DBox member_box = trans * (db::ICplxTrans (cell_inst.complex_trans (*cell_inst.begin ())) * cell_box);
+      if (member_box.width () < 1.0 && member_box.height () < 1.0) {
+        pyramid.mark_array (member_box, trans * a, trans * b, amax, bmax);
+        index += n;
+        continue;
+      }
+
+    }
+
+    for (db::Cell::cell_inst_array_type::iterator a = cell_inst.begin (); ! a.at_end (); ++a, ++index) {
+
+      if (index < start) {
+        continue;
+      }
+
+      //  past the resume position the children are built from their beginning
+      if (index > start) {
+        resume.clear ();
+      }
+
+      position.resize (level + 1);
+      position [level] = index;
+      build_density_pyramid (pyramid, renderer, new_ci, trans * db::ICplxTrans (cell_inst.complex_trans (*a)), level + 1, resume);
+
+    }
+
+  }
+}
+
+/**
+ *  @brief Returns true if a regular instance array is small enough to be represented by its bounding box
+ */
+static bool
+can_simplify_array (const db::CellInstArray &cell_inst, const db::Box &cell_box, const db::Vector &a, const db::Vector &b, unsigned long amax, unsigned long bmax, const db::CplxTrans &trans)
+{
+  db::DBox inst_box;
+  if (cell_inst.is_complex ()) {
+    inst_box = trans * (cell_inst.complex_trans () * cell_box);
+  } else {
+    inst_box = trans * cell_box;
+  }
+
+  return ((a.x () == 0 && b.y () == 0) || (a.y () == 0 && b.x () == 0)) && 
+         inst_box.width () < 1.5 && inst_box.height () < 1.5 && 
+         (amax <= 1 || trans.ctrans (a.length ()) < 1.5) &&
+         (bmax <= 1 || trans.ctrans (b.length ()) < 1.5);
+}
+
 void
 RedrawThreadWorker::draw_layer_wo_cache (int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector<db::Box> &vv, int level,
                                          lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, const UpdateSnapshotCallback *update_snapshot)
@@ -1694,21 +2114,7 @@ RedrawThreadWorker::draw_layer_wo_cache (int from_level, int to_level, db::cell_
             }
 
             if (anything && cell_inst.is_regular_array (a, b, amax, bmax)) {
-
-              db::DBox inst_box;
-              if (cell_inst.is_complex ()) {
-                inst_box = trans * (cell_inst.complex_trans () * new_cell_box);
-              } else {
-                inst_box = trans * new_cell_box;
-              }
-
-              if (((a.x () == 0 && b.y () == 0) || (a.y () == 0 && b.x () == 0)) && 
-                  inst_box.width () < 1.5 && inst_box.height () < 1.5 && 
-                  (amax <= 1 || trans.ctrans (a.length ()) < 1.5) &&
-                  (bmax <= 1 || trans.ctrans (b.length ()) < 1.5)) {
-                simplify = true;
-              }
-
+              simplify = can_simplify_array (cell_inst, new_cell_box, a, b, amax, bmax, trans);
             }
 
             if (simplify) {
@@ -1786,6 +2192,43 @@ private:
   lay::CanvasPlane *mp_text;
 };
 
+/**
+ *  @brief Returns true if the given box (in pixel units) is small enough to be represented by a box
+ */
+static bool
+is_tiny_box (const db::DBox &dbbox)
+{
+  return (dbbox.width () < 2.5 && dbbox.height () < 1.5) || (dbbox.width () < 1.5 && dbbox.height () < 2.5);
+}
+
+bool
+RedrawThreadWorker::can_cache_cell (const db::Cell &cell, const std::vector<db::Box> &vv, int level, lay::CanvasPlane *fill) const
+{
+  //  use the presence of a lay::Bitmap for the drawing plane as an indicator that we can cache the 
+  //  drawings
+  if (! m_bitmap_caching || dynamic_cast<lay::Bitmap *> (fill) == 0) {
+    return false;
+  }
+
+  //  don't cache if the cell is not fully inside the search region
+  if (vv.size () > 1 || ! cell.bbox ().inside (vv.front ())) {
+    return false;
+  }
+
+  //  only cache if we have more than one instance at all
+  if (level > 0) {
+    db::Cell::parent_inst_iterator p = cell.begin_parent_insts ();
+    size_t n;
+    for (n = 0; !p.at_end () && n < 2; ++n) 
+      ;
+    if (n <= 1) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void
 RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector<db::Box> &vp, int level,
                                 lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, const UpdateSnapshotCallback *update_snapshot)
@@ -1834,8 +2277,7 @@ RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_typ
 
     //  optimize very small cells
     db::DBox dbbox = trans * bbox;
-    if ((dbbox.width () < 2.5 && dbbox.height () < 1.5) || 
-        (dbbox.width () < 1.5 && dbbox.height () < 2.5)) {
+    if (is_tiny_box (dbbox)) {
 
       bool anything = true;
       if (level == 0 && cell_bbox.inside (vp)) {
@@ -1854,27 +2296,7 @@ RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_typ
       //  create a set of boxes to look into
       std::vector<db::Box> vv = search_regions (cell_bbox, vp, level);
 
-      //  use the presence of a lay::Bitmap for the drawing plane as an indicator that we can cache the 
-      //  drawings
-      bool can_cache = (m_bitmap_caching && dynamic_cast<lay::Bitmap *> (fill) != 0);
-
-      //  don't cache if the cell is not fully inside the search region
-      if (vv.size () > 1 || ! cell_bbox.inside (vv.front ())) {
-        can_cache = false;
-      }
-
-      //  only cache if we have more than one instance at all
-      if (can_cache && level > 0) {
-        db::Cell::parent_inst_iterator p = cell.begin_parent_insts ();
-        size_t n;
-        for (n = 0; !p.at_end () && n < 2; ++n) 
-          ;
-        if (n <= 1) {
-          can_cache = false;
-        }
-      }
-
-      if (can_cache) {
+      if (can_cache_cell (cell, vv, level, fill)) {
 
         db::CplxTrans trans_wo_disp = trans;
         trans_wo_disp.disp (db::DVector ());
@@ -1893,21 +2315,27 @@ RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_typ
           db::DPoint d = cell_box_trans.lower_left () + trans.disp ();
           d = db::DPoint (floor (d.x ()), floor (d.y ()));
           cached_cell->second.offset = d - trans.disp ();
-          db::CplxTrans drawing_trans = trans_wo_disp;
-          drawing_trans.disp (db::DPoint () - cached_cell->second.offset);
 
-          int width = int (cell_box_trans.width () + 3);    //  +3 = one pixel for a one-pixel frame at both sides and one for safety
-          int height = int (cell_box_trans.height () + 3);
+          //  reuse the bitmaps from a previous redraw if possible
+          if (! m_persistent_cell_cache || ! mp_redraw_thread->cell_bitmap_cache ().take (CellBitmapCacheKey (m_cv_index, m_layer, m_xfill, key, cached_cell->second.offset), cached_cell->second)) {
+
+            db::CplxTrans drawing_trans = trans_wo_disp;
+            drawing_trans.disp (db::DPoint () - cached_cell->second.offset);
+
+            int width = int (cell_box_trans.width () + 3);    //  +3 = one pixel for a one-pixel frame at both sides and one for safety
+            int height = int (cell_box_trans.height () + 3);
 
-          cached_cell->second.fill   = new lay::Bitmap (width, height, 1.0);
-          cached_cell->second.frame  = new lay::Bitmap (width, height, 1.0);
-          cached_cell->second.vertex = new lay::Bitmap (width, height, 1.0);
-          cached_cell->second.text   = new lay::Bitmap (width, height, 1.0);
+            cached_cell->second.fill   = new lay::Bitmap (width, height, 1.0);
+            cached_cell->second.frame  = new lay::Bitmap (width, height, 1.0);
+            cached_cell->second.vertex = new lay::Bitmap (width, height, 1.0);
+            cached_cell->second.text   = new lay::Bitmap (width, height, 1.0);
 
-          //  this object is responsible for doing updates when a snapshot is taken
-          UpdateSnapshotWithCache update_cached_snapshot (update_snapshot, &trans, &cached_cell->second, fill, frame, vertex, text);
+            //  this object is responsible for doing updates when a snapshot is taken
+            UpdateSnapshotWithCache update_cached_snapshot (update_snapshot, &trans, &cached_cell->second, fill, frame, vertex, text);
 
-          draw_layer_wo_cache (from_level, to_level, ci, drawing_trans, vv, level, cached_cell->second.fill, cached_cell->second.frame, cached_cell->second.vertex, cached_cell->second.text, &update_cached_snapshot);
+            draw_layer_wo_cache (from_level, to_level, ci, drawing_trans, vv, level, cached_cell->second.fill, cached_cell->second.frame, cached_cell->second.vertex, cached_cell->second.text, &update_cached_snapshot);
+
+          }
 
         }
         cached_cell->second.hits++;
@@ -1999,6 +2427,210 @@ RedrawThreadWorker::draw_layer (bool drawing_context, db::cell_index_type ci, co
   }
 }
 
+void
+RedrawThreadWorker::draw_layer_group (bool drawing_context, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector<db::Box> &redraw_regions, int level)
+{
+  if (drawing_context) {
+
+    if (m_to_level > m_from_level) {
+      draw_layer_group (m_group_walk, 0, m_from_level, m_to_level, ci, trans, redraw_regions, level);
+    }
+
+  } else if (! m_child_context_enabled) {
+
+    if (m_to_level > m_from_level) {
+      draw_layer_group (m_group_walk, 2, m_from_level, m_to_level, ci, trans, redraw_regions, level);
+    }
+
+  } else {
+
+    if (1 > m_from_level) {
+      draw_layer_group (m_group_walk, 2, m_from_level, 1, ci, trans, redraw_regions, level);
+    }
+
+    if (m_to_level > 1) {
+      draw_layer_group (m_group_walk, 1, 1, m_to_level, ci, trans, redraw_regions, level);
+    }
+
+  }
+}
+
+void
+RedrawThreadWorker::draw_layer_group (const std::vector<unsigned int> &slots, int plane_group, int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector<db::Box> &vp, int level)
+{
+  //  do not draw, if there is nothing to draw
+  if (mp_layout->cells () <= ci || vp.empty ()) {
+    return;
+  }
+  if (cell_var_cached (ci, trans)) {
+    return;
+  }
+
+  for (std::vector<db::Box>::const_iterator b = vp.begin (); b != vp.end (); ++b) {
+    draw_layer_group (slots, plane_group, from_level, to_level, ci, trans, *b, level);
+  }
+}
+
+void
+RedrawThreadWorker::draw_layer_group (const std::vector<unsigned int> &slots, int plane_group, int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const db::Box &vp, int level)
+{
+  test_snapshot (0);
+
+  const db::Cell &cell = mp_layout->cell (ci);
+  db::Box cell_bbox = cell.bbox ();
+
+  //  For small bboxes, the cell outline can be reduced ..
+  if (m_drop_small_cells && drop_cell (cell, trans)) {
+    return;
+  }
+
+  //  Don't draw hidden cells
+  bool hidden = (m_cv_index < int (m_hidden_cells.size ()) && m_hidden_cells [m_cv_index].find (ci) != m_hidden_cells [m_cv_index].end ());
+  if (hidden) {
+    return;
+  }
+
+  bool draw_level = (level >= from_level && level < to_level);
+
+  //  create a set of boxes to look into
+  std::vector<db::Box> vv;
+  if (draw_level) {
+    vv = search_regions (cell_bbox, vp, level);
+  } else {
+    vv.push_back (vp);
+  }
+
+  //  Draw the shapes of this level. Tiny and cached cells are drawn per layer - the
+  //  remaining layers are collected for the common traversal of the child cells.
+  std::vector<unsigned int> walk;
+  walk.reserve (slots.size ());
+
+  for (std::vector<unsigned int>::const_iterator s = slots.begin (); s != slots.end (); ++s) {
+
+    select_layer (int (*s));
+
+    db::Box bbox = cell.bbox (m_layer);
+    if (bbox.empty ()) {
+      continue;
+    }
+
+    lay::CanvasPlane *fill   = m_planes[0 + plane_group * (planes_per_layer / 3)];
+    lay::CanvasPlane *frame  = m_planes[1 + plane_group * (planes_per_layer / 3)];
+    lay::CanvasPlane *text   = m_planes[2 + plane_group * (planes_per_layer / 3)];
+    lay::CanvasPlane *vertex = m_planes[3 + plane_group * (planes_per_layer / 3)];
+
+    if (draw_level) {
+
+      if (is_tiny_box (trans * bbox) || can_cache_cell (cell, vv, level, fill)) {
+        draw_layer (from_level, to_level, ci, trans, vp, level, fill, frame, vertex, text, 0);
+        continue;
+      }
+
+      //  draw the shapes of this level only
+      draw_layer_wo_cache (from_level, level + 1, ci, trans, vv, level, fill, frame, vertex, text, 0);
+
+    }
+
+    if (level + 1 < to_level) {
+      walk.push_back (*s);
+    }
+
+  }
+
+  if (walk.empty ()) {
+    return;
+  }
+
+  //  dive down into the hierarchy ..
+
+  db::box_convert <db::CellInst> bc_all (*mp_layout);
+  std::vector<unsigned int> child_slots;
+  child_slots.reserve (walk.size ());
+
+  for (std::vector<db::Box>::const_iterator v = vv.begin (); v != vv.end (); ++v) {
+
+    if (v->empty ()) {
+      continue;
+    }
+
+    db::Cell::touching_iterator inst = cell.begin_touching (*v); 
+    while (! inst.at_end ()) {
+
+      test_snapshot (0); 
+
+      const db::CellInstArray &cell_inst = inst->cell_inst ();
+      ++inst;
+
+      db::cell_index_type new_ci = cell_inst.object ().cell_index ();
+      bool hidden = (m_cv_index < int (m_hidden_cells.size ()) && m_hidden_cells [m_cv_index].find (new_ci) != m_hidden_cells [m_cv_index].end ());
+      if (hidden) {
+        continue;
+      }
+
+      db::Vector a, b;
+      unsigned long amax = 0, bmax = 0; 
+      bool regular = cell_inst.is_regular_array (a, b, amax, bmax);
+
+      child_slots.clear ();
+
+      for (std::vector<unsigned int>::const_iterator s = walk.begin (); s != walk.end (); ++s) {
+
+        select_layer (int (*s));
+
+        db::Box new_cell_box = mp_layout->cell (new_ci).bbox (m_layer);
+        if (new_cell_box.empty ()) {
+          continue;
+        }
+
+        //  Hint: don't use any_text_shapes on partially visible cells because that will degrade performance 
+        if (new_cell_box.inside (*v) && ! any_shapes (new_ci, to_level - (level + 1))) {
+          continue;
+        }
+
+        if (regular && can_simplify_array (cell_inst, new_cell_box, a, b, amax, bmax, trans)) {
+
+          //  The array can be simplified ..
+
+          lay::CanvasPlane *frame  = m_planes[1 + plane_group * (planes_per_layer / 3)];
+          lay::CanvasPlane *vertex = m_planes[3 + plane_group * (planes_per_layer / 3)];
+
+          db::box_convert <db::CellInst> bc (*mp_layout, m_layer);
+          db::Box bbox = cell_inst.bbox (bc);
+          if (frame) {
+            mp_renderer->draw (bbox, trans, frame, frame, 0, 0);
+          }
+          if (vertex) {
+            mp_renderer->draw (bbox, trans, vertex, vertex, 0, 0);
+          }
+
+        } else {
+          child_slots.push_back (*s);
+        }
+
+      }
+
+      if (child_slots.empty ()) {
+        continue;
+      }
+
+      for (db::CellInstArray::iterator p = cell_inst.begin_touching (*v, bc_all); ! p.at_end (); ++p) {
+
+        if (! m_draw_array_border_instances || 
+            p.index_a () <= 0 || (unsigned long)p.index_a () == amax - 1 || p.index_b () <= 0 || (unsigned long)p.index_b () == bmax - 1) {
+
+          db::ICplxTrans t (cell_inst.complex_trans (*p));
+          db::Box new_vp = db::Box (t.inverted () * *v);
+          draw_layer_group (child_slots, plane_group, from_level, to_level, new_ci, trans * t, new_vp, level + 1);
+
+        } 
+
+      }
+
+    }
+
+  }
+}
+
 bool
 RedrawThreadWorker::drop_cell (const db::Cell &cell, const db::CplxTrans &trans)
 {
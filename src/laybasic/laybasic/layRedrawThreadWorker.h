@@ -26,11 +26,15 @@
 
 #include "dbLayout.h"
 #include "layLayoutView.h"
+#include "layCellBitmapCache.h"
 #include "tlThreadedWorkers.h"
+#include "tlThreads.h"
 #include "tlTimer.h"
 
 #include <memory>
 #include <map>
+#include <list>
+#include <string>
 #include <vector>
 #include <set>
 
@@ -39,6 +43,8 @@ namespace lay
 
 class RedrawThreadCanvas;
 class RedrawThread;
+class BitmapRenderer;
+class DensityPyramid;
 class Drawing;
 class CanvasPlane;
 
@@ -70,78 +76,34 @@ public:
 
 /**
  *  @brief A task object for the redraw thread worker (a tl::Task specialization)
+ *
+ *  A task either draws a single layer or special objects or a group of layers.
+ *  The layers of a group are drawn with a single traversal of the hierarchy.
  */
 class RedrawThreadTask
   : public tl::Task
 {
 public: 
   RedrawThreadTask (int id)
-    : m_id (id)
+    : m_ids (1, id)
   { }
 
-  int id () const
-  {
-    return m_id;
-  }
-
-private:
-  int m_id;
-};
-
-/**
- *  @brief An entry in the drawing cache
- */
-struct CellCacheKey 
-{
-public:
-  CellCacheKey (int n, db::cell_index_type c, const db::CplxTrans &t) 
-    : nlevels (n), ci (c), trans (t)
+  RedrawThreadTask (const std::vector<int> &ids)
+    : m_ids (ids)
   { }
 
-  int nlevels;
-  db::cell_index_type ci;
-  db::CplxTrans trans;
-
-  bool operator< (const CellCacheKey &other) const
+  int id () const
   {
-    if (nlevels != other.nlevels) {
-      return nlevels < other.nlevels;
-    }
-    if (ci != other.ci) {
-      return ci < other.ci;
-    }
-    if (! trans.equal (other.trans)) {
-      return trans.less (other.trans);
-    }
-    return false;
+    return m_ids.front ();
   }
-};
-
-/**
- *  @brief An value in the drawing cache
- */
-struct CellCacheInfo 
-{
-public:
-  CellCacheInfo ()
-    : hits (0), fill (0), frame (0), vertex (0), text (0)
-  { }
 
-  ~CellCacheInfo () 
+  const std::vector<int> &ids () const
   {
-    delete fill;
-    fill = 0;
-    delete frame;
-    frame = 0;
-    delete vertex;
-    vertex = 0;
-    delete text;
-    text = 0;
+    return m_ids;
   }
 
-  size_t hits;
-  db::DPoint offset;
-  lay::Bitmap *fill, *frame, *vertex, *text;
+private:
+  std::vector<int> m_ids;
 };
 
 /**
@@ -176,8 +138,17 @@ protected:
 
 private:
   void draw_layer (bool drawing_context, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector <db::Box> &redraw_regions, int level);
+  void draw_layer_group (bool drawing_context, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector <db::Box> &redraw_regions, int level);
+  void draw_layer_group (const std::vector<unsigned int> &slots, int plane_group, int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector <db::Box> &redraw_regions, int level);
+  void draw_layer_group (const std::vector<unsigned int> &slots, int plane_group, int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const db::Box &redraw_box, int level);
+  void perform_layer_group_task (const std::vector<int> &ids);
+  void select_layer (int slot);
+  std::vector<db::Box> init_layer_planes (int task_id, lay::CanvasPlane **planes);
+  bool can_cache_cell (const db::Cell &cell, const std::vector<db::Box> &vv, int level, lay::CanvasPlane *fill) const;
   void draw_layer (int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector <db::Box> &redraw_regions, int level, lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, const UpdateSnapshotCallback *update_snapshot);
   void draw_layer (int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const db::Box &redraw_box, int level, lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, const UpdateSnapshotCallback *update_snapshot);
+  bool draw_density_pyramid (db::cell_index_type ci, const db::CplxTrans &trans);
+  void build_density_pyramid (lay::DensityPyramid &pyramid, lay::BitmapRenderer &renderer, db::cell_index_type ci, const db::CplxTrans &trans, unsigned int level, std::vector<size_t> &resume);
   void draw_layer_wo_cache (int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector<db::Box> &vv, int level, lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, const UpdateSnapshotCallback *update_snapshot);
   void draw_text_layer (bool drawing_context, db::cell_index_type ci, const db::CplxTrans &trans, const std::vector <db::Box> &redraw_regions, int level);
   void draw_text_layer (bool drawing_context, db::cell_index_type ci, const db::CplxTrans &trans, const db::Box &redraw_region, int level, lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, Bitmap *opt_bitmap);
@@ -216,6 +187,8 @@ private:
   bool m_text_visible;
   bool m_text_lazy_rendering;
   bool m_bitmap_caching;
+  bool m_lod_pyramid;
+  double m_lod_pyramid_threshold;
   bool m_show_properties;
   bool m_apply_text_trans;
   double m_default_text_size;
@@ -228,6 +201,38 @@ private:
 
   micro_instance_cache_t m_mi_cache, m_mi_text_cache, m_mi_cell_box_cache;
   cell_cache_t m_cell_cache;
+
+  /**
+   *  @brief The per-layer state of a layer group task
+   *
+   *  The state of the layer selected by "select_layer" is held by the worker's members.
+   *  The caches of the other layers are parked here.
+   */
+  struct LayerGroupSlot
+  {
+    LayerGroupSlot ()
+      : task_id (0), layer (0), xfill (false)
+    {
+      for (unsigned int i = 0; i < (unsigned int) planes_per_layer; ++i) {
+        planes [i] = 0;
+      }
+    }
+
+    int task_id;
+    unsigned int layer;
+    bool xfill;
+    lay::CanvasPlane *planes[planes_per_layer];
+    cell_cache_t cell_cache;
+    micro_instance_cache_t mi_cache, mi_text_cache;
+  };
+
+  std::vector<LayerGroupSlot> m_group;
+  std::vector<unsigned int> m_group_walk;
+  std::vector<lay::CanvasPlane *> m_group_planes;
+  int m_current_slot;
+
+  bool m_persistent_cell_cache;
+  size_t m_cell_cache_generation;
   std::set <std::pair <db::CplxTrans, db::cell_index_type>, lay::CellVariantCacheCompare> *mp_cell_var_cache;
   unsigned int m_cache_hits, m_cache_misses;
   std::set <std::pair <db::DCplxTrans, int> > m_box_variants;
@@ -92,6 +92,7 @@ SOURCES = \
   layBrowserPanel.cc \
   layBrowseShapesForm.cc \
   layCanvasPlane.cc \
+  layCellBitmapCache.cc \
   layCellSelectionForm.cc \
   layCellTreeModel.cc \
   layCellView.cc \
@@ -99,6 +100,7 @@ SOURCES = \
   layConfigurationDialog.cc \
   layConverters.cc \
   layCursor.cc \
+  layDensityPyramid.cc \
   layDialogs.cc \
   layDisplayState.cc \
   layDitherPattern.cc \
@@ -167,6 +169,7 @@ HEADERS = \
   layAnnotationShapes.h \
   layBitmap.h \
   layBitmapRenderer.h \
+  layBitmapSIMD.h \
   layBitmapsToImage.h \
   layBookmarkList.h \
   layBookmarkManagementForm.h \
@@ -176,6 +179,7 @@ HEADERS = \
   layBrowserPanel.h \
   layBrowseShapesForm.h \
   layCanvasPlane.h \
+  layCellBitmapCache.h \
   layCellSelectionForm.h \
   layCellTreeModel.h \
   layCellView.h \
@@ -183,6 +187,7 @@ HEADERS = \
   layConfigurationDialog.h \
   layConverters.h \
   layCursor.h \
+  layDensityPyramid.h \
   layDialogs.h \
   layDisplayState.h \
   layDitherPattern.h \
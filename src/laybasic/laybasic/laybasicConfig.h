@@ -81,6 +81,8 @@ static const std::string cfg_text_color ("text-color");
 static const std::string cfg_text_visible ("text-visible");
 static const std::string cfg_text_lazy_rendering ("text-lazy-rendering");
 static const std::string cfg_bitmap_caching ("bitmap-caching");
+static const std::string cfg_lod_pyramid ("lod-pyramid");
+static const std::string cfg_lod_pyramid_threshold ("lod-pyramid-threshold");
 static const std::string cfg_show_properties ("show-properties");
 static const std::string cfg_apply_text_trans ("apply-text-trans");
 static const std::string cfg_global_trans ("global-trans");
@@ -24,7 +24,12 @@
 
 
 #include "layBitmap.h"
+#include "layBitmapRenderer.h"
 #include "tlUnitTest.h"
+#include "tlTimer.h"
+
+#include <vector>
+#include <stdlib.h>
 
 static std::string 
 to_string (const lay::Bitmap &bm)
@@ -203,3 +208,95 @@ TEST(2)
 
 }
 
+
+static bool 
+bit (const lay::Bitmap &bm, unsigned int x, unsigned int y)
+{
+  return (bm.scanline (y)[x / 32] & (1 << (x % 32))) != 0;
+}
+
+//  wide fills and merges (vectorized code paths) against a pixel-by-pixel reference
+TEST(3) 
+{
+  const unsigned int w = 1000, h = 20;
+
+  lay::Bitmap b1 (w, h, 1.0);
+  std::vector<bool> ref (w * h, false);
+
+  srand (1);
+  for (unsigned int i = 0; i < 200; ++i) {
+    unsigned int y = rand () % h;
+    unsigned int x1 = rand () % w;
+    unsigned int x2 = x1 + rand () % (w - x1) + 1;
+    b1.fill (y, x1, x2);
+    for (unsigned int x = x1; x < x2; ++x) {
+      ref [y * w + x] = true;
+    }
+  }
+
+  bool ok = true;
+  for (unsigned int y = 0; y < h && ok; ++y) {
+    for (unsigned int x = 0; x < w && ok; ++x) {
+      ok = (bit (b1, x, y) == ref [y * w + x]);
+    }
+  }
+  EXPECT_EQ (ok, true);
+
+  int dxs[] = { 0, 1, 31, 32, 33, 100, -1, -31, -32, -33, -100 };
+  for (unsigned int i = 0; i < sizeof (dxs) / sizeof (dxs [0]); ++i) {
+
+    int dx = dxs [i], dy = 1;
+
+    lay::Bitmap b2 (w, h, 1.0);
+    b2.merge (&b1, dx, dy);
+
+    ok = true;
+    for (unsigned int y = 0; y < h && ok; ++y) {
+      for (unsigned int x = 0; x < w && ok; ++x) {
+        int xx = int (x) - dx, yy = int (y) - dy;
+        bool r = (xx >= 0 && xx < int (w) && yy >= 0 && yy < int (h) && ref [yy * w + xx]);
+        ok = (bit (b2, x, y) == r);
+      }
+    }
+    EXPECT_EQ (ok, true);
+
+  }
+}
+
+//  render benchmark
+TEST(4) 
+{
+  const unsigned int w = 2000, h = 2000;
+
+  lay::Bitmap bm (w, h, 1.0);
+  lay::BitmapRenderer r (w, h, 1.0);
+
+  {
+    tl::SelfTimer timer ("render_fill of 10000 boxes");
+    for (unsigned int i = 0; i < 100; ++i) {
+      for (unsigned int j = 0; j < 100; ++j) {
+        r.clear ();
+        r.insert (db::DBox (i * 20.0, j * 20.0, i * 20.0 + 500.0, j * 20.0 + 15.0));
+        r.render_fill (bm);
+      }
+    }
+  }
+
+  //  the boxes cover all pixels of the lines 1 to 14
+  bool ok = true;
+  for (unsigned int x = 0; x < w && ok; ++x) {
+    ok = bit (bm, x, 1) && bit (bm, x, 14);
+  }
+  EXPECT_EQ (ok, true);
+
+  lay::Bitmap bm2 (w, h, 1.0);
+  {
+    tl::SelfTimer timer ("merge of 100 bitmaps");
+    for (unsigned int i = 0; i < 100; ++i) {
+      bm2.merge (&bm, int (i), 0);
+    }
+  }
+
+  EXPECT_EQ (bit (bm2, 0, 1), true);
+  EXPECT_EQ (bit (bm2, 1999, 1999), false);
+}
@@ -0,0 +1,181 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layCellBitmapCache.h"
+#include "tlUnitTest.h"
+
+static lay::CellBitmapCacheKey
+key (db::cell_index_type ci, const db::DPoint &offset = db::DPoint ())
+{
+  return lay::CellBitmapCacheKey (0, 1, false, lay::CellCacheKey (0, ci, db::CplxTrans ()), offset);
+}
+
+//  puts a 32x8 fill bitmap (32 bytes) into the cache
+static void
+put (lay::CellBitmapCache &cache, const lay::CellBitmapCacheKey &k)
+{
+  lay::CellCacheInfo info;
+  info.fill = new lay::Bitmap (32, 8, 1.0);
+  cache.put (k, info, cache.generation ());
+}
+
+static bool
+take (lay::CellBitmapCache &cache, const lay::CellBitmapCacheKey &k)
+{
+  lay::CellCacheInfo info;
+  bool found = cache.take (k, info);
+  if (found && (! info.fill || info.fill->width () != 32 || info.fill->height () != 8)) {
+    return false;
+  }
+  return found;
+}
+
+TEST(1)
+{
+  //  LRU order
+  lay::CellBitmapCache cache;
+  cache.set_max_size (100);
+  EXPECT_EQ (cache.max_size (), size_t (100));
+  EXPECT_EQ (cache.size (), size_t (0));
+
+  put (cache, key (1));
+  put (cache, key (2));
+  put (cache, key (3));
+  EXPECT_EQ (cache.size (), size_t (96));
+
+  //  putting 1 again makes it the most recently used entry, so 2 is the one to go
+  put (cache, key (1));
+  EXPECT_EQ (cache.size (), size_t (96));
+  put (cache, key (4));
+  EXPECT_EQ (cache.size (), size_t (96));
+
+  EXPECT_EQ (take (cache, key (2)), false);
+  EXPECT_EQ (take (cache, key (1)), true);
+  EXPECT_EQ (take (cache, key (3)), true);
+  EXPECT_EQ (take (cache, key (4)), true);
+  EXPECT_EQ (cache.size (), size_t (0));
+
+  //  entries are taken out
+  EXPECT_EQ (take (cache, key (1)), false);
+}
+
+TEST(2)
+{
+  //  byte budget
+  lay::CellBitmapCache cache;
+  cache.set_max_size (1000);
+
+  put (cache, key (1));
+  put (cache, key (2));
+  put (cache, key (3));
+  EXPECT_EQ (cache.size (), size_t (96));
+
+  //  reducing the limit drops the oldest entries
+  cache.set_max_size (64);
+  EXPECT_EQ (cache.size (), size_t (64));
+  EXPECT_EQ (take (cache, key (1)), false);
+  EXPECT_EQ (take (cache, key (2)), true);
+  EXPECT_EQ (cache.size (), size_t (32));
+
+  //  all bitmaps of an entry count: 32 + 32 bytes, so 3 has to go
+  lay::CellCacheInfo info;
+  info.fill = new lay::Bitmap (32, 8, 1.0);
+  info.frame = new lay::Bitmap (64, 4, 1.0);
+  cache.put (key (5), info, cache.generation ());
+  EXPECT_EQ (info.fill == 0, true);
+  EXPECT_EQ (info.frame == 0, true);
+  EXPECT_EQ (cache.size (), size_t (64));
+  EXPECT_EQ (take (cache, key (3)), false);
+
+  //  entries bigger than the limit are not accepted and stay with the caller
+  lay::CellCacheInfo big;
+  big.fill = new lay::Bitmap (1024, 1, 1.0);
+  cache.put (key (6), big, cache.generation ());
+  EXPECT_EQ (big.fill != 0, true);
+  EXPECT_EQ (cache.size (), size_t (64));
+  EXPECT_EQ (take (cache, key (6)), false);
+
+  lay::CellCacheInfo taken;
+  EXPECT_EQ (cache.take (key (5), taken), true);
+  EXPECT_EQ (taken.fill != 0 && taken.frame != 0, true);
+  EXPECT_EQ (cache.size (), size_t (0));
+}
+
+TEST(3)
+{
+  //  generation invalidation
+  lay::CellBitmapCache cache;
+
+  size_t g = cache.generation ();
+  put (cache, key (1));
+  EXPECT_EQ (cache.size (), size_t (32));
+
+  cache.clear ();
+  EXPECT_EQ (cache.size (), size_t (0));
+  EXPECT_NE (cache.generation (), g);
+
+  //  bitmaps drawn before the clear are rejected
+  lay::CellCacheInfo info;
+  info.fill = new lay::Bitmap (32, 8, 1.0);
+  cache.put (key (2), info, g);
+  EXPECT_EQ (info.fill != 0, true);
+  EXPECT_EQ (cache.size (), size_t (0));
+  EXPECT_EQ (take (cache, key (2)), false);
+
+  //  validate clears the cache only if the state changes
+  cache.validate ("A");
+  put (cache, key (3));
+  g = cache.generation ();
+  cache.validate ("A");
+  EXPECT_EQ (cache.generation (), g);
+  EXPECT_EQ (cache.size (), size_t (32));
+  cache.validate ("B");
+  EXPECT_NE (cache.generation (), g);
+  EXPECT_EQ (cache.size (), size_t (0));
+  EXPECT_EQ (take (cache, key (3)), false);
+}
+
+TEST(4)
+{
+  //  phase key
+  lay::CellBitmapCache cache;
+
+  put (cache, key (1, db::DPoint (0.5, 0.25)));
+
+  //  the phase is quantized to 1/16 pixel, the integer part does not matter
+  EXPECT_EQ (take (cache, key (1, db::DPoint (0.55, 0.25))), false);
+  EXPECT_EQ (take (cache, key (1, db::DPoint (0.5, 0.3))), false);
+  EXPECT_EQ (take (cache, key (1, db::DPoint (10.51, -1.76))), true);
+
+  //  phases close to a full pixel wrap around to zero
+  put (cache, key (1, db::DPoint (0.0, 0.0)));
+  EXPECT_EQ (take (cache, key (1, db::DPoint (0.999, 2.0))), true);
+
+  //  other components of the key
+  put (cache, key (1));
+  EXPECT_EQ (take (cache, lay::CellBitmapCacheKey (0, 2, false, lay::CellCacheKey (0, 1, db::CplxTrans ()), db::DPoint ())), false);
+  EXPECT_EQ (take (cache, lay::CellBitmapCacheKey (0, 1, true, lay::CellCacheKey (0, 1, db::CplxTrans ()), db::DPoint ())), false);
+  EXPECT_EQ (take (cache, lay::CellBitmapCacheKey (0, 1, false, lay::CellCacheKey (1, 1, db::CplxTrans ()), db::DPoint ())), false);
+  EXPECT_EQ (take (cache, lay::CellBitmapCacheKey (0, 1, false, lay::CellCacheKey (0, 1, db::CplxTrans (2.0)), db::DPoint ())), false);
+  EXPECT_EQ (take (cache, key (1)), true);
+}
@@ -0,0 +1,208 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layDensityPyramid.h"
+#include "layBitmap.h"
+#include "tlUnitTest.h"
+
+#include <stdlib.h>
+
+static bool
+bit (const lay::Bitmap &bm, unsigned int x, unsigned int y)
+{
+  return (bm.scanline (y)[x / 32] & (1 << (x % 32))) != 0;
+}
+
+static std::string
+to_string (const lay::Bitmap &bm)
+{
+  std::string r;
+
+  for (unsigned int j = bm.height (); j > 0; --j) {
+    for (unsigned int k = 0; k < bm.width (); ++k) {
+      r += bit (bm, k, j - 1) ? "#" : "-";
+    }
+    r += "\n";
+  }
+
+  return r;
+}
+
+TEST(1)
+{
+  lay::DensityPyramid pyramid (db::Box (0, 0, 1000, 500), 100);
+
+  EXPECT_EQ (pyramid.pixel_size (), 10.0);
+  EXPECT_EQ (pyramid.base ().width (), 101u);
+  EXPECT_EQ (pyramid.base ().height (), 51u);
+
+  pyramid.mark (pyramid.pixel_trans () * db::Box (100, 100, 120, 120));
+  pyramid.finish ();
+
+  EXPECT_EQ (pyramid.levels (), 4u);
+  EXPECT_EQ (pyramid.level (3).width (), 13u);
+  EXPECT_EQ (pyramid.level (3).height (), 7u);
+  EXPECT_EQ (bit (pyramid.level (1), 5, 5), true);
+  EXPECT_EQ (bit (pyramid.level (1), 6, 6), true);
+  EXPECT_EQ (bit (pyramid.level (1), 7, 6), false);
+
+  std::vector<db::Box> regions;
+  regions.push_back (db::Box (0, 0, 10, 10));
+
+  //  not fine enough
+  lay::Bitmap bitmap (10, 10, 1.0);
+  EXPECT_EQ (pyramid.draw (db::CplxTrans (1.0), regions, &bitmap), false);
+  EXPECT_EQ (bitmap.empty (), true);
+
+  //  uses level 2 (40 dbu per pixel)
+  EXPECT_EQ (pyramid.draw (db::CplxTrans (1.0 / 40.0), regions, &bitmap), true);
+  EXPECT_EQ (to_string (bitmap),
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "--##------\n"
+    "--##------\n"
+    "----------\n"
+    "----------\n"
+  );
+
+  //  only inside the regions
+  regions.clear ();
+  regions.push_back (db::Box (3, 0, 9, 9));
+  lay::Bitmap bitmap2 (10, 10, 1.0);
+  EXPECT_EQ (pyramid.draw (db::CplxTrans (1.0 / 40.0), regions, &bitmap2), true);
+  EXPECT_EQ (to_string (bitmap2),
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "----------\n"
+    "---#------\n"
+    "---#------\n"
+    "----------\n"
+    "----------\n"
+  );
+}
+
+TEST(2)
+{
+  lay::DensityPyramid pyramid (db::Box (0, 0, 2999, 1999), 3000);
+
+  srand (1);
+  for (unsigned int i = 0; i < 5000; ++i) {
+    double x = rand () % 3000, y = rand () % 2000;
+    pyramid.mark (db::DBox (x, y, x, y));
+  }
+  pyramid.finish ();
+
+  EXPECT_EQ (pyramid.levels (), 9u);
+
+  //  each pixel is the "or" of the corresponding 2x2 pixels of the finer level
+  bool ok = true;
+  for (unsigned int l = 1; l < pyramid.levels () && ok; ++l) {
+    const lay::Bitmap &c = pyramid.level (l);
+    const lay::Bitmap &f = pyramid.level (l - 1);
+    for (unsigned int y = 0; y < c.height () && ok; ++y) {
+      for (unsigned int x = 0; x < c.width () && ok; ++x) {
+        bool r = false;
+        for (unsigned int i = 0; i < 4; ++i) {
+          unsigned int xx = x * 2 + i % 2, yy = y * 2 + i / 2;
+          if (xx < f.width () && yy < f.height () && bit (f, xx, yy)) {
+            r = true;
+          }
+        }
+        ok = (bit (c, x, y) == r);
+      }
+    }
+  }
+  EXPECT_EQ (ok, true);
+}
+
+
+TEST(3)
+{
+  lay::DensityPyramid pyramid (db::Box (0, 0, 99, 99), 100);
+
+  //  a dense orthogonal array marks its bounding box
+  pyramid.mark_array (db::DBox (10, 10, 10, 10), db::DVector (1, 0), db::DVector (0, 1), 5, 3);
+  EXPECT_EQ (bit (pyramid.base (), 10, 10), true);
+  EXPECT_EQ (bit (pyramid.base (), 14, 12), true);
+  EXPECT_EQ (bit (pyramid.base (), 15, 12), false);
+  EXPECT_EQ (bit (pyramid.base (), 14, 13), false);
+
+  //  a sparse array marks the members only
+  pyramid.mark_array (db::DBox (30, 30, 30, 30), db::DVector (4, 0), db::DVector (0, 4), 3, 2);
+  EXPECT_EQ (bit (pyramid.base (), 30, 30), true);
+  EXPECT_EQ (bit (pyramid.base (), 34, 30), true);
+  EXPECT_EQ (bit (pyramid.base (), 38, 34), true);
+  EXPECT_EQ (bit (pyramid.base (), 32, 30), false);
+  EXPECT_EQ (bit (pyramid.base (), 34, 32), false);
+
+  //  a skewed array with more members than pixels marks its bounding box
+  pyramid.mark_array (db::DBox (50, 50, 50, 50), db::DVector (0.5, 0.5), db::DVector (0.5, -0.5), 10, 10);
+  EXPECT_EQ (bit (pyramid.base (), 51, 53), true);
+  EXPECT_EQ (bit (pyramid.base (), 58, 47), true);
+  EXPECT_EQ (bit (pyramid.base (), 61, 50), false);
+
+  //  a skewed sparse array marks the members only
+  pyramid.mark_array (db::DBox (70, 70, 70, 70), db::DVector (3, 3), db::DVector (3, -3), 3, 3);
+  EXPECT_EQ (bit (pyramid.base (), 76, 70), true);
+  EXPECT_EQ (bit (pyramid.base (), 73, 70), false);
+}
+
+TEST(4)
+{
+  lay::DensityPyramidCache cache;
+
+  EXPECT_EQ (cache.take_partial (0, 1, 2) == 0, true);
+
+  lay::DensityPyramid *p = new lay::DensityPyramid (db::Box (0, 0, 99, 99), 100);
+  p->build_position ().push_back (17);
+  cache.put_partial (0, 1, 2, p);
+
+  //  a partial pyramid is not a finished one
+  EXPECT_EQ (cache.take_partial (0, 1, 3) == 0, true);
+  EXPECT_EQ (cache.take_partial (1, 1, 2) == 0, true);
+
+  lay::DensityPyramid *pp = cache.take_partial (0, 1, 2);
+  EXPECT_EQ (pp == p, true);
+  EXPECT_EQ (pp->build_position ().size (), size_t (1));
+
+  //  taking it removes it from the cache
+  EXPECT_EQ (cache.take_partial (0, 1, 2) == 0, true);
+
+  //  putting another partial pyramid replaces the first one
+  cache.put_partial (0, 1, 2, pp);
+  cache.put_partial (0, 1, 2, new lay::DensityPyramid (db::Box (0, 0, 99, 99), 100));
+  pp = cache.take_partial (0, 1, 2);
+  EXPECT_EQ (pp != 0 && pp->build_position ().empty (), true);
+  delete pp;
+
+  cache.put_partial (0, 1, 2, new lay::DensityPyramid (db::Box (0, 0, 99, 99), 100));
+  cache.clear ();
+  EXPECT_EQ (cache.take_partial (0, 1, 2) == 0, true);
+}
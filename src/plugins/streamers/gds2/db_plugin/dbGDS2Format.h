@@ -45,7 +45,8 @@ public:
   GDS2ReaderOptions ()
     : box_mode (1),
       allow_big_records (true),
-      allow_multi_xy_records (true)
+      allow_multi_xy_records (true),
+      threads (0)
   {
     //  .. nothing yet ..
   }
@@ -75,6 +76,16 @@ public:
    */
   bool allow_multi_xy_records;
 
+  /**
+   *  @brief The number of threads to use for reading the cells
+   *
+   *  If this value is 0, the file is read in the calling thread. Otherwise the
+   *  calling thread only splits the file into cells. The cell bodies are decoded
+   *  by the given number of worker threads and the results are transferred into the
+   *  layout in the order of the file. The resulting layout is the same in both cases.
+   */
+  unsigned int threads;
+
   /** 
    *  @brief Implementation of FormatSpecificReaderOptions
    */
@@ -25,25 +25,187 @@
 #include "dbGDS2Reader.h"
 #include "dbGDS2.h"
 #include "dbArray.h"
+#include "dbLayoutUtils.h"
 
 #include "tlException.h"
 #include "tlString.h"
 #include "tlClassRegistry.h"
+#include "tlThreadedWorkers.h"
+
+#include <memory>
+#include <set>
 
 namespace db
 {
 
+// ---------------------------------------------------------------
+//  Multi-threaded reading support
+
+//  The number of bytes collected for one worker task
+static const size_t batch_size = 256 * 1024;
+
+//  The number of batches per worker which are allowed to be pending
+static const size_t max_pending_batches_per_worker = 4;
+
+/**
+ *  @brief A batch of cell bodies which are read by a worker
+ *
+ *  The batch holds the raw records of the bodies of one or more cells.
+ *  The worker reads these records into a private layout from which the
+ *  reader transfers the cells into the target layout.
+ */
+class GDS2CellBatch
+{
+public:
+  struct Cell
+  {
+    tl::string name;
+    //  the offset of the body inside the data block
+    size_t offset;
+    //  the position of the body inside the file and the number of the record before (for messages)
+    size_t file_pos;
+    size_t recnum;
+  };
+
+  GDS2CellBatch ()
+    : done (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  std::vector<char> data;
+  std::vector<Cell> cells;
+
+  //  the results
+  std::auto_ptr<db::Layout> layout;
+  std::vector<db::cell_index_type> cell_indexes;
+  std::string error;
+  bool done;
+};
+
+/**
+ *  @brief The job reading the cell batches
+ */
+class GDS2ReaderJob
+  : public tl::JobBase
+{
+public:
+  GDS2ReaderJob (const GDS2Reader *master, int nworkers)
+    : tl::JobBase (nworkers), mp_master (master)
+  {
+    //  .. nothing yet ..
+  }
+
+  const GDS2Reader *master () const
+  {
+    return mp_master;
+  }
+
+  void batch_done (GDS2CellBatch *batch)
+  {
+    m_lock.lock ();
+    batch->done = true;
+    m_done_condition.wakeAll ();
+    m_lock.unlock ();
+  }
+
+  bool is_done (const GDS2CellBatch *batch)
+  {
+    m_lock.lock ();
+    bool done = batch->done;
+    m_lock.unlock ();
+    return done;
+  }
+
+  void wait_for (const GDS2CellBatch *batch)
+  {
+    m_lock.lock ();
+    while (! batch->done) {
+      m_done_condition.wait (&m_lock);
+    }
+    m_lock.unlock ();
+  }
+
+protected:
+  virtual tl::Worker *create_worker ();
+
+private:
+  const GDS2Reader *mp_master;
+  tl::Mutex m_lock;
+  tl::WaitCondition m_done_condition;
+};
+
+class GDS2ReaderTask
+  : public tl::Task
+{
+public:
+  GDS2ReaderTask (GDS2CellBatch *batch)
+    : mp_batch (batch)
+  {
+    //  .. nothing yet ..
+  }
+
+  GDS2CellBatch *batch () const
+  {
+    return mp_batch;
+  }
+
+private:
+  GDS2CellBatch *mp_batch;
+};
+
+class GDS2ReaderWorker
+  : public tl::Worker
+{
+public:
+  GDS2ReaderWorker (GDS2ReaderJob *job)
+    : tl::Worker (), mp_job (job)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    GDS2CellBatch *batch = static_cast<GDS2ReaderTask *> (task)->batch ();
+
+    try {
+      tl::InputMemoryStream data_stream (batch->data.empty () ? 0 : &batch->data.front (), batch->data.size ());
+      tl::InputStream stream (data_stream);
+      GDS2Reader reader (stream);
+      reader.read_batch (*batch, *mp_job->master ());
+    } catch (tl::Exception &ex) {
+      batch->error = ex.msg ();
+    } catch (std::exception &ex) {
+      batch->error = ex.what ();
+    }
+
+    mp_job->batch_done (batch);
+  }
+
+private:
+  GDS2ReaderJob *mp_job;
+};
+
+tl::Worker *
+GDS2ReaderJob::create_worker ()
+{
+  return new GDS2ReaderWorker (this);
+}
+
 // ---------------------------------------------------------------
 //  GDS2Reader
 
 GDS2Reader::GDS2Reader (tl::InputStream &s)
   : m_stream (s), 
+    m_pos_offset (0),
     m_recnum (0),
     m_reclen (0),
     m_recptr (0),
     mp_rec_buf (0),
     m_stored_rec (0),
-    m_progress (tl::to_string (tr ("Reading GDS2 file")), 10000)
+    m_progress (tl::to_string (tr ("Reading GDS2 file")), 10000),
+    mp_job (0),
+    mp_current_batch (0)
 {
   m_progress.set_format (tl::to_string (tr ("%.0f MB")));
   m_progress.set_unit (1024 * 1024);
@@ -51,7 +213,7 @@ GDS2Reader::GDS2Reader (tl::InputStream &s)
 
 GDS2Reader::~GDS2Reader ()
 {
-  //  .. nothing yet ..
+  clear_batches ();
 }
 
 const LayerMap &
@@ -64,7 +226,193 @@ GDS2Reader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
   --m_recnum;
   m_reclen = 0;
 
-  return basic_read (layout, m_common_options.layer_map, m_common_options.create_other_layers, m_common_options.enable_text_objects, m_common_options.enable_properties, m_options.allow_multi_xy_records, m_options.box_mode);
+  clear_batches ();
+
+  try {
+    const LayerMap &lm = basic_read (layout, m_common_options.layer_map, m_common_options.create_other_layers, m_common_options.enable_text_objects, m_common_options.enable_properties, m_options.allow_multi_xy_records, m_options.box_mode);
+    clear_batches ();
+    return lm;
+  } catch (...) {
+    clear_batches ();
+    throw;
+  }
+}
+
+void
+GDS2Reader::clear_batches ()
+{
+  //  stop the workers before the batches are deleted
+  if (mp_job) {
+    mp_job->terminate ();
+    delete mp_job;
+    mp_job = 0;
+  }
+
+  for (std::list<GDS2CellBatch *>::const_iterator b = m_batches.begin (); b != m_batches.end (); ++b) {
+    delete *b;
+  }
+  m_batches.clear ();
+
+  if (mp_current_batch) {
+    delete mp_current_batch;
+    mp_current_batch = 0;
+  }
+}
+
+bool
+GDS2Reader::defer_cell (db::Layout &layout)
+{
+  if (m_options.threads == 0) {
+    return false;
+  }
+
+  if (! mp_current_batch) {
+    mp_current_batch = new GDS2CellBatch ();
+  }
+
+  std::vector<char> &data = mp_current_batch->data;
+
+  GDS2CellBatch::Cell cell;
+  cell.name = cellname ();
+  cell.offset = data.size ();
+  cell.file_pos = m_stream.pos ();
+  cell.recnum = m_recnum;
+  mp_current_batch->cells.push_back (cell);
+
+  //  Collect the raw records up to and including ENDSTR. The records are checked
+  //  by the worker's reader.
+  while (true) {
+
+    const char *b = m_stream.get (4);
+    if (! b) {
+      error (tl::to_string (tr ("Unexpected end-of-file")));
+    }
+
+    m_recnum++;
+
+    uint16_t l = *((uint16_t *)b);
+    gds2h ((int16_t &) l);
+    size_t reclen = size_t (l);
+
+    uint16_t rec_id = ((uint16_t *)b) [1];
+    gds2h ((int16_t &) rec_id);
+
+    if (reclen < 4) {
+      error (tl::to_string (tr ("Invalid record length (less than 4)")));
+    }
+
+    data.insert (data.end (), b, b + 4);
+
+    if (reclen > 4) {
+      const char *r = m_stream.get (reclen - 4);
+      if (! r) {
+        error (tl::to_string (tr ("Unexpected end-of-file")));
+      }
+      data.insert (data.end (), r, r + (reclen - 4));
+    }
+
+    if (short (rec_id) == sENDSTR) {
+      break;
+    }
+
+  }
+
+  progress_checkpoint ();
+
+  if (data.size () >= batch_size) {
+    submit_batch (layout);
+  }
+
+  return true;
+}
+
+void
+GDS2Reader::submit_batch (db::Layout &layout)
+{
+  if (! mp_current_batch) {
+    return;
+  }
+
+  if (! mp_job) {
+    mp_job = new GDS2ReaderJob (this, int (m_options.threads));
+  }
+
+  GDS2CellBatch *batch = mp_current_batch;
+  mp_current_batch = 0;
+
+  m_batches.push_back (batch);
+  mp_job->schedule (new GDS2ReaderTask (batch));
+
+  //  the job finishes when the workers run out of tasks - restart it in that case
+  if (! mp_job->is_running ()) {
+    mp_job->start ();
+  }
+
+  //  transfer the batches which are ready and limit the number of pending ones
+  while (! m_batches.empty () && (mp_job->is_done (m_batches.front ()) || m_batches.size () > size_t (m_options.threads) * max_pending_batches_per_worker)) {
+    transfer_batch (layout);
+  }
+}
+
+void
+GDS2Reader::transfer_batch (db::Layout &layout)
+{
+  std::auto_ptr<GDS2CellBatch> batch (m_batches.front ());
+  m_batches.pop_front ();
+
+  mp_job->wait_for (batch.get ());
+
+  if (! batch->error.empty ()) {
+    throw ReaderException (batch->error);
+  }
+
+  db::PropertyMapper pm (layout, *batch->layout);
+
+  //  NOTE: a cell may appear multiple times in the file - its content is collected in the same cell
+  std::set<db::cell_index_type> transferred;
+  for (std::vector<db::cell_index_type>::const_iterator c = batch->cell_indexes.begin (); c != batch->cell_indexes.end (); ++c) {
+    if (transferred.insert (*c).second) {
+      transfer_cell (layout, *batch->layout, *c, pm);
+    }
+  }
+}
+
+void
+GDS2Reader::finish_deferred_cells (db::Layout &layout)
+{
+  submit_batch (layout);
+
+  while (! m_batches.empty ()) {
+    transfer_batch (layout);
+  }
+}
+
+void
+GDS2Reader::read_batch (GDS2CellBatch &batch, const GDS2Reader &master)
+{
+  m_options = master.m_options;
+  m_options.threads = 0;
+  setup_from (master);
+
+  batch.layout.reset (new db::Layout (false));
+  db::Layout &layout = *batch.layout;
+
+  for (std::vector<GDS2CellBatch::Cell>::const_iterator c = batch.cells.begin (); c != batch.cells.end (); ++c) {
+
+    tl_assert (m_stream.pos () == c->offset);
+
+    m_pos_offset = c->file_pos - c->offset;
+    m_recnum = c->recnum;
+    set_cellname (c->name);
+
+    db::cell_index_type ci = make_cell (layout, c->name.c_str (), false);
+    batch.cell_indexes.push_back (ci);
+
+    read_cell_body (layout, &layout.cell (ci));
+
+  }
+
+  set_cellname (tl::string ());
 }
 
 const LayerMap &
@@ -259,7 +607,7 @@ GDS2Reader::progress_checkpoint ()
 void 
 GDS2Reader::error (const std::string &msg)
 {
-  throw GDS2ReaderException (msg, m_stream.pos (), m_recnum, cellname ().c_str ());
+  throw GDS2ReaderException (msg, m_stream.pos () + m_pos_offset, m_recnum, cellname ().c_str ());
 }
 
 void 
@@ -267,7 +615,7 @@ GDS2Reader::warn (const std::string &msg)
 {
   // TODO: compress
   tl::warn << msg 
-           << tl::to_string (tr (" (position=")) << m_stream.pos ()
+           << tl::to_string (tr (" (position=")) << m_stream.pos () + m_pos_offset
            << tl::to_string (tr (", record number=")) << m_recnum
            << tl::to_string (tr (", cell=")) << cellname ().c_str ()
            << ")";
@@ -38,9 +38,14 @@
 #include "tlString.h"
 #include "tlStream.h"
 
+#include <list>
+
 namespace db
 {
 
+class GDS2CellBatch;
+class GDS2ReaderJob;
+
 /**
  *  @brief Generic base class of GDS2 reader exceptions
  */
@@ -110,7 +115,10 @@ public:
   virtual const char *format () const { return "GDS2"; }
 
 private:
+  friend class GDS2ReaderWorker;
+
   tl::InputStream &m_stream;
+  size_t m_pos_offset;
   size_t m_recnum;
   size_t m_reclen;
   size_t m_recptr;
@@ -120,6 +128,16 @@ private:
   db::GDS2ReaderOptions m_options;
   db::CommonReaderOptions m_common_options;
   tl::AbsoluteProgress m_progress;
+  GDS2ReaderJob *mp_job;
+  std::list<GDS2CellBatch *> m_batches;
+  GDS2CellBatch *mp_current_batch;
+
+  virtual bool defer_cell (db::Layout &layout);
+  virtual void finish_deferred_cells (db::Layout &layout);
+  void submit_batch (db::Layout &layout);
+  void transfer_batch (db::Layout &layout);
+  void read_batch (GDS2CellBatch &batch, const GDS2Reader &master);
+  void clear_batches ();
 
   virtual void error (const std::string &txt);
   virtual void warn (const std::string &txt);
@@ -24,6 +24,7 @@
 #include "dbGDS2ReaderBase.h"
 #include "dbGDS2.h"
 #include "dbArray.h"
+#include "dbLayoutUtils.h"
 
 #include "tlException.h"
 #include "tlString.h"
@@ -318,11 +319,6 @@ GDS2ReaderBase::do_read (db::Layout &layout)
     layout.prop_id (layout.properties_repository ().properties_id (layout_properties));
   }
 
-  //  this container has been found to grow quite a lot.
-  //  using a list instead of a vector should make this more efficient.
-  tl::vector<db::CellInstArray> instances;
-  tl::vector<db::CellInstArrayWithProperties> instances_with_props;
-
   //  prepare a string vector for the context information
   m_context_info.clear ();
 
@@ -333,10 +329,6 @@ GDS2ReaderBase::do_read (db::Layout &layout)
 
     progress_checkpoint ();
 
-    //  erase current instance list 
-    instances.erase (instances.begin (), instances.end ());
-    instances_with_props.erase (instances_with_props.begin (), instances_with_props.end ());
-
     if (get_record () != sSTRNAME) {
       error (tl::to_string (tr ("STRNAME record expected")));
     }
@@ -349,7 +341,10 @@ GDS2ReaderBase::do_read (db::Layout &layout)
 
       read_context_info_cell ();
 
-    } else {
+    } else if (m_context_info.find (m_cellname) != m_context_info.end () || ! defer_cell (layout)) {
+
+      //  cells which are not read by a deferred reader may depend on the cells read before
+      finish_deferred_cells (layout);
 
       db::cell_index_type cell_index = make_cell (layout, m_cellname.c_str (), false);
 
@@ -366,93 +361,165 @@ GDS2ReaderBase::do_read (db::Layout &layout)
         }
       }
       
-      long attr = 0;
-      db::PropertiesRepository::properties_set cell_properties;
+      read_cell_body (layout, cell);
 
-      //  read cell content
-      while ((rec_id = get_record ()) != sENDSTR) { 
+    }
 
-        progress_checkpoint ();
+    m_cellname = "";
+    first_cell = false;
 
-        if (cell == 0) {
+  }
 
-          //  ignore everything in proxy cells: these are created from the libraries or PCell's.
+  finish_deferred_cells (layout);
 
-        } else if (rec_id == sPROPATTR) {
+  //  check, if the last record is a ENDLIB
+  if (rec_id != sENDLIB) {
+    error (tl::to_string (tr ("ENDLIB record expected")));
+  }
+}
 
-          attr = long (get_ushort ());
+void
+GDS2ReaderBase::read_cell_body (db::Layout &layout, db::Cell *cell)
+{
+  short rec_id = 0;
 
-        } else if (rec_id == sPROPVALUE) {
+  //  erase current instance list 
+  m_instances.erase (m_instances.begin (), m_instances.end ());
+  m_instances_with_props.erase (m_instances_with_props.begin (), m_instances_with_props.end ());
 
-          const char *value = get_string ();
-          if (m_read_properties) {
-            cell_properties.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant (attr)), tl::Variant (value)));
-          }
+  long attr = 0;
+  db::PropertiesRepository::properties_set cell_properties;
 
-        } else if (rec_id == sBOUNDARY) {
+  //  read cell content
+  while ((rec_id = get_record ()) != sENDSTR) { 
 
-          read_boundary (layout, *cell, false);
+    progress_checkpoint ();
 
-        } else if (rec_id == sPATH) {
+    if (cell == 0) {
 
-          read_path (layout, *cell);
+      //  ignore everything in proxy cells: these are created from the libraries or PCell's.
 
-        } else if (rec_id == sSREF || rec_id == sAREF) {
+    } else if (rec_id == sPROPATTR) {
 
-          bool array = (rec_id == sAREF);
-          read_ref (layout, *cell, array, instances, instances_with_props);
+      attr = long (get_ushort ());
 
-        } else if (rec_id == sTEXT) {
+    } else if (rec_id == sPROPVALUE) {
 
-          read_text (layout, *cell);
+      const char *value = get_string ();
+      if (m_read_properties) {
+        cell_properties.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant (attr)), tl::Variant (value)));
+      }
 
-        } else if (rec_id == sBOX) {
+    } else if (rec_id == sBOUNDARY) {
 
-          if (m_box_mode == 1) {
-            read_box (layout, *cell);
-          } else if (m_box_mode == 2) {
-            read_boundary (layout, *cell, true);
-          } else if (m_box_mode == 3) {
-            error (tl::to_string (tr ("BOX record encountered (reader is configured to produce an error in this case)")));
-          } else {
-            while (get_record () != sENDEL) { }
-          }
+      read_boundary (layout, *cell, false);
 
-        } else if (rec_id == sNODE) {
+    } else if (rec_id == sPATH) {
 
-          //  NODE records are ignored.
-          while (get_record () != sENDEL) { }
+      read_path (layout, *cell);
 
-        } else {
-          error (tl::to_string (tr ("Invalid record or data type")));
-        }
-      
-      }
+    } else if (rec_id == sSREF || rec_id == sAREF) {
 
-      //  insert all instances collected
-      if (! instances.empty ()) {
-        cell->insert (instances.begin (), instances.end ());
-      }
-      if (! instances_with_props.empty ()) {
-        cell->insert (instances_with_props.begin (), instances_with_props.end ());
-      }
+      bool array = (rec_id == sAREF);
+      read_ref (layout, *cell, array, m_instances, m_instances_with_props);
+
+    } else if (rec_id == sTEXT) {
+
+      read_text (layout, *cell);
 
-      //  set the cell properties
-      if (! cell_properties.empty ()) {
-        cell->prop_id (layout.properties_repository ().properties_id (cell_properties));
+    } else if (rec_id == sBOX) {
+
+      if (m_box_mode == 1) {
+        read_box (layout, *cell);
+      } else if (m_box_mode == 2) {
+        read_boundary (layout, *cell, true);
+      } else if (m_box_mode == 3) {
+        error (tl::to_string (tr ("BOX record encountered (reader is configured to produce an error in this case)")));
+      } else {
+        while (get_record () != sENDEL) { }
       }
 
+    } else if (rec_id == sNODE) {
+
+      //  NODE records are ignored.
+      while (get_record () != sENDEL) { }
+
+    } else {
+      error (tl::to_string (tr ("Invalid record or data type")));
     }
+  
+  }
 
-    m_cellname = "";
-    first_cell = false;
+  //  insert all instances collected
+  if (! m_instances.empty ()) {
+    cell->insert (m_instances.begin (), m_instances.end ());
+  }
+  if (! m_instances_with_props.empty ()) {
+    cell->insert (m_instances_with_props.begin (), m_instances_with_props.end ());
+  }
 
+  //  set the cell properties
+  if (! cell_properties.empty ()) {
+    cell->prop_id (layout.properties_repository ().properties_id (cell_properties));
   }
+}
 
-  //  check, if the last record is a ENDLIB
-  if (rec_id != sENDLIB) {
-    error (tl::to_string (tr ("ENDLIB record expected")));
+void
+GDS2ReaderBase::setup_from (const GDS2ReaderBase &other)
+{
+  m_layer_map = LayerMap ();
+  m_create_layers = true;
+  m_read_texts = other.m_read_texts;
+  m_read_properties = other.m_read_properties;
+  m_allow_multi_xy_records = other.m_allow_multi_xy_records;
+  m_box_mode = other.m_box_mode;
+  m_dbu = other.m_dbu;
+  m_dbuu = other.m_dbuu;
+  m_libname = other.m_libname;
+  m_cellname = "";
+  m_mapped_cellnames.clear ();
+}
+
+void
+GDS2ReaderBase::transfer_cell (db::Layout &layout, const db::Layout &source, db::cell_index_type source_cell_index, db::PropertyMapper &pm)
+{
+  const db::Cell &source_cell = source.cell (source_cell_index);
+
+  m_cellname = source.cell_name (source_cell_index);
+  db::Cell &cell = layout.cell (make_cell (layout, m_cellname.c_str (), false));
+
+  //  the source layout holds one layer per GDS layer/datatype pair
+  for (unsigned int l = 0; l < source.layers (); ++l) {
+    if (source.is_valid_layer (l) && ! source_cell.shapes (l).empty ()) {
+      const db::LayerProperties &lp = source.get_properties (l);
+      std::pair<bool, unsigned int> ll = open_dl (layout, LDPair (lp.layer, lp.datatype), m_create_layers);
+      if (ll.first) {
+        cell.shapes (ll.second).insert (source_cell.shapes (l), pm);
+      }
+    }
   }
+
+  //  instances refer to the target cells by name
+  std::map<db::cell_index_type, db::cell_index_type> cell_map;
+  for (db::Cell::const_iterator i = source_cell.begin (); ! i.at_end (); ++i) {
+    db::cell_index_type ci = i->cell_index ();
+    if (cell_map.find (ci) == cell_map.end ()) {
+      cell_map.insert (std::make_pair (ci, make_cell (layout, source.cell_name (ci), true)));
+    }
+  }
+
+  if (! cell_map.empty ()) {
+    tl::map_map<db::cell_index_type> im (cell_map);
+    for (db::Cell::const_iterator i = source_cell.begin (); ! i.at_end (); ++i) {
+      cell.insert (*i, im, pm);
+    }
+  }
+
+  if (source_cell.prop_id () != 0) {
+    cell.prop_id (pm (source_cell.prop_id ()));
+  }
+
+  m_cellname = "";
 }
 
 void
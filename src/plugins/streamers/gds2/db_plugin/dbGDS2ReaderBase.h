@@ -39,6 +39,8 @@
 namespace db
 {
 
+class PropertyMapper;
+
 struct GDS2XY
 {
   unsigned char x[4];
@@ -95,6 +97,65 @@ protected:
    */
   const tl::string &cellname () const { return m_cellname; }
 
+  /**
+   *  @brief Reads the body of a cell
+   *
+   *  This method reads the records following STRNAME up to and including ENDSTR
+   *  into the given cell. If the cell is 0, the body is skipped.
+   */
+  void read_cell_body (db::Layout &layout, db::Cell *cell);
+
+  /**
+   *  @brief Creates or looks up a cell by name
+   *
+   *  @param for_instance True, if the cell is created for an instance (forward reference)
+   */
+  db::cell_index_type make_cell (db::Layout &layout, const char *cn, bool for_instance);
+
+  /**
+   *  @brief Sets the current cell name (used for messages)
+   */
+  void set_cellname (const tl::string &cn) { m_cellname = cn; }
+
+  /**
+   *  @brief Takes the reader settings from another reader
+   *
+   *  This method prepares a helper reader which reads cell bodies into a
+   *  temporary layout. The helper reader creates one layer per GDS layer and datatype.
+   *  The layers are mapped when the cells are transferred into the target layout
+   *  with \transfer_cell.
+   */
+  void setup_from (const GDS2ReaderBase &other);
+
+  /**
+   *  @brief Transfers a cell read by a helper reader into the target layout
+   *
+   *  The cell is created or looked up in the target layout by name. Layer mapping is
+   *  applied to the shapes and the instances are mapped to the target cells by name.
+   */
+  void transfer_cell (db::Layout &layout, const db::Layout &source, db::cell_index_type source_cell_index, db::PropertyMapper &pm);
+
+  /**
+   *  @brief Offers the body of the current cell for deferred reading
+   *
+   *  This method is called after the STRNAME record of a cell has been read and
+   *  before the body is read. If the implementation takes the body (i.e. reads all records
+   *  up to and including ENDSTR), it must return true. In that case, the implementation is
+   *  responsible for producing the cell content (e.g. by reading the body in a helper
+   *  reader and transferring the results with \transfer_cell). The cell name is available
+   *  through \cellname.
+   *  Deferred cells must be completed in the order they are offered when
+   *  \finish_deferred_cells is called.
+   *
+   *  The default implementation does not defer cells.
+   */
+  virtual bool defer_cell (db::Layout & /*layout*/) { return false; }
+
+  /**
+   *  @brief Completes all deferred cells
+   */
+  virtual void finish_deferred_cells (db::Layout & /*layout*/) { }
+
 private:
   friend class GDS2ReaderLayerMapping;
 
@@ -110,6 +171,9 @@ private:
   std::map <tl::string, std::vector<std::string> > m_context_info;
   std::vector <db::Point> m_all_points;
   std::map <tl::string, tl::string> m_mapped_cellnames;
+  //  these containers have been found to grow quite a lot - they are kept between cells
+  tl::vector<db::CellInstArray> m_instances;
+  tl::vector<db::CellInstArrayWithProperties> m_instances_with_props;
 
   void read_context_info_cell ();
   void read_boundary (db::Layout &layout, db::Cell &cell, bool from_box_record);
@@ -117,7 +181,6 @@ private:
   void read_text (db::Layout &layout, db::Cell &cell);
   void read_box (db::Layout &layout, db::Cell &cell);
   void read_ref (db::Layout &layout, db::Cell &cell, bool array, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &insts_wp);
-  db::cell_index_type make_cell (db::Layout &layout, const char *cn, bool for_instance);
 
   void do_read (db::Layout &layout);
 
@@ -283,6 +283,16 @@ static bool get_gds2_allow_big_records (const db::LoadLayoutOptions *options)
   return options->get_options<db::GDS2ReaderOptions> ().allow_big_records;
 }
 
+static void set_gds2_threads (db::LoadLayoutOptions *options, unsigned int n)
+{
+  options->get_options<db::GDS2ReaderOptions> ().threads = n;
+}
+
+static unsigned int get_gds2_threads (const db::LoadLayoutOptions *options)
+{
+  return options->get_options<db::GDS2ReaderOptions> ().threads;
+}
+
 //  extend lay::LoadLayoutOptions with the GDS2 options 
 static
 gsi::ClassExt<db::LoadLayoutOptions> gds2_reader_options (
@@ -321,6 +331,19 @@ gsi::ClassExt<db::LoadLayoutOptions> gds2_reader_options (
     "@brief Gets a value specifying whether to allow big records with a length of 32768 to 65535 bytes.\n"
     "See \\gds2_allow_big_records= method for a description of this property."
     "\nThis property has been added in version 0.18.\n"
+  ) +
+  gsi::method_ext ("gds2_threads=", &set_gds2_threads,
+    "@brief Sets the number of threads to use for reading GDS2 files\n"
+    "\n"
+    "If this value is 0 (the default), GDS2 files are read in the calling thread. Otherwise, "
+    "the cell bodies are decoded in the given number of worker threads while the calling thread "
+    "splits the file into cells and collects the results. The resulting layout is the same in both cases.\n"
+    "\nThis property has been added in version 0.26.\n"
+  ) +
+  gsi::method_ext ("gds2_threads", &get_gds2_threads,
+    "@brief Gets the number of threads to use for reading GDS2 files\n"
+    "See \\gds2_threads= method for a description of this property."
+    "\nThis property has been added in version 0.26.\n"
   ),
   ""
 );
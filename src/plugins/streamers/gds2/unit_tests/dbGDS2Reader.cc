@@ -23,8 +23,10 @@
 #include "dbGDS2Reader.h"
 #include "dbLayoutDiff.h"
 #include "dbTestSupport.h"
+#include "dbWriter.h"
 #include "tlUnitTest.h"
 #include "tlStream.h"
+#include "tlTimer.h"
 
 #include <iostream>
 
@@ -391,3 +393,140 @@ TEST(Bug_121_2)
   db::compare_layouts (_this, layout, fn_au, db::WriteGDS2, 1);
 }
 
+//  Multi-threaded reading
+
+static void read_layout (db::Layout &layout, const std::string &fn, unsigned int threads)
+{
+  db::LoadLayoutOptions options;
+  options.get_options<db::GDS2ReaderOptions> ().threads = threads;
+
+  tl::InputStream file (fn);
+  db::Reader reader (file);
+  reader.read (layout, options);
+}
+
+TEST(3)
+{
+  tl::InputMemoryStream im ((const char *) data, sizeof (data));
+
+  db::Manager m;
+  db::Layout layout (&m);
+
+  db::LoadLayoutOptions options;
+  options.get_options<db::GDS2ReaderOptions> ().threads = 2;
+
+  tl::InputStream file (im);
+  db::Reader reader (file);
+  db::LayerMap map = reader.read (layout, options);
+
+  //  same layers and cells (in the same order) than in serial mode (see TEST(1))
+  EXPECT_EQ (layout.layers (), size_t (11));
+  EXPECT_EQ (map.mapping_str (0), "2/0 : 2/0");
+  EXPECT_EQ (map.mapping_str (1), "4/0 : 4/0");
+  EXPECT_EQ (map.mapping_str (5), "1/0 : 1/0");
+  EXPECT_EQ (map.mapping_str (10), "8/1 : 8/1");
+
+  EXPECT_EQ (layout.cells (), size_t (3));
+  EXPECT_EQ (std::string (layout.cell_name (0)), "TRANS");
+  EXPECT_EQ (std::string (layout.cell_name (1)), "INV2");
+  EXPECT_EQ (std::string (layout.cell_name (2)), "RINGO");
+
+  db::Layout layout_ref (&m);
+  im.reset ();
+  tl::InputStream file_ref (im);
+  db::Reader reader_ref (file_ref);
+  reader_ref.read (layout_ref);
+
+  EXPECT_EQ (db::compare_layouts (layout, layout_ref, db::layout_diff::f_verbose, 0), true);
+}
+
+TEST(4)
+{
+  const char *files[] = {
+    "arefs.gds",
+    "bug_121a.gds",
+    "lib_test.gds",
+    "pcell_test.gds",
+    "t10.gds",
+    "t200.gds"
+  };
+
+  for (size_t i = 0; i < sizeof (files) / sizeof (files [0]); ++i) {
+
+    std::string fn = tl::testsrc () + "/testdata/gds/" + files [i];
+
+    db::Layout layout_ref;
+    read_layout (layout_ref, fn, 0);
+
+    db::Layout layout;
+    read_layout (layout, fn, 3);
+
+    tl::info << "Comparing " << files [i];
+    EXPECT_EQ (db::compare_layouts (layout, layout_ref, db::layout_diff::f_verbose, 0), true);
+    EXPECT_EQ (layout.cells (), layout_ref.cells ());
+
+  }
+}
+
+//  Benchmark: serial vs. multi-threaded reading of a larger file
+TEST(5)
+{
+  db::Layout layout_org;
+  layout_org.dbu (0.001);
+
+  unsigned int l1 = layout_org.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = layout_org.insert_layer (db::LayerProperties (2, 5));
+
+  db::PropertiesRepository::properties_set ps;
+  ps.insert (std::make_pair (layout_org.properties_repository ().prop_name_id (tl::Variant (17)), tl::Variant ("value")));
+  db::properties_id_type pid = layout_org.properties_repository ().properties_id (ps);
+
+  db::Cell &top = layout_org.cell (layout_org.add_cell ("TOP"));
+
+  for (int c = 0; c < 200; ++c) {
+
+    db::Cell &cell = layout_org.cell (layout_org.add_cell (tl::sprintf ("C%d", c).c_str ()));
+
+    for (int i = 0; i < 1000; ++i) {
+      db::Coord x = (i % 40) * 1000, y = (i / 40) * 1000;
+      cell.shapes (l1).insert (db::Box (x, y, x + 500, y + 200 + c));
+      db::Point pts[] = { db::Point (x, y), db::Point (x, y + 700), db::Point (x + 100, y + 800), db::Point (x + 600, y + 300) };
+      db::Polygon poly;
+      poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+      if (i % 10 == 0) {
+        cell.shapes (l2).insert (db::PolygonWithProperties (poly, pid));
+      } else {
+        cell.shapes (l2).insert (poly);
+      }
+    }
+
+    top.insert (db::CellInstArray (db::CellInst (cell.cell_index ()), db::Trans (db::Vector (0, c * 100000))));
+
+  }
+
+  std::string tmp_file = tl::TestBase::tmp_file ("tmp_GDS2Reader_5.gds");
+
+  {
+    tl::OutputStream stream (tmp_file);
+    db::SaveLayoutOptions options;
+    options.set_format ("GDS2");
+    db::Writer writer (options);
+    writer.write (layout_org, stream);
+  }
+
+  db::Layout layout_ref;
+  {
+    tl::SelfTimer timer ("Reading GDS2 file serially");
+    read_layout (layout_ref, tmp_file, 0);
+  }
+
+  db::Layout layout;
+  {
+    tl::SelfTimer timer ("Reading GDS2 file with 4 threads");
+    read_layout (layout, tmp_file, 4);
+  }
+
+  EXPECT_EQ (layout.cells (), size_t (201));
+  EXPECT_EQ (db::compare_layouts (layout, layout_ref, db::layout_diff::f_verbose, 0), true);
+  EXPECT_EQ (db::compare_layouts (layout, layout_org, db::layout_diff::f_verbose, 0), true);
+}
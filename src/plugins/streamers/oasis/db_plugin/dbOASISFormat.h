@@ -43,7 +43,7 @@ public:
    *  @brief The constructor
    */
   OASISReaderOptions ()
-    : read_all_properties (false), expect_strict_mode (-1)
+    : read_all_properties (false), expect_strict_mode (-1), threads (0)
   {
     //  .. nothing yet ..
   }
@@ -70,6 +70,17 @@ public:
    */
   int expect_strict_mode;
 
+  /**
+   *  @brief The number of threads to use for reading the cells
+   *
+   *  If this value is 0, the file is read in the calling thread. Otherwise, the
+   *  cell bodies of strict-mode files with S_CELL_OFFSET properties are decoded
+   *  (including CBLOCK decompression) by the given number of worker threads. The
+   *  results are transferred into the layout in the order of the file. Other files
+   *  are read in the calling thread. The resulting layout is the same in both cases.
+   */
+  unsigned int threads;
+
   /**
    *  @brief Implementation of FormatSpecificReaderOptions
    */
@@ -101,7 +112,7 @@ public:
    *  @brief The constructor
    */
   OASISWriterOptions ()
-    : compression_level (2), write_cblocks (false), strict_mode (false), recompress (false), permissive (false), write_std_properties (1), subst_char ("*")
+    : compression_level (2), write_cblocks (false), strict_mode (false), recompress (false), permissive (false), write_std_properties (1), subst_char ("*"), threads (0)
   {
     //  .. nothing yet ..
   }
@@ -166,6 +177,17 @@ public:
    */
   std::string subst_char;
 
+  /**
+   *  @brief The number of threads to use for writing the cells
+   *
+   *  If this value is non-zero, the cell bodies are serialized by the given number
+   *  of worker threads. This includes the shape array formation and the CBLOCK
+   *  compression. The cells are emitted in the same order than by the
+   *  single-threaded writer and the file produced is identical.
+   *  A value of 0 disables multi-threaded writing.
+   */
+  unsigned int threads;
+
   /** 
    *  @brief Implementation of FormatSpecificWriterOptions
    */
@@ -28,10 +28,15 @@
 #include "dbObjectWithProperties.h"
 #include "dbArray.h"
 #include "dbStatic.h"
+#include "dbLayoutUtils.h"
 
 #include "tlException.h"
 #include "tlString.h"
 #include "tlClassRegistry.h"
+#include "tlThreadedWorkers.h"
+
+#include <memory>
+#include <algorithm>
 
 namespace db
 {
@@ -67,6 +72,227 @@ private:
   bool m_create;
 };
 
+// ---------------------------------------------------------------
+//  Multi-threaded reading support
+
+//  The number of bytes collected for one worker task
+static const size_t batch_size = 256 * 1024;
+
+//  The number of batches per worker which are allowed to be pending
+static const size_t max_pending_batches_per_worker = 4;
+
+//  The chunk size for skipping and copying stream data
+static const size_t copy_chunk_size = 65536;
+
+/**
+ *  @brief A batch of cell bodies which are read by a worker
+ *
+ *  The batch holds the raw bytes of the bodies of one or more cells, each
+ *  followed by an END record byte as a terminator. The worker reads them into
+ *  a private layout from which the reader transfers the cells into the target
+ *  layout.
+ */
+class OASISCellBatch
+{
+public:
+  struct Cell
+  {
+    unsigned long id;
+    //  the offset of the body inside the data block and the offset of the terminator
+    size_t offset, end;
+    //  the position of the body inside the file (for messages)
+    size_t file_pos;
+    //  the cell index inside the private layout and the layers in the order of their appearance
+    db::cell_index_type cell_index;
+    std::vector<std::pair<db::LDPair, unsigned int> > layers;
+    std::vector<bool> has_layer;
+
+    void add_layer (const db::LDPair &dl, unsigned int l)
+    {
+      if (l >= has_layer.size ()) {
+        has_layer.resize (l + 1, false);
+      }
+      if (! has_layer [l]) {
+        has_layer [l] = true;
+        layers.push_back (std::make_pair (dl, l));
+      }
+    }
+  };
+
+  /**
+   *  @brief Describes a cell lookup the worker has done
+   *
+   *  The reader replays these lookups on the target layout in the same order.
+   *  This way, cells are created in the same order than by the single-threaded
+   *  reader.
+   */
+  struct CellRef
+  {
+    db::cell_index_type cell_index;
+    bool is_definition;
+    bool by_name;
+    unsigned long id;
+    std::string name;
+  };
+
+  OASISCellBatch ()
+    : current_cell (0), done (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  std::vector<char> data;
+  std::vector<Cell> cells;
+
+  //  the results
+  std::auto_ptr<db::Layout> layout;
+  std::vector<CellRef> cell_refs;
+  std::map<db::cell_index_type, std::vector<std::string> > contexts;
+  Cell *current_cell;
+  std::string error;
+  bool done;
+};
+
+/**
+ *  @brief The job reading the cell batches
+ *
+ *  The job keeps a copy of the name tables which the workers use to resolve
+ *  text strings and property names and values.
+ */
+class OASISReaderJob
+  : public tl::JobBase
+{
+public:
+  OASISReaderJob (const OASISReader *master, int nworkers)
+    : tl::JobBase (nworkers), mp_master (master),
+      textstrings (master->m_textstrings), propstrings (master->m_propstrings), propnames (master->m_propnames)
+  {
+    //  .. nothing yet ..
+  }
+
+  const OASISReader *master () const
+  {
+    return mp_master;
+  }
+
+  void batch_done (OASISCellBatch *batch)
+  {
+    m_lock.lock ();
+    batch->done = true;
+    m_done_condition.wakeAll ();
+    m_lock.unlock ();
+  }
+
+  bool is_done (const OASISCellBatch *batch)
+  {
+    m_lock.lock ();
+    bool done = batch->done;
+    m_lock.unlock ();
+    return done;
+  }
+
+  void wait_for (const OASISCellBatch *batch)
+  {
+    m_lock.lock ();
+    while (! batch->done) {
+      m_done_condition.wait (&m_lock);
+    }
+    m_lock.unlock ();
+  }
+
+  const std::map <unsigned long, std::string> textstrings;
+  const std::map <unsigned long, std::string> propstrings;
+  const std::map <unsigned long, std::string> propnames;
+
+protected:
+  virtual tl::Worker *create_worker ();
+
+private:
+  const OASISReader *mp_master;
+  tl::Mutex m_lock;
+  tl::WaitCondition m_done_condition;
+};
+
+class OASISReaderTask
+  : public tl::Task
+{
+public:
+  OASISReaderTask (OASISCellBatch *batch)
+    : mp_batch (batch)
+  {
+    //  .. nothing yet ..
+  }
+
+  OASISCellBatch *batch () const
+  {
+    return mp_batch;
+  }
+
+private:
+  OASISCellBatch *mp_batch;
+};
+
+class OASISReaderWorker
+  : public tl::Worker
+{
+public:
+  OASISReaderWorker (OASISReaderJob *job)
+    : tl::Worker (), mp_job (job),
+      m_textstrings (job->textstrings), m_propstrings (job->propstrings), m_propnames (job->propnames)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    OASISCellBatch *batch = static_cast<OASISReaderTask *> (task)->batch ();
+
+    try {
+
+      tl::InputMemoryStream data_stream (batch->data.empty () ? 0 : &batch->data.front (), batch->data.size ());
+      tl::InputStream stream (data_stream);
+      OASISReader reader (stream);
+
+      //  lend the name tables to the reader
+      reader.m_textstrings.swap (m_textstrings);
+      reader.m_propstrings.swap (m_propstrings);
+      reader.m_propnames.swap (m_propnames);
+
+      try {
+        reader.read_batch (*batch, *mp_job->master ());
+      } catch (...) {
+        reader.m_textstrings.swap (m_textstrings);
+        reader.m_propstrings.swap (m_propstrings);
+        reader.m_propnames.swap (m_propnames);
+        throw;
+      }
+
+      reader.m_textstrings.swap (m_textstrings);
+      reader.m_propstrings.swap (m_propstrings);
+      reader.m_propnames.swap (m_propnames);
+
+    } catch (tl::Exception &ex) {
+      batch->error = ex.msg ();
+    } catch (std::exception &ex) {
+      batch->error = ex.what ();
+    }
+
+    mp_job->batch_done (batch);
+  }
+
+private:
+  OASISReaderJob *mp_job;
+  std::map <unsigned long, std::string> m_textstrings;
+  std::map <unsigned long, std::string> m_propstrings;
+  std::map <unsigned long, std::string> m_propnames;
+};
+
+tl::Worker *
+OASISReaderJob::create_worker ()
+{
+  return new OASISReaderWorker (this);
+}
+
 // ---------------------------------------------------------------
 //  OASISReader
 
@@ -106,7 +332,14 @@ OASISReader::OASISReader (tl::InputStream &s)
     m_read_properties (true),
     m_read_all_properties (false),
     m_s_gds_property_name_id (0),
-    m_klayout_context_property_name_id (0)
+    m_klayout_context_property_name_id (0),
+    m_threads (0),
+    m_deferred_cells (0),
+    m_names_end (0),
+    m_pos_offset (0),
+    mp_job (0),
+    mp_current_batch (0),
+    mp_batch (0)
 {
   m_progress.set_format (tl::to_string (tr ("%.0f MB")));
   m_progress.set_unit (1024 * 1024);
@@ -122,11 +355,12 @@ OASISReader::OASISReader (tl::InputStream &s)
   m_table_textstring = 0;
   m_table_layername = 0;
   m_table_start = 0;
+  m_tables_strict = false;
 }
 
 OASISReader::~OASISReader ()
 {
-  //  .. nothing yet ..
+  clear_batches ();
 }
 
 const LayerMap &
@@ -143,12 +377,18 @@ OASISReader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
   m_create_layers = common_options.create_other_layers;
   m_read_all_properties = oasis_options.read_all_properties;
   m_expect_strict_mode = oasis_options.expect_strict_mode;
+  m_threads = oasis_options.threads;
+  m_deferred_cells = 0;
+
+  clear_batches ();
 
   layout.start_changes ();
   try {
     do_read (layout);
+    clear_batches ();
     layout.end_changes ();
   } catch (...) {
+    clear_batches ();
     layout.end_changes ();
     throw;
   }
@@ -162,6 +402,473 @@ OASISReader::read (db::Layout &layout)
   return read (layout, db::LoadLayoutOptions ());
 }
 
+void
+OASISReader::clear_batches ()
+{
+  //  stop the workers before the batches are deleted
+  if (mp_job) {
+    mp_job->terminate ();
+    delete mp_job;
+    mp_job = 0;
+  }
+
+  for (std::list<OASISCellBatch *>::const_iterator b = m_batches.begin (); b != m_batches.end (); ++b) {
+    delete *b;
+  }
+  m_batches.clear ();
+
+  if (mp_current_batch) {
+    delete mp_current_batch;
+    mp_current_batch = 0;
+  }
+}
+
+void
+OASISReader::skip_to (size_t pos)
+{
+  if (m_stream.supports_seek ()) {
+    m_stream.seek (pos);
+    return;
+  }
+
+  //  there is no seek: rewind if required and read over the data
+  if (m_stream.is_inflating () || m_stream.pos () > pos) {
+    m_stream.reset ();
+  }
+
+  while (m_stream.pos () < pos) {
+    size_t n = std::min (copy_chunk_size, pos - m_stream.pos ());
+    if (! m_stream.get (n)) {
+      error (tl::to_string (tr ("Unexpected end of file")));
+    }
+  }
+}
+
+void
+OASISReader::scan_name_table (db::PropertiesRepository &rep, std::map<unsigned long, size_t> &cell_offsets)
+{
+  db::property_names_id_type cell_offset_name_id = rep.prop_name_id (tl::Variant ("S_CELL_OFFSET"));
+
+  unsigned long cellname_id = 0;
+  unsigned long propname_id = 0;
+
+  while (true) {
+
+    unsigned char r = get_byte ();
+
+    if (r == 0 /*PAD*/) {
+
+      //  simply skip.
+
+    } else if (r == 34 /*CBLOCK*/) {
+
+      unsigned int type = get_uint ();
+      if (type != 0) {
+        error (tl::sprintf (tl::to_string (tr ("Invalid CBLOCK compression type %d")), type));
+      }
+
+      get_uint ();  // uncomp-byte-count - not needed
+      get_uint ();  // comp-byte-count - not needed
+
+      //  put the stream into deflating mode
+      m_stream.inflate ();
+
+    } else if (r == 3 || r == 4 /*CELLNAME*/) {
+
+      get_str ();
+
+      unsigned long id = cellname_id;
+      if (r == 3) {
+        ++cellname_id;
+      } else {
+        get (id);
+      }
+
+      reset_modal_variables ();
+
+      std::pair<bool, db::properties_id_type> pp = read_element_properties (rep, false);
+      if (pp.first) {
+        const db::PropertiesRepository::properties_set &props = rep.properties (pp.second);
+        db::PropertiesRepository::properties_set::const_iterator p = props.find (cell_offset_name_id);
+        if (p != props.end ()) {
+          cell_offsets [id] = size_t (p->second.to_ulong ());
+        }
+      }
+
+    } else if (r == 7 || r == 8 /*PROPNAME*/) {
+
+      std::string name = get_str ();
+
+      unsigned long id = propname_id;
+      if (r == 7) {
+        ++propname_id;
+      } else {
+        get (id);
+      }
+
+      m_propnames.insert (std::make_pair (id, name));
+
+      reset_modal_variables ();
+
+      //  ignore properties attached to this name item
+      read_element_properties (rep, true);
+
+    } else {
+      break;
+    }
+
+  }
+}
+
+void
+OASISReader::prepare_parallel_read (bool table_offsets_at_end)
+{
+  //  With the table offsets in the END record, the END record has to be read first. This
+  //  requires seeking to the end of the stream - otherwise the whole stream would have to be
+  //  read twice (pipes, HTTP or compressed streams). Such streams are read serially.
+  if (! m_stream.supports_seek ()) {
+    if (table_offsets_at_end) {
+      return;
+    }
+    //  the name tables are scanned by reading forward and rewinding afterwards: this is
+    //  not possible with pipes or HTTP streams
+    if (! dynamic_cast<tl::InputZLibFile *> (m_stream.base ())) {
+      return;
+    }
+  }
+
+  size_t start_pos = m_stream.pos ();
+  size_t end_pos = 0;
+
+  bool tables_strict = m_tables_strict && ! table_offsets_at_end;
+  size_t table_cellname = m_table_cellname;
+  size_t table_textstring = m_table_textstring;
+  size_t table_propname = m_table_propname;
+  size_t table_propstring = m_table_propstring;
+  size_t table_layername = m_table_layername;
+
+  std::map<unsigned long, size_t> cell_offsets;
+
+  try {
+
+    //  the last 256 bytes are the END record
+    const size_t end_record_size = 256;
+    if (m_stream.supports_seek () && m_stream.size () >= start_pos + end_record_size) {
+
+      size_t pos = m_stream.size () - end_record_size;
+      m_stream.seek (pos);
+
+      const char *b = m_stream.get (end_record_size);
+      if (b && *b == 2 /*END*/) {
+
+        end_pos = pos;
+
+        if (table_offsets_at_end) {
+
+          std::string end_record (b + 1, end_record_size - 1);
+          tl::InputMemoryStream end_record_mem (end_record.c_str (), end_record.size ());
+          tl::InputStream end_record_stream (end_record_mem);
+          OASISReader end_record_reader (end_record_stream);
+          end_record_reader.read_offset_table ();
+
+          tables_strict = end_record_reader.m_tables_strict;
+          table_cellname = end_record_reader.m_table_cellname;
+          table_textstring = end_record_reader.m_table_textstring;
+          table_propname = end_record_reader.m_table_propname;
+          table_propstring = end_record_reader.m_table_propstring;
+          table_layername = end_record_reader.m_table_layername;
+
+        }
+
+      }
+
+    }
+
+    //  the cell positions are taken from the S_CELL_OFFSET properties of the CELLNAME records.
+    //  The property names need to be known for this.
+    if ((end_pos > 0 || ! table_offsets_at_end) && tables_strict && table_cellname != 0) {
+
+      OASISReader scanner (m_stream);
+      db::PropertiesRepository rep;
+      scanner.m_s_gds_property_name_id = rep.prop_name_id (tl::Variant ("S_GDS_PROPERTY"));
+
+      if (table_propname != 0) {
+        skip_to (table_propname);
+        scanner.scan_name_table (rep, cell_offsets);
+      }
+
+      skip_to (table_cellname);
+      scanner.scan_name_table (rep, cell_offsets);
+
+    }
+
+  } catch (tl::Exception &) {
+    //  fall back to single-threaded reading
+    cell_offsets.clear ();
+  }
+
+  skip_to (start_pos);
+
+  for (std::map<unsigned long, size_t>::const_iterator c = cell_offsets.begin (); c != cell_offsets.end (); ++c) {
+    if (c->second > start_pos && (end_pos == 0 || c->second < end_pos)) {
+      m_cell_offsets.insert (*c);
+      m_record_offsets.push_back (c->second);
+    }
+  }
+
+  if (m_cell_offsets.empty ()) {
+    m_record_offsets.clear ();
+    return;
+  }
+
+  //  the cell bodies end at the next cell, table or the END record
+  size_t tables [] = { table_cellname, table_textstring, table_propname, table_propstring, table_layername };
+  for (size_t i = 0; i < sizeof (tables) / sizeof (tables [0]); ++i) {
+    if (tables [i] != 0) {
+      m_record_offsets.push_back (tables [i]);
+    }
+  }
+  if (end_pos > 0) {
+    m_record_offsets.push_back (end_pos);
+  }
+
+  std::sort (m_record_offsets.begin (), m_record_offsets.end ());
+  m_record_offsets.erase (std::unique (m_record_offsets.begin (), m_record_offsets.end ()), m_record_offsets.end ());
+
+  //  without the position of the END record, the end of a cell following all tables
+  //  is not known: such a cell is read serially
+  if (end_pos == 0) {
+    for (std::map<unsigned long, size_t>::iterator c = m_cell_offsets.begin (); c != m_cell_offsets.end (); ++c) {
+      if (c->second == m_record_offsets.back ()) {
+        m_cell_offsets.erase (c);
+        break;
+      }
+    }
+  }
+
+  //  cells can only be read by the workers if the names they use are known already
+  m_names_end = std::max (table_textstring, std::max (table_propname, table_propstring));
+}
+
+bool
+OASISReader::defer_cell (db::Layout &layout, unsigned long id, size_t pos)
+{
+  if (m_cell_offsets.empty () || pos <= m_names_end) {
+    return false;
+  }
+
+  std::map<unsigned long, size_t>::const_iterator co = m_cell_offsets.find (id);
+  if (co == m_cell_offsets.end () || co->second != pos) {
+    return false;
+  }
+
+  std::vector<size_t>::const_iterator ro = std::upper_bound (m_record_offsets.begin (), m_record_offsets.end (), pos);
+  if (ro == m_record_offsets.end ()) {
+    return false;
+  }
+
+  size_t end = *ro;
+
+  if (! mp_current_batch) {
+    mp_current_batch = new OASISCellBatch ();
+  }
+
+  std::vector<char> &data = mp_current_batch->data;
+
+  OASISCellBatch::Cell cell;
+  cell.id = id;
+  cell.offset = data.size ();
+  cell.file_pos = m_stream.pos ();
+  cell.cell_index = 0;
+
+  //  collect the raw cell body (including the CBLOCKs) up to the next record
+  while (m_stream.pos () < end) {
+    size_t n = std::min (copy_chunk_size, end - m_stream.pos ());
+    const char *b = m_stream.get (n);
+    if (! b) {
+      error (tl::to_string (tr ("Unexpected end of file")));
+    }
+    data.insert (data.end (), b, b + n);
+  }
+
+  //  terminate the cell body with an END record
+  cell.end = data.size ();
+  data.push_back (char (2));
+
+  mp_current_batch->cells.push_back (cell);
+  ++m_deferred_cells;
+
+  m_progress.set (m_stream.pos ());
+
+  if (data.size () >= batch_size) {
+    submit_batch (layout);
+  }
+
+  return true;
+}
+
+void
+OASISReader::submit_batch (db::Layout &layout)
+{
+  if (! mp_current_batch) {
+    return;
+  }
+
+  if (! mp_job) {
+    mp_job = new OASISReaderJob (this, int (m_threads));
+  }
+
+  OASISCellBatch *batch = mp_current_batch;
+  mp_current_batch = 0;
+
+  m_batches.push_back (batch);
+  mp_job->schedule (new OASISReaderTask (batch));
+
+  //  the job finishes when the workers run out of tasks - restart it in that case
+  if (! mp_job->is_running ()) {
+    mp_job->start ();
+  }
+
+  //  transfer the batches which are ready and limit the number of pending ones
+  while (! m_batches.empty () && (mp_job->is_done (m_batches.front ()) || m_batches.size () > size_t (m_threads) * max_pending_batches_per_worker)) {
+    transfer_batch (layout);
+  }
+}
+
+void
+OASISReader::transfer_batch (db::Layout &layout)
+{
+  std::auto_ptr<OASISCellBatch> batch (m_batches.front ());
+  m_batches.pop_front ();
+
+  mp_job->wait_for (batch.get ());
+
+  if (! batch->error.empty ()) {
+    throw ReaderException (batch->error);
+  }
+
+  const db::Layout &source = *batch->layout;
+
+  //  replay the cell lookups of the worker: this way the cells are created in the
+  //  same order than by the single-threaded reader
+  std::map<db::cell_index_type, db::cell_index_type> cell_map;
+  for (std::vector<OASISCellBatch::CellRef>::const_iterator r = batch->cell_refs.begin (); r != batch->cell_refs.end (); ++r) {
+    db::cell_index_type ci;
+    if (r->is_definition) {
+      ci = cell_for_definition (layout, r->id);
+    } else if (r->by_name) {
+      ci = cell_for_placement (layout, r->name);
+    } else {
+      ci = cell_for_placement (layout, r->id);
+    }
+    cell_map.insert (std::make_pair (r->cell_index, ci));
+  }
+
+  db::PropertyMapper pm (layout, source);
+  tl::map_map<db::cell_index_type> im (cell_map);
+
+  for (std::vector<OASISCellBatch::Cell>::const_iterator c = batch->cells.begin (); c != batch->cells.end (); ++c) {
+
+    const db::Cell &source_cell = source.cell (c->cell_index);
+
+    std::map<db::cell_index_type, db::cell_index_type>::const_iterator cm = cell_map.find (c->cell_index);
+    tl_assert (cm != cell_map.end ());
+    db::Cell &cell = layout.cell (cm->second);
+
+    //  the layers are opened in the order the worker has encountered them
+    for (std::vector<std::pair<db::LDPair, unsigned int> >::const_iterator l = c->layers.begin (); l != c->layers.end (); ++l) {
+      std::pair<bool, unsigned int> ll = open_dl (layout, l->first, m_create_layers);
+      if (ll.first && ! source_cell.shapes (l->second).empty ()) {
+        cell.shapes (ll.second).insert (source_cell.shapes (l->second), pm);
+      }
+    }
+
+    for (db::Cell::const_iterator i = source_cell.begin (); ! i.at_end (); ++i) {
+      cell.insert (*i, im, pm);
+    }
+
+    if (source_cell.prop_id () != 0) {
+      cell.prop_id (pm (source_cell.prop_id ()));
+    }
+
+    //  Restore proxy cell (link to PCell or Library)
+    std::map<db::cell_index_type, std::vector<std::string> >::const_iterator ctx = batch->contexts.find (c->cell_index);
+    if (ctx != batch->contexts.end ()) {
+      OASISReaderLayerMapping layer_mapping (this, &layout, m_create_layers);
+      layout.recover_proxy_as (cell.cell_index (), ctx->second.begin (), ctx->second.end (), &layer_mapping);
+    }
+
+  }
+}
+
+void
+OASISReader::finish_deferred_cells (db::Layout &layout)
+{
+  submit_batch (layout);
+
+  while (! m_batches.empty ()) {
+    transfer_batch (layout);
+  }
+}
+
+void
+OASISReader::read_batch (OASISCellBatch &batch, const OASISReader &master)
+{
+  m_read_texts = master.m_read_texts;
+  m_read_properties = master.m_read_properties;
+  m_read_all_properties = master.m_read_all_properties;
+  m_expect_strict_mode = master.m_expect_strict_mode;
+  m_dbu = master.m_dbu;
+  set_warnings_as_errors (master.warnings_as_errors ());
+
+  //  the worker's layout receives one layer per layer/datatype pair - the layers are mapped on transfer
+  m_create_layers = true;
+  m_threads = 0;
+  mp_batch = &batch;
+
+  batch.layout.reset (new db::Layout (false));
+  db::Layout &layout = *batch.layout;
+  layout.dbu (m_dbu * 1e6);
+
+  m_s_gds_property_name_id = layout.properties_repository ().prop_name_id ("S_GDS_PROPERTY");
+  m_klayout_context_property_name_id = layout.properties_repository ().prop_name_id ("KLAYOUT_CONTEXT");
+
+  for (std::vector<OASISCellBatch::Cell>::iterator c = batch.cells.begin (); c != batch.cells.end (); ++c) {
+
+    tl_assert (m_stream.pos () == c->offset);
+
+    m_pos_offset = c->file_pos - c->offset;
+    batch.current_cell = c.operator-> ();
+
+    c->cell_index = cell_for_definition (layout, c->id);
+
+    reset_modal_variables ();
+    mark_start_table ();
+
+    do_read_cell (c->cell_index, layout);
+
+    if (m_stream.pos () != c->end || get_byte () != 2) {
+      error (tl::to_string (tr ("Cell body does not end at the next record given by the offset table")));
+    }
+
+  }
+
+  batch.current_cell = 0;
+
+  //  the workers only read cells following the name tables, hence there cannot be forward references
+  if (! m_text_forward_references.empty ()) {
+    error (tl::sprintf (tl::to_string (tr ("No text string defined for text string id %ld")), m_text_forward_references.begin ()->first));
+  }
+  if (! m_propname_forward_references.empty ()) {
+    error (tl::sprintf (tl::to_string (tr ("No property name defined for property name id %ld")), m_propname_forward_references.begin ()->first));
+  }
+  if (! m_propvalue_forward_references.empty ()) {
+    error (tl::sprintf (tl::to_string (tr ("No property value defined for property value id %ld")), m_propvalue_forward_references.begin ()->first));
+  }
+
+  mp_batch = 0;
+}
+
 inline long long 
 OASISReader::get_long_long ()
 {
@@ -534,7 +1241,7 @@ OASISReader::get_gdelta (long grid)
 void 
 OASISReader::error (const std::string &msg)
 {
-  throw OASISReaderException (msg, m_stream.pos (), m_cellname.c_str ());
+  throw OASISReaderException (msg, m_stream.pos () + m_pos_offset, m_cellname.c_str ());
 }
 
 void 
@@ -545,7 +1252,7 @@ OASISReader::warn (const std::string &msg)
   } else {
     // TODO: compress
     tl::warn << msg 
-             << tl::to_string (tr (" (position=")) << m_stream.pos ()
+             << tl::to_string (tr (" (position=")) << m_stream.pos () + m_pos_offset
              << tl::to_string (tr (", cell=")) << m_cellname
              << ")";
   }
@@ -557,6 +1264,11 @@ OASISReader::open_dl (db::Layout &layout, const LDPair &dl, bool create)
   std::pair<bool, unsigned int> ll = m_layer_map.logical (dl);
   if (ll.first) {
 
+    //  inside a worker: remember the layers a cell uses in the order of their appearance
+    if (mp_batch && mp_batch->current_cell) {
+      mp_batch->current_cell->add_layer (dl, ll.second);
+    }
+
     return ll;
 
   } else if (! create) {
@@ -584,6 +1296,10 @@ OASISReader::open_dl (db::Layout &layout, const LDPair &dl, bool create)
 
     m_layers_created.insert (ll);
 
+    if (mp_batch && mp_batch->current_cell) {
+      mp_batch->current_cell->add_layer (dl, ll);
+    }
+
     return std::make_pair (true, ll);
 
   }
@@ -649,35 +1365,53 @@ OASISReader::read_offset_table ()
 {
   unsigned long of = 0;
 
+  //  the tables are strict if all present tables are flagged strict
+  m_tables_strict = true;
+
   of = get_uint ();
   m_table_cellname = get_ulong ();
   if (m_table_cellname != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (tr ("CELLNAME offset table has unexpected strict mode")));
   }
+  if (m_table_cellname != 0 && of == 0) {
+    m_tables_strict = false;
+  }
 
   of = get_uint ();
   m_table_textstring = get_ulong ();
   if (m_table_textstring != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (tr ("TEXTSTRING offset table has unexpected strict mode")));
   }
+  if (m_table_textstring != 0 && of == 0) {
+    m_tables_strict = false;
+  }
 
   of = get_uint ();
   m_table_propname = get_ulong ();
   if (m_table_propname != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (tr ("PROPNAME offset table has unexpected strict mode")));
   }
+  if (m_table_propname != 0 && of == 0) {
+    m_tables_strict = false;
+  }
 
   of = get_uint ();
   m_table_propstring = get_ulong ();
   if (m_table_propstring != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (tr ("PROPSTRING offset table has unexpected strict mode")));
   }
+  if (m_table_propstring != 0 && of == 0) {
+    m_tables_strict = false;
+  }
 
   of = get_uint ();
   m_table_layername = get_ulong ();
   if (m_table_layername != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (tr ("LAYERNAME offset table has unexpected strict mode")));
   }
+  if (m_table_layername != 0 && of == 0) {
+    m_tables_strict = false;
+  }
 
   //  XNAME table ignored currently
   get_uint ();
@@ -734,6 +1468,14 @@ OASISReader::do_read (db::Layout &layout)
     read_offset_table ();
   }
 
+  //  locate the cells for multi-threaded reading
+  m_cell_offsets.clear ();
+  m_record_offsets.clear ();
+  m_names_end = 0;
+  if (m_threads > 0) {
+    prepare_parallel_read (table_offsets_at_end);
+  }
+
   //  reset the strict mode checking locations
   m_first_cellname = 0;
   m_first_propname = 0;
@@ -784,6 +1526,11 @@ OASISReader::do_read (db::Layout &layout)
 
     r = get_byte ();
 
+    //  cells read by the workers need to be transferred before any other record is processed
+    if (r != 0 /*PAD*/ && r != 13 /*CELL*/ && r != 34 /*CBLOCK*/) {
+      finish_deferred_cells (layout);
+    }
+
     if (r == 0 /*PAD*/) {
 
       //  simply skip.
@@ -933,9 +1680,10 @@ OASISReader::do_read (db::Layout &layout)
           //  exchange the properties in the repository: first locate all
           //  property sets that are affected
           std::vector <db::properties_id_type> pids;
-          for (db::PropertiesRepository::iterator p = rep.begin (); p != rep.end (); ++p) {
-            if (p->second.find (s_gds_name_id) != p->second.end ()) {
-              pids.push_back (p->first);
+          for (db::properties_id_type p = rep.begin_id (); p != rep.end_id (); ++p) {
+            const db::PropertiesRepository::properties_set &ps = rep.properties (p);
+            if (ps.find (s_gds_name_id) != ps.end ()) {
+              pids.push_back (p);
             }
           }
 
@@ -1146,46 +1894,27 @@ OASISReader::do_read (db::Layout &layout)
       }
 
       db::cell_index_type cell_index = 0;
+      bool deferred = false;
 
       //  read a cell
       if (r == 13) {
 
+        //  the position of the CELL record (only meaningful outside of CBLOCKs)
+        size_t cell_pos = m_stream.is_inflating () ? 0 : m_stream.pos () - 1;
+
         unsigned long id = 0;
         get (id);
-        if (! m_defined_cells_by_id.insert (id).second) {
-          error (tl::sprintf (tl::to_string (tr ("A cell with id %ld is defined already")), id));
-        }
-
-        std::map <unsigned long, db::cell_index_type>::const_iterator c = m_cells_by_id.find (id);
-        if (c != m_cells_by_id.end ()) {
-
-          cell_index = c->second;
-          layout.cell (cell_index).set_ghost_cell (false);
-
-        } else {
-
-          std::map <unsigned long, std::string>::const_iterator name = m_cellnames.find (id);
-          if (name == m_cellnames.end ()) {
-
-            cell_index = layout.add_cell ();
-            //  force a cell rename to empty to avoid name clashes of the generated
-            //  $x names with the same inside the OASIS file.
-            layout.rename_cell (cell_index, "");
-            m_forward_references.insert (std::make_pair (id, cell_index));
-
-          } else {
-
-            cell_index = make_cell (layout, name->second.c_str (), false);
-            m_cells_by_name.insert (std::make_pair (name->second, cell_index));
-
-          }
-
-          m_cells_by_id.insert (std::make_pair (id, cell_index));
 
+        deferred = defer_cell (layout, id, cell_pos);
+        if (! deferred) {
+          finish_deferred_cells (layout);
+          cell_index = cell_for_definition (layout, id);
         }
 
       } else {
 
+        finish_deferred_cells (layout);
+
         if (m_expect_strict_mode == 1) {
           warn (tl::to_string (tr ("CELL names must be references to CELLNAME ids in strict mode")));
         }
@@ -1213,7 +1942,9 @@ OASISReader::do_read (db::Layout &layout)
       reset_modal_variables ();
       mark_start_table ();
 
-      do_read_cell (cell_index, layout);
+      if (! deferred) {
+        do_read_cell (cell_index, layout);
+      }
 
     } else if (r == 34 /*CBLOCK*/) {
 
@@ -1274,12 +2005,20 @@ OASISReader::do_read (db::Layout &layout)
   //  resolve all propvalue forward referenced
   if (! m_propvalue_forward_references.empty ()) {
 
-    for (db::PropertiesRepository::non_const_iterator pi = layout.properties_repository ().begin_non_const (); pi != layout.properties_repository ().end_non_const (); ++pi) {
+    db::PropertiesRepository &rep = layout.properties_repository ();
+
+    for (db::properties_id_type pi = rep.begin_id (); pi != rep.end_id (); ++pi) {
+
+      //  work on a copy and replace the set, so the repository's index is updated
+      db::PropertiesRepository::properties_set new_set = rep.properties (pi);
+      bool any_replaced = false;
 
-      for (db::PropertiesRepository::properties_set::iterator ps = pi->second.begin (); ps != pi->second.end (); ++ps) {
+      for (db::PropertiesRepository::properties_set::iterator ps = new_set.begin (); ps != new_set.end (); ++ps) {
 
         if (ps->second.is_id ()) {
 
+          any_replaced = true;
+
           unsigned long id = (unsigned long) ps->second.to_id ();
           std::map <unsigned long, std::string>::const_iterator fw = m_propvalue_forward_references.find (id);
           if (fw != m_propvalue_forward_references.end ()) {
@@ -1301,6 +2040,8 @@ OASISReader::do_read (db::Layout &layout)
 
           if (needs_replacement) {
 
+            any_replaced = true;
+
             std::vector<tl::Variant> new_list (l);
             for (std::vector<tl::Variant>::iterator ll = new_list.begin (); ll != new_list.end (); ++ll) {
               if (ll->is_id ()) {
@@ -1322,6 +2063,10 @@ OASISReader::do_read (db::Layout &layout)
 
       }
 
+      if (any_replaced) {
+        rep.change_properties (pi, new_set);
+      }
+
     }
 
     m_propvalue_forward_references.clear ();
@@ -1894,6 +2639,120 @@ OASISReader::make_cell (db::Layout &layout, const char *cn, bool for_instance)
   return ci;
 }
 
+db::cell_index_type
+OASISReader::cell_for_definition (db::Layout &layout, unsigned long id)
+{
+  if (! m_defined_cells_by_id.insert (id).second) {
+    error (tl::sprintf (tl::to_string (tr ("A cell with id %ld is defined already")), id));
+  }
+
+  db::cell_index_type cell_index = 0;
+
+  std::map <unsigned long, db::cell_index_type>::const_iterator c = m_cells_by_id.find (id);
+  if (c != m_cells_by_id.end ()) {
+
+    cell_index = c->second;
+    layout.cell (cell_index).set_ghost_cell (false);
+
+  } else {
+
+    std::map <unsigned long, std::string>::const_iterator name = m_cellnames.find (id);
+    if (name == m_cellnames.end ()) {
+
+      cell_index = layout.add_cell ();
+      //  force a cell rename to empty to avoid name clashes of the generated
+      //  $x names with the same inside the OASIS file.
+      layout.rename_cell (cell_index, "");
+      m_forward_references.insert (std::make_pair (id, cell_index));
+
+    } else {
+
+      cell_index = make_cell (layout, name->second.c_str (), false);
+      m_cells_by_name.insert (std::make_pair (name->second, cell_index));
+
+    }
+
+    m_cells_by_id.insert (std::make_pair (id, cell_index));
+
+  }
+
+  if (mp_batch) {
+    OASISCellBatch::CellRef ref;
+    ref.cell_index = cell_index;
+    ref.is_definition = true;
+    ref.by_name = false;
+    ref.id = id;
+    mp_batch->cell_refs.push_back (ref);
+  }
+
+  return cell_index;
+}
+
+db::cell_index_type
+OASISReader::cell_for_placement (db::Layout &layout, unsigned long id)
+{
+  std::map <unsigned long, db::cell_index_type>::const_iterator cid = m_cells_by_id.find (id);
+  if (cid != m_cells_by_id.end ()) {
+    return cid->second;
+  }
+
+  db::cell_index_type cell_index = 0;
+
+  //  create the cell
+  std::map <unsigned long, std::string>::const_iterator name = m_cellnames.find (id);
+  if (name == m_cellnames.end ()) {
+
+    cell_index = layout.add_cell ();
+    m_forward_references.insert (std::make_pair (id, cell_index));
+
+    //  temporarily mark as "ghost cell"
+    layout.cell (cell_index).set_ghost_cell (true);
+
+  } else {
+
+    cell_index = make_cell (layout, name->second.c_str (), true);
+    m_cells_by_name.insert (std::make_pair (name->second, cell_index));
+
+  }
+
+  m_cells_by_id.insert (std::make_pair (id, cell_index));
+
+  if (mp_batch) {
+    OASISCellBatch::CellRef ref;
+    ref.cell_index = cell_index;
+    ref.is_definition = false;
+    ref.by_name = false;
+    ref.id = id;
+    mp_batch->cell_refs.push_back (ref);
+  }
+
+  return cell_index;
+}
+
+db::cell_index_type
+OASISReader::cell_for_placement (db::Layout &layout, const std::string &name)
+{
+  std::map <std::string, db::cell_index_type>::const_iterator cid = m_cells_by_name.find (name);
+  if (cid != m_cells_by_name.end ()) {
+    return cid->second;
+  }
+
+  db::cell_index_type cell_index = make_cell (layout, name.c_str (), true);
+  m_cells_by_name.insert (std::make_pair (name, cell_index));
+
+  if (mp_batch) {
+    OASISCellBatch::CellRef ref;
+    ref.cell_index = cell_index;
+    ref.is_definition = false;
+    ref.by_name = true;
+    ref.id = 0;
+    ref.name = name;
+    mp_batch->cell_refs.push_back (ref);
+  }
+
+  return cell_index;
+}
+
 void 
 OASISReader::do_read_placement (unsigned char r,
                                 bool xy_absolute,
@@ -1911,47 +2770,14 @@ OASISReader::do_read_placement (unsigned char r,
       //  cell by id
       unsigned long id;
       get (id);
-      std::map <unsigned long, db::cell_index_type>::const_iterator cid = m_cells_by_id.find (id);
-      if (cid == m_cells_by_id.end ()) {
-
-        //  create the cell
-        std::map <unsigned long, std::string>::const_iterator name = m_cellnames.find (id);
-        if (name == m_cellnames.end ()) {
-
-          mm_placement_cell = layout.add_cell ();
-          m_forward_references.insert (std::make_pair (id, mm_placement_cell.get ()));
-
-          //  temporarily mark as "ghost cell"
-          layout.cell (mm_placement_cell.get ()).set_ghost_cell (true);
-
-        } else {
-
-          mm_placement_cell = make_cell (layout, name->second.c_str (), true);
-          m_cells_by_name.insert (std::make_pair (name->second, mm_placement_cell.get ()));
-         
-        }
-
-        m_cells_by_id.insert (std::make_pair (id, mm_placement_cell.get ()));
-
-      } else {
-        mm_placement_cell = cid->second;
-      }
+      mm_placement_cell = cell_for_placement (layout, id);
 
     } else {
 
       //  cell by name
       std::string name;
       get_str (name);
-
-      std::map <std::string, db::cell_index_type>::const_iterator cid = m_cells_by_name.find (name);
-      if (cid == m_cells_by_name.end ()) {
-
-        mm_placement_cell = make_cell (layout, name.c_str (), true);
-        m_cells_by_name.insert (std::make_pair (name, mm_placement_cell.get ()));
-
-      } else {
-        mm_placement_cell = cid->second;
-      }
+      mm_placement_cell = cell_for_placement (layout, name);
 
     }
 
@@ -3575,8 +4401,13 @@ OASISReader::do_read_cell (db::cell_index_type cell_index, db::Layout &layout)
 
   //  Restore proxy cell (link to PCell or Library)
   if (has_context) {
-    OASISReaderLayerMapping layer_mapping (this, &layout, m_create_layers);
-    layout.recover_proxy_as (cell_index, context_strings.begin (), context_strings.end (), &layer_mapping);
+    if (mp_batch) {
+      //  inside a worker: the proxy is restored when the cell is transferred
+      mp_batch->contexts [cell_index].swap (context_strings);
+    } else {
+      OASISReaderLayerMapping layer_mapping (this, &layout, m_create_layers);
+      layout.recover_proxy_as (cell_index, context_strings.begin (), context_strings.end (), &layer_mapping);
+    }
   }
 
   m_cellname = "";
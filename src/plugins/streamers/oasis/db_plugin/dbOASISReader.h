@@ -42,10 +42,14 @@
 
 #include <map>
 #include <set>
+#include <list>
 
 namespace db
 {
 
+class OASISCellBatch;
+class OASISReaderJob;
+
 /**
  *  @brief Generic base class of OASIS reader exceptions
  */
@@ -132,8 +136,20 @@ public:
    */
   virtual void warn (const std::string &txt);
 
+  /**
+   *  @brief Gets the number of cells read by the worker threads in the last read
+   *
+   *  This number is zero if the file was read serially.
+   */
+  size_t deferred_cells () const
+  {
+    return m_deferred_cells;
+  }
+
 private:
   friend class OASISReaderLayerMapping;
+  friend class OASISReaderWorker;
+  friend class OASISReaderJob;
 
   typedef db::coord_traits<db::Coord>::distance_type distance_type;
 
@@ -166,6 +182,7 @@ private:
   size_t m_table_textstring;
   size_t m_table_layername;
   size_t m_table_start;
+  bool m_tables_strict;
 
   modal_variable<Repetition> mm_repetition;
   modal_variable<db::cell_index_type> mm_placement_cell;
@@ -222,6 +239,17 @@ private:
   db::property_names_id_type m_s_gds_property_name_id;
   db::property_names_id_type m_klayout_context_property_name_id;
 
+  unsigned int m_threads;
+  size_t m_deferred_cells;
+  std::map <unsigned long, size_t> m_cell_offsets;
+  std::vector <size_t> m_record_offsets;
+  size_t m_names_end;
+  size_t m_pos_offset;
+  OASISReaderJob *mp_job;
+  std::list<OASISCellBatch *> m_batches;
+  OASISCellBatch *mp_current_batch;
+  OASISCellBatch *mp_batch;
+
   void do_read (db::Layout &layout);
   void do_read_cell (db::cell_index_type cell_index, db::Layout &layout);
 
@@ -239,6 +267,19 @@ private:
   void do_read_ctrapezoid (bool xy_absolute,db::cell_index_type cell_index, db::Layout &layout);
   void do_read_circle (bool xy_absolute,db::cell_index_type cell_index, db::Layout &layout);
   db::cell_index_type make_cell (db::Layout &layout, const char *cn, bool for_instance);
+  db::cell_index_type cell_for_definition (db::Layout &layout, unsigned long id);
+  db::cell_index_type cell_for_placement (db::Layout &layout, unsigned long id);
+  db::cell_index_type cell_for_placement (db::Layout &layout, const std::string &name);
+
+  void prepare_parallel_read (bool table_offsets_at_end);
+  void scan_name_table (db::PropertiesRepository &rep, std::map<unsigned long, size_t> &cell_offsets);
+  void skip_to (size_t pos);
+  bool defer_cell (db::Layout &layout, unsigned long id, size_t pos);
+  void submit_batch (db::Layout &layout);
+  void transfer_batch (db::Layout &layout);
+  void finish_deferred_cells (db::Layout &layout);
+  void clear_batches ();
+  void read_batch (OASISCellBatch &batch, const OASISReader &master);
 
   void reset_modal_variables ();
 
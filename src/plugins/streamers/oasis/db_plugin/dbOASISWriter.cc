@@ -26,8 +26,11 @@
 
 #include "tlDeflate.h"
 #include "tlMath.h"
+#include "tlThreadedWorkers.h"
 
 #include <math.h>
+#include <memory>
+#include <deque>
 
 namespace db
 {
@@ -1150,6 +1153,422 @@ OASISWriter::reset_modal_variables ()
   mm_last_value_list.reset ();
 }
 
+/**
+ *  @brief Returns true, if the given cell needs to be written
+ *
+ *  Ghost cells are not written unless they are not empty (any more).
+ *  Proxy cells which are not employed are not written either.
+ */
+static bool
+must_write_cell (const db::Cell &cref)
+{
+  return (! cref.is_ghost_cell () || ! cref.empty ()) && (! cref.is_proxy () || ! cref.is_top ());
+}
+
+void
+OASISWriter::write_cell_body (const db::Cell &cref, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, const std::vector <std::string> *context_prop_strings)
+{
+  mp_cell = &cref;
+
+  reset_modal_variables ();
+
+  if (m_options.write_cblocks) {
+    begin_cblock ();
+  }
+
+  //  context information as property named KLAYOUT_CONTEXT
+  if (context_prop_strings) {
+
+    write_record_id (28);
+    write_byte (char (0xf6)); 
+    std::map <std::string, unsigned long>::const_iterator pni = m_propnames.find (klayout_context_name);
+    tl_assert (pni != m_propnames.end ());
+    write (pni->second);
+
+    write ((unsigned long) context_prop_strings->size ());
+
+    for (std::vector <std::string>::const_iterator c = context_prop_strings->begin (); c != context_prop_strings->end (); ++c) {
+      write_byte (14); // b-string by reference number
+      std::map <std::string, unsigned long>::const_iterator psi = m_propstrings.find (*c);
+      tl_assert (psi != m_propstrings.end ());
+      write (psi->second);
+    }
+
+    mm_last_property_name = klayout_context_name;
+    mm_last_property_is_sprop = false;
+    mm_last_value_list.reset ();
+
+  }
+
+  if (cref.prop_id () != 0) {
+    write_props (cref.prop_id ());
+  }
+
+  //  instances
+  if (cref.cell_instances () > 0) {
+    write_insts (cell_set);
+  }
+
+  //  shapes
+  for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+    const db::Shapes &shapes = cref.shapes (l->first);
+    if (! shapes.empty ()) {
+      write_shapes (l->second, shapes);
+      m_progress.set (mp_stream->pos ());
+    }
+  }
+
+  //  end CBLOCK if required
+  if (m_options.write_cblocks) {
+    end_cblock ();
+  } 
+}
+
+// ---------------------------------------------------------------------------------
+//  Multi-threaded writing support
+
+//  The number of objects (shapes and instances) collected for one worker task
+static const size_t batch_weight = 50000;
+
+//  The number of batches per worker which are allowed to be pending
+static const size_t max_pending_batches_per_worker = 4;
+
+/**
+ *  @brief A batch of cells whose bodies are written by a worker
+ *
+ *  The worker produces the serialized (and optionally CBLOCK-compressed) bodies of
+ *  the cells - everything following the CELL record's reference number. The writer
+ *  emits the CELL records together with these bodies in the original order.
+ */
+class OASISCellWriterBatch
+{
+public:
+  struct Cell
+  {
+    db::cell_index_type cell_index;
+    bool has_context;
+    std::vector <std::string> context_prop_strings;
+    //  the end of the body inside the data block
+    size_t end;
+  };
+
+  OASISCellWriterBatch ()
+    : weight (0), done (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  std::vector<Cell> cells;
+  size_t weight;
+
+  //  the results
+  std::vector<char> data;
+  std::string error;
+  bool done;
+};
+
+/**
+ *  @brief The job writing the cell batches
+ *
+ *  The job keeps a copy of the name tables which the workers use to resolve
+ *  text strings and property names and values.
+ */
+class OASISWriterJob
+  : public tl::JobBase
+{
+public:
+  OASISWriterJob (const OASISWriter *master, int nworkers, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers)
+    : tl::JobBase (nworkers), mp_master (master), mp_cell_set (&cell_set), mp_layers (&layers),
+      textstrings (master->m_textstrings), propnames (master->m_propnames), propstrings (master->m_propstrings)
+  {
+    //  .. nothing yet ..
+  }
+
+  const OASISWriter *master () const
+  {
+    return mp_master;
+  }
+
+  const std::set <db::cell_index_type> &cell_set () const
+  {
+    return *mp_cell_set;
+  }
+
+  const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers () const
+  {
+    return *mp_layers;
+  }
+
+  void batch_done (OASISCellWriterBatch *batch)
+  {
+    m_lock.lock ();
+    batch->done = true;
+    m_done_condition.wakeAll ();
+    m_lock.unlock ();
+  }
+
+  bool is_done (const OASISCellWriterBatch *batch)
+  {
+    m_lock.lock ();
+    bool done = batch->done;
+    m_lock.unlock ();
+    return done;
+  }
+
+  void wait_for (const OASISCellWriterBatch *batch)
+  {
+    m_lock.lock ();
+    while (! batch->done) {
+      m_done_condition.wait (&m_lock);
+    }
+    m_lock.unlock ();
+  }
+
+  const std::map <std::string, unsigned long> textstrings;
+  const std::map <std::string, unsigned long> propnames;
+  const std::map <std::string, unsigned long> propstrings;
+
+protected:
+  virtual tl::Worker *create_worker ();
+
+private:
+  const OASISWriter *mp_master;
+  const std::set <db::cell_index_type> *mp_cell_set;
+  const std::vector <std::pair <unsigned int, db::LayerProperties> > *mp_layers;
+  tl::Mutex m_lock;
+  tl::WaitCondition m_done_condition;
+};
+
+class OASISWriterTask
+  : public tl::Task
+{
+public:
+  OASISWriterTask (OASISCellWriterBatch *batch)
+    : mp_batch (batch)
+  {
+    //  .. nothing yet ..
+  }
+
+  OASISCellWriterBatch *batch () const
+  {
+    return mp_batch;
+  }
+
+private:
+  OASISCellWriterBatch *mp_batch;
+};
+
+class OASISWriterWorker
+  : public tl::Worker
+{
+public:
+  OASISWriterWorker (OASISWriterJob *job)
+    : tl::Worker (), mp_job (job),
+      m_textstrings (job->textstrings), m_propnames (job->propnames), m_propstrings (job->propstrings)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    OASISCellWriterBatch *batch = static_cast<OASISWriterTask *> (task)->batch ();
+
+    try {
+
+      tl::OutputMemoryStream data_stream;
+
+      {
+        tl::OutputStream stream (data_stream);
+        OASISWriter writer;
+        writer.mp_stream = &stream;
+
+        //  lend the name tables to the writer
+        writer.m_textstrings.swap (m_textstrings);
+        writer.m_propnames.swap (m_propnames);
+        writer.m_propstrings.swap (m_propstrings);
+
+        try {
+          writer.write_batch (*batch, *mp_job->master (), mp_job->cell_set (), mp_job->layers ());
+        } catch (...) {
+          writer.m_textstrings.swap (m_textstrings);
+          writer.m_propnames.swap (m_propnames);
+          writer.m_propstrings.swap (m_propstrings);
+          throw;
+        }
+
+        writer.m_textstrings.swap (m_textstrings);
+        writer.m_propnames.swap (m_propnames);
+        writer.m_propstrings.swap (m_propstrings);
+
+        stream.flush ();
+      }
+
+      batch->data.assign (data_stream.data (), data_stream.data () + data_stream.size ());
+
+    } catch (tl::Exception &ex) {
+      batch->error = ex.msg ();
+    } catch (std::exception &ex) {
+      batch->error = ex.what ();
+    }
+
+    mp_job->batch_done (batch);
+  }
+
+private:
+  OASISWriterJob *mp_job;
+  std::map <std::string, unsigned long> m_textstrings;
+  std::map <std::string, unsigned long> m_propnames;
+  std::map <std::string, unsigned long> m_propstrings;
+};
+
+tl::Worker *
+OASISWriterJob::create_worker ()
+{
+  return new OASISWriterWorker (this);
+}
+
+void
+OASISWriter::write_batch (OASISCellWriterBatch &batch, const OASISWriter &master, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers)
+{
+  mp_layout = master.mp_layout;
+  m_sf = master.m_sf;
+  m_options = master.m_options;
+
+  //  the property tables have been written already: no new names can be created
+  m_propname_id = master.m_propname_id;
+  m_propstring_id = master.m_propstring_id;
+  m_proptables_written = true;
+
+  for (std::vector<OASISCellWriterBatch::Cell>::iterator c = batch.cells.begin (); c != batch.cells.end (); ++c) {
+    write_cell_body (mp_layout->cell (c->cell_index), cell_set, layers, c->has_context ? &c->context_prop_strings : 0);
+    c->end = mp_stream->pos ();
+  }
+}
+
+void
+OASISWriter::emit_batch (const OASISCellWriterBatch &batch, std::map <db::cell_index_type, size_t> &cell_positions)
+{
+  size_t offset = 0;
+
+  for (std::vector<OASISCellWriterBatch::Cell>::const_iterator c = batch.cells.begin (); c != batch.cells.end (); ++c) {
+
+    m_progress.set (mp_stream->pos ());
+
+    //  cell header 
+
+    cell_positions.insert (std::make_pair (c->cell_index, mp_stream->pos ()));
+
+    write_record_id (13);  // CELL
+    write ((unsigned long) c->cell_index);
+
+    //  cell body
+
+    if (c->end > offset) {
+      write_bytes (&batch.data [offset], c->end - offset);
+    }
+    offset = c->end;
+
+  }
+}
+
+void
+OASISWriter::write_cells_parallel (db::Layout &layout, const std::vector <db::cell_index_type> &cells, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, std::map <db::cell_index_type, size_t> &cell_positions)
+{
+  //  sort the shapes and instances now: the workers must not do this
+  layout.update ();
+
+  OASISWriterJob job (this, int (m_options.threads), cell_set, layers);
+  std::deque<OASISCellWriterBatch *> batches;
+  std::auto_ptr<OASISCellWriterBatch> current_batch;
+
+  try {
+
+    for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
+
+      const db::Cell &cref (layout.cell (*cell));
+      if (! must_write_cell (cref)) {
+        continue;
+      }
+
+      if (! current_batch.get ()) {
+        current_batch.reset (new OASISCellWriterBatch ());
+      }
+
+      current_batch->cells.push_back (OASISCellWriterBatch::Cell ());
+      OASISCellWriterBatch::Cell &c = current_batch->cells.back ();
+      c.cell_index = *cell;
+      c.end = 0;
+
+      //  the context information is computed here as it involves the libraries
+      c.has_context = cref.is_proxy () && layout.get_context_info (*cell, c.context_prop_strings);
+
+      current_batch->weight += cref.cell_instances () + 1;
+      for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+        current_batch->weight += cref.shapes (l->first).size ();
+      }
+
+      if (current_batch->weight >= batch_weight) {
+
+        batches.push_back (current_batch.release ());
+        job.schedule (new OASISWriterTask (batches.back ()));
+
+        //  the job finishes when the workers run out of tasks - restart it in that case
+        if (! job.is_running ()) {
+          job.start ();
+        }
+
+      }
+
+      //  emit the batches which are ready and limit the number of pending ones
+      while (! batches.empty () && (job.is_done (batches.front ()) || batches.size () > size_t (m_options.threads) * max_pending_batches_per_worker)) {
+
+        std::auto_ptr<OASISCellWriterBatch> batch (batches.front ());
+        batches.pop_front ();
+
+        job.wait_for (batch.get ());
+        if (! batch->error.empty ()) {
+          throw tl::Exception (batch->error);
+        }
+
+        emit_batch (*batch, cell_positions);
+
+      }
+
+    }
+
+    if (current_batch.get ()) {
+      batches.push_back (current_batch.release ());
+      job.schedule (new OASISWriterTask (batches.back ()));
+      if (! job.is_running ()) {
+        job.start ();
+      }
+    }
+
+    while (! batches.empty ()) {
+
+      std::auto_ptr<OASISCellWriterBatch> batch (batches.front ());
+      batches.pop_front ();
+
+      job.wait_for (batch.get ());
+      if (! batch->error.empty ()) {
+        throw tl::Exception (batch->error);
+      }
+
+      emit_batch (*batch, cell_positions);
+
+    }
+
+  } catch (...) {
+
+    job.terminate ();
+    for (std::deque<OASISCellWriterBatch *>::const_iterator b = batches.begin (); b != batches.end (); ++b) {
+      delete *b;
+    }
+    throw;
+
+  }
+}
+
 void 
 OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options)
 {
@@ -1576,19 +1995,22 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
 
   }
 
-  std::vector <std::string> context_prop_strings;
+  if (m_options.threads > 0) {
 
-  for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
+    write_cells_parallel (layout, cells, cell_set, layers, cell_positions);
 
-    m_progress.set (mp_stream->pos ());
+  } else {
+
+    std::vector <std::string> context_prop_strings;
 
-    //  cell body 
-    const db::Cell &cref (layout.cell (*cell));
-    mp_cell = &cref;
+    for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
 
-    //  don't write ghost cells unless they are not empty (any more)
-    //  also don't write proxy cells which are not employed
-    if ((! cref.is_ghost_cell () || ! cref.empty ()) && (! cref.is_proxy () || ! cref.is_top ())) {
+      m_progress.set (mp_stream->pos ());
+
+      const db::Cell &cref (layout.cell (*cell));
+      if (! must_write_cell (cref)) {
+        continue;
+      }
 
       //  cell header 
 
@@ -1597,66 +2019,12 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
       write_record_id (13);  // CELL
       write ((unsigned long) *cell);
 
-      reset_modal_variables ();
-
-      if (m_options.write_cblocks) {
-        begin_cblock ();
-      }
-
-      //  context information as property named KLAYOUT_CONTEXT
-      if (cref.is_proxy ()) {
-
-        context_prop_strings.clear ();
-
-        if (layout.get_context_info (*cell, context_prop_strings)) {
-
-          write_record_id (28);
-          write_byte (char (0xf6)); 
-          std::map <std::string, unsigned long>::const_iterator pni = m_propnames.find (klayout_context_name);
-          tl_assert (pni != m_propnames.end ());
-          write (pni->second);
-
-          write ((unsigned long) context_prop_strings.size ());
-
-          for (std::vector <std::string>::const_iterator c = context_prop_strings.begin (); c != context_prop_strings.end (); ++c) {
-            write_byte (14); // b-string by reference number
-            std::map <std::string, unsigned long>::const_iterator psi = m_propstrings.find (*c);
-            tl_assert (psi != m_propstrings.end ());
-            write (psi->second);
-          }
-
-          mm_last_property_name = klayout_context_name;
-          mm_last_property_is_sprop = false;
-          mm_last_value_list.reset ();
-
-        }
-
-      }
-
-      if (cref.prop_id () != 0) {
-        write_props (cref.prop_id ());
-      }
-
-      //  instances
-      if (cref.cell_instances () > 0) {
-        write_insts (cell_set);
-      }
-
-      //  shapes
-      for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
-        const db::Shapes &shapes = cref.shapes (l->first);
-        if (! shapes.empty ()) {
-          write_shapes (l->second, shapes);
-          m_progress.set (mp_stream->pos ());
-        }
-      }
+      //  cell body
 
-      //  end CBLOCK if required
-      if (m_options.write_cblocks) {
-        end_cblock ();
-      } 
+      context_prop_strings.clear ();
+      bool has_context = cref.is_proxy () && layout.get_context_info (*cell, context_prop_strings);
 
-      //  end of cell
+      write_cell_body (cref, cell_set, layers, has_context ? &context_prop_strings : 0);
 
     }
 
@@ -47,6 +47,9 @@ namespace db
 class Layout;
 class SaveLayoutOptions;
 class OASISWriter;
+class OASISCellWriterBatch;
+class OASISWriterJob;
+class OASISWriterWorker;
 
 /**
  *  @brief A displacement list compactor
@@ -197,6 +200,9 @@ public:
   void write (const db::Polygon &polygon, db::properties_id_type prop_id, const db::Repetition &rep);
 
 private:
+  friend class OASISWriterJob;
+  friend class OASISWriterWorker;
+
   tl::OutputStream *mp_stream;
   double m_sf;
   const db::Layout *mp_layout;
@@ -302,6 +308,11 @@ private:
 
   void write_shapes (const db::LayerProperties &lprops, const db::Shapes &shapes);
 
+  void write_cell_body (const db::Cell &cref, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, const std::vector <std::string> *context_prop_strings);
+  void write_cells_parallel (db::Layout &layout, const std::vector <db::cell_index_type> &cells, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, std::map <db::cell_index_type, size_t> &cell_positions);
+  void write_batch (OASISCellWriterBatch &batch, const OASISWriter &master, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers);
+  void emit_batch (const OASISCellWriterBatch &batch, std::map <db::cell_index_type, size_t> &cell_positions);
+
   void write_props (db::properties_id_type prop_id);
   void write_property_def (const char *name_str, const std::vector<tl::Variant> &pvl, bool sflag);
   void write_property_def (const char *name_str, const tl::Variant &pv, bool sflag);
@@ -53,6 +53,16 @@ static int get_oasis_expect_strict_mode (const db::LoadLayoutOptions *options)
   return options->get_options<db::OASISReaderOptions> ().expect_strict_mode;
 }
 
+static void set_oasis_threads (db::LoadLayoutOptions *options, unsigned int n)
+{
+  options->get_options<db::OASISReaderOptions> ().threads = n;
+}
+
+static unsigned int get_oasis_threads (const db::LoadLayoutOptions *options)
+{
+  return options->get_options<db::OASISReaderOptions> ().threads;
+}
+
 //  extend lay::LoadLayoutOptions with the OASIS options
 static
 gsi::ClassExt<db::LoadLayoutOptions> oasis_reader_options (
@@ -71,6 +81,20 @@ gsi::ClassExt<db::LoadLayoutOptions> oasis_reader_options (
   gsi::method_ext ("oasis_expect_strict_mode?", &get_oasis_expect_strict_mode,
     //  this method is mainly provided as access point for the generic interface
     "@hide"
+  ) +
+  gsi::method_ext ("oasis_threads=", &set_oasis_threads,
+    "@brief Sets the number of threads to use for reading OASIS files\n"
+    "\n"
+    "If this value is 0 (the default), OASIS files are read in the calling thread. Otherwise, "
+    "the cell bodies of strict-mode files carrying S_CELL_OFFSET properties are decoded in the given "
+    "number of worker threads, including the decompression of CBLOCKs. Other files are read in the calling "
+    "thread. The resulting layout is the same in both cases.\n"
+    "\nThis property has been added in version 0.26.\n"
+  ) +
+  gsi::method_ext ("oasis_threads", &get_oasis_threads,
+    "@brief Gets the number of threads to use for reading OASIS files\n"
+    "See \\oasis_threads= method for a description of this property."
+    "\nThis property has been added in version 0.26.\n"
   ),
   ""
 );
@@ -178,6 +202,16 @@ static std::string get_oasis_subst_char (const db::SaveLayoutOptions *options)
   return options->get_options<db::OASISWriterOptions> ().subst_char;
 }
 
+static void set_oasis_write_threads (db::SaveLayoutOptions *options, unsigned int n)
+{
+  options->get_options<db::OASISWriterOptions> ().threads = n;
+}
+
+static unsigned int get_oasis_write_threads (const db::SaveLayoutOptions *options)
+{
+  return options->get_options<db::OASISWriterOptions> ().threads;
+}
+
 //  extend lay::SaveLayoutOptions with the OASIS options
 static
 gsi::ClassExt<db::SaveLayoutOptions> oasis_writer_options (
@@ -296,6 +330,19 @@ gsi::ClassExt<db::SaveLayoutOptions> oasis_writer_options (
   gsi::method_ext ("oasis_compression_level", &get_oasis_compression,
     "@brief Get the OASIS compression level\n"
     "See \\oasis_compression_level= method for a description of the OASIS compression level."
+  ) +
+  gsi::method_ext ("oasis_threads=", &set_oasis_write_threads,
+    "@brief Sets the number of threads to use for writing OASIS files\n"
+    "@args n\n"
+    "If this value is non-zero, the cells are serialized by the given number of worker threads. This "
+    "includes the formation of shape arrays and the CBLOCK compression. The file produced is identical "
+    "to the one written without threads. A value of 0 (the default) disables multi-threaded writing.\n"
+    "\n"
+    "This method has been added in version 0.26."
+  ) +
+  gsi::method_ext ("oasis_threads", &get_oasis_write_threads,
+    "@brief Gets the number of threads to use for writing OASIS files\n"
+    "See \\oasis_threads= method for a description of this property."
   ),
   ""
 );
@@ -24,10 +24,13 @@
 #include "dbOASISReader.h"
 #include "dbTextWriter.h"
 #include "dbTestSupport.h"
+#include "dbOASISWriter.h"
+#include "dbLayoutDiff.h"
 #include "tlLog.h"
 #include "tlUnitTest.h"
 #include "tlStream.h"
 #include "tlFileUtils.h"
+#include "tlTimer.h"
 
 #include <stdlib.h>
 
@@ -579,3 +582,120 @@ TEST(Bug_121_2)
   std::string fn_au (tl::testsrc () + "/testdata/oasis/bug_121_au2.gds");
   db::compare_layouts (_this, layout, fn_au, db::WriteGDS2, 1);
 }
+
+//  Multi-threaded reading
+
+//  returns the number of cells read by the worker threads
+static size_t read_layout (db::Layout &layout, const std::string &fn, unsigned int threads)
+{
+  db::LoadLayoutOptions options;
+  options.get_options<db::OASISReaderOptions> ().threads = threads;
+  options.get_options<db::OASISReaderOptions> ().expect_strict_mode = 1;
+
+  tl::InputStream file (fn);
+  db::OASISReader reader (file);
+  reader.set_warnings_as_errors (true);
+  reader.read (layout, options);
+  return reader.deferred_cells ();
+}
+
+static void write_layout (db::Layout &layout, const std::string &fn, tl::OutputStream::OutputStreamMode mode)
+{
+  tl::OutputStream stream (fn, mode);
+  db::OASISWriter writer;
+  db::SaveLayoutOptions options;
+  db::OASISWriterOptions oasis_options;
+  oasis_options.write_cblocks = true;
+  oasis_options.strict_mode = true;
+  options.set_options (oasis_options);
+  writer.write (layout, stream, options);
+}
+
+//  Benchmark: serial vs. multi-threaded reading of a larger file
+TEST(200)
+{
+  db::Layout layout_org;
+  layout_org.dbu (0.001);
+
+  unsigned int l1 = layout_org.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = layout_org.insert_layer (db::LayerProperties (2, 5));
+
+  db::PropertiesRepository::properties_set ps;
+  ps.insert (std::make_pair (layout_org.properties_repository ().prop_name_id (tl::Variant ("NAME")), tl::Variant ("value")));
+  db::properties_id_type pid = layout_org.properties_repository ().properties_id (ps);
+
+  db::Cell &top = layout_org.cell (layout_org.add_cell ("TOP"));
+
+  for (int c = 0; c < 200; ++c) {
+
+    db::Cell &cell = layout_org.cell (layout_org.add_cell (tl::sprintf ("C%d", c).c_str ()));
+
+    for (int i = 0; i < 1000; ++i) {
+      db::Coord x = (i % 40) * 1000, y = (i / 40) * 1000;
+      cell.shapes (l1).insert (db::Box (x, y, x + 500 + (i % 7) * 10, y + 200 + c));
+      db::Point pts[] = { db::Point (x, y), db::Point (x, y + 700 + i % 5), db::Point (x + 100, y + 800), db::Point (x + 600, y + 300) };
+      db::Polygon poly;
+      poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+      if (i % 10 == 0) {
+        cell.shapes (l2).insert (db::PolygonWithProperties (poly, pid));
+      } else {
+        cell.shapes (l2).insert (poly);
+      }
+      if (i % 100 == 0) {
+        cell.shapes (l1).insert (db::Text (tl::sprintf ("T%d", i / 100), db::Trans (db::Vector (x, y))));
+      }
+    }
+
+    if (c > 0) {
+      //  references to cells defined before and after this one
+      cell.insert (db::CellInstArray (db::CellInst (cell.cell_index () - 1), db::Trans ()));
+    }
+    top.insert (db::CellInstArray (db::CellInst (cell.cell_index ()), db::Trans (db::Vector (0, c * 100000))));
+
+  }
+
+  std::string tmp_file = tl::TestBase::tmp_file ("tmp_OASISReader_200.oas");
+  write_layout (layout_org, tmp_file, tl::OutputStream::OM_Plain);
+
+  db::Layout layout_ref;
+  size_t deferred_ref = 0;
+  {
+    tl::SelfTimer timer ("Reading OASIS file serially");
+    deferred_ref = read_layout (layout_ref, tmp_file, 0);
+  }
+  EXPECT_EQ (deferred_ref, size_t (0));
+
+  db::Layout layout;
+  size_t deferred = 0;
+  {
+    tl::SelfTimer timer ("Reading OASIS file with 4 threads");
+    deferred = read_layout (layout, tmp_file, 4);
+  }
+  //  all cells are read by the workers (the END record tells where the last one ends)
+  EXPECT_EQ (deferred, size_t (201));
+
+  EXPECT_EQ (layout.cells (), size_t (201));
+  EXPECT_EQ (layout.cells (), layout_ref.cells ());
+
+  //  the cells are created in the same order than by the serial reader
+  bool same_order = true;
+  for (db::cell_index_type ci = 0; ci < layout.cells (); ++ci) {
+    if (std::string (layout.cell_name (ci)) != layout_ref.cell_name (ci)) {
+      same_order = false;
+    }
+  }
+  EXPECT_EQ (same_order, true);
+
+  EXPECT_EQ (db::compare_layouts (layout, layout_ref, db::layout_diff::f_verbose, 0), true);
+  EXPECT_EQ (db::compare_layouts (layout, layout_org, db::layout_diff::f_verbose, 0), true);
+
+  //  compressed streams can't seek to the table offsets in the END record: they are read serially
+  std::string tmp_file_gz = tl::TestBase::tmp_file ("tmp_OASISReader_200.oas.gz");
+  write_layout (layout_org, tmp_file_gz, tl::OutputStream::OM_Zlib);
+
+  db::Layout layout_gz;
+  size_t deferred_gz = read_layout (layout_gz, tmp_file_gz, 4);
+  EXPECT_EQ (deferred_gz, size_t (0));
+
+  EXPECT_EQ (db::compare_layouts (layout_gz, layout_org, db::layout_diff::f_verbose, 0), true);
+}
@@ -28,6 +28,7 @@
 #include "dbTextWriter.h"
 
 #include "tlUnitTest.h"
+#include "tlTimer.h"
 
 #include <cstdlib>
 
@@ -132,6 +133,51 @@ void run_test (tl::TestBase *_this, const char *file, bool scaling_test, int com
       _this->raise (tl::sprintf ("Compare failed - see %s vs %s\n", fn, tmp_file));
     }
 
+    //  multi-threaded reading
+    db::Layout layout3 (&m);
+
+    {
+      tl::InputStream stream3 (tmp_file);
+      db::Reader reader3 (stream3);
+      db::LoadLayoutOptions options;
+      db::OASISReaderOptions oasis_options;
+      oasis_options.expect_strict_mode = 1;
+      oasis_options.threads = 2;
+      options.set_options (oasis_options);
+      reader3.set_warnings_as_errors (true);
+      reader3.read (layout3, options);
+    }
+
+    CHECKPOINT ();
+    equal = db::compare_layouts (layout, layout3, db::layout_diff::f_verbose | db::layout_diff::f_flatten_array_insts, 0);
+    if (! equal) {
+      _this->raise (tl::sprintf ("Compare failed (multi-threaded reading) - see %s vs %s\n", fn, tmp_file));
+    }
+
+    //  multi-threaded writing must produce the same file
+    std::string data[2];
+
+    for (unsigned int i = 0; i < 2; ++i) {
+      tl::OutputMemoryStream data_stream;
+      {
+        tl::OutputStream stream (data_stream);
+        db::OASISWriter writer;
+        db::SaveLayoutOptions options;
+        db::OASISWriterOptions oasis_options;
+        oasis_options.write_cblocks = true;
+        oasis_options.strict_mode = true;
+        oasis_options.threads = i * 2;
+        options.set_options (oasis_options);
+        writer.write (layout, stream, options);
+      }
+      data [i] = std::string (data_stream.data (), data_stream.size ());
+    }
+
+    CHECKPOINT ();
+    if (data [0] != data [1]) {
+      _this->raise (tl::sprintf ("Multi-threaded writing produced a different file for %s\n", fn));
+    }
+
   }
 
   {
@@ -231,6 +277,27 @@ void run_test (tl::TestBase *_this, const char *file, bool scaling_test, int com
       _this->raise (tl::sprintf ("Compare failed - see %s vs %s\n", fn, tmp_file));
     }
 
+    //  multi-threaded reading
+    db::Layout layout3 (&m);
+
+    {
+      tl::InputStream stream3 (tmp_file);
+      db::Reader reader3 (stream3);
+      db::LoadLayoutOptions options;
+      db::OASISReaderOptions oasis_options;
+      oasis_options.expect_strict_mode = 1;
+      oasis_options.threads = 2;
+      options.set_options (oasis_options);
+      reader3.set_warnings_as_errors (true);
+      reader3.read (layout3, options);
+    }
+
+    CHECKPOINT ();
+    equal = db::compare_layouts (layout, layout3, db::layout_diff::f_verbose | db::layout_diff::f_flatten_array_insts, 0);
+    if (! equal) {
+      _this->raise (tl::sprintf ("Compare failed (multi-threaded reading) - see %s vs %s\n", fn, tmp_file));
+    }
+
   }
 
   if (scaling_test) {
@@ -1728,3 +1795,84 @@ TEST(117)
   EXPECT_EQ (std::string (os.string ()), std::string (expected))
 }
 
+
+//  multi-threaded writing (also a benchmark)
+TEST(200)
+{
+  db::Layout layout_org;
+  layout_org.dbu (0.001);
+
+  unsigned int l1 = layout_org.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = layout_org.insert_layer (db::LayerProperties (2, 5));
+
+  db::PropertiesRepository::properties_set ps;
+  ps.insert (std::make_pair (layout_org.properties_repository ().prop_name_id (tl::Variant ("NAME")), tl::Variant ("value")));
+  db::properties_id_type pid = layout_org.properties_repository ().properties_id (ps);
+
+  db::Cell &top = layout_org.cell (layout_org.add_cell ("TOP"));
+
+  for (int c = 0; c < 200; ++c) {
+
+    db::Cell &cell = layout_org.cell (layout_org.add_cell (tl::sprintf ("C%d", c).c_str ()));
+
+    for (int i = 0; i < 2000; ++i) {
+      db::Coord x = (i % 40) * 1000 + (i % 3) * 7, y = (i / 40) * 1000;
+      cell.shapes (l1).insert (db::Box (x, y, x + 500 + (i % 7) * 10, y + 200 + c));
+      db::Point pts[] = { db::Point (x, y), db::Point (x, y + 700 + i % 5), db::Point (x + 100, y + 800), db::Point (x + 600, y + 300) };
+      db::Polygon poly;
+      poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+      if (i % 10 == 0) {
+        cell.shapes (l2).insert (db::PolygonWithProperties (poly, pid));
+      } else {
+        cell.shapes (l2).insert (poly);
+      }
+      if (i % 100 == 0) {
+        cell.shapes (l1).insert (db::Text (tl::sprintf ("T%d", i / 100), db::Trans (db::Vector (x, y))));
+      }
+    }
+
+    if (c > 0) {
+      cell.insert (db::CellInstArray (db::CellInst (cell.cell_index () - 1), db::Trans ()));
+    }
+    top.insert (db::CellInstArray (db::CellInst (cell.cell_index ()), db::Trans (db::Vector (0, c * 100000))));
+
+  }
+
+  std::string data[2];
+
+  for (unsigned int i = 0; i < 2; ++i) {
+
+    tl::SelfTimer timer (i == 0 ? "Writing OASIS file serially" : "Writing OASIS file with 4 threads");
+
+    tl::OutputMemoryStream data_stream;
+    {
+      tl::OutputStream stream (data_stream);
+      db::OASISWriter writer;
+      db::SaveLayoutOptions options;
+      db::OASISWriterOptions oasis_options;
+      oasis_options.compression_level = 10;
+      oasis_options.write_cblocks = true;
+      oasis_options.strict_mode = true;
+      oasis_options.threads = i * 4;
+      options.set_options (oasis_options);
+      writer.write (layout_org, stream, options);
+    }
+
+    data [i] = std::string (data_stream.data (), data_stream.size ());
+
+  }
+
+  EXPECT_EQ (data [0].size (), data [1].size ());
+  EXPECT_EQ (data [0] == data [1], true);
+
+  db::Layout layout;
+  {
+    tl::InputMemoryStream data_stream (data [1].c_str (), data [1].size ());
+    tl::InputStream stream (data_stream);
+    db::Reader reader (stream);
+    reader.set_warnings_as_errors (true);
+    reader.read (layout);
+  }
+
+  EXPECT_EQ (db::compare_layouts (layout, layout_org, db::layout_diff::f_verbose | db::layout_diff::f_flatten_array_insts, 0), true);
+}
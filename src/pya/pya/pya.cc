@@ -284,6 +284,9 @@ PythonInterpreter::PythonInterpreter (bool embedded)
 
   Py_InitializeEx (0 /*don't set signals*/);
 
+  //  creates the GIL - long-running methods release it
+  PyEval_InitThreads ();
+
   //  Set dummy argv[]
   //  TODO: more?
   char *argv[1] = { make_string (app_path) };
@@ -314,6 +317,11 @@ PythonInterpreter::PythonInterpreter (bool embedded)
   PyImport_AppendInittab (pya_module_name, &init_pya_module);
   Py_InitializeEx (0 /*don't set signals*/);
 
+#if PY_MINOR_VERSION < 7
+  //  creates the GIL - long-running methods release it (implicit since Python 3.7)
+  PyEval_InitThreads ();
+#endif
+
   //  Set dummy argv[]
   //  TODO: more?
   wchar_t *argv[1] = { mp_py3_app_name };
@@ -374,6 +382,8 @@ PythonInterpreter::make_string (const std::string &s)
 void
 PythonInterpreter::add_path (const std::string &p)
 {
+  PythonGILLock gil_lock;
+
   PyObject *path = PySys_GetObject ((char *) "path");
   if (path != NULL && PyList_Check (path)) {
     PyList_Append (path, c2python (p));
@@ -478,6 +488,8 @@ PythonInterpreter::get_context (int context, PythonRef &globals, PythonRef &loca
 void
 PythonInterpreter::eval_string (const char *expr, const char *file, int /*line*/, int context)
 {
+  PythonGILLock gil_lock;
+
   PYTHON_BEGIN_EXEC
 
     //  TODO: what to do with "line"?
@@ -511,6 +523,8 @@ PythonInterpreter::eval_string (const char *expr, const char *file, int /*line*/
 tl::Variant
 PythonInterpreter::eval_int (const char *expr, const char *file, int /*line*/, bool eval_expr, int context)
 {
+  PythonGILLock gil_lock;
+
   tl::Variant ret;
 
   PYTHON_BEGIN_EXEC
@@ -564,6 +578,8 @@ PythonInterpreter::eval_expr (const char *expr, const char *file, int line, int
 gsi::Inspector *
 PythonInterpreter::inspector (int context)
 {
+  PythonGILLock gil_lock;
+
   PythonRef globals, locals;
   get_context (context, globals, locals, 0);
   return create_inspector (locals.get (), true /*symbolic*/);
@@ -572,6 +588,8 @@ PythonInterpreter::inspector (int context)
 void
 PythonInterpreter::define_variable (const std::string &name, const std::string &value)
 {
+  PythonGILLock gil_lock;
+
   PythonPtr main_module (PyImport_AddModule ("__main__"));
   PythonPtr dict (PyModule_GetDict (main_module.get ()));
   if (dict) {
@@ -710,6 +728,8 @@ PythonInterpreter::trace_func (PyFrameObject *frame, int event, PyObject *arg)
 void
 PythonInterpreter::push_exec_handler (gsi::ExecutionHandler *exec_handler)
 {
+  PythonGILLock gil_lock;
+
   if (mp_current_exec_handler) {
     m_exec_handlers.push_back (mp_current_exec_handler);
   } else {
@@ -729,6 +749,8 @@ PythonInterpreter::push_exec_handler (gsi::ExecutionHandler *exec_handler)
 void
 PythonInterpreter::remove_exec_handler (gsi::ExecutionHandler *exec_handler)
 {
+  PythonGILLock gil_lock;
+
   if (mp_current_exec_handler == exec_handler) {
 
     //  if we happen to remove the exec handler inside the execution,
@@ -760,6 +782,8 @@ PythonInterpreter::remove_exec_handler (gsi::ExecutionHandler *exec_handler)
 void
 PythonInterpreter::push_console (gsi::Console *console)
 {
+  PythonGILLock gil_lock;
+
   if (! mp_current_console) {
 
     PythonPtr current_stdout (PySys_GetObject ((char *) "stdout"));
@@ -784,6 +808,8 @@ PythonInterpreter::push_console (gsi::Console *console)
 void
 PythonInterpreter::remove_console (gsi::Console *console)
 {
+  PythonGILLock gil_lock;
+
   if (mp_current_console == console) {
 
     if (m_consoles.empty ()) {
@@ -822,6 +848,8 @@ PythonInterpreter::remove_console (gsi::Console *console)
 std::string
 PythonInterpreter::version () const
 {
+  PythonGILLock gil_lock;
+
   PyObject *version = PySys_GetObject ((char *) "version");
   if (version != NULL) {
     return python2c<std::string> (version);
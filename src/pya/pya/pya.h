@@ -94,6 +94,10 @@ class PythonModule;
 
 /**
  *  @brief The python interpreter wrapper class
+ *
+ *  Long-running methods release the GIL, so the application may enter the interpreter
+ *  while such a method is running (e.g. from the event loop). Hence the methods of this
+ *  class acquire the GIL where they use Python's API.
  */
 class PYA_PUBLIC PythonInterpreter
   : public gsi::Interpreter
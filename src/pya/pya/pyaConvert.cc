@@ -42,6 +42,11 @@ bool is_derived_from (const gsi::ClassBase *cls, const std::type_info &ti)
 template <>
 long python2c_func<long>::operator() (PyObject *rval)
 {
+  //  fast path for the common case
+  if (PyLong_CheckExact (rval)) {
+    return PyLong_AsLong (rval);
+  }
+
 #if PY_MAJOR_VERSION < 3
   if (PyInt_Check (rval)) {
     return PyInt_AsLong (rval);
@@ -153,6 +158,11 @@ __int128 python2c_func<__int128>::operator() (PyObject *rval)
 template <>
 double python2c_func<double>::operator() (PyObject *rval)
 {
+  //  fast path for the common case
+  if (PyFloat_CheckExact (rval)) {
+    return PyFloat_AS_DOUBLE (rval);
+  }
+
 #if PY_MAJOR_VERSION < 3
   if (PyInt_Check (rval)) {
     return PyInt_AsLong (rval);
@@ -1020,7 +1020,7 @@ struct test_arg_func<gsi::ObjectType>
       *ret = false;
       return;
     }
-    if ((atype.is_ref () || atype.is_ptr ()) && ((PYAObjectBase *) arg)->const_ref ()) {
+    if ((atype.is_ref () || atype.is_ptr ()) && PYAObjectBase::from_pyobject (arg)->const_ref ()) {
       *ret = false;
       return;
     }
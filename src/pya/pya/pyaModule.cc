@@ -51,8 +51,83 @@ class MethodTableEntry
 public:
   typedef std::vector<const gsi::MethodBase *>::const_iterator method_iterator;
 
+  /**
+   *  @brief A key for the overload resolution cache
+   *  The key describes the argument types of a call and the constness of the object.
+   */
+  struct MethodVariantKey
+  {
+    enum { max_args = 8 };
+
+    MethodVariantKey ()
+      : m_argc (0), m_const_mask (0), m_has_self (false), m_is_const (false)
+    { }
+
+    MethodVariantKey (bool has_self, bool is_const)
+      : m_argc (0), m_const_mask (0), m_has_self (has_self), m_is_const (is_const)
+    { }
+
+    /**
+     *  @brief Adds an argument type
+     *  Returns false if the number of arguments is too large for caching.
+     */
+    bool add_arg (const void *type, bool is_const)
+    {
+      if (m_argc == (unsigned int) max_args) {
+        return false;
+      }
+      if (is_const) {
+        m_const_mask |= (1 << m_argc);
+      }
+      m_argtypes [m_argc++] = size_t (type);
+      return true;
+    }
+
+    bool operator== (const MethodVariantKey &other) const
+    {
+      if (m_argc != other.m_argc || m_const_mask != other.m_const_mask || m_has_self != other.m_has_self || m_is_const != other.m_is_const) {
+        return false;
+      }
+      for (unsigned int i = 0; i < m_argc; ++i) {
+        if (m_argtypes [i] != other.m_argtypes [i]) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool operator< (const MethodVariantKey &other) const
+    {
+      if (m_argc != other.m_argc) {
+        return m_argc < other.m_argc;
+      }
+      for (unsigned int i = 0; i < m_argc; ++i) {
+        if (m_argtypes [i] != other.m_argtypes [i]) {
+          return m_argtypes [i] < other.m_argtypes [i];
+        }
+      }
+      if (m_const_mask != other.m_const_mask) {
+        return m_const_mask < other.m_const_mask;
+      }
+      if (m_has_self != other.m_has_self) {
+        return m_has_self < other.m_has_self;
+      }
+      if (m_is_const != other.m_is_const) {
+        return m_is_const < other.m_is_const;
+      }
+      return false;
+    }
+
+  private:
+    size_t m_argtypes [max_args];
+    unsigned int m_argc;
+    unsigned int m_const_mask;
+    bool m_has_self;
+    bool m_is_const;
+  };
+
   MethodTableEntry (const std::string &name, bool st, bool prot)
-    : m_name (name), m_is_static (st), m_is_protected (prot)
+    : m_name (name), m_is_static (st), m_is_protected (prot), mp_last_variant (0)
   { }
 
   const std::string &name () const
@@ -93,11 +168,53 @@ public:
     return m_methods.end ();
   }
 
+  /**
+   *  @brief Returns true if there is more than one implementation
+   */
+  bool is_overloaded () const
+  {
+    return m_methods.size () > 1;
+  }
+
+  /**
+   *  @brief Looks up a resolved overload variant from the cache
+   *  Returns 0 if there is no cached variant for this key.
+   */
+  const gsi::MethodBase *find_variant (const MethodVariantKey &key) const
+  {
+    //  tight loops usually call the same variant again
+    if (mp_last_variant && m_last_key == key) {
+      return mp_last_variant;
+    }
+
+    std::map<MethodVariantKey, const gsi::MethodBase *>::const_iterator v = m_variants.find (key);
+    if (v != m_variants.end ()) {
+      m_last_key = key;
+      mp_last_variant = v->second;
+      return v->second;
+    }
+
+    return 0;
+  }
+
+  /**
+   *  @brief Puts a resolved overload variant into the cache
+   */
+  void add_variant (const MethodVariantKey &key, const gsi::MethodBase *meth) const
+  {
+    m_variants.insert (std::make_pair (key, meth));
+    m_last_key = key;
+    mp_last_variant = meth;
+  }
+
 private:
   std::string m_name;
   bool m_is_static : 1;
   bool m_is_protected : 1;
   std::vector<const gsi::MethodBase *> m_methods;
+  mutable std::map<MethodVariantKey, const gsi::MethodBase *> m_variants;
+  mutable MethodVariantKey m_last_key;
+  mutable const gsi::MethodBase *mp_last_variant;
 };
 
 /**
@@ -319,6 +436,14 @@ public:
     return m_property_table[mid - m_property_offset].second.end ();
   }
 
+  /**
+   *  @brief Gets the method table entry for method ID mid
+   */
+  const MethodTableEntry &entry (size_t mid) const
+  {
+    return m_table[mid - m_method_offset];
+  }
+
   /**
    *  @brief Begins iteration of the overload variants for method ID mid
    */
@@ -588,6 +713,26 @@ pya_object_deallocate (PyObject *self)
   Py_TYPE (self)->tp_free (self);
 }
 
+/**
+ *  @brief Gets the bound type a Python type is derived from
+ *  Returns 0 if the type is not derived from a type created for a GSI class.
+ *  This check is cheap as it does not involve any attribute lookup.
+ */
+static PyTypeObject *
+bound_base_type (PyTypeObject *type)
+{
+  PyObject *mro = type->tp_mro;
+  if (mro != NULL && PyTuple_Check (mro)) {
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE (mro); ++i) {
+      PyTypeObject *t = (PyTypeObject *) PyTuple_GET_ITEM (mro, i);
+      if (t->tp_dealloc == (destructor) &pya_object_deallocate) {
+        return t;
+      }
+    }
+  }
+  return 0;
+}
+
 /**
  *  @brief Constructor for the base class (the implementation object)
  */
@@ -616,6 +761,81 @@ pya_object_new (PyTypeObject *type, PyObject * /*args*/, PyObject * /*kwds*/)
   return self_pyobject;
 }
 
+#if PY_MAJOR_VERSION >= 3
+
+/**
+ *  @brief Implements the buffer protocol for classes providing a data block
+ *
+ *  The data block is exported as a two-dimensional, C-contiguous array.
+ */
+static int
+pya_object_getbuffer (PyObject *self, Py_buffer *view, int flags)
+{
+  view->obj = NULL;
+
+  PYA_TRY
+
+    PYAObjectBase *p = PYAObjectBase::from_pyobject (self);
+
+    gsi::BufferInfo info;
+    if (! p->cls_decl ()->get_buffer (p->obj (), info)) {
+      PyErr_SetString (PyExc_BufferError, tl::to_string (tr ("Object does not provide a buffer")).c_str ());
+      return -1;
+    }
+
+    bool readonly = info.readonly || p->const_ref ();
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && readonly) {
+      PyErr_SetString (PyExc_BufferError, tl::to_string (tr ("Object does not provide a writable buffer")).c_str ());
+      return -1;
+    }
+
+    //  shape and strides - released in pya_object_releasebuffer
+    Py_ssize_t *dims = new Py_ssize_t [4];
+    dims [0] = Py_ssize_t (info.rows);
+    dims [1] = Py_ssize_t (info.columns);
+    dims [2] = Py_ssize_t (info.columns * info.item_size);
+    dims [3] = Py_ssize_t (info.item_size);
+
+    //  an empty block still needs a valid address
+    static char empty = 0;
+
+    view->buf = info.data ? info.data : (void *) &empty;
+    view->len = Py_ssize_t (info.rows * info.columns * info.item_size);
+    view->itemsize = Py_ssize_t (info.item_size);
+    view->readonly = readonly;
+    view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? (char *) info.format : NULL;
+    view->ndim = 2;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? dims : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? dims + 2 : NULL;
+    view->suboffsets = NULL;
+    view->internal = (void *) dims;
+
+    view->obj = self;
+    Py_INCREF (self);
+
+    //  blocks assign and destroy while the buffer is in use
+    p->add_buffer_export ();
+
+    return 0;
+
+  PYA_CATCH ("buffer access")
+
+  return -1;
+}
+
+/**
+ *  @brief Releases the buffer obtained with pya_object_getbuffer
+ */
+static void
+pya_object_releasebuffer (PyObject *self, Py_buffer *view)
+{
+  PYAObjectBase::from_pyobject (self)->remove_buffer_export ();
+  delete [] (Py_ssize_t *) view->internal;
+  view->internal = 0;
+}
+
+#endif
+
 // --------------------------------------------------------------------------
 //  Method binding guts
 
@@ -704,6 +924,45 @@ get_return_value (PYAObjectBase *self, gsi::SerialArgs &retlist, const gsi::Meth
   return ret;
 }
 
+/**
+ *  @brief Computes the overload cache key for the given arguments
+ *  Returns false if the overload resolution can't be cached for these arguments.
+ */
+static bool
+make_variant_key (MethodTableEntry::MethodVariantKey &key, PyObject *args, int argc)
+{
+  for (int i = 0; i < argc; ++i) {
+
+    PyObject *arg = PyTuple_GET_ITEM (args, i);
+    PyTypeObject *type = Py_TYPE (arg);
+
+    PyTypeObject *bound_type = bound_base_type (type);
+    if (bound_type) {
+
+      //  for objects, the overload resolution depends on the class and the constness
+      if (! key.add_arg (bound_type, PYAObjectBase::from_pyobject (arg)->const_ref ())) {
+        return false;
+      }
+
+    } else if (PyTuple_Check (arg) || PyList_Check (arg) || PyDict_Check (arg)) {
+
+      //  caching can't work for lists or dicts as the resolution depends on the content
+      return false;
+
+    } else if ((type->tp_flags & Py_TPFLAGS_HEAPTYPE) != 0) {
+
+      //  heap types may be deleted and another type may take their address
+      return false;
+
+    } else if (! key.add_arg (type, false)) {
+      return false;
+    }
+
+  }
+
+  return true;
+}
+
 static const gsi::MethodBase *
 match_method (int mid, PyObject *self, PyObject *args, bool strict)
 {
@@ -738,6 +997,19 @@ match_method (int mid, PyObject *self, PyObject *args, bool strict)
 
   }
 
+  //  try to find the variant in the cache
+
+  const MethodTableEntry &entry = mt->entry (mid);
+
+  MethodTableEntry::MethodVariantKey key (p != 0, p != 0 && p->const_ref ());
+  bool use_cache = entry.is_overloaded () && make_variant_key (key, args, argc);
+  if (use_cache) {
+    const gsi::MethodBase *cached = entry.find_variant (key);
+    if (cached) {
+      return cached;
+    }
+  }
+
   for (MethodTableEntry::method_iterator m = mt->begin (mid); m != mt->end (mid); ++m) {
 
     if ((*m)->is_callback()) {
@@ -858,6 +1130,10 @@ match_method (int mid, PyObject *self, PyObject *args, bool strict)
     }
   }
 
+  if (use_cache) {
+    entry.add_variant (key, meth);
+  }
+
   return meth;
 }
 
@@ -910,6 +1186,9 @@ object_assign (PyObject *self, PyObject *args)
   if (! cls_decl_self->can_copy ()) {
     throw tl::Exception (tl::to_string (tr ("No assignment provided for class '%s'")), cls_decl_self->name ());
   }
+  if ((PYAObjectBase::from_pyobject (self))->has_buffer_exports ()) {
+    throw tl::Exception (tl::to_string (tr ("Object cannot be assigned while its buffer is in use (e.g. by a memoryview)")));
+  }
 
   cls_decl_self->assign ((PYAObjectBase::from_pyobject (self))->obj (), (PYAObjectBase::from_pyobject (src))->obj ());
 
@@ -1103,6 +1382,25 @@ special_method_impl (gsi::MethodBase::special_method_type smt, PyObject *self, P
   }
 }
 
+/**
+ *  @brief Calls the given method, releasing the GIL for long-running ones
+ *
+ *  Callbacks into Python reacquire the GIL (see PythonGILLock). So do the entry points
+ *  of the embedded interpreter, which the application's event loop may call while
+ *  the method runs (e.g. when progress is reported). Worker threads of the method can 
+ *  call back into Python while the calling thread waits for them.
+ */
+static void
+call_method (const gsi::MethodBase *meth, void *obj, gsi::SerialArgs &arglist, gsi::SerialArgs &retlist)
+{
+  if (meth->is_long_running ()) {
+    PythonGILReleaser gil_releaser;
+    meth->call (obj, arglist, retlist);
+  } else {
+    meth->call (obj, arglist, retlist);
+  }
+}
+
 static PyObject *
 method_adaptor (int mid, PyObject *self, PyObject *args)
 {
@@ -1161,7 +1459,7 @@ method_adaptor (int mid, PyObject *self, PyObject *args)
 
       }
 
-      meth->call (obj, arglist, retlist);
+      call_method (meth, obj, arglist, retlist);
 
       ret = get_return_value (p, retlist, meth, heap);
 
@@ -1712,7 +2010,7 @@ method_init_adaptor (int mid, PyObject *self, PyObject *args)
 
       }
 
-      meth->call (0, arglist, retlist);
+      call_method (meth, 0, arglist, retlist);
 
       void *obj = retlist.read<void *> (heap);
       if (obj) {
@@ -2150,6 +2448,7 @@ property_setter_func (PyObject *self, PyObject *value, void *closure)
 
 std::map<const gsi::MethodBase *, std::string> PythonModule::m_python_doc;
 std::vector<const gsi::ClassBase *> PythonModule::m_classes;
+std::map<PyTypeObject *, const gsi::ClassBase *> PythonModule::m_classes_by_type;
 
 const std::string pymod_name ("klayout");
 
@@ -2455,7 +2754,16 @@ PythonModule::make_classes (const char *mod_name)
       type->tp_setattro = PyObject_GenericSetAttr;
       type->tp_getattro = PyObject_GenericGetAttr;
 
+#if PY_MAJOR_VERSION >= 3
+      if (c->provides_buffer ()) {
+        //  heap types carry their own buffer slots
+        type->tp_as_buffer->bf_getbuffer = &pya_object_getbuffer;
+        type->tp_as_buffer->bf_releasebuffer = &pya_object_releasebuffer;
+      }
+#endif
+
       PythonClassClientData::initialize (*c, type);
+      m_classes_by_type.insert (std::make_pair (type, c.operator-> ()));
 
       tl_assert (cls_for_type (type) == c.operator-> ());
 
@@ -2914,20 +3222,16 @@ PythonModule::make_classes (const char *mod_name)
 
 const gsi::ClassBase *PythonModule::cls_for_type (PyTypeObject *type)
 {
-  //  GSI classes store their class index inside the __gsi_id__ attribute
-  if (PyObject_HasAttrString ((PyObject *) type, "__gsi_id__")) {
-
-    PyObject *cls_id = PyObject_GetAttrString ((PyObject *) type, "__gsi_id__");
-    if (cls_id != NULL && pya::test_type<size_t> (cls_id)) {
-      size_t i = pya::python2c<size_t> (cls_id);
-      if (i < m_classes.size ()) {
-        return m_classes [i];
-      }
-    }
-
+  //  Python classes derived from bound types are represented by the GSI class
+  //  of the bound type. This lookup is used for every object argument, hence
+  //  it does not involve an attribute lookup.
+  PyTypeObject *bound_type = bound_base_type (type);
+  if (! bound_type) {
+    return 0;
   }
 
-  return 0;
+  std::map<PyTypeObject *, const gsi::ClassBase *>::const_iterator c = m_classes_by_type.find (bound_type);
+  return c != m_classes_by_type.end () ? c->second : 0;
 }
 
 PyTypeObject *PythonModule::type_for_cls (const gsi::ClassBase *cls)
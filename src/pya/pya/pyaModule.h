@@ -125,6 +125,7 @@ private:
 
   static std::map<const gsi::MethodBase *, std::string> m_python_doc;
   static std::vector<const gsi::ClassBase *> m_classes;
+  static std::map<PyTypeObject *, const gsi::ClassBase *> m_classes_by_type;
 };
 
 }
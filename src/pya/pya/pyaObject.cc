@@ -122,6 +122,9 @@ Callee::can_call () const
 void 
 Callee::call (int id, gsi::SerialArgs &args, gsi::SerialArgs &ret) const
 {
+  //  the callback may happen while a long-running method has released the GIL
+  PythonGILLock gil_lock;
+
   const gsi::MethodBase *meth = m_cbfuncs [id].method ();
 
   try {
@@ -189,7 +192,8 @@ PYAObjectBase::PYAObjectBase(const gsi::ClassBase *_cls_decl, PyObject *py_objec
     m_owned (false),
     m_const_ref (false),
     m_destroyed (false),
-    m_can_destroy (false)
+    m_can_destroy (false),
+    m_buffer_exports (0)
 {
   //  .. nothing yet ..
 }
@@ -542,6 +546,10 @@ PYAObjectBase::destroy ()
     throw tl::Exception (tl::to_string (tr ("Object cannot be destroyed explicitly")));
   }
 
+  if (m_buffer_exports > 0) {
+    throw tl::Exception (tl::to_string (tr ("Object cannot be destroyed while its buffer is in use (e.g. by a memoryview)")));
+  }
+
   //  first create the object if it was not created yet and check if it has not been 
   //  destroyed already (the former is to ensure that the object is created at least)
   if (! m_obj) {
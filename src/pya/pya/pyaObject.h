@@ -196,6 +196,33 @@ public:
     return m_owned;
   }
 
+  /**
+   *  @brief Registers a buffer export (see the buffer protocol)
+   *  While a buffer is exported, the C++ object must not be destroyed or assigned
+   *  as this might invalidate the buffer's memory.
+   */
+  void add_buffer_export ()
+  {
+    ++m_buffer_exports;
+  }
+
+  /**
+   *  @brief Unregisters a buffer export
+   */
+  void remove_buffer_export ()
+  {
+    tl_assert (m_buffer_exports > 0);
+    --m_buffer_exports;
+  }
+
+  /**
+   *  @brief Returns true, if buffers are exported currently
+   */
+  bool has_buffer_exports () const
+  {
+    return m_buffer_exports > 0;
+  }
+
   /**
    *  @brief Returns the signal handler for the signal given by "meth"
    *  If a signal handler was already present, the existing object is returned.
@@ -228,6 +255,7 @@ private:
   bool m_const_ref : 1;
   bool m_destroyed : 1;
   bool m_can_destroy : 1;
+  unsigned int m_buffer_exports;
   std::map <const gsi::MethodBase *, pya::SignalHandler> m_signal_table;
 };
 
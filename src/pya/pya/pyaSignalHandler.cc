@@ -123,6 +123,9 @@ SignalHandler::~SignalHandler ()
 
 void SignalHandler::call (const gsi::MethodBase *meth, gsi::SerialArgs &args, gsi::SerialArgs &ret) const
 {
+  //  the event may be issued while a long-running method has released the GIL
+  PythonGILLock gil_lock;
+
   PYTHON_BEGIN_EXEC
 
     tl::Heap heap;
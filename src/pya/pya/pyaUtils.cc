@@ -132,5 +132,35 @@ void check_error ()
   }
 }
 
+// --------------------------------------------------------------------------
+//  Implementation of PythonGILReleaser and PythonGILLock
+
+PythonGILReleaser::PythonGILReleaser ()
+{
+  mp_thread_state = PyEval_SaveThread ();
+}
+
+PythonGILReleaser::~PythonGILReleaser ()
+{
+  PyEval_RestoreThread (mp_thread_state);
+}
+
+PythonGILLock::PythonGILLock ()
+  : m_locked (false), m_state (0)
+{
+  //  NOTE: callbacks may still happen after Python has shut down (e.g. on object destruction)
+  if (Py_IsInitialized ()) {
+    m_state = int (PyGILState_Ensure ());
+    m_locked = true;
+  }
+}
+
+PythonGILLock::~PythonGILLock ()
+{
+  if (m_locked) {
+    PyGILState_Release (PyGILState_STATE (m_state));
+  }
+}
+
 }
 
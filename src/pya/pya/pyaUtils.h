@@ -26,6 +26,9 @@
 
 #include "tlScriptError.h"
 
+struct _ts;
+typedef _ts PyThreadState;
+
 namespace pya
 {
 
@@ -70,6 +73,41 @@ namespace pya
  */
 void check_error ();
 
+/**
+ *  @brief Releases the Python GIL while this object lives
+ *
+ *  This object is used around long-running C++ calls to let other Python threads run.
+ *  Inside its scope, Python objects must not be touched unless the GIL is reacquired
+ *  with PythonGILLock.
+ */
+class PythonGILReleaser
+{
+public:
+  PythonGILReleaser ();
+  ~PythonGILReleaser ();
+
+private:
+  PyThreadState *mp_thread_state;
+};
+
+/**
+ *  @brief Acquires the Python GIL for the current thread while this object lives
+ *
+ *  This object is used on entry of callbacks into Python. Such callbacks may happen
+ *  from inside a long-running call which has released the GIL or from worker threads.
+ *  If the current thread already holds the GIL, this object does nothing.
+ */
+class PythonGILLock
+{
+public:
+  PythonGILLock ();
+  ~PythonGILLock ();
+
+private:
+  bool m_locked;
+  int m_state;
+};
+
 }
 
 #endif
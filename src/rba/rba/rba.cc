@@ -159,28 +159,60 @@ public:
 
   struct MethodVariantKey
   {
+    enum { max_args = 8 };
+
+    MethodVariantKey ()
+      : m_argc (0), m_const_args (0), m_block_given (false), m_is_ctor (false), m_is_static (false), m_is_const (false)
+    { }
+
     MethodVariantKey (int argc, VALUE *argv, bool block_given, bool is_ctor, bool is_static, bool is_const)
-      : m_block_given (block_given), m_is_ctor (is_ctor), m_is_static (is_static), m_is_const (is_const)
+      : m_argc ((unsigned int) argc), m_const_args (0), m_block_given (block_given), m_is_ctor (is_ctor), m_is_static (is_static), m_is_const (is_const)
     {
-      m_argtypes.reserve (size_t (argc));
+      //  NOTE: the caller needs to make sure that argc does not exceed max_args
       for (int i = 0; i < argc; ++i) {
-        m_argtypes.push_back (CLASS_OF (argv[i]));
+        m_argtypes [i] = CLASS_OF (argv[i]);
+        //  const objects can't be passed to non-const references or pointers, hence
+        //  the constness of object arguments takes part in the resolution
+        if (TYPE (argv[i]) == T_DATA) {
+          Proxy *p = 0;
+          Data_Get_Struct (argv[i], Proxy, p);
+          if (p->const_ref ()) {
+            m_const_args |= (1u << i);
+          }
+        }
       }
     }
 
     bool operator== (const MethodVariantKey &other) const
     {
-      return m_argtypes == other.m_argtypes &&
-             m_block_given == other.m_block_given &&
-             m_is_ctor == other.m_is_ctor &&
-             m_is_static == other.m_is_static &&
-             m_is_const == other.m_is_const;
+      if (m_argc != other.m_argc ||
+          m_const_args != other.m_const_args ||
+          m_block_given != other.m_block_given ||
+          m_is_ctor != other.m_is_ctor ||
+          m_is_static != other.m_is_static ||
+          m_is_const != other.m_is_const) {
+        return false;
+      }
+      for (unsigned int i = 0; i < m_argc; ++i) {
+        if (m_argtypes [i] != other.m_argtypes [i]) {
+          return false;
+        }
+      }
+      return true;
     }
 
     bool operator< (const MethodVariantKey &other) const
     {
-      if (m_argtypes != other.m_argtypes) {
-        return m_argtypes < other.m_argtypes;
+      if (m_argc != other.m_argc) {
+        return m_argc < other.m_argc;
+      }
+      for (unsigned int i = 0; i < m_argc; ++i) {
+        if (m_argtypes [i] != other.m_argtypes [i]) {
+          return m_argtypes [i] < other.m_argtypes [i];
+        }
+      }
+      if (m_const_args != other.m_const_args) {
+        return m_const_args < other.m_const_args;
       }
       if (m_block_given != other.m_block_given) {
         return m_block_given < other.m_block_given;
@@ -198,7 +230,9 @@ public:
     }
 
   private:
-    std::vector<size_t> m_argtypes;
+    size_t m_argtypes [max_args];
+    unsigned int m_argc;
+    unsigned int m_const_args;
     bool m_block_given;
     bool m_is_ctor;
     bool m_is_static;
@@ -206,7 +240,7 @@ public:
   };
 
   MethodTableEntry (const std::string &name, bool ctor, bool st, bool prot, bool signal)
-    : m_name (name), m_is_ctor (ctor), m_is_static (st), m_is_protected (prot), m_is_signal (signal)
+    : m_name (name), m_is_ctor (ctor), m_is_static (st), m_is_protected (prot), m_is_signal (signal), m_has_last_variant (false), mp_last_variant (0)
   { }
 
   const std::string &name () const
@@ -259,6 +293,12 @@ public:
 
   const gsi::MethodBase *get_variant (int argc, VALUE *argv, bool block_given, bool is_ctor, bool is_static, bool is_const) const
   {
+    //  without overloads, the resolution is cheap and there is nothing to cache
+
+    if (m_methods.size () <= 1 || argc > int (MethodVariantKey::max_args)) {
+      return find_variant (argc, argv, block_given, is_ctor, is_static, is_const);
+    }
+
     //  caching can't work for arrays or hashes - in this case, give up
 
     for (int i = 0; i < argc; ++i) {
@@ -268,17 +308,23 @@ public:
       }
     }
 
-    //  try to find the variant in the cache
+    //  try to find the variant in the cache - tight loops usually call the same variant again
 
     MethodVariantKey key (argc, argv, block_given, is_ctor, is_static, is_const);
+    if (m_has_last_variant && m_last_key == key) {
+      return mp_last_variant;
+    }
+
     std::map<MethodVariantKey, const gsi::MethodBase *>::const_iterator v = m_variants.find (key);
-    if (v != m_variants.end ()) {
-      return v->second;
+    if (v == m_variants.end ()) {
+      v = m_variants.insert (std::make_pair (key, find_variant (argc, argv, block_given, is_ctor, is_static, is_const))).first;
     }
 
-    const gsi::MethodBase *meth = find_variant (argc, argv, block_given, is_ctor, is_static, is_const);
-    m_variants[key] = meth;
-    return meth;
+    m_last_key = key;
+    mp_last_variant = v->second;
+    m_has_last_variant = true;
+
+    return v->second;
   }
 
 private:
@@ -435,6 +481,9 @@ private:
   bool m_is_signal : 1;
   std::vector<const gsi::MethodBase *> m_methods;
   mutable std::map<MethodVariantKey, const gsi::MethodBase *> m_variants;
+  mutable MethodVariantKey m_last_key;
+  mutable bool m_has_last_variant;
+  mutable const gsi::MethodBase *mp_last_variant;
 };
 
 /**
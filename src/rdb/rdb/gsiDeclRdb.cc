@@ -48,7 +48,7 @@ namespace gsi
 class ItemRefUnwrappingIterator
 {
 public:
-  typedef rdb::Database::const_item_ref_iterator::iterator_category iterator_category;
+  typedef std::forward_iterator_tag iterator_category;
   typedef rdb::Database::const_item_ref_iterator::difference_type difference_type;
   typedef rdb::Item value_type;
   typedef const rdb::Item &reference;
@@ -43,6 +43,7 @@
 
 #include <limits>
 #include <memory>
+#include <algorithm>
 
 namespace rdb
 {
@@ -832,30 +833,31 @@ Item &Item::operator= (const Item &d)
 void 
 Item::add_tag (id_type tag_id)
 {
-  if (m_tag_ids.size () <= tag_id) {
-    m_tag_ids.resize (tag_id + 1, false);
+  std::vector<id_type>::iterator t = std::lower_bound (m_tag_ids.begin (), m_tag_ids.end (), tag_id);
+  if (t == m_tag_ids.end () || *t != tag_id) {
+    m_tag_ids.insert (t, tag_id);
   }
-  m_tag_ids [tag_id] = true;
 }
 
 void 
 Item::remove_tag (id_type tag_id)
 {
-  if (m_tag_ids.size () > tag_id) {
-    m_tag_ids [tag_id] = false;
+  std::vector<id_type>::iterator t = std::lower_bound (m_tag_ids.begin (), m_tag_ids.end (), tag_id);
+  if (t != m_tag_ids.end () && *t == tag_id) {
+    m_tag_ids.erase (t);
   }
 }
 
 void 
 Item::remove_tags ()
 {
-  m_tag_ids = std::vector <bool> ();
+  m_tag_ids = std::vector <id_type> ();
 }
 
 bool 
 Item::has_tag (id_type tag_id) const
 {
-  return m_tag_ids.size () > tag_id && m_tag_ids [tag_id];
+  return std::binary_search (m_tag_ids.begin (), m_tag_ids.end (), tag_id);
 }
 
 std::string 
@@ -906,22 +908,15 @@ Item::tag_str () const
   std::string r;
   r.reserve (200);
 
-  if (! m_tag_ids.empty ()) {
-
-    id_type tag_id = 0;
-    for (std::vector<bool>::const_iterator t = m_tag_ids.begin (); t != m_tag_ids.end (); ++t, ++tag_id) {
-      if (*t) {
-        if (! r.empty ()) {
-          r += ",";
-        }
-        const Tag &tag = mp_database->tags ().tag (tag_id);
-        if (tag.is_user_tag ()) {
-          r += "#";
-        }
-        r += tl::to_word_or_quoted_string (tag.name ());
-      }
+  for (std::vector<id_type>::const_iterator t = m_tag_ids.begin (); t != m_tag_ids.end (); ++t) {
+    if (! r.empty ()) {
+      r += ",";
     }
-
+    const Tag &tag = mp_database->tags ().tag (*t);
+    if (tag.is_user_tag ()) {
+      r += "#";
+    }
+    r += tl::to_word_or_quoted_string (tag.name ());
   }
 
   return r;
@@ -1060,14 +1055,14 @@ Database::set_items (Items *items)
 
       cell->add_to_num_items (1);
 
-      m_items_by_cell_id.insert (std::make_pair (cell_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (&*i));
+      m_items_by_cell_id.insert (std::make_pair (cell_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (&*i));
 
       if (i->visited ()) {
         cell->add_to_num_items_visited (1);
       }
 
-      m_items_by_category_id.insert (std::make_pair (category_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (&*i));
-      m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::list<ItemRef> ())).first->second.push_back (ItemRef (&*i));
+      m_items_by_category_id.insert (std::make_pair (category_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (&*i));
+      m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::vector<ItemRef> ())).first->second.push_back (ItemRef (&*i));
 
       while (category) {
 
@@ -1384,45 +1379,45 @@ Database::create_item (id_type cell_id, id_type category_id)
   item->set_cell_id (cell_id);
   item->set_category_id (category_id);
 
-  m_items_by_cell_id.insert (std::make_pair (cell_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (item));
-  m_items_by_category_id.insert (std::make_pair (category_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (item));
-  m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::list<ItemRef> ())).first->second.push_back (ItemRef (item));
+  m_items_by_cell_id.insert (std::make_pair (cell_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (item));
+  m_items_by_category_id.insert (std::make_pair (category_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (item));
+  m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::vector<ItemRef> ())).first->second.push_back (ItemRef (item));
 
   return item;
 }
 
-static std::list<ItemRef> empty_list;
+static std::vector<ItemRef> empty_list;
 
 std::pair<Database::const_item_ref_iterator, Database::const_item_ref_iterator> 
 Database::items_by_cell_and_category (id_type cell_id, id_type category_id) const
 {
-  std::map <std::pair <id_type, id_type>, std::list<ItemRef> >::const_iterator i = m_items_by_cell_and_category_id.find (std::make_pair (cell_id, category_id));
+  std::map <std::pair <id_type, id_type>, std::vector<ItemRef> >::const_iterator i = m_items_by_cell_and_category_id.find (std::make_pair (cell_id, category_id));
   if (i != m_items_by_cell_and_category_id.end ()) {
-    return std::make_pair (i->second.begin (), i->second.end ());
+    return std::make_pair (const_item_ref_iterator (&i->second, 0), const_item_ref_iterator (&i->second, i->second.size ()));
   } else {
-    return std::make_pair (empty_list.begin (), empty_list.end ());
+    return std::make_pair (const_item_ref_iterator (&empty_list, 0), const_item_ref_iterator (&empty_list, 0));
   }
 }
 
 std::pair<Database::const_item_ref_iterator, Database::const_item_ref_iterator> 
 Database::items_by_cell (id_type cell_id) const
 {
-  std::map <id_type, std::list<ItemRef> >::const_iterator i = m_items_by_cell_id.find (cell_id);
+  std::map <id_type, std::vector<ItemRef> >::const_iterator i = m_items_by_cell_id.find (cell_id);
   if (i != m_items_by_cell_id.end ()) {
-    return std::make_pair (i->second.begin (), i->second.end ());
+    return std::make_pair (const_item_ref_iterator (&i->second, 0), const_item_ref_iterator (&i->second, i->second.size ()));
   } else {
-    return std::make_pair (empty_list.begin (), empty_list.end ());
+    return std::make_pair (const_item_ref_iterator (&empty_list, 0), const_item_ref_iterator (&empty_list, 0));
   }
 }
 
 std::pair<Database::const_item_ref_iterator, Database::const_item_ref_iterator> 
 Database::items_by_category (id_type category_id) const
 {
-  std::map <id_type, std::list<ItemRef> >::const_iterator i = m_items_by_category_id.find (category_id);
+  std::map <id_type, std::vector<ItemRef> >::const_iterator i = m_items_by_category_id.find (category_id);
   if (i != m_items_by_category_id.end ()) {
-    return std::make_pair (i->second.begin (), i->second.end ());
+    return std::make_pair (const_item_ref_iterator (&i->second, 0), const_item_ref_iterator (&i->second, i->second.size ()));
   } else {
-    return std::make_pair (empty_list.begin (), empty_list.end ());
+    return std::make_pair (const_item_ref_iterator (&empty_list, 0), const_item_ref_iterator (&empty_list, 0));
   }
 }
 
@@ -33,9 +33,11 @@
 
 #include <string>
 #include <list>
+#include <deque>
 #include <map>
 #include <set>
 #include <vector>
+#include <iterator>
 
 #if defined(HAVE_QT)
 class QImage;
@@ -735,6 +737,7 @@ public:
   void from_string (Database *rdb, const std::string &s);  
 
 private:
+  //  NOTE: a list, so values can be added while iterating and value references stay valid
   std::list <ValueWrapper> m_values;
 };
 
@@ -920,6 +923,14 @@ public:
    */
   bool has_tag (id_type tag_id) const;
 
+  /**
+   *  @brief Get the ids of the tags of this item (sorted by id)
+   */
+  const std::vector<id_type> &tag_ids () const
+  {
+    return m_tag_ids;
+  }
+
   /**
    *  @brief Get the tags for this item by string
    */
@@ -987,7 +998,8 @@ private:
   id_type m_category_id;
   size_t m_multiplicity;
   bool m_visited;
-  std::vector <bool> m_tag_ids;
+  //  sorted list of tag ids (most items carry no or only a few tags)
+  std::vector <id_type> m_tag_ids;
   Database *mp_database;
 #if defined(HAVE_QT)
   std::auto_ptr<QImage> mp_image;
@@ -1059,16 +1071,111 @@ public:
   Item *mp_item;
 };
 
+/**
+ *  @brief An iterator addressing the elements of a container by index
+ *
+ *  In contrast to the iterators of std::deque and std::vector, this iterator
+ *  stays valid when elements are appended to the container. Hence items can
+ *  be created while iterating over the items (i.e. from scripts).
+ *  Elements appended after the end iterator was taken are not visited.
+ */
+template <class C, class V>
+class index_iterator
+{
+public:
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef std::ptrdiff_t difference_type;
+  typedef V value_type;
+  typedef V &reference;
+  typedef V *pointer;
+
+  index_iterator ()
+    : mp_container (0), m_index (0)
+  { }
+
+  index_iterator (C *container, size_t index)
+    : mp_container (container), m_index (index)
+  { }
+
+  template <class C2, class V2>
+  index_iterator (const index_iterator<C2, V2> &d)
+    : mp_container (d.container ()), m_index (d.index ())
+  { }
+
+  bool operator== (const index_iterator &d) const
+  {
+    return m_index == d.m_index;
+  }
+
+  bool operator!= (const index_iterator &d) const
+  {
+    return m_index != d.m_index;
+  }
+
+  index_iterator &operator++ ()
+  {
+    ++m_index;
+    return *this;
+  }
+
+  index_iterator operator++ (int)
+  {
+    index_iterator i (*this);
+    ++m_index;
+    return i;
+  }
+
+  index_iterator &operator-- ()
+  {
+    --m_index;
+    return *this;
+  }
+
+  index_iterator operator-- (int)
+  {
+    index_iterator i (*this);
+    --m_index;
+    return i;
+  }
+
+  V &operator* () const
+  {
+    return (*mp_container) [m_index];
+  }
+
+  V *operator-> () const
+  {
+    return &(*mp_container) [m_index];
+  }
+
+  C *container () const
+  {
+    return mp_container;
+  }
+
+  size_t index () const
+  {
+    return m_index;
+  }
+
+private:
+  C *mp_container;
+  size_t m_index;
+};
+
 /**
  *  @brief A container for items
  *
  *  This container is owned by the database.
+ *  The items are stored in chunks of contiguous memory. Items are only appended,
+ *  hence their addresses do not change and item references stay valid.
+ *  The iterators address the items by index, so they stay valid too.
  */
 class RDB_PUBLIC Items
 {
 public:
-  typedef std::list<Item>::const_iterator const_iterator;
-  typedef std::list<Item>::iterator iterator;
+  typedef index_iterator<const std::deque<Item>, const Item> const_iterator;
+  typedef index_iterator<std::deque<Item>, Item> iterator;
 
   /**
    *  @brief Construct an item list with a database reference
@@ -1084,7 +1191,7 @@ public:
    */
   const_iterator begin () const 
   { 
-    return m_items.begin (); 
+    return const_iterator (&m_items, 0);
   }
 
   /**
@@ -1092,7 +1199,7 @@ public:
    */
   const_iterator end () const 
   { 
-    return m_items.end (); 
+    return const_iterator (&m_items, m_items.size ());
   }
 
   /**
@@ -1100,7 +1207,7 @@ public:
    */
   iterator begin ()
   { 
-    return m_items.begin (); 
+    return iterator (&m_items, 0);
   }
 
   /**
@@ -1108,7 +1215,7 @@ public:
    */
   iterator end ()
   { 
-    return m_items.end (); 
+    return iterator (&m_items, m_items.size ());
   }
 
   /**
@@ -1144,7 +1251,7 @@ private:
   friend class Cell;
   friend class Database;
 
-  std::list <Item> m_items;
+  std::deque <Item> m_items;
   Database *mp_database;
 
   Items (const Items &d);
@@ -1912,8 +2019,8 @@ class RDB_PUBLIC Database
 public:
   typedef Items::const_iterator const_item_iterator;
   typedef Items::iterator item_iterator;
-  typedef std::list<ItemRef>::const_iterator const_item_ref_iterator;
-  typedef std::list<ItemRef>::iterator item_ref_iterator;
+  typedef index_iterator<const std::vector<ItemRef>, const ItemRef> const_item_ref_iterator;
+  typedef index_iterator<std::vector<ItemRef>, ItemRef> item_ref_iterator;
   typedef Cells::const_iterator const_cell_iterator;
   typedef Cells::iterator cell_iterator;
 
@@ -2298,11 +2405,11 @@ private:
   std::map <std::string, std::vector <id_type> > m_cell_variants;
   std::map <id_type, Cell *> m_cells_by_id;
   std::map <id_type, Category *> m_categories_by_id;
-  std::map <std::pair <id_type, id_type>, std::list<ItemRef> > m_items_by_cell_and_category_id;
+  std::map <std::pair <id_type, id_type>, std::vector<ItemRef> > m_items_by_cell_and_category_id;
   std::map <std::pair <id_type, id_type>, size_t> m_num_items_by_cell_and_category;
   std::map <std::pair <id_type, id_type>, size_t> m_num_items_visited_by_cell_and_category;
-  std::map <id_type, std::list<ItemRef> > m_items_by_cell_id;
-  std::map <id_type, std::list<ItemRef> > m_items_by_category_id;
+  std::map <id_type, std::vector<ItemRef> > m_items_by_cell_id;
+  std::map <id_type, std::vector<ItemRef> > m_items_by_category_id;
   Items *mp_items;
   Cells m_cells;
   size_t m_num_items;
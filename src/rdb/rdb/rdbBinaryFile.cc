@@ -0,0 +1,694 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "rdb.h"
+#include "rdbBinaryFile.h"
+#include "rdbReader.h"
+
+#include "tlTimer.h"
+#include "tlProgress.h"
+#include "tlClassRegistry.h"
+#include "dbPolygon.h"
+#include "dbEdge.h"
+#include "dbEdgePair.h"
+#include "dbBox.h"
+#include "dbPath.h"
+
+#include <cstring>
+#include <map>
+#include <algorithm>
+#include <stdint.h>
+
+namespace rdb
+{
+
+const char *binary_rdb_file_format = "KLayout binary RDB files (*.lyrdbb *.lyrdbb.gz)";
+
+//  The file starts with this magic string (without the terminating 0) followed by the version
+static const char binary_rdb_magic [] = "KLayout-RDB-binary\n";
+static const size_t binary_rdb_version = 1;
+
+//  Sanity limit for counts and string lengths and the chunk size in which such data is read.
+//  Reading in chunks makes sure that corrupt files can't make the reader allocate more memory
+//  than there is data.
+static const size_t max_count = size_t (1) << 31;
+static const size_t chunk_size = 65536;
+
+/**
+ *  @brief The record types of the binary format
+ *
+ *  Each record starts with the record type byte. Ids of tags, categories and cells
+ *  refer to the ids of the database written. The reader maps them to its own ids.
+ */
+enum BinaryRecordType
+{
+  RecordEnd = 0,          //  no payload
+  RecordHeader = 1,       //  description, original file, generator, top cell (strings)
+  RecordTag = 2,          //  id, name, user tag flag (byte), description
+  RecordCategory = 3,     //  id, parent id (0 for top level categories), name, description
+  RecordCell = 4,         //  id, name, variant
+  RecordReference = 5,    //  cell id, parent cell id, displacement (2 doubles), magnification, angle, mirror flag (byte)
+  RecordItem = 6          //  cell id, category id, flags, multiplicity, tag ids, values, image
+};
+
+/**
+ *  @brief The value types of the binary format
+ *
+ *  Each value starts with the tag id and the value type byte. Values without a
+ *  binary representation are stored in their string form.
+ */
+enum BinaryValueType
+{
+  ValueString = 0,        //  generic value in string form (see ValueBase::to_string)
+  ValueDouble = 1,
+  ValueText = 2,          //  a std::string value
+  ValuePolygon = 3,       //  hull points, number of holes, hole points
+  ValueEdge = 4,
+  ValueEdgePair = 5,
+  ValueBox = 6,           //  non-empty boxes only
+  ValuePath = 7           //  width, begin and end extension, round flag (byte), points
+};
+
+const unsigned int item_flag_visited = 1;
+
+// -------------------------------------------------------------
+//  BinaryWriter implementation
+
+BinaryWriter::BinaryWriter (tl::OutputStream &stream)
+  : m_stream (stream)
+{
+  //  .. nothing yet ..
+}
+
+void
+BinaryWriter::write (const rdb::Database &db)
+{
+  m_stream.put (binary_rdb_magic, sizeof (binary_rdb_magic) - 1);
+  write_uint (binary_rdb_version);
+
+  write_byte (RecordHeader);
+  write_string (db.description ());
+  write_string (db.original_file ());
+  write_string (db.generator ());
+  write_string (db.top_cell_name ());
+
+  for (rdb::Tags::const_iterator t = db.tags ().begin_tags (); t != db.tags ().end_tags (); ++t) {
+    write_byte (RecordTag);
+    write_uint (t->id ());
+    write_string (t->name ());
+    write_byte (t->is_user_tag () ? 1 : 0);
+    write_string (t->description ());
+  }
+
+  write_categories (db.categories (), 0);
+
+  for (rdb::Cells::const_iterator c = db.cells ().begin (); c != db.cells ().end (); ++c) {
+    write_byte (RecordCell);
+    write_uint (c->id ());
+    write_string (c->name ());
+    write_string (c->variant ());
+  }
+
+  //  references are written after the cells, so the parent cells are known when reading them
+  for (rdb::Cells::const_iterator c = db.cells ().begin (); c != db.cells ().end (); ++c) {
+    for (rdb::Cell::reference_iterator r = c->references ().begin (); r != c->references ().end (); ++r) {
+      write_byte (RecordReference);
+      write_uint (c->id ());
+      write_uint (r->parent_cell_id ());
+      write_double (r->trans ().disp ().x ());
+      write_double (r->trans ().disp ().y ());
+      write_double (r->trans ().mag ());
+      write_double (r->trans ().angle ());
+      write_byte (r->trans ().is_mirror () ? 1 : 0);
+    }
+  }
+
+  for (rdb::Items::const_iterator i = db.items ().begin (); i != db.items ().end (); ++i) {
+    write_item (*i);
+  }
+
+  write_byte (RecordEnd);
+}
+
+void
+BinaryWriter::write_categories (const rdb::Categories &categories, id_type parent_id)
+{
+  for (rdb::Categories::const_iterator c = categories.begin (); c != categories.end (); ++c) {
+    write_byte (RecordCategory);
+    write_uint (c->id ());
+    write_uint (parent_id);
+    write_string (c->name ());
+    write_string (c->description ());
+    write_categories (c->sub_categories (), c->id ());
+  }
+}
+
+void
+BinaryWriter::write_item (const rdb::Item &item)
+{
+  write_byte (RecordItem);
+  write_uint (item.cell_id ());
+  write_uint (item.category_id ());
+  write_uint (item.visited () ? item_flag_visited : 0);
+  write_uint (item.multiplicity ());
+
+  write_uint (item.tag_ids ().size ());
+  for (std::vector<id_type>::const_iterator t = item.tag_ids ().begin (); t != item.tag_ids ().end (); ++t) {
+    write_uint (*t);
+  }
+
+  size_t nvalues = 0;
+  for (rdb::Values::const_iterator v = item.values ().begin (); v != item.values ().end (); ++v) {
+    if (v->get ()) {
+      ++nvalues;
+    }
+  }
+
+  write_uint (nvalues);
+  for (rdb::Values::const_iterator v = item.values ().begin (); v != item.values ().end (); ++v) {
+    if (v->get ()) {
+      write_value (*v);
+    }
+  }
+
+#if defined(HAVE_QT)
+  write_string (item.image_str ());
+#else
+  write_string (std::string ());
+#endif
+}
+
+void
+BinaryWriter::write_value (const rdb::ValueWrapper &value)
+{
+  write_uint (value.tag_id ());
+
+  const rdb::ValueBase *v = value.get ();
+  int ti = v->type_index ();
+
+  if (ti == type_index_of<double> ()) {
+
+    write_byte (ValueDouble);
+    write_double (static_cast<const rdb::Value<double> *> (v)->value ());
+
+  } else if (ti == type_index_of<std::string> ()) {
+
+    write_byte (ValueText);
+    write_string (static_cast<const rdb::Value<std::string> *> (v)->value ());
+
+  } else if (ti == type_index_of<db::DPolygon> ()) {
+
+    const db::DPolygon &poly = static_cast<const rdb::Value<db::DPolygon> *> (v)->value ();
+
+    write_byte (ValuePolygon);
+    write_uint (poly.hull ().size ());
+    for (size_t i = 0; i < poly.hull ().size (); ++i) {
+      write_point (poly.hull () [i]);
+    }
+    write_uint (poly.holes ());
+    for (unsigned int h = 0; h < poly.holes (); ++h) {
+      write_uint (poly.hole (h).size ());
+      for (size_t i = 0; i < poly.hole (h).size (); ++i) {
+        write_point (poly.hole (h) [i]);
+      }
+    }
+
+  } else if (ti == type_index_of<db::DEdge> ()) {
+
+    const db::DEdge &edge = static_cast<const rdb::Value<db::DEdge> *> (v)->value ();
+
+    write_byte (ValueEdge);
+    write_point (edge.p1 ());
+    write_point (edge.p2 ());
+
+  } else if (ti == type_index_of<db::DEdgePair> ()) {
+
+    const db::DEdgePair &ep = static_cast<const rdb::Value<db::DEdgePair> *> (v)->value ();
+
+    write_byte (ValueEdgePair);
+    write_point (ep.first ().p1 ());
+    write_point (ep.first ().p2 ());
+    write_point (ep.second ().p1 ());
+    write_point (ep.second ().p2 ());
+
+  } else if (ti == type_index_of<db::DBox> () && ! static_cast<const rdb::Value<db::DBox> *> (v)->value ().empty ()) {
+
+    const db::DBox &box = static_cast<const rdb::Value<db::DBox> *> (v)->value ();
+
+    write_byte (ValueBox);
+    write_point (box.p1 ());
+    write_point (box.p2 ());
+
+  } else if (ti == type_index_of<db::DPath> ()) {
+
+    const db::DPath &path = static_cast<const rdb::Value<db::DPath> *> (v)->value ();
+
+    write_byte (ValuePath);
+    write_double (path.width ());
+    write_double (path.bgn_ext ());
+    write_double (path.end_ext ());
+    write_byte (path.round () ? 1 : 0);
+    write_uint (path.points ());
+    for (db::DPath::iterator p = path.begin (); p != path.end (); ++p) {
+      write_point (*p);
+    }
+
+  } else {
+
+    write_byte (ValueString);
+    write_string (v->to_string ());
+
+  }
+}
+
+void
+BinaryWriter::write_byte (unsigned char b)
+{
+  m_stream.put ((const char *) &b, 1);
+}
+
+void
+BinaryWriter::write_uint (size_t n)
+{
+  //  7 bits per byte, the high bit indicates that more bytes follow
+  char b [16];
+  size_t l = 0;
+  do {
+    b [l] = char (n & 0x7f);
+    n >>= 7;
+    if (n != 0) {
+      b [l] |= char (0x80);
+    }
+    ++l;
+  } while (n != 0);
+
+  m_stream.put (b, l);
+}
+
+void
+BinaryWriter::write_double (double d)
+{
+  //  IEEE 754, little endian
+  uint64_t u = 0;
+  memcpy (&u, &d, sizeof (u));
+
+  char b [8];
+  for (unsigned int i = 0; i < 8; ++i) {
+    b [i] = char (u & 0xff);
+    u >>= 8;
+  }
+
+  m_stream.put (b, sizeof (b));
+}
+
+void
+BinaryWriter::write_string (const std::string &s)
+{
+  write_uint (s.size ());
+  m_stream.put (s.c_str (), s.size ());
+}
+
+void
+BinaryWriter::write_point (const db::DPoint &p)
+{
+  write_double (p.x ());
+  write_double (p.y ());
+}
+
+// -------------------------------------------------------------
+//  The binary format reader
+
+class BinaryReader
+  : public ReaderBase
+{
+public:
+  BinaryReader (tl::InputStream &stream)
+    : m_input_stream (stream),
+      m_progress (tl::to_string (tr ("Reading binary RDB")), 10000)
+  {
+    m_progress.set_format (tl::to_string (tr ("%.0f MB")));
+    m_progress.set_unit (1024 * 1024);
+  }
+
+  virtual void read (Database &db)
+  {
+    tl::SelfTimer timer (tl::verbosity () >= 11, "Reading binary marker database file");
+
+    //  skip the magic bytes
+    get (sizeof (binary_rdb_magic) - 1);
+
+    size_t version = get_uint ();
+    if (version > binary_rdb_version) {
+      error (tl::sprintf (tl::to_string (tr ("Unsupported binary RDB version %lu")), version));
+    }
+
+    bool at_end = false;
+    while (! at_end) {
+
+      unsigned char rec = get_byte ();
+
+      if (rec == RecordEnd) {
+
+        at_end = true;
+
+      } else if (rec == RecordHeader) {
+
+        db.set_description (get_string ());
+        db.set_original_file (get_string ());
+        db.set_generator (get_string ());
+        db.set_top_cell_name (get_string ());
+
+      } else if (rec == RecordTag) {
+
+        id_type id = get_uint ();
+        std::string name = get_string ();
+        bool user_tag = (get_byte () != 0);
+        std::string description = get_string ();
+
+        id_type tag_id = db.tags ().tag (name, user_tag).id ();
+        db.set_tag_description (tag_id, description);
+        map_id (m_tag_ids, id, tag_id);
+
+      } else if (rec == RecordCategory) {
+
+        id_type id = get_uint ();
+        id_type parent_id = get_uint ();
+        std::string name = get_string ();
+
+        Category *cat = 0;
+        if (parent_id == 0) {
+          cat = db.create_category (name);
+        } else {
+          Category *parent = const_cast<Category *> (db.category_by_id (mapped_id (m_category_ids, parent_id)));
+          if (! parent) {
+            error (tl::to_string (tr ("Invalid parent category in binary RDB")));
+          }
+          cat = db.create_category (parent, name);
+        }
+
+        cat->set_description (get_string ());
+        map_id (m_category_ids, id, cat->id ());
+
+      } else if (rec == RecordCell) {
+
+        id_type id = get_uint ();
+        std::string name = get_string ();
+        std::string variant = get_string ();
+
+        Cell *cell = db.create_cell (name, variant);
+        map_id (m_cell_ids, id, cell->id ());
+
+      } else if (rec == RecordReference) {
+
+        Cell *cell = const_cast<Cell *> (db.cell_by_id (mapped_id (m_cell_ids, get_uint ())));
+        id_type parent_id = mapped_id (m_cell_ids, get_uint ());
+        if (! cell || ! db.cell_by_id (parent_id)) {
+          error (tl::to_string (tr ("Invalid cell in binary RDB reference")));
+        }
+
+        db::DPoint d = get_point ();
+        double mag = get_double ();
+        double angle = get_double ();
+        bool mirror = (get_byte () != 0);
+
+        cell->references ().insert (Reference (db::DCplxTrans (mag, angle, mirror, d - db::DPoint ()), parent_id));
+
+      } else if (rec == RecordItem) {
+
+        read_item (db);
+        m_progress.set (m_input_stream.pos ());
+
+      } else {
+        error (tl::sprintf (tl::to_string (tr ("Invalid record type %d in binary RDB")), int (rec)));
+      }
+
+    }
+  }
+
+  virtual const char *format () const
+  {
+    return "KLayout-RDB-binary";
+  }
+
+private:
+  tl::InputStream &m_input_stream;
+  tl::AbsoluteProgress m_progress;
+  std::map<id_type, id_type> m_tag_ids, m_category_ids, m_cell_ids;
+
+  void read_item (Database &db)
+  {
+    id_type cell_id = mapped_id (m_cell_ids, get_uint ());
+    id_type category_id = mapped_id (m_category_ids, get_uint ());
+    if (! db.cell_by_id (cell_id) || ! db.category_by_id (category_id)) {
+      error (tl::to_string (tr ("Invalid cell or category in binary RDB item")));
+    }
+
+    Item *item = db.create_item (cell_id, category_id);
+
+    size_t flags = get_uint ();
+    item->set_multiplicity (get_uint ());
+
+    size_t ntags = get_count ();
+    for (size_t i = 0; i < ntags; ++i) {
+      db.add_item_tag (item, mapped_id (m_tag_ids, get_uint ()));
+    }
+
+    size_t nvalues = get_count ();
+    for (size_t i = 0; i < nvalues; ++i) {
+      id_type tag_id = get_uint ();
+      item->values ().add (read_value (), tag_id > 0 ? mapped_id (m_tag_ids, tag_id) : 0);
+    }
+
+#if defined(HAVE_QT)
+    std::string image = get_string ();
+    if (! image.empty ()) {
+      item->set_image_str (image);
+    }
+#else
+    get_string ();
+#endif
+
+    //  set the visited flag through the database, so the visited counts are maintained
+    if ((flags & item_flag_visited) != 0) {
+      db.set_item_visited (item, true);
+    }
+  }
+
+  ValueBase *read_value ()
+  {
+    unsigned char type = get_byte ();
+
+    if (type == ValueDouble) {
+
+      return new Value<double> (get_double ());
+
+    } else if (type == ValueText) {
+
+      return new Value<std::string> (get_string ());
+
+    } else if (type == ValuePolygon) {
+
+      db::DPolygon poly;
+
+      std::vector<db::DPoint> pts;
+      get_points (pts);
+      poly.assign_hull (pts.begin (), pts.end (), false);
+
+      size_t nholes = get_count ();
+      for (size_t h = 0; h < nholes; ++h) {
+        get_points (pts);
+        poly.insert_hole (pts.begin (), pts.end (), false);
+      }
+
+      return new Value<db::DPolygon> (poly);
+
+    } else if (type == ValueEdge) {
+
+      db::DPoint p1 = get_point ();
+      db::DPoint p2 = get_point ();
+      return new Value<db::DEdge> (db::DEdge (p1, p2));
+
+    } else if (type == ValueEdgePair) {
+
+      db::DPoint p1 = get_point ();
+      db::DPoint p2 = get_point ();
+      db::DPoint p3 = get_point ();
+      db::DPoint p4 = get_point ();
+      return new Value<db::DEdgePair> (db::DEdgePair (db::DEdge (p1, p2), db::DEdge (p3, p4)));
+
+    } else if (type == ValueBox) {
+
+      db::DPoint p1 = get_point ();
+      db::DPoint p2 = get_point ();
+      return new Value<db::DBox> (db::DBox (p1, p2));
+
+    } else if (type == ValuePath) {
+
+      db::DPath path;
+      path.width (get_double ());
+      path.bgn_ext (get_double ());
+      path.end_ext (get_double ());
+      path.round (get_byte () != 0);
+
+      std::vector<db::DPoint> pts;
+      get_points (pts);
+      path.assign (pts.begin (), pts.end ());
+
+      return new Value<db::DPath> (path);
+
+    } else if (type == ValueString) {
+
+      return ValueBase::create_from_string (get_string ());
+
+    } else {
+      error (tl::sprintf (tl::to_string (tr ("Invalid value type %d in binary RDB")), int (type)));
+      return 0;
+    }
+  }
+
+  static void map_id (std::map<id_type, id_type> &map, id_type from, id_type to)
+  {
+    map [from] = to;
+  }
+
+  static id_type mapped_id (const std::map<id_type, id_type> &map, id_type from)
+  {
+    std::map<id_type, id_type>::const_iterator i = map.find (from);
+    return i != map.end () ? i->second : 0;
+  }
+
+  void error (const std::string &msg)
+  {
+    throw ReaderException (tl::sprintf (tl::to_string (tr ("%s (position %lu)")), msg, m_input_stream.pos ()));
+  }
+
+  const char *get (size_t n)
+  {
+    const char *b = m_input_stream.get (n);
+    if (! b) {
+      error (tl::to_string (tr ("Unexpected end of file in binary RDB")));
+    }
+    return b;
+  }
+
+  unsigned char get_byte ()
+  {
+    return (unsigned char) *get (1);
+  }
+
+  size_t get_uint ()
+  {
+    size_t n = 0;
+    unsigned int shift = 0;
+
+    unsigned char b;
+    do {
+      b = get_byte ();
+      if (shift >= sizeof (size_t) * 8) {
+        error (tl::to_string (tr ("Integer overflow in binary RDB")));
+      }
+      n |= size_t (b & 0x7f) << shift;
+      shift += 7;
+    } while ((b & 0x80) != 0);
+
+    return n;
+  }
+
+  double get_double ()
+  {
+    const unsigned char *b = (const unsigned char *) get (8);
+
+    uint64_t u = 0;
+    for (unsigned int i = 8; i > 0; --i) {
+      u = (u << 8) | uint64_t (b [i - 1]);
+    }
+
+    double d = 0.0;
+    memcpy (&d, &u, sizeof (d));
+    return d;
+  }
+
+  size_t get_count ()
+  {
+    size_t n = get_uint ();
+    if (n > max_count) {
+      error (tl::sprintf (tl::to_string (tr ("Invalid count or length %lu in binary RDB")), n));
+    }
+    return n;
+  }
+
+  std::string get_string ()
+  {
+    std::string s;
+
+    size_t n = get_count ();
+    while (n > 0) {
+      size_t nc = std::min (n, chunk_size);
+      s.append (get (nc), nc);
+      n -= nc;
+    }
+
+    return s;
+  }
+
+  db::DPoint get_point ()
+  {
+    double x = get_double ();
+    double y = get_double ();
+    return db::DPoint (x, y);
+  }
+
+  void get_points (std::vector<db::DPoint> &pts)
+  {
+    pts.clear ();
+    size_t n = get_count ();
+    pts.reserve (std::min (n, chunk_size));
+    for (size_t i = 0; i < n; ++i) {
+      pts.push_back (get_point ());
+    }
+  }
+};
+
+class BinaryFormatDeclaration
+  : public FormatDeclaration
+{
+  virtual std::string format_name () const { return "KLayout-RDB-binary"; }
+  virtual std::string format_desc () const { return "KLayout binary report database format"; }
+  virtual std::string file_format () const { return binary_rdb_file_format; }
+
+  virtual bool detect (tl::InputStream &stream) const
+  {
+    const char *b = stream.get (sizeof (binary_rdb_magic) - 1);
+    return b && strncmp (b, binary_rdb_magic, sizeof (binary_rdb_magic) - 1) == 0;
+  }
+
+  virtual ReaderBase *create_reader (tl::InputStream &s) const
+  {
+    return new BinaryReader (s);
+  }
+};
+
+static tl::RegisteredClass<rdb::FormatDeclaration> format_decl (new BinaryFormatDeclaration (), 0, "KLayout-RDB-binary");
+
+}
+
@@ -0,0 +1,82 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2019 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_rdbBinaryFile
+#define HDR_rdbBinaryFile
+
+#include "rdbCommon.h"
+#include "rdb.h"
+
+#include "tlStream.h"
+
+#include <string>
+
+namespace rdb
+{
+
+class Categories;
+
+/**
+ *  @brief The file format string for the binary report database format
+ */
+RDB_PUBLIC extern const char *binary_rdb_file_format;
+
+/**
+ *  @brief A writer for the binary report database format
+ *
+ *  The binary format is a compact alternative to the XML format. It stores
+ *  the database as a sequence of records which the reader can turn into
+ *  database objects one by one without an intermediate representation.
+ *  Geometrical values are stored as binary coordinates.
+ */
+class RDB_PUBLIC BinaryWriter
+{
+public:
+  /**
+   *  @brief Creates a writer for the given stream
+   */
+  BinaryWriter (tl::OutputStream &stream);
+
+  /**
+   *  @brief Writes the database to the stream
+   */
+  void write (const rdb::Database &db);
+
+private:
+  tl::OutputStream &m_stream;
+
+  void write_categories (const rdb::Categories &categories, id_type parent_id);
+  void write_item (const rdb::Item &item);
+  void write_value (const rdb::ValueWrapper &value);
+  void write_byte (unsigned char b);
+  void write_uint (size_t n);
+  void write_double (double d);
+  void write_string (const std::string &s);
+  void write_point (const db::DPoint &p);
+};
+
+}
+
+#endif
+
@@ -24,6 +24,7 @@
 #include "rdb.h"
 #include "rdbReader.h"
 #include "rdbCommon.h"
+#include "rdbBinaryFile.h"
 
 #include "tlTimer.h"
 #include "tlProgress.h"
@@ -125,7 +126,11 @@ void
 rdb::Database::save (const std::string &fn)
 {
   tl::OutputStream os (fn, tl::OutputStream::OM_Auto);
-  make_rdb_structure (this).write (os, *this); 
+  if (tl::match_filename_to_format (fn, binary_rdb_file_format)) {
+    rdb::BinaryWriter (os).write (*this);
+  } else {
+    make_rdb_structure (this).write (os, *this); 
+  }
   set_filename (fn);
 
   tl::log << "Saved RDB to " << fn;
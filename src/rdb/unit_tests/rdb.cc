@@ -23,11 +23,18 @@
 
 
 #include "rdb.h"
+#include "rdbBinaryFile.h"
 #include "tlUnitTest.h"
 #include "dbBox.h"
 #include "dbEdge.h"
+#include "dbEdgePair.h"
+#include "dbPath.h"
+#include "dbPolygon.h"
+#include "dbText.h"
 #include "tlXMLParser.h"
 
+#include <cstring>
+
 TEST(1) 
 {
   rdb::Database db;
@@ -506,6 +513,152 @@ TEST(5a)
   }
 }
 
+TEST(5b) 
+{
+  std::string tmp_file = tl::TestBase::tmp_file ("tmp_5b.lyrdbb");
+
+  {
+    rdb::Database db;
+
+    db.set_description ("db-description");
+    db.set_generator ("db-generator");
+    db.set_top_cell_name ("c3");
+
+    rdb::Category *cath = db.create_category ("cath_name");
+    cath->set_description ("<>&%!$\" \n+~?");
+    rdb::Category *cath2 = db.create_category ("cath2");
+    rdb::Category *cath2cc = db.create_category (cath2, "cc");
+    cath2cc->set_description ("cath2.cc description");
+
+    rdb::Cell *c1 = db.create_cell ("c1");
+    rdb::Cell *c2 = db.create_cell ("c2", "var");
+    c2->references ().insert (rdb::Reference (db::DCplxTrans (1.5, 45, true, db::DVector (10.0, 20.0)), c1->id ()));
+
+    rdb::id_type tag1 = db.tags ().tag ("tag1").id ();
+    rdb::id_type utag = db.tags ().tag ("utag", true).id ();
+    db.set_tag_description (tag1, "tag1 description");
+
+    rdb::Item *i1 = db.create_item (c1->id (), cath->id ());
+    i1->values ().add (new rdb::Value<db::DBox> (db::DBox (1.0, -1.0, 10.0, 11.0)));
+    i1->values ().add (new rdb::Value<double> (0.125), utag);
+    i1->values ().add (new rdb::Value<std::string> ("a string"));
+    i1->add_tag (tag1);
+    i1->set_multiplicity (17);
+
+    rdb::Item *i2 = db.create_item (c2->id (), cath2cc->id ());
+    db::DPoint pts[] = { db::DPoint (0, 0), db::DPoint (0, 1.5), db::DPoint (2.25, 1.5), db::DPoint (2.25, 0) };
+    db::DPolygon poly;
+    poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+    i2->values ().add (new rdb::Value<db::DPolygon> (poly));
+    i2->values ().add (new rdb::Value<db::DPath> (db::DPath (pts, pts + 3, 0.5, 0.25, 0.125, true)));
+    i2->values ().add (new rdb::Value<db::DEdgePair> (db::DEdgePair (db::DEdge (0, 0, 1, 0), db::DEdge (0, 2, 1, 2))));
+    i2->values ().add (new rdb::Value<db::DText> (db::DText ("T", db::DTrans (db::DVector (1, 2)))));
+    i2->add_tag (tag1);
+    i2->add_tag (utag);
+    db.set_item_visited (i2, true);
+
+    tl::OutputStream os (tmp_file, tl::OutputStream::OM_Auto);
+    rdb::BinaryWriter (os).write (db);
+  }
+
+  {
+    rdb::Database db2;
+    db2.load (tmp_file);
+
+    EXPECT_EQ (db2.description (), "db-description");
+    EXPECT_EQ (db2.generator (), "db-generator");
+    EXPECT_EQ (db2.top_cell_name (), "c3");
+    EXPECT_EQ (db2.num_items (), size_t (2));
+    EXPECT_EQ (db2.num_items_visited (), size_t (1));
+
+    EXPECT_EQ (db2.category_by_name ("cath_name") != 0, true);
+    EXPECT_EQ (db2.category_by_name ("cath_name")->description (), "<>&%!$\" \n+~?");
+    EXPECT_EQ (db2.category_by_name ("cath2.cc") != 0, true);
+    EXPECT_EQ (db2.category_by_name ("cath2.cc")->description (), "cath2.cc description");
+
+    EXPECT_EQ (db2.cell_by_qname ("c1") != 0, true);
+    EXPECT_EQ (db2.cell_by_qname ("c2:var") != 0, true);
+
+    rdb::References::const_iterator r = db2.cell_by_qname ("c2:var")->references ().begin ();
+    EXPECT_EQ (r == db2.cell_by_qname ("c2:var")->references ().end (), false);
+    EXPECT_EQ (r->trans ().to_string (), "m22.5 *1.5 10,20");
+    EXPECT_EQ (r->parent_cell_id (), db2.cell_by_qname ("c1")->id ());
+
+    EXPECT_EQ (db2.tags ().has_tag ("utag", true), true);
+    EXPECT_EQ (db2.tags ().tag ("tag1").description (), "tag1 description");
+
+    std::pair<rdb::Database::const_item_ref_iterator, rdb::Database::const_item_ref_iterator> be;
+
+    be = db2.items_by_cell_and_category (db2.cell_by_qname ("c1")->id (), db2.category_by_name ("cath_name")->id ()); 
+    EXPECT_EQ (be.first != be.second, true);
+    EXPECT_EQ ((*be.first)->visited (), false);
+    EXPECT_EQ ((*be.first)->multiplicity (), size_t (17));
+    EXPECT_EQ ((*be.first)->tag_str (), "tag1");
+
+    rdb::Values::const_iterator v = (*be.first)->values ().begin ();
+    EXPECT_EQ (v->get ()->to_string (), "box: (1,-1;10,11)");
+    ++v;
+    EXPECT_EQ (v->get ()->to_string (), "float: 0.125");
+    EXPECT_EQ (v->tag_id (), db2.tags ().tag ("utag", true).id ());
+    ++v;
+    EXPECT_EQ (v->get ()->to_string (), "text: 'a string'");
+    ++v;
+    EXPECT_EQ (v == (*be.first)->values ().end (), true);
+
+    be = db2.items_by_cell_and_category (db2.cell_by_qname ("c2:var")->id (), db2.category_by_name ("cath2.cc")->id ()); 
+    EXPECT_EQ (be.first != be.second, true);
+    EXPECT_EQ ((*be.first)->visited (), true);
+    EXPECT_EQ ((*be.first)->has_tag (db2.tags ().tag ("tag1").id ()), true);
+    EXPECT_EQ ((*be.first)->has_tag (db2.tags ().tag ("utag", true).id ()), true);
+
+    v = (*be.first)->values ().begin ();
+    EXPECT_EQ (v->get ()->to_string (), "polygon: (0,0;0,1.5;2.25,1.5;2.25,0)");
+    ++v;
+    EXPECT_EQ (v->get ()->to_string (), "path: (0,0;0,1.5;2.25,1.5) w=0.5 bx=0.25 ex=0.125 r=true");
+    ++v;
+    EXPECT_EQ (v->get ()->to_string (), "edge-pair: (0,0;1,0)/(0,2;1,2)");
+    ++v;
+    EXPECT_EQ (v->get ()->to_string (), "label: ('T',r0 1,2)");
+    ++v;
+    EXPECT_EQ (v == (*be.first)->values ().end (), true);
+  }
+}
+
+TEST(5c)
+{
+  //  corrupt binary files must not make the reader allocate huge amounts of memory
+
+  const char *files[] = {
+    //  header with a string length beyond the end of file
+    "KLayout-RDB-binary\n\x01\x01\xff\xff\xff\xff\x07" "abc",
+    //  header with a string length beyond the sanity limit
+    "KLayout-RDB-binary\n\x01\x01\xff\xff\xff\xff\xff\x7f",
+    //  a truncated file
+    "KLayout-RDB-binary\n\x01\x01\x03" "ab"
+  };
+
+  for (size_t i = 0; i < sizeof (files) / sizeof (files [0]); ++i) {
+
+    std::string tmp_file = tl::TestBase::tmp_file ("tmp_5c.lyrdbb");
+
+    {
+      tl::OutputStream os (tmp_file, tl::OutputStream::OM_Plain);
+      os.put (files [i], strlen (files [i]));
+    }
+
+    rdb::Database db;
+
+    bool error = false;
+    try {
+      db.load (tmp_file);
+    } catch (tl::Exception &) {
+      error = true;
+    }
+    EXPECT_EQ (error, true);
+
+  }
+}
+
 TEST(6) 
 {
   rdb::Database db;
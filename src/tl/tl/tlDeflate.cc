@@ -26,64 +26,122 @@
 #include "tlAssert.h"
 
 #include <algorithm>
+#include <string.h>
 
 #include <zlib.h>
 
 namespace tl
 {
 
+// ------------------------------------------------------------------------
+//  BitStream implementation
+
+bool
+BitStream::next_window ()
+{
+  //  Return the whole bytes of the bit buffer to the window. By construction,
+  //  these have been taken from the current window.
+  size_t nbytes = m_nbits / 8;
+  m_window_pos -= nbytes;
+  m_nbits -= (unsigned int) nbytes * 8;
+  m_bits &= (uint64_t (1) << m_nbits) - 1;
+
+  if (mp_window) {
+    mp_input->unget (m_window_len - m_window_pos, true /*bypass_inflate*/);
+    mp_window = 0;
+  }
+
+  //  make the input stream provide more bytes than we have given back
+  size_t n = mp_input->blen ();
+  if (n <= nbytes) {
+    if (mp_input->get (n + 1, true /*bypass_inflate*/)) {
+      mp_input->unget (n + 1, true /*bypass_inflate*/);
+    }
+    n = mp_input->blen ();
+  }
+
+  m_window_pos = 0;
+  m_window_len = 0;
+
+  if (n > 0) {
+    mp_window = mp_input->get (n, true /*bypass_inflate*/);
+    tl_assert (mp_window != 0);
+    m_window_len = n;
+  }
+
+  if (n > nbytes) {
+    return true;
+  }
+
+  //  no more data: load the bytes we have given back before
+  while (m_window_pos < m_window_len) {
+    m_bits |= uint64_t ((unsigned char) mp_window [m_window_pos++]) << m_nbits;
+    m_nbits += 8;
+  }
+
+  return false;
+}
+
+void
+BitStream::release ()
+{
+  if (mp_window) {
+    mp_input->unget (m_window_len - m_window_pos + m_nbits / 8, true /*bypass_inflate*/);
+    mp_window = 0;
+  }
+
+  m_window_len = m_window_pos = 0;
+  m_bits = 0;
+  m_nbits = 0;
+}
+
 // ------------------------------------------------------------------------
 //  The Huffmann decoder core
 
 /**
  *  @brief The decoder for Huffmann codes
  *
- *  The decoder keeps a Huffmann code tree and decodes a value from a bit stream
- *  using this tree. 
- *  As specified by RFC1951, the code tree is constructed from a list of code lengths
+ *  The decoder resolves codes with up to "table_bits" bits through a lookup table
+ *  which is indexed with the next bits of the stream. Longer codes are decoded
+ *  with the canonical code procedure, using the number of codes per length.
+ *  As specified by RFC1951, the codes are constructed from a list of code lengths
  *  vs. value alone.
  */
 class HuffmannDecoder
 {
 public:
+  //  the number of bits resolved by the lookup table
+  enum { table_bits = 10 };
+
+  //  the maximum code length in DEFLATE
+  enum { max_bits = 15 };
+
+  //  the maximum number of symbols
+  enum { max_symbols = 288 };
+
   /**
    *  @brief Constructor
    *  
-   *  Creates an empty code tree.
+   *  Creates an empty decoder.
    */
   HuffmannDecoder ()
   {
-    mp_codes = 0;
-    mp_bitmasks = 0;
-    m_max_bits = 0;
-    m_num_codes = 0;
-  }
-
-  /**
-   *  @brief Destructor
-   */
-  ~HuffmannDecoder ()
-  {
-    if (mp_codes) {
-      delete [] mp_codes;
+    for (unsigned int i = 0; i < (1 << table_bits); ++i) {
+      m_table [i] = 0;
     }
-    mp_codes = 0;
-    if (mp_bitmasks) {
-      delete [] mp_bitmasks;
+    for (unsigned int i = 0; i <= max_bits; ++i) {
+      m_count [i] = 0;
     }
-    mp_bitmasks = 0;
   }
 
   /**
-   *  @brief Initialize the code tree with the fixed Huffmann code table for literals/lengths
+   *  @brief Initialize the decoder with the fixed Huffmann code table for literals/lengths
    *
    *  This table is used by compression mode 1.
    *  It is specified in RFC1951.
    */
   void fill_fixed_table_length ()
   {
-    reserve (9);
-
     unsigned short lengths [288];
     for (unsigned int i = 0; i < 144; ++i) {
       lengths[i] = 8;
@@ -102,15 +160,13 @@ public:
   }
 
   /**
-   *  @brief Initialize the code tree with the fixed Huffmann code table for distances
+   *  @brief Initialize the decoder with the fixed Huffmann code table for distances
    *
    *  This table is used by compression mode 1.
    *  It is specified in RFC1951.
    */
   void fill_fixed_table_dist ()
   {
-    reserve (5);
-
     unsigned short lengths [32];
     for (unsigned int i = 0; i < 32; ++i) {
       lengths[i] = 5;
@@ -119,9 +175,9 @@ public:
   }
 
   /**
-   *  @brief Initialize the code tree from a list of lengths
+   *  @brief Initialize the decoder from a list of lengths
    *
-   *  This method initializes the code tree from a list of lengths, given 
+   *  This method initializes the decoder from a list of lengths, given 
    *  by the sequence [begin_lengths, end_lengths). The codes are assumed to 
    *  range from 0 to distance(begin_lengths, end_lengths).
    *  See RFC1951 for a description about the procedure.
@@ -129,97 +185,142 @@ public:
   template <class Iter>
   void init_codes (Iter begin_lengths, Iter end_lengths)
   {
-    const unsigned int MAX_BITS = 16;
-    unsigned short bl_count[MAX_BITS + 1];
-    unsigned short bitmasks[MAX_BITS + 1];
-    unsigned short next_code[MAX_BITS + 1];
-    unsigned int max_bits = 0;
-
-    for (unsigned int bits = 0; bits <= MAX_BITS; bits++) {
-      bl_count[bits] = 0;
+    tl_assert (std::distance (begin_lengths, end_lengths) <= max_symbols);
+
+    for (unsigned int bits = 0; bits <= max_bits; bits++) {
+      m_count [bits] = 0;
     }
 
     for (Iter l = begin_lengths; l != end_lengths; ++l) {
-      tl_assert (*l < MAX_BITS);
-      if (*l > 0) {
-        ++bl_count [*l];
-      }
+      tl_assert (*l <= max_bits);
+      ++m_count [*l];
     }
+    m_count [0] = 0;
 
-    unsigned int code = 0;
-    for (unsigned int bits = 1; bits <= MAX_BITS; bits++) {
-      if (bl_count[bits - 1] > 0) {
-        max_bits = bits - 1;
-      }
-      code = (code + bl_count[bits - 1]) << 1;
-      next_code[bits] = code;
+    //  the symbols sorted by code length (that is in canonical code order)
+    unsigned short offsets [max_bits + 1];
+    offsets [1] = 0;
+    for (unsigned int bits = 1; bits < max_bits; bits++) {
+      offsets [bits + 1] = offsets [bits] + m_count [bits];
     }
 
-    for (unsigned int bits = 0; bits <= max_bits; bits++) {
-      bitmasks [bits] = ((1 << bits) - 1) << (max_bits - bits);
+    unsigned short next_code [max_bits + 1];
+    unsigned int code = 0;
+    for (unsigned int bits = 1; bits <= max_bits; bits++) {
+      code = (code + m_count [bits - 1]) << 1;
+      next_code [bits] = code;
     }
 
-    reserve (max_bits);
+    for (unsigned int i = 0; i < (1 << table_bits); ++i) {
+      m_table [i] = 0;
+    }
 
     unsigned short symbol = 0;
     for (Iter l = begin_lengths; l != end_lengths; ++l, ++symbol) {
-      if (*l > 0) {
-        unsigned int code = next_code [*l]++;
-        code <<= (max_bits - *l);
-        mp_codes [code] = symbol;
-        mp_bitmasks [code] = bitmasks [*l];
-      } 
+
+      unsigned int len = *l;
+      if (len == 0) {
+        continue;
+      }
+
+      m_symbols [offsets [len]++] = symbol;
+
+      unsigned int c = next_code [len]++;
+      if (len <= table_bits) {
+
+        //  Huffmann codes are stored most significant bit first: reverse the code
+        //  to obtain the table index
+        unsigned int rc = 0;
+        for (unsigned int i = 0; i < len; ++i) {
+          rc = (rc << 1) | ((c >> i) & 1);
+        }
+
+        for (unsigned int i = rc; i < (1 << table_bits); i += (1 << len)) {
+          m_table [i] = (unsigned short) ((symbol << 4) | len);
+        }
+
+      }
+
     }
   }
 
   /**
    *  @brief Decode the next value from a bit stream
-   *
-   *  This method takes the next value from the bit stream decoding the bits with
-   *  the code tree currently loaded.
    */
-  unsigned short decode (BitStream &s) const
+  unsigned int decode (BitStream &s) const
   {
-    tl_assert (mp_codes != 0);
-
-    unsigned int m = m_num_codes / 2;
-    
-    unsigned int c = 0;
-    do {
-      if (s.get_bit ()) {
-        c |= m;
-      }
-      m >>= 1;
-    } while ((mp_bitmasks [c] & m) != 0);
+    if (s.available () < (unsigned int) table_bits) {
+      s.fill (max_bits);
+    }
 
-    return mp_codes [c];
+    unsigned short e = m_table [s.peek_bits (table_bits)];
+    unsigned int len = e & 0xf;
+    if (len > 0 && len <= s.available ()) {
+      s.consume (len);
+      return e >> 4;
+    } else {
+      return decode_slow (s);
+    }
   }
 
 private:
-  unsigned short *mp_codes, *mp_bitmasks;
-  unsigned int m_num_codes, m_max_bits;
+  unsigned short m_table [1 << table_bits];
+  unsigned short m_count [max_bits + 1];
+  unsigned short m_symbols [max_symbols];
 
-  void reserve (unsigned int max_bits)
+  unsigned int decode_slow (BitStream &s) const
   {
-    m_num_codes = 1 << max_bits;
-    if (max_bits > m_max_bits) {
-      m_max_bits = max_bits;
-      if (mp_codes) {
-        delete [] mp_codes;
-      }
-      mp_codes = new unsigned short [m_num_codes];
-      if (mp_bitmasks) {
-        delete [] mp_bitmasks;
+    s.fill (max_bits);
+
+    unsigned int bits = s.peek_bits (max_bits);
+    int code = 0, first = 0, index = 0;
+
+    for (unsigned int len = 1; len <= max_bits && len <= s.available (); ++len) {
+      code |= (bits >> (len - 1)) & 1;
+      int count = m_count [len];
+      if (code - count < first) {
+        s.consume (len);
+        return m_symbols [index + (code - first)];
       }
-      mp_bitmasks = new unsigned short [m_num_codes];
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
+    }
+
+    if (s.available () < (unsigned int) max_bits) {
+      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
+    } else {
+      throw tl::Exception (tl::to_string (tr ("Invalid Huffmann code (DEFLATE implementation)")));
     }
   }
 };
 
-
 // ------------------------------------------------------------------------
 //  InflateFilter implementation
 
+//  base values and number of extra bits for length codes 257..285
+static const unsigned short length_base [] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const unsigned char length_extra [] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+//  base values and number of extra bits for distance codes 0..29
+static const unsigned short dist_base [] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const unsigned char dist_extra [] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
 InflateFilter::InflateFilter (tl::InputStream &input)
   : m_input (input), 
     m_b_insert (0), m_b_read (0), m_at_end (false),
@@ -247,10 +348,8 @@ InflateFilter::get (size_t n)
 {
   tl_assert (n < sizeof (m_buffer) / 2);
 
-  while ((m_b_insert + sizeof (m_buffer) - m_b_read) % sizeof (m_buffer) < n) {
-    if (! process ()) {
-      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
-    }
+  if (available () < n && ! process (n)) {
+    throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
   }
 
   tl_assert (m_b_read != m_b_insert);
@@ -278,7 +377,7 @@ bool
 InflateFilter::at_end () 
 {
   if (! m_at_end && m_b_read == m_b_insert) {
-    if (! process ()) {
+    if (! process (1)) {
       m_at_end = true;
     }
   }
@@ -286,108 +385,79 @@ InflateFilter::at_end ()
 }
 
 void 
-InflateFilter::put_byte (char b) 
+InflateFilter::put_bytes_dist (unsigned int d, unsigned int length) 
 {
-  m_buffer [m_b_insert] = b;
-  m_b_insert = (m_b_insert + 1) % sizeof (m_buffer);
-}
-
-void 
-InflateFilter::put_byte_dist (unsigned int d) 
-{
-  put_byte (m_buffer [(m_b_insert - d) % sizeof (m_buffer)]);
+  unsigned int from = (m_b_insert - d) & buffer_mask;
+
+  if (d >= length && from + length <= buffer_size && m_b_insert + length <= buffer_size) {
+    //  fast path: non-overlapping and not wrapping
+    memcpy (m_buffer + m_b_insert, m_buffer + from, length);
+    m_b_insert = (m_b_insert + length) & buffer_mask;
+  } else {
+    while (length-- > 0) {
+      m_buffer [m_b_insert] = m_buffer [from];
+      m_b_insert = (m_b_insert + 1) & buffer_mask;
+      from = (from + 1) & buffer_mask;
+    }
+  }
 }
 
 bool 
-InflateFilter::process ()
+InflateFilter::process (size_t n)
 {
-  while (true) {
+  while (available () < n) {
 
-    bool new_block = false;
+    if (m_uncompressed_length > 0) {
 
-    if (m_uncompressed_length == 0) {
+      //  uncompressed data
+      while (m_uncompressed_length > 0 && available () < n) {
+        put_byte (m_input.get_byte ());
+        --m_uncompressed_length;
+      }
 
-      m_uncompressed_length = -1;
-      new_block = true;
+    } else if (m_uncompressed_length < 0) {
 
-    } else if (m_uncompressed_length > 0) {
+      //  compressed data
+      while (available () < n) {
 
-      put_byte (m_input.get_byte ());
-      --m_uncompressed_length;
+        unsigned int l = mp_lit_decoder->decode (m_input);
+        if (l < 256) {
 
-    } else {
+          put_byte (char (l));
 
-      unsigned int l = mp_lit_decoder->decode (m_input);
-      if (l < 256) {
+        } else if (l == 256) {
 
-        put_byte (char (l));
+          //  end of block
+          m_uncompressed_length = 0;
+          break;
 
-      } else if (l == 256) {
+        } else {
 
-        new_block = true;
+          l -= 257;
+          if (l >= sizeof (length_base) / sizeof (length_base [0])) {
+            throw tl::Exception (tl::to_string (tr ("Invalid length code (DEFLATE implementation)")));
+          }
 
-      } else {
+          unsigned int length = length_base [l] + m_input.get_bits (length_extra [l]);
 
-        unsigned int length = 0;
-        if (l < 265) {
-          length = l - 254;
-        } else if (l < 269) {
-          length = (l - 265) * 2 + 11 + m_input.get_bits (1);
-        } else if (l < 273) {
-          length = (l - 269) * 4 + 19 + m_input.get_bits (2);
-        } else if (l < 277) {
-          length = (l - 273) * 8 + 35 + m_input.get_bits (3);
-        } else if (l < 281) {
-          length = (l - 277) * 16 + 67 + m_input.get_bits (4);
-        } else if (l < 285) {
-          length = (l - 281) * 32 + 131 + m_input.get_bits (5);
-        } else {
-          length = 258;
-        }
+          unsigned int d = mp_dist_decoder->decode (m_input);
+          if (d >= sizeof (dist_base) / sizeof (dist_base [0])) {
+            throw tl::Exception (tl::to_string (tr ("Invalid distance code (DEFLATE implementation)")));
+          }
 
-        unsigned int d = mp_dist_decoder->decode (m_input);
-        unsigned int dist = 0;
-        if (d < 4) {
-          dist = d + 1;
-        } else if (d < 6) {
-          dist = (d - 4) * 2 + 5 + m_input.get_bits (1);
-        } else if (d < 8) {
-          dist = (d - 6) * 4 + 9 + m_input.get_bits (2);
-        } else if (d < 10) {
-          dist = (d - 8) * 8 + 17 + m_input.get_bits (3);
-        } else if (d < 12) {
-          dist = (d - 10) * 16 + 33 + m_input.get_bits (4);
-        } else if (d < 14) {
-          dist = (d - 12) * 32 + 65 + m_input.get_bits (5);
-        } else if (d < 16) {
-          dist = (d - 14) * 64 + 129 + m_input.get_bits (6);
-        } else if (d < 18) {
-          dist = (d - 16) * 128 + 257 + m_input.get_bits (7);
-        } else if (d < 20) {
-          dist = (d - 18) * 256 + 513 + m_input.get_bits (8);
-        } else if (d < 22) {
-          dist = (d - 20) * 512 + 1025 + m_input.get_bits (9);
-        } else if (d < 24) {
-          dist = (d - 22) * 1024 + 2049 + m_input.get_bits (10);
-        } else if (d < 26) {
-          dist = (d - 24) * 2048 + 4097 + m_input.get_bits (11);
-        } else if (d < 28) {
-          dist = (d - 26) * 4096 + 8193 + m_input.get_bits (12);
-        } else {
-          dist = (d - 28) * 8192 + 16385 + m_input.get_bits (13);
-        }
+          unsigned int dist = dist_base [d] + m_input.get_bits (dist_extra [d]);
+
+          put_bytes_dist (dist, length);
 
-        while (length-- > 0) {
-          put_byte_dist (dist);
         }
 
       }
 
-    }
-
-    if (new_block) {
+    } else {
 
       if (m_last_block) {
+        //  give back the bytes we have read ahead
+        m_input.release ();
         return false;
       }
 
@@ -404,6 +474,8 @@ InflateFilter::process ()
 
       } else if (t == 1 || t == 2) {
         
+        m_uncompressed_length = -1;
+
         if (t == 1) {
 
           //  KLUDGE: should use a different decoder object, so we save time to do this:
@@ -432,8 +504,9 @@ InflateFilter::process ()
           HuffmannDecoder ldecoder;
           ldecoder.init_codes (hclengths, hclengths + sizeof (hclengths) / sizeof (hclengths[0]));
 
-          unsigned int lengths [286 + 32];
+          unsigned int lengths [288 + 32];
           unsigned int nlengths = hlit + hdist;
+          tl_assert (nlengths <= sizeof (lengths) / sizeof (lengths [0]));
 
           for (unsigned int i = 0; i < nlengths; ) {
 
@@ -475,11 +548,11 @@ InflateFilter::process ()
         throw tl::Exception (tl::to_string (tr ("Invalid compression type: %d")), t);
       }
 
-    } else {
-      return true;
     }
 
   }
+
+  return true;
 }
 
 // ------------------------------------------------------------------------
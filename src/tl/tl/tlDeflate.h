@@ -29,6 +29,8 @@
 #include "tlStream.h"
 #include "tlException.h"
 
+#include <stdint.h>
+
 //  forware definition of the zlib stream structure - we can omit the zlib header here
 struct z_stream_s;
 
@@ -43,6 +45,11 @@ class HuffmannDecoder;
  *  This filter reads bytes from a tl::Stream and delivers bits, taken from
  *  these bytes. The bits are delivered in the order specified by the DEFLATE
  *  format specification (least significant bit first).
+ *
+ *  For performance, the bit stream takes the bytes available in the input
+ *  stream's buffer as a whole ("window") and keeps up to 64 bits in a bit buffer.
+ *  Hence it reads ahead. "release" returns the bytes not consumed to the
+ *  input stream. This must be called when the DEFLATE stream has ended.
  */
 class TL_PUBLIC BitStream
 {
@@ -54,7 +61,8 @@ public:
    */
   BitStream (tl::InputStream &input)
     : mp_input (&input),
-      m_mask (0), m_byte (0)
+      mp_window (0), m_window_len (0), m_window_pos (0),
+      m_bits (0), m_nbits (0)
   {
     // ...
   }
@@ -62,17 +70,13 @@ public:
   /**
    *  @brief Get a byte
    *
-   *  This method simply passes the byte.
+   *  This method skips to the next byte boundary and delivers the next byte.
    *  The method expects the next byte to be available.
    */
   unsigned char get_byte ()
   {
-    m_mask = 0;
-    const char *c = mp_input->get (1, true /*bypass_deflate*/);
-    if (c == 0) {
-      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
-    }
-    return *c;
+    skip_to_byte ();
+    return (unsigned char) get_bits (8);
   }
 
   /**
@@ -83,13 +87,7 @@ public:
    */
   bool get_bit ()
   {
-    if (m_mask == 0) {
-      m_byte = get_byte ();
-      m_mask = 0x01;
-    } 
-    bool b = ((m_byte & m_mask) != 0);
-    m_mask <<= 1;
-    return b;
+    return get_bits (1) != 0;
   }
 
   /**
@@ -101,13 +99,11 @@ public:
    */
   unsigned int get_bits (unsigned int n)
   {
-    //  KLUDGE: take directly from the byte for performance.
-    unsigned int r = 0;
-    unsigned int m = 1;
-    while (n-- > 0) {
-      r |= get_bit () ? m : 0;
-      m <<= 1;
+    if (m_nbits < n && ! fill (n)) {
+      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
     }
+    unsigned int r = peek_bits (n);
+    consume (n);
     return r;
   }
 
@@ -116,13 +112,71 @@ public:
    */
   void skip_to_byte ()
   {
-    m_mask = 0;
+    consume (m_nbits % 8);
   }
 
+  /**
+   *  @brief Makes at least n bits available in the bit buffer (n <= 57)
+   *
+   *  Returns false, if the input does not provide enough bits. In that case,
+   *  all remaining bits are loaded into the bit buffer.
+   */
+  bool fill (unsigned int n)
+  {
+    while (m_nbits < n) {
+      if (m_window_pos == m_window_len && ! next_window ()) {
+        return false;
+      }
+      while (m_nbits <= 56 && m_window_pos < m_window_len) {
+        m_bits |= uint64_t ((unsigned char) mp_window [m_window_pos++]) << m_nbits;
+        m_nbits += 8;
+      }
+    }
+    return true;
+  }
+
+  /**
+   *  @brief Gets the next n bits without consuming them
+   *
+   *  If less than n bits are available, the missing bits are reported as zero.
+   */
+  unsigned int peek_bits (unsigned int n) const
+  {
+    return (unsigned int) (m_bits & ((uint64_t (1) << n) - 1));
+  }
+
+  /**
+   *  @brief Consumes n bits (n must not be larger than the number of available bits)
+   */
+  void consume (unsigned int n)
+  {
+    m_bits >>= n;
+    m_nbits -= n;
+  }
+
+  /**
+   *  @brief Gets the number of bits available in the bit buffer
+   */
+  unsigned int available () const
+  {
+    return m_nbits;
+  }
+
+  /**
+   *  @brief Returns the bytes read ahead to the input stream
+   *
+   *  The bits of a partially consumed byte are discarded.
+   */
+  void release ();
+
 private:
   tl::InputStream *mp_input;
-  unsigned char m_mask;
-  unsigned char m_byte;
+  const char *mp_window;
+  size_t m_window_len, m_window_pos;
+  uint64_t m_bits;
+  unsigned int m_nbits;
+
+  bool next_window ();
 };
 
 
@@ -230,9 +284,12 @@ public:
   bool at_end ();
 
 private:
+  //  the buffer size must be a power of two
+  enum { buffer_size = 65536, buffer_mask = buffer_size - 1 };
+
   BitStream m_input;
 
-  char m_buffer[65536];
+  char m_buffer[buffer_size];
   unsigned int m_b_insert;
   unsigned int m_b_read;
   bool m_at_end;
@@ -242,9 +299,19 @@ private:
   int m_uncompressed_length;
   HuffmannDecoder *mp_lit_decoder, *mp_dist_decoder;
 
-  void put_byte (char b);
-  void put_byte_dist (unsigned int d);
-  bool process ();
+  unsigned int available () const
+  {
+    return (m_b_insert - m_b_read) & buffer_mask;
+  }
+
+  void put_byte (char b)
+  {
+    m_buffer [m_b_insert] = b;
+    m_b_insert = (m_b_insert + 1) & buffer_mask;
+  }
+
+  void put_bytes_dist (unsigned int d, unsigned int length);
+  bool process (size_t n);
 
 };
 
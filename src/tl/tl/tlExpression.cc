@@ -3147,6 +3147,14 @@ Eval::set_var (const std::string &name, const tl::Variant &var)
   m_local_vars.insert (std::make_pair (name, tl::Variant ())).first->second = var;
 }
 
+void 
+Eval::reset_vars ()
+{
+  for (std::map<std::string, tl::Variant>::iterator v = m_local_vars.begin (); v != m_local_vars.end (); ++v) {
+    v->second = tl::Variant ();
+  }
+}
+
 void 
 Eval::define_function (const std::string &name, EvalFunction *function)
 {
@@ -428,6 +428,15 @@ public:
    */
   void set_var (const std::string &name, const tl::Variant &var);
 
+  /**
+   *  @brief Resets all local variables to nil
+   *
+   *  The variables are not removed, hence expressions parsed within this context
+   *  stay valid. This allows executing a parsed expression multiple times with
+   *  fresh variables.
+   */
+  void reset_vars ();
+
   /**
    *  @brief Parse an expression from the extractor
    *
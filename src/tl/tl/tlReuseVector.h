@@ -29,6 +29,7 @@
 #include <iterator>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #include "tlAssert.h"
 #include "tlTypeTraits.h"
@@ -821,6 +822,17 @@ public:
     mp_finish = mp_start;
   }
 
+  /**
+   *  @brief Swaps the contents of this container with another one
+   */
+  void swap (reuse_vector &other)
+  {
+    std::swap (mp_start, other.mp_start);
+    std::swap (mp_finish, other.mp_finish);
+    std::swap (mp_capacity, other.mp_capacity);
+    std::swap (mp_rdata, other.mp_rdata);
+  }
+
   /**
    *  @brief Return the size
    *
@@ -32,7 +32,11 @@
 #include <zlib.h>
 #ifdef _WIN32 
 #  include <io.h>
+#else
+#  include <unistd.h>
+#  include <sys/mman.h>
 #endif
+#include <limits>
 
 #include "tlStream.h"
 #include "tlHttpStream.h"
@@ -134,24 +138,46 @@ public:
 // ---------------------------------------------------------------
 //  InputStream implementation
 
+/**
+ *  @brief Creates the delegate for a local file
+ *
+ *  Plain files are memory-mapped if possible. Otherwise, the zlib delegate
+ *  is used which reads plain and gzip-compressed files.
+ */
+static InputStreamBase *
+open_file (const std::string &path)
+{
+#if !defined(_WIN32)
+  InputStreamBase *mapped = InputMappedFile::try_open (path);
+  if (mapped) {
+    return mapped;
+  }
+#endif
+  return new InputZLibFile (path);
+}
+
 InputStream::InputStream (InputStreamBase &delegate)
-  : m_pos (0), mp_bptr (0), mp_delegate (&delegate), m_owns_delegate (false), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), m_buffer_origin (0), mp_delegate (&delegate), m_owns_delegate (false), mp_direct (0), m_direct_len (0), mp_inflate (0)
 { 
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
   mp_buffer = new char [m_bcap];
+
+  init_direct ();
 }
 
 InputStream::InputStream (InputStreamBase *delegate)
-  : m_pos (0), mp_bptr (0), mp_delegate (delegate), m_owns_delegate (true), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), m_buffer_origin (0), mp_delegate (delegate), m_owns_delegate (true), mp_direct (0), m_direct_len (0), mp_inflate (0)
 {
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
   mp_buffer = new char [m_bcap];
+
+  init_direct ();
 }
 
 InputStream::InputStream (const std::string &abstract_path)
-  : m_pos (0), mp_bptr (0), mp_delegate (0), m_owns_delegate (false), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), m_buffer_origin (0), mp_delegate (0), m_owns_delegate (false), mp_direct (0), m_direct_len (0), mp_inflate (0)
 { 
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
@@ -168,13 +194,25 @@ InputStream::InputStream (const std::string &abstract_path)
   } else
   if (ex.test ("file:")) {
     tl::URI uri (abstract_path);
-    mp_delegate = new InputZLibFile (uri.path ());
+    mp_delegate = open_file (uri.path ());
   } else
   {
-    mp_delegate = new InputZLibFile (abstract_path);
+    mp_delegate = open_file (abstract_path);
   }
 
   m_owns_delegate = true;
+
+  init_direct ();
+}
+
+void
+InputStream::init_direct ()
+{
+  mp_direct = mp_delegate->data (m_direct_len);
+  if (mp_direct) {
+    mp_bptr = mp_direct;
+    m_blen = m_direct_len;
+  }
 }
 
 std::string InputStream::absolute_path (const std::string &abstract_path)
@@ -227,7 +265,12 @@ InputStream::get (size_t n, bool bypass_inflate)
     }
   } 
 
-  if (m_blen < n) {
+  if (m_blen < n && mp_direct) {
+
+    //  direct access: all data is available already
+    return 0;
+
+  } else if (m_blen < n) {
 
     //  to keep move activity low, allocate twice as much as required
     if (m_bcap < n * 2) {
@@ -249,6 +292,7 @@ InputStream::get (size_t n, bool bypass_inflate)
 
     m_blen += mp_delegate->read (mp_buffer + m_blen, m_bcap - m_blen); 
     mp_bptr = mp_buffer;
+    m_buffer_origin = m_pos;
 
   }
 
@@ -264,9 +308,9 @@ InputStream::get (size_t n, bool bypass_inflate)
 }
 
 void
-InputStream::unget (size_t n)
+InputStream::unget (size_t n, bool bypass_inflate)
 {
-  if (mp_inflate) {
+  if (mp_inflate && ! bypass_inflate) {
     mp_inflate->unget (n);
   } else {
     mp_bptr -= n;
@@ -310,6 +354,14 @@ InputStream::read_all ()
 
 void InputStream::copy_to(tl::OutputStream &os)
 {
+  if (mp_direct) {
+    os.put (mp_bptr, m_blen);
+    mp_bptr += m_blen;
+    m_pos += m_blen;
+    m_blen = 0;
+    return;
+  }
+
   const size_t chunk = 65536;
   char b [chunk];
   size_t read;
@@ -331,6 +383,14 @@ InputStream::close ()
   if (mp_delegate) {
     mp_delegate->close ();
   }
+
+  //  the direct mapping is released by the delegate - don't point into it any longer
+  if (mp_direct) {
+    mp_direct = 0;
+    m_direct_len = 0;
+    mp_bptr = 0;
+    m_blen = 0;
+  }
 }
 
 void 
@@ -342,9 +402,15 @@ InputStream::reset ()
     mp_inflate = 0;
   } 
 
-  //  optimize for a reset in the first m_bcap bytes
+  if (mp_direct) {
+
+    mp_bptr = mp_direct;
+    m_blen = m_direct_len;
+    m_pos = 0;
+
+  //  optimize for a reset while the buffer still holds the beginning of the stream
   //  -> this reduces the reset calls on mp_delegate which may not support this
-  if (m_pos < m_bcap) {
+  } else if (m_buffer_origin == 0) {
 
     m_blen += m_pos;
     mp_bptr = mp_buffer;
@@ -362,11 +428,46 @@ InputStream::reset ()
 
     mp_bptr = 0;
     m_blen = 0;
+    m_buffer_origin = 0;
     mp_buffer = new char [m_bcap];
 
   }
 }
 
+void
+InputStream::seek (size_t pos)
+{
+  //  stop inflate
+  if (mp_inflate) {
+    delete mp_inflate;
+    mp_inflate = 0;
+  }
+
+  if (mp_direct) {
+
+    pos = std::min (pos, m_direct_len);
+    mp_bptr = mp_direct + pos;
+    m_blen = m_direct_len - pos;
+    m_pos = pos;
+
+  } else if (pos >= m_buffer_origin && pos <= m_pos + m_blen) {
+
+    //  the position is inside the buffered data
+    m_blen = m_pos + m_blen - pos;
+    mp_bptr = mp_buffer + (pos - m_buffer_origin);
+    m_pos = pos;
+
+  } else {
+
+    mp_delegate->seek (pos);
+    mp_bptr = mp_buffer;
+    m_blen = 0;
+    m_pos = pos;
+    m_buffer_origin = pos;
+
+  }
+}
+
 // ---------------------------------------------------------------
 //  TextInputStream implementation
 
@@ -526,6 +627,39 @@ InputFile::reset ()
   }
 }
 
+void
+InputFile::seek (size_t pos)
+{
+  tl_assert (m_fd >= 0);
+#if defined(_WIN64)
+  _lseeki64 (m_fd, (__int64) pos, SEEK_SET);
+#elif defined(_WIN32)
+  _lseek (m_fd, (long) pos, SEEK_SET);
+#else
+  lseek (m_fd, (off_t) pos, SEEK_SET);
+#endif
+}
+
+size_t
+InputFile::size ()
+{
+  tl_assert (m_fd >= 0);
+#if defined(_WIN64)
+  __int64 pos = _lseeki64 (m_fd, 0, SEEK_CUR);
+  __int64 n = _lseeki64 (m_fd, 0, SEEK_END);
+  _lseeki64 (m_fd, pos, SEEK_SET);
+#elif defined(_WIN32)
+  long pos = _lseek (m_fd, 0, SEEK_CUR);
+  long n = _lseek (m_fd, 0, SEEK_END);
+  _lseek (m_fd, pos, SEEK_SET);
+#else
+  off_t pos = lseek (m_fd, 0, SEEK_CUR);
+  off_t n = lseek (m_fd, 0, SEEK_END);
+  lseek (m_fd, pos, SEEK_SET);
+#endif
+  return n < 0 ? 0 : size_t (n);
+}
+
 std::string
 InputFile::absolute_path () const
 {
@@ -538,6 +672,110 @@ InputFile::filename () const
   return tl::filename (m_source);
 }
 
+// ---------------------------------------------------------------
+//  InputMappedFile implementation
+
+#if !defined(_WIN32)
+
+InputMappedFile *
+InputMappedFile::try_open (const std::string &path)
+{
+  int fd = open (path.c_str (), O_RDONLY);
+  if (fd < 0) {
+    throw FileOpenErrorException (path, errno);
+  }
+
+  struct stat st;
+  if (fstat (fd, &st) != 0 || ! S_ISREG (st.st_mode) || st.st_size <= 0 || (unsigned long long) st.st_size > (unsigned long long) std::numeric_limits<size_t>::max ()) {
+    ::close (fd);
+    return 0;
+  }
+
+  size_t length = size_t (st.st_size);
+  void *data = mmap (0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  //  the mapping stays valid after the file has been closed
+  ::close (fd);
+
+  if (data == MAP_FAILED) {
+    return 0;
+  }
+
+  //  gzip-compressed files are left to InputZLibFile
+  const unsigned char *d = (const unsigned char *) data;
+  if (length >= 2 && d[0] == 0x1f && d[1] == 0x8b) {
+    munmap (data, length);
+    return 0;
+  }
+
+#if defined(MADV_SEQUENTIAL)
+  madvise (data, length, MADV_SEQUENTIAL);
+#endif
+
+  return new InputMappedFile (path, (const char *) data, length);
+}
+
+InputMappedFile::InputMappedFile (const std::string &path, const char *data, size_t length)
+  : m_source (path), mp_data (data), m_length (length), m_pos (0)
+{
+  //  .. nothing yet ..
+}
+
+InputMappedFile::~InputMappedFile ()
+{
+  close ();
+}
+
+void
+InputMappedFile::close ()
+{
+  if (mp_data) {
+    munmap ((void *) mp_data, m_length);
+    mp_data = 0;
+    m_length = 0;
+    m_pos = 0;
+  }
+}
+
+size_t
+InputMappedFile::read (char *b, size_t n)
+{
+  tl_assert (mp_data != 0);
+  if (m_pos + n > m_length) {
+    n = m_length - m_pos;
+  }
+  memcpy (b, mp_data + m_pos, n);
+  m_pos += n;
+  return n;
+}
+
+const char *
+InputMappedFile::data (size_t &n) const
+{
+  n = m_length;
+  return mp_data;
+}
+
+void
+InputMappedFile::reset ()
+{
+  m_pos = 0;
+}
+
+std::string
+InputMappedFile::absolute_path () const
+{
+  return tl::absolute_file_path (m_source);
+}
+
+std::string
+InputMappedFile::filename () const
+{
+  return tl::filename (m_source);
+}
+
+#endif
+
 // ---------------------------------------------------------------
 //  InputZLibFile implementation
 
@@ -55,7 +55,7 @@ extern TL_PUBLIC bool match_filename_to_format (const std::string &fn, const std
  *  @brief The input stream delegate base class
  *
  *  This class provides the basic input stream functionality.
- *  The actual implementation is provided through InputFile, InputPipe and InputZLibFile.
+ *  The actual implementation is provided through InputFile, InputMappedFile, InputPipe and InputZLibFile.
  */
 
 class TL_PUBLIC InputStreamBase
@@ -77,11 +77,53 @@ public:
    */
   virtual size_t read (char *b, size_t n) = 0;
 
+  /**
+   *  @brief Gets the complete data if the delegate keeps it in memory
+   *
+   *  If this method returns a non-null pointer, InputStream will deliver the data
+   *  directly from this memory block rather than copying it into its buffer through
+   *  read (). "n" receives the number of bytes available. The memory block must stay
+   *  valid as long as the delegate lives.
+   */
+  virtual const char *data (size_t & /*n*/) const
+  {
+    return 0;
+  }
+
   /**
    *  @brief Seek to the beginning
    */
   virtual void reset () = 0;
 
+  /**
+   *  @brief Returns a value indicating whether the delegate supports seek and size
+   */
+  virtual bool supports_seek ()
+  {
+    return false;
+  }
+
+  /**
+   *  @brief Seek to the given position
+   *
+   *  Reading continues at that position after a seek. This method is only called
+   *  if "supports_seek" is true.
+   */
+  virtual void seek (size_t /*pos*/)
+  {
+    //  .. nothing yet ..
+  }
+
+  /**
+   *  @brief Gets the total number of bytes available from the delegate
+   *
+   *  This method is only called if "supports_seek" is true.
+   */
+  virtual size_t size ()
+  {
+    return 0;
+  }
+
   /**
    *  @brief Closes the channel
    */
@@ -139,6 +181,12 @@ public:
     return n;
   }
 
+  virtual const char *data (size_t &n) const
+  {
+    n = m_length;
+    return mp_data;
+  }
+
   virtual void reset ()
   {
     m_pos = 0;
@@ -262,6 +310,15 @@ public:
 
   virtual void reset ();
 
+  virtual bool supports_seek ()
+  {
+    return true;
+  }
+
+  virtual void seek (size_t pos);
+
+  virtual size_t size ();
+
   virtual void close ();
 
   virtual std::string source () const
@@ -282,6 +339,68 @@ private:
   int m_fd;
 };
 
+#if !defined(_WIN32)
+
+/**
+ *  @brief A memory-mapped input file delegate
+ *
+ *  This delegate maps the whole file into memory. InputStream will serve
+ *  the data directly from the mapping without copying it. The kernel
+ *  is advised to expect sequential access.
+ *
+ *  Use "try_open" to create the delegate: this method returns 0 if the
+ *  file cannot be mapped (e.g. because it is empty, not a regular file
+ *  or gzip-compressed).
+ */
+class TL_PUBLIC InputMappedFile
+  : public InputStreamBase
+{
+public:
+  /**
+   *  @brief Creates a mapped file delegate for the given path
+   *
+   *  Returns 0 if the file cannot be mapped. In that case, the caller should use
+   *  a different delegate. Throws a FileOpenErrorException if the file cannot
+   *  be opened.
+   */
+  static InputMappedFile *try_open (const std::string &path);
+
+  /**
+   *  @brief Unmaps and closes the file
+   */
+  virtual ~InputMappedFile ();
+
+  virtual size_t read (char *b, size_t n);
+
+  virtual const char *data (size_t &n) const;
+
+  virtual void reset ();
+
+  virtual void close ();
+
+  virtual std::string source () const
+  {
+    return m_source;
+  }
+
+  virtual std::string absolute_path () const;
+
+  virtual std::string filename () const;
+
+private:
+  InputMappedFile (const std::string &path, const char *data, size_t length);
+
+  //  no copying
+  InputMappedFile (const InputMappedFile &d);
+  InputMappedFile &operator= (const InputMappedFile &d);
+
+  std::string m_source;
+  const char *mp_data;
+  size_t m_length, m_pos;
+};
+
+#endif
+
 /**
  *  @brief A simple pipe input delegate
  *
@@ -432,8 +551,10 @@ public:
    *  
    *  This call puts back the bytes read by a previous get call.
    *  Only one call can be made undone.
+   *  If "bypass_inflate" is true, the bytes are put back into the raw
+   *  stream even if inflating is enabled.
    */
-  void unget (size_t n);
+  void unget (size_t n, bool bypass_inflate = false);
 
   /**
    *  @brief Reads all remaining bytes into the string
@@ -472,6 +593,44 @@ public:
     return m_pos;
   }
 
+  /**
+   *  @brief Returns true, if the stream delivers inflated data currently
+   *
+   *  In this case, "pos" is not the position of the data delivered.
+   */
+  bool is_inflating () const
+  {
+    return mp_inflate != 0;
+  }
+
+  /**
+   *  @brief Returns a value indicating whether the stream supports seek
+   *
+   *  This is the case for in-memory data, mapped files and plain files.
+   */
+  bool supports_seek () const
+  {
+    return mp_direct != 0 || mp_delegate->supports_seek ();
+  }
+
+  /**
+   *  @brief Seek to the specified position
+   *
+   *  Reading continues at that position. This method must only be called if
+   *  "supports_seek" is true. Inflating is stopped.
+   */
+  void seek (size_t pos);
+
+  /**
+   *  @brief Gets the total size of the stream in bytes
+   *
+   *  This method must only be called if "supports_seek" is true.
+   */
+  size_t size () const
+  {
+    return mp_direct != 0 ? m_direct_len : mp_delegate->size ();
+  }
+
   /**
    *  @brief Obtain the available number of bytes
    *
@@ -549,10 +708,18 @@ private:
   char *mp_buffer;
   size_t m_bcap;
   size_t m_blen;
-  char *mp_bptr;
+  const char *mp_bptr;
+  //  the stream position of the first byte in mp_buffer
+  size_t m_buffer_origin;
   InputStreamBase *mp_delegate;
   bool m_owns_delegate;
 
+  //  direct (zero-copy) access to the delegate's data
+  const char *mp_direct;
+  size_t m_direct_len;
+
+  void init_direct ();
+
   //  inflate support 
   InflateFilter *mp_inflate;
 
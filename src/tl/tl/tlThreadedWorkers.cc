@@ -25,6 +25,7 @@
 #include "tlLog.h"
 #include "tlProgress.h"
 #include "tlAssert.h"
+#include "tlTimer.h"
 
 #include <memory>
 #include <stdio.h>
@@ -58,6 +59,29 @@ public:
 struct WorkerTerminatedException { };
 struct TaskTerminatedException { };
 
+// -----------------------------------------------------------------------------
+//  The per-worker task queue
+
+/**
+ *  @brief A task queue owned by one worker
+ *
+ *  The owner takes the tasks from the front of the queue. Other workers
+ *  steal tasks from the back. The queues and the statistics kept here are 
+ *  protected by the job's lock.
+ */
+struct WorkerQueue
+{
+  WorkerQueue ()
+    : idle_since_valid (false)
+  { }
+
+  TaskList tasks;
+  WorkerStatistics statistics;
+  //  the start of the current idle period
+  tl::Clock idle_since;
+  bool idle_since_valid;
+};
+
 // -----------------------------------------------------------------------------
 //  tl::Boss implementation
 
@@ -101,7 +125,7 @@ Boss::stop_all ()
 //  tl::TaskList implementation
 
 TaskList::TaskList ()
-  : mp_first (0), mp_last (0)
+  : mp_first (0), mp_last (0), m_size (0)
 {
   // .. nothing yet ..
 }
@@ -128,6 +152,26 @@ TaskList::fetch ()
   tl_assert (task->mp_last == 0);
   task->mp_next = 0;
 
+  --m_size;
+  return task;
+}
+
+Task *
+TaskList::fetch_back ()
+{
+  Task *task = mp_last;
+
+  mp_last = task->mp_last;
+  if (! mp_last) {
+    mp_first = 0;
+  } else {
+    mp_last->mp_next = 0;
+  }
+
+  tl_assert (task->mp_next == 0);
+  task->mp_last = 0;
+
+  --m_size;
   return task;
 }
 
@@ -143,6 +187,8 @@ TaskList::put (Task *task)
   } else {
     mp_first = task;
   }
+
+  ++m_size;
 }
 
 void 
@@ -157,19 +203,17 @@ TaskList::put_front (Task *task)
   } else {
     mp_last = task;
   }
+
+  ++m_size;
 }
 
 // -----------------------------------------------------------------------------
 //  tl::JobBase implementation
 
 JobBase::JobBase (int nworkers)
-  : m_nworkers (nworkers), m_idle_workers (0), m_stopping (false), m_running (false)
+  : mp_per_worker_task_lists (0), mp_work_queues (0), m_nworkers (nworkers), m_idle_workers (0), m_next_worker (0), m_stopping (false), m_running (false)
 {
-  if (nworkers > 0) {
-    mp_per_worker_task_lists = new TaskList[nworkers];
-  } else {
-    mp_per_worker_task_lists = 0;
-  }
+  create_work_queues ();
 }
 
 JobBase::~JobBase ()
@@ -184,6 +228,32 @@ JobBase::~JobBase ()
     delete[] mp_per_worker_task_lists;
     mp_per_worker_task_lists = 0;
   }
+
+  if (mp_work_queues) {
+    delete[] mp_work_queues;
+    mp_work_queues = 0;
+  }
+}
+
+void
+JobBase::create_work_queues ()
+{
+  if (mp_per_worker_task_lists) {
+    delete[] mp_per_worker_task_lists;
+    mp_per_worker_task_lists = 0;
+  }
+
+  if (mp_work_queues) {
+    delete[] mp_work_queues;
+    mp_work_queues = 0;
+  }
+
+  if (m_nworkers > 0) {
+    mp_per_worker_task_lists = new TaskList[m_nworkers];
+    mp_work_queues = new WorkerQueue[m_nworkers];
+  }
+
+  m_next_worker = 0;
 }
 
 void
@@ -220,6 +290,31 @@ JobBase::error_messages ()
   return r;
 }
 
+std::vector<WorkerStatistics>
+JobBase::statistics ()
+{
+  std::vector<WorkerStatistics> r;
+  r.reserve (m_nworkers);
+
+  m_lock.lock ();
+  for (int i = 0; i < m_nworkers; ++i) {
+    r.push_back (mp_work_queues [i].statistics);
+  }
+  m_lock.unlock ();
+
+  return r;
+}
+
+void
+JobBase::reset_statistics ()
+{
+  m_lock.lock ();
+  for (int i = 0; i < m_nworkers; ++i) {
+    mp_work_queues [i].statistics = WorkerStatistics ();
+  }
+  m_lock.unlock ();
+}
+
 void
 JobBase::set_num_workers (int nworkers)
 {
@@ -228,15 +323,7 @@ JobBase::set_num_workers (int nworkers)
   m_nworkers = nworkers;
   m_idle_workers = 0;
 
-  if (mp_per_worker_task_lists) {
-    delete[] mp_per_worker_task_lists;
-  }
-
-  if (nworkers > 0) {
-    mp_per_worker_task_lists = new TaskList[nworkers];
-  } else {
-    mp_per_worker_task_lists = 0;
-  }
+  create_work_queues ();
 }
 
 void 
@@ -257,18 +344,41 @@ JobBase::start ()
     mp_per_worker_task_lists[i].put_front (new StartTask ());
   }
 
-  m_task_available_condition.wakeAll ();
+  if (m_nworkers > 0) {
+
+    //  distribute the tasks scheduled so far over the workers
+    while (! m_task_list.is_empty ()) {
+      dispatch (m_task_list.fetch ());
+    }
+
+    //  idle times are counted from here
+    tl::Clock now = tl::Clock::current ();
+    for (int i = 0; i < m_nworkers; ++i) {
+      if (mp_work_queues [i].idle_since_valid) {
+        mp_work_queues [i].idle_since = now;
+      }
+    }
 
+  }
+
+  int first_new_worker = int (mp_workers.size ());
   while (m_nworkers > int (mp_workers.size ())) {
     mp_workers.push_back (create_worker ());
-    mp_workers.back ()->start (this, int (mp_workers.size ()) - 1);
   }
 
+  //  all workers are set up before they can pick up tasks: new workers are
+  //  not started yet and existing ones need the lock to fetch a task
   for (int i = 0; i < int (mp_workers.size ()); ++i) {
     setup_worker (mp_workers [i]);
     mp_workers [i]->reset_stop_request ();
   }
 
+  for (int i = first_new_worker; i < int (mp_workers.size ()); ++i) {
+    mp_workers [i]->start (this, i);
+  }
+
+  m_task_available_condition.wakeAll ();
+
   m_lock.unlock ();
 
   if (mp_workers.empty ()) {
@@ -347,6 +457,7 @@ JobBase::stop ()
   while (! m_task_list.is_empty ()) {
     delete m_task_list.fetch ();
   }
+  clear_work_queues ();
 
   if (! mp_workers.empty ()) {
 
@@ -419,8 +530,52 @@ JobBase::terminate ()
   }
 }
 
+void
+JobBase::clear_work_queues ()
+{
+  //  NOTE: this method is called with m_lock held
+  for (int i = 0; i < m_nworkers; ++i) {
+    WorkerQueue &q = mp_work_queues [i];
+    while (! q.tasks.is_empty ()) {
+      delete q.tasks.fetch ();
+    }
+  }
+}
+
+void
+JobBase::dispatch (Task *task)
+{
+  //  NOTE: this method is called with m_lock held
+  int w;
+  if (task->m_affinity >= 0) {
+    w = task->m_affinity % m_nworkers;
+  } else {
+    w = int (m_next_worker++ % (unsigned int) m_nworkers);
+  }
+
+  mp_work_queues [w].tasks.put (task);
+}
+
+bool
+JobBase::has_work ()
+{
+  //  NOTE: this method is called with m_lock held
+  for (int i = 0; i < m_nworkers; ++i) {
+    if (! mp_work_queues [i].tasks.is_empty ()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void 
 JobBase::schedule (Task *task)
+{
+  schedule (task, -1);
+}
+
+void 
+JobBase::schedule (Task *task, int affinity)
 {
   m_lock.lock ();
 
@@ -431,11 +586,15 @@ JobBase::schedule (Task *task)
 
   } else {
 
-    //  Add the task to the task queue
-    m_task_list.put (task);
+    task->m_affinity = affinity;
 
-    if (m_running) {
+    if (m_running && m_nworkers > 0) {
+      //  Add the task to one of the worker queues
+      dispatch (task);
       m_task_available_condition.wakeAll ();
+    } else {
+      //  Add the task to the task queue - it will be distributed on start ()
+      m_task_list.put (task);
     }
 
   }
@@ -443,35 +602,94 @@ JobBase::schedule (Task *task)
   m_lock.unlock ();
 }
 
+Task *
+JobBase::fetch_or_steal (int worker)
+{
+  //  NOTE: this method is called with m_lock held
+  WorkerQueue &own = mp_work_queues [worker];
+
+  if (! own.tasks.is_empty ()) {
+    ++own.statistics.tasks;
+    return own.tasks.fetch ();
+  }
+
+  Task *task = 0;
+
+  //  our own queue is empty: steal from the back of the others, starting
+  //  with the next worker so the victims are spread evenly
+  for (int i = 1; i < m_nworkers && ! task; ++i) {
+    WorkerQueue &victim = mp_work_queues [(worker + i) % m_nworkers];
+    if (! victim.tasks.is_empty ()) {
+      task = victim.tasks.fetch_back ();
+    }
+  }
+
+  if (task) {
+    ++own.statistics.tasks;
+    ++own.statistics.stolen;
+  }
+
+  return task;
+}
+
 Task *
 JobBase::get_task (int worker)
 {
+  WorkerQueue &own = mp_work_queues [worker];
+
   while (true) {
 
     m_lock.lock ();
 
-    //  wait for new relevant entries in the task queue
-    while (m_task_list.is_empty () && mp_per_worker_task_lists [worker].is_empty ()) {
+    Task *work = fetch_or_steal (worker);
+    if (work) {
+      m_lock.unlock ();
+      return work;
+    }
+
+    //  wait for new relevant entries in the task queues
+    while (mp_per_worker_task_lists [worker].is_empty () && ! has_work ()) {
 
       //  if the queue is empty, mark this worker as idle.
       ++m_idle_workers;
 
+      own.idle_since = tl::Clock::current ();
+      own.idle_since_valid = true;
+
       //  signal empty queue if all workers are waiting
       if (m_idle_workers == m_nworkers) {
+
         if (! m_stopping) {
           finished ();
         }
         m_running = false;
+
+        //  the job is finished: waiting for the next job does not count as idle time
+        tl::Clock now = tl::Clock::current ();
+        for (int i = 0; i < m_nworkers; ++i) {
+          WorkerQueue &q = mp_work_queues [i];
+          if (q.idle_since_valid) {
+            q.statistics.idle_time += (now - q.idle_since).seconds ();
+            q.idle_since = now;
+          }
+        }
+
         m_queue_empty_condition.wakeAll ();
+
       }
 
       //  wait until we receive a task
-      while (m_task_list.is_empty () && mp_per_worker_task_lists [worker].is_empty ()) {
+      while (mp_per_worker_task_lists [worker].is_empty () && ! has_work ()) {
         mp_workers [worker]->set_idle (true);
         m_task_available_condition.wait (&m_lock);
         mp_workers [worker]->set_idle (false);
       }
 
+      if (m_running) {
+        own.statistics.idle_time += (tl::Clock::current () - own.idle_since).seconds ();
+      }
+      own.idle_since_valid = false;
+
       --m_idle_workers;
 
     } 
@@ -479,8 +697,6 @@ JobBase::get_task (int worker)
     Task *task = 0;
     if (! mp_per_worker_task_lists [worker].is_empty ()) {
       task = mp_per_worker_task_lists [worker].fetch ();
-    } else if (! m_task_list.is_empty ()) {
-      task = m_task_list.fetch ();
     }
 
     m_lock.unlock ();
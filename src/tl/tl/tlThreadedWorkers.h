@@ -58,6 +58,7 @@ namespace tl
 class Boss;
 class Worker;
 class Task;
+struct WorkerQueue;
 
 /**
  *  @brief A task list
@@ -91,6 +92,11 @@ public:
    */
   Task *fetch ();
 
+  /**
+   *  @brief Fetch the last task
+   */
+  Task *fetch_back ();
+
   /**
    *  @brief Put (append) a task to the task list
    */
@@ -109,20 +115,56 @@ public:
     return mp_first;
   }
 
+  /**
+   *  @brief Gets the number of tasks in the list
+   */
+  size_t size () const
+  {
+    return m_size;
+  }
+
 private:
   Task *mp_first, *mp_last;
+  size_t m_size;
 
   TaskList (const TaskList &);
   TaskList &operator= (const TaskList &);
 };
 
+/**
+ *  @brief Execution statistics for one worker
+ */
+struct TL_PUBLIC WorkerStatistics
+{
+  WorkerStatistics ()
+    : tasks (0), stolen (0), idle_time (0.0)
+  { }
+
+  /**
+   *  @brief The number of tasks performed by the worker
+   */
+  size_t tasks;
+
+  /**
+   *  @brief The number of tasks the worker took from other worker's queues
+   */
+  size_t stolen;
+
+  /**
+   *  @brief The time in seconds the worker spent waiting for tasks
+   */
+  double idle_time;
+};
+
 /**
  *  @brief This object represents a job
  *
  *  A job can be delegated to multiple workers. 
  *  A job is organised in tasks, which are scheduled to the job. Upon \start,
- *  the job takes the tasks from a queue and sends them to the workers for
- *  being processed.
+ *  the job distributes the tasks over per-worker queues. Each worker takes
+ *  the tasks from its own queue. A worker whose queue has run dry takes
+ *  ("steals") tasks from the queues of the other workers. Hence, unbalanced
+ *  task loads are distributed over the workers automatically.
  */
 class TL_PUBLIC JobBase
 {
@@ -163,6 +205,18 @@ public:
    */
   void schedule (Task *task);
 
+  /**
+   *  @brief Schedule a task for being processed with an affinity hint
+   *
+   *  Tasks with the same affinity value are sent to the same worker (the one with
+   *  index affinity modulo the number of workers). This way, tasks which share data
+   *  (e.g. neighboring tiles) can be executed by the same thread. Other workers will
+   *  take such a task only if they have run out of work. A negative affinity value
+   *  is equivalent to \schedule without an affinity hint: such tasks are distributed
+   *  over the workers in a round-robin fashion.
+   */
+  void schedule (Task *task, int affinity);
+
   /**
    *  @brief Start the execution of the job
    */
@@ -212,6 +266,20 @@ public:
    */
   std::vector<std::string> error_messages ();
 
+  /**
+   *  @brief Gets the execution statistics
+   *
+   *  The statistics are delivered per worker. The statistics are accumulated
+   *  over all runs of the job until \reset_statistics is called. In synchronous
+   *  mode, an empty vector is returned.
+   */
+  std::vector<WorkerStatistics> statistics ();
+
+  /**
+   *  @brief Resets the execution statistics
+   */
+  void reset_statistics ();
+
 protected:
   /**
    *  @brief Creates a worker object
@@ -259,9 +327,11 @@ private:
 
   TaskList m_task_list;
   TaskList *mp_per_worker_task_lists;
+  WorkerQueue *mp_work_queues;
 
   int m_nworkers;
   int m_idle_workers;
+  unsigned int m_next_worker;
   bool m_stopping;
   bool m_running;
 
@@ -275,6 +345,11 @@ private:
   std::vector<std::string> m_error_messages;
 
   Task *get_task (int for_worker);
+  Task *fetch_or_steal (int for_worker);
+  bool has_work ();
+  void dispatch (Task *task);
+  void clear_work_queues ();
+  void create_work_queues ();
   void log_error (const std::string &s);
 };
 
@@ -404,7 +479,7 @@ public:
    *  @brief Default ctor
    */
   Task () 
-    : mp_next (0), mp_last (0)
+    : mp_next (0), mp_last (0), m_affinity (-1)
   { }
 
   /**
@@ -415,8 +490,10 @@ public:
 
 private:
   friend class TaskList;
+  friend class JobBase;
 
   Task *mp_next, *mp_last;
+  int m_affinity;
 };
 
 /**
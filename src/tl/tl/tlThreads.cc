@@ -404,3 +404,29 @@ ThreadStorageHolderBase *ThreadStorageBase::holder ()
 }
 
 #endif
+
+// -------------------------------------------------------------------------------
+//  cpu_count implementation
+
+#if defined(HAVE_QT) && !defined(HAVE_PTHREADS)
+#  include "tlThreads.h"
+#endif
+
+namespace tl
+{
+
+unsigned int cpu_count ()
+{
+#if defined(HAVE_QT) && !defined(HAVE_PTHREADS)
+  int n = QThread::idealThreadCount ();
+#elif defined(_WIN32)
+  SYSTEM_INFO si;
+  GetSystemInfo (&si);
+  int n = int (si.dwNumberOfProcessors);
+#else
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+  return n > 0 ? (unsigned int) n : 1;
+}
+
+}
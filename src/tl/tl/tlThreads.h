@@ -259,6 +259,14 @@ public:
 
 #endif
 
+/**
+ *  @brief Gets the number of processor cores available
+ *
+ *  This number is a suggestion for the number of worker threads.
+ *  If the number can't be determined, 1 is returned.
+ */
+TL_PUBLIC unsigned int cpu_count ();
+
 }
 
 #endif
@@ -1071,6 +1071,71 @@ Variant::operator< (const tl::Variant &d) const
   }
 }
 
+static inline size_t
+hash_combine (size_t h, size_t v)
+{
+  return (h << 4) ^ (h >> 4) ^ v;
+}
+
+static size_t
+hash_chars (const char *cp, size_t n)
+{
+  size_t h = 0;
+  for ( ; n > 0; --n, ++cp) {
+    h = (h << 5) - h + size_t ((unsigned char) *cp);
+  }
+  return h;
+}
+
+size_t
+Variant::hash () const
+{
+  type t = normalized_type (m_type);
+
+  if (t == t_nil) {
+    return 0;
+  } else if (t == t_bool) {
+    return m_var.m_bool ? 1 : 2;
+  } else if (is_integer_type (t) || t == t_double) {
+    //  integer and double values are equal if they are numerically equal, hence 
+    //  the double representation is used for the hash value
+    double d = to_double ();
+    if (d == 0.0) {
+      return 3;  //  also for -0.0
+    }
+    return hash_chars ((const char *) &d, sizeof (d));
+  } else if (t == t_id) {
+    return m_var.m_id;
+  } else if (t == t_string) {
+    const char *cp = to_string ();
+    return hash_chars (cp, strlen (cp));
+#if defined(HAVE_QT)
+  } else if (t == t_qstring) {
+    return hash_chars ((const char *) m_var.m_qstring->constData (), m_var.m_qstring->size () * sizeof (QChar));
+  } else if (t == t_qbytearray) {
+    return hash_chars (m_var.m_qbytearray->constData (), m_var.m_qbytearray->size ());
+#endif
+  } else if (t == t_list) {
+    size_t h = 4;
+    for (std::vector<tl::Variant>::const_iterator i = m_var.m_list->begin (); i != m_var.m_list->end (); ++i) {
+      h = hash_combine (h, i->hash ());
+    }
+    return h;
+  } else if (t == t_array) {
+    size_t h = 5;
+    for (std::map<tl::Variant, tl::Variant>::const_iterator i = m_var.m_array->begin (); i != m_var.m_array->end (); ++i) {
+      h = hash_combine (hash_combine (h, i->first.hash ()), i->second.hash ());
+    }
+    return h;
+  } else if (t == t_user) {
+    return size_t (m_var.mp_user.cls);
+  } else if (t == t_user_ref) {
+    return size_t (m_var.mp_user_ref.cls);
+  } else {
+    return 0;
+  }
+}
+
 bool 
 Variant::can_convert_to_float () const
 {
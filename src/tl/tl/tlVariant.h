@@ -590,6 +590,16 @@ public:
    */
   bool operator< (const Variant &d) const;
 
+  /**
+   *  @brief Computes a hash value
+   *
+   *  The hash value is compatible with the equality: variants which are equal
+   *  deliver the same hash value. Specifically, numerical values deliver the 
+   *  same hash value if they are numerically identical, regardless of their type.
+   *  For user types, the hash value is only derived from the class.
+   */
+  size_t hash () const;
+
   /**
    *  @brief Conversion to a string
    *
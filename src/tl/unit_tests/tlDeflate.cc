@@ -24,6 +24,7 @@
 #include "tlStream.h"
 #include "tlDeflate.h"
 #include "tlUnitTest.h"
+#include "tlTimer.h"
 
 #include "zlib.h"
 
@@ -118,3 +119,113 @@ TEST(3)
   delete[] hello;
 }
 
+
+//  Inflate benchmark and stream positioning after the DEFLATE block
+TEST(4)
+{
+  //  generate some layout-like text of about 16M
+  std::string text;
+  text.reserve (17 * 1024 * 1024);
+  size_t r = 1;
+  while (text.size () < 16 * 1024 * 1024) {
+    r *= 12361;
+    r ^= (r >> 8);
+    text += "boundary ";
+    text += tl::to_string (int (r % 64));
+    text += " 0 {";
+    text += tl::to_string (int ((r >> 4) % 100000));
+    text += " ";
+    text += tl::to_string (int ((r >> 12) % 1000) * 5);
+    text += "} {";
+    text += tl::to_string (int ((r >> 5) % 100000));
+    text += " 1000}\n";
+  }
+
+  tl::OutputStringStream oss;
+  {
+    tl::OutputStream os (oss);
+    tl::DeflateFilter fg (os);
+    fg.put (text.c_str (), text.size ());
+    fg.flush ();
+  }
+
+  //  append some bytes following the compressed block
+  std::string deflated = oss.string ();
+  deflated += "TAIL";
+
+  std::string out;
+  out.reserve (text.size ());
+
+  {
+    tl::SelfTimer timer ("Inflating 16M in chunks of 1..16 bytes");
+
+    tl::InputMemoryStream ims (deflated.c_str (), deflated.size ());
+    tl::InputStream is (ims);
+    is.inflate ();
+
+    size_t n = 0;
+    while (true) {
+      size_t chunk = (n++ % 16) + 1;
+      if (out.size () + chunk > text.size ()) {
+        chunk = text.size () - out.size ();
+      }
+      if (chunk == 0) {
+        break;
+      }
+      const char *b = is.get (chunk);
+      tl_assert (b != 0);
+      out.append (b, chunk);
+    }
+
+    //  the stream continues right after the compressed data
+    const char *tail = is.get (4);
+    EXPECT_EQ (tail != 0, true);
+    if (tail) {
+      EXPECT_EQ (std::string (tail, 4), "TAIL");
+    }
+  }
+
+  EXPECT_EQ (out.size (), text.size ());
+  EXPECT_EQ (out == text, true);
+
+  out.clear ();
+
+  {
+    tl::SelfTimer timer ("Inflating 16M in chunks of 16k");
+
+    tl::InputMemoryStream ims (deflated.c_str (), deflated.size ());
+    tl::InputStream is (ims);
+    is.inflate ();
+
+    while (out.size () < text.size ()) {
+      size_t chunk = std::min (text.size () - out.size (), size_t (16384));
+      const char *b = is.get (chunk);
+      tl_assert (b != 0);
+      out.append (b, chunk);
+    }
+  }
+
+  EXPECT_EQ (out == text, true);
+
+  //  reference: zlib
+  {
+    tl::SelfTimer timer ("Inflating 16M with zlib");
+
+    std::string zout;
+    zout.resize (text.size ());
+
+    z_stream zs;
+    zs.zalloc = (alloc_func) 0;
+    zs.zfree = (free_func) 0;
+    zs.opaque = (voidpf) 0;
+    zs.next_in = (Bytef *) deflated.c_str ();
+    zs.avail_in = (unsigned int) deflated.size ();
+    zs.next_out = (Bytef *) &zout [0];
+    zs.avail_out = (unsigned int) zout.size ();
+    inflateInit2 (&zs, -15);
+    inflate (&zs, Z_FINISH);
+    inflateEnd (&zs);
+
+    EXPECT_EQ (zout == text, true);
+  }
+}
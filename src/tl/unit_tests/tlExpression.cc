@@ -1104,6 +1104,19 @@ TEST(14)
   EXPECT_EQ (v.to_string (), std::string ("4"));
   v = e.parse ("var y=x==4; y").execute ();
   EXPECT_EQ (v.to_string (), std::string ("true"));
+
+  //  reset_vars keeps the parsed expressions valid
+  tl::Expression ex;
+  e.parse (ex, "var z; z = (z ? z + 1 : 1)");
+  v = ex.execute ();
+  EXPECT_EQ (v.to_string (), std::string ("1"));
+  v = ex.execute ();
+  EXPECT_EQ (v.to_string (), std::string ("2"));
+  e.reset_vars ();
+  v = ex.execute ();
+  EXPECT_EQ (v.to_string (), std::string ("1"));
+  v = e.parse ("x").execute ();
+  EXPECT_EQ (v.to_string (), std::string ("nil"));
 }
 
 // index
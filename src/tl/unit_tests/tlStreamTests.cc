@@ -22,6 +22,9 @@
 
 #include "tlStream.h"
 #include "tlUnitTest.h"
+#include "tlString.h"
+
+#include <memory>
 
 TEST(InputPipe1)
 {
@@ -42,3 +45,138 @@ TEST(InputPipe2)
   tl::info << "Process exit code: " << ret;
   EXPECT_NE (ret, 0);
 }
+
+TEST(InputMappedFile1)
+{
+  std::string fn = tmp_file ("tmp_mapped.txt");
+
+  std::string data;
+  for (int i = 0; i < 10000; ++i) {
+    data += tl::sprintf ("line %d\n", i);
+  }
+
+  {
+    tl::OutputStream os (fn, tl::OutputStream::OM_Plain);
+    os.put (data.c_str (), data.size ());
+  }
+
+  tl::InputStream is (fn);
+#if !defined(_WIN32)
+  EXPECT_EQ (dynamic_cast<tl::InputMappedFile *> (is.base ()) != 0, true);
+#endif
+
+  //  big chunks are delivered directly
+  EXPECT_EQ (is.blen (), data.size ());
+  const char *b = is.get (data.size () - 10);
+  EXPECT_EQ (b != 0, true);
+  EXPECT_EQ (std::string (b, data.size () - 10), data.substr (0, data.size () - 10));
+  EXPECT_EQ (is.pos (), data.size () - 10);
+
+  is.unget (5);
+  EXPECT_EQ (std::string (is.get (15), 15), data.substr (data.size () - 15));
+  EXPECT_EQ (is.get (1) == 0, true);
+
+  is.reset ();
+  EXPECT_EQ (is.pos (), size_t (0));
+
+  tl::TextInputStream tis (is);
+  EXPECT_EQ (tis.get_line (), "line 0");
+  EXPECT_EQ (tis.get_line (), "line 1");
+}
+
+TEST(InputMappedFile2)
+{
+  //  compressed and empty files are not mapped
+  std::string fn = tmp_file ("tmp_mapped.txt.gz");
+
+  {
+    tl::OutputStream os (fn, tl::OutputStream::OM_Zlib);
+    os << "HELLOWORLD\n";
+  }
+
+  {
+    tl::InputStream is (fn);
+#if !defined(_WIN32)
+    EXPECT_EQ (dynamic_cast<tl::InputMappedFile *> (is.base ()) == 0, true);
+#endif
+    tl::TextInputStream tis (is);
+    EXPECT_EQ (tis.get_line (), "HELLOWORLD");
+  }
+
+  std::string fn_empty = tmp_file ("tmp_mapped_empty.txt");
+
+  {
+    tl::OutputStream os (fn_empty, tl::OutputStream::OM_Plain);
+  }
+
+  {
+    tl::InputStream is (fn_empty);
+#if !defined(_WIN32)
+    EXPECT_EQ (dynamic_cast<tl::InputMappedFile *> (is.base ()) == 0, true);
+#endif
+    EXPECT_EQ (is.get (1) == 0, true);
+  }
+}
+
+TEST(InputSeek)
+{
+  std::string fn = tmp_file ("tmp_seek.txt");
+
+  std::string data;
+  for (int i = 0; i < 10000; ++i) {
+    data += tl::sprintf ("line %d\n", i);
+  }
+
+  {
+    tl::OutputStream os (fn, tl::OutputStream::OM_Plain);
+    os.put (data.c_str (), data.size ());
+  }
+
+  for (int mode = 0; mode < 2; ++mode) {
+
+    //  mode 0: default delegate (mapped where available), mode 1: plain file
+    std::auto_ptr<tl::InputStream> is (mode == 0 ? new tl::InputStream (fn) : new tl::InputStream (new tl::InputFile (fn)));
+
+    EXPECT_EQ (is->supports_seek (), true);
+    EXPECT_EQ (is->size (), data.size ());
+
+    is->seek (data.size () - 10);
+    EXPECT_EQ (is->pos (), data.size () - 10);
+    EXPECT_EQ (std::string (is->get (10), 10), data.substr (data.size () - 10));
+    EXPECT_EQ (is->get (1) == 0, true);
+
+    is->seek (10);
+    EXPECT_EQ (std::string (is->get (20), 20), data.substr (10, 20));
+
+    is->seek (50000);
+    EXPECT_EQ (std::string (is->get (20), 20), data.substr (50000, 20));
+
+    //  a reset after seek starts from the beginning
+    is->reset ();
+    EXPECT_EQ (is->pos (), size_t (0));
+    EXPECT_EQ (std::string (is->get (20), 20), data.substr (0, 20));
+
+    //  the buffer does not start at the beginning of the stream after a seek
+    //  and a get growing the buffer
+    is->seek (4096);
+    EXPECT_EQ (std::string (is->get (12000), 12000), data.substr (4096, 12000));
+    is->seek (100);
+    EXPECT_EQ (is->pos (), size_t (100));
+    EXPECT_EQ (std::string (is->get (1), 1), data.substr (100, 1));
+    is->seek (8000);
+    EXPECT_EQ (std::string (is->get (10), 10), data.substr (8000, 10));
+    is->reset ();
+    EXPECT_EQ (std::string (is->get (10), 10), data.substr (0, 10));
+
+    //  seek back into the buffered data
+    is->get (5000);
+    is->seek (200);
+    EXPECT_EQ (std::string (is->get (10), 10), data.substr (200, 10));
+
+  }
+
+  //  pipes can't seek
+  tl::InputPipe pipe ("echo HELLOWORLD");
+  tl::InputStream str (pipe);
+  EXPECT_EQ (str.supports_seek (), false);
+}
@@ -639,3 +639,231 @@ TEST(29)
   }
 }
 
+
+TEST(30) 
+{
+  tl::SelfTimer timer ("4 threads, 1000 tasks with affinity");
+  MyJob job (4);
+
+  s_sum[0].reset ();
+  s_sum[1].reset ();
+  s_sum[2].reset ();
+  s_sum[3].reset ();
+
+  for (int i = 0; i < 1000; ++i) {
+    job.schedule (new MyTask (10), i % 4);
+  }
+
+  job.start ();
+  job.wait ();
+  EXPECT_EQ (job.is_running (), false);
+
+  EXPECT_EQ (s_sum[0].sum () + s_sum[1].sum() + s_sum[2].sum() + s_sum[3].sum (), 10000);
+
+  std::vector<tl::WorkerStatistics> stat = job.statistics ();
+  EXPECT_EQ (stat.size (), size_t (4));
+
+  size_t tasks = 0;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = stat.begin (); s != stat.end (); ++s) {
+    tasks += s->tasks;
+    EXPECT_EQ (s->stolen <= s->tasks, true);
+    EXPECT_EQ (s->idle_time >= 0.0, true);
+  }
+  EXPECT_EQ (tasks, size_t (1000));
+
+  //  statistics are accumulated over runs
+  for (int i = 0; i < 100; ++i) {
+    job.schedule (new MyTask (10));
+  }
+
+  job.start ();
+  job.wait ();
+
+  stat = job.statistics ();
+  tasks = 0;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = stat.begin (); s != stat.end (); ++s) {
+    tasks += s->tasks;
+  }
+  EXPECT_EQ (tasks, size_t (1100));
+
+  job.reset_statistics ();
+
+  stat = job.statistics ();
+  tasks = 0;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = stat.begin (); s != stat.end (); ++s) {
+    tasks += s->tasks;
+  }
+  EXPECT_EQ (tasks, size_t (0));
+}
+
+TEST(31) 
+{
+  tl::SelfTimer timer ("4 threads, unbalanced load");
+  MyJob job (4);
+
+  s_sum[0].reset ();
+  s_sum[1].reset ();
+  s_sum[2].reset ();
+  s_sum[3].reset ();
+
+  //  all tasks go to worker 0 - the others need to steal
+  for (int i = 0; i < 400; ++i) {
+    job.schedule (new MyTask (1000), 0);
+  }
+
+  job.start ();
+  job.wait ();
+  EXPECT_EQ (job.is_running (), false);
+
+  EXPECT_EQ (s_sum[0].sum () + s_sum[1].sum() + s_sum[2].sum() + s_sum[3].sum (), 400000);
+
+  std::vector<tl::WorkerStatistics> stat = job.statistics ();
+  EXPECT_EQ (stat.size (), size_t (4));
+
+  size_t tasks = 0, stolen = 0;
+  for (std::vector<tl::WorkerStatistics>::const_iterator s = stat.begin (); s != stat.end (); ++s) {
+    tasks += s->tasks;
+    stolen += s->stolen;
+  }
+  EXPECT_EQ (tasks, size_t (400));
+  //  worker 0 never steals as it owns all tasks
+  EXPECT_EQ (stat [0].stolen, size_t (0));
+  EXPECT_EQ (stolen, tasks - stat [0].tasks);
+}
+
+TEST(32) 
+{
+  tl::TaskList list;
+  EXPECT_EQ (list.size (), size_t (0));
+
+  MyTask *t1 = new MyTask (1);
+  MyTask *t2 = new MyTask (2);
+  MyTask *t3 = new MyTask (3);
+
+  list.put (t2);
+  list.put (t3);
+  list.put_front (t1);
+  EXPECT_EQ (list.size (), size_t (3));
+
+  EXPECT_EQ (dynamic_cast<MyTask *> (list.fetch_back ())->m_n, 3);
+  EXPECT_EQ (dynamic_cast<MyTask *> (list.fetch ())->m_n, 1);
+  EXPECT_EQ (list.size (), size_t (1));
+  EXPECT_EQ (dynamic_cast<MyTask *> (list.fetch_back ())->m_n, 2);
+  EXPECT_EQ (list.size (), size_t (0));
+  EXPECT_EQ (list.is_empty (), true);
+
+  delete t1;
+  delete t2;
+  delete t3;
+
+  //  synchronous jobs don't deliver statistics
+  MyJob job (0);
+  EXPECT_EQ (job.statistics ().size (), size_t (0));
+}
+
+namespace
+{
+
+class CountingTask : public tl::Task
+{
+public:
+  CountingTask (int id, int spawn) : m_id (id), m_spawn (spawn) { }
+  int m_id, m_spawn;
+};
+
+class CountingJob;
+
+class CountingWorker : public tl::Worker
+{
+public:
+  CountingWorker (CountingJob *job) : tl::Worker (), mp_job (job), m_set_up (false) { }
+
+  void setup () { m_set_up = true; }
+
+protected:
+  void perform_task (tl::Task *task);
+
+private:
+  CountingJob *mp_job;
+  bool m_set_up;
+};
+
+class CountingJob : public tl::JobBase
+{
+public:
+  CountingJob (int w, int ntasks) : tl::JobBase (w), m_counts (ntasks, 0), m_not_set_up (0) { }
+
+  void count (int id, bool set_up)
+  {
+    m_lock.lock ();
+    ++m_counts [id];
+    if (! set_up) {
+      ++m_not_set_up;
+    }
+    m_lock.unlock ();
+  }
+
+  tl::Mutex m_lock;
+  std::vector<int> m_counts;
+  int m_not_set_up;
+
+protected:
+  tl::Worker *create_worker () { return new CountingWorker (this); }
+  void setup_worker (tl::Worker *worker) { dynamic_cast<CountingWorker *> (worker)->setup (); }
+};
+
+void CountingWorker::perform_task (tl::Task *task)
+{
+  CountingTask *ct = dynamic_cast<CountingTask *> (task);
+  if (ct) {
+    //  tasks with children schedule them while the job is running
+    for (int i = 0; i < ct->m_spawn; ++i) {
+      mp_job->schedule (new CountingTask (ct->m_id + 1 + i, 0), (ct->m_id + i) % 3);
+    }
+    mp_job->count (ct->m_id, m_set_up);
+  }
+}
+
+}
+
+//  stress test: no task is lost or executed twice, no task is executed before the worker is set up
+TEST(33) 
+{
+  tl::SelfTimer timer ("stress test for task stealing");
+
+  const int nparents = 2000, nchildren = 9;
+
+  for (int run = 0; run < 10; ++run) {
+
+    CountingJob job (4, nparents * (nchildren + 1));
+
+    for (int i = 0; i < nparents; ++i) {
+      //  all initial tasks go to the first worker, so the others need to steal
+      job.schedule (new CountingTask (i * (nchildren + 1), nchildren), 0);
+    }
+
+    job.start ();
+    job.wait ();
+    EXPECT_EQ (job.is_running (), false);
+
+    int lost = 0, duplicate = 0;
+    for (std::vector<int>::const_iterator c = job.m_counts.begin (); c != job.m_counts.end (); ++c) {
+      if (*c == 0) {
+        ++lost;
+      } else if (*c > 1) {
+        ++duplicate;
+      }
+    }
+    EXPECT_EQ (lost, 0);
+    EXPECT_EQ (duplicate, 0);
+    EXPECT_EQ (job.m_not_set_up, 0);
+
+    size_t tasks = 0;
+    std::vector<tl::WorkerStatistics> stat = job.statistics ();
+    for (std::vector<tl::WorkerStatistics>::const_iterator s = stat.begin (); s != stat.end (); ++s) {
+      tasks += s->tasks;
+    }
+    EXPECT_EQ (tasks, size_t (nparents * (nchildren + 1)));
+
+  }
+}
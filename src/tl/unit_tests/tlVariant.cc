@@ -1085,6 +1085,41 @@ TEST(5)
   EXPECT_EQ (m [" 3"], 0);
 }
 
+//  hash values
+TEST(6)
+{
+  EXPECT_EQ (tl::Variant ().hash () == tl::Variant ().hash (), true);
+  EXPECT_EQ (tl::Variant (1).hash () == tl::Variant (1l).hash (), true);
+  EXPECT_EQ (tl::Variant (1).hash () == tl::Variant ((long long) 1).hash (), true);
+  EXPECT_EQ (tl::Variant (1).hash () == tl::Variant (1.0).hash (), true);
+  EXPECT_EQ (tl::Variant ((unsigned int) 2).hash () == tl::Variant (2.0).hash (), true);
+  EXPECT_EQ (tl::Variant (0.0).hash () == tl::Variant (-0.0).hash (), true);
+  EXPECT_EQ (tl::Variant (0.0).hash () == tl::Variant (0).hash (), true);
+  EXPECT_EQ (tl::Variant (1).hash () == tl::Variant (2).hash (), false);
+  EXPECT_EQ (tl::Variant (1.0).hash () == tl::Variant (1.25).hash (), false);
+  EXPECT_EQ (tl::Variant ("abc").hash () == tl::Variant (std::string ("abc")).hash (), true);
+  EXPECT_EQ (tl::Variant ("abc").hash () == tl::Variant ("abd").hash (), false);
+  EXPECT_EQ (tl::Variant (true).hash () == tl::Variant (false).hash (), false);
+
+  tl::Variant l1 = tl::Variant::empty_list ();
+  l1.push (tl::Variant (1));
+  l1.push (tl::Variant ("x"));
+  tl::Variant l2 = tl::Variant::empty_list ();
+  l2.push (tl::Variant (1.0));
+  l2.push (tl::Variant ("x"));
+  EXPECT_EQ (l1 == l2, true);
+  EXPECT_EQ (l1.hash () == l2.hash (), true);
+  l2.push (tl::Variant ());
+  EXPECT_EQ (l1.hash () == l2.hash (), false);
+
+  tl::Variant a1 = tl::Variant::empty_array ();
+  a1.insert (tl::Variant ("k"), tl::Variant (17));
+  tl::Variant a2 = tl::Variant::empty_array ();
+  a2.insert (tl::Variant ("k"), tl::Variant (17.0));
+  EXPECT_EQ (a1 == a2, true);
+  EXPECT_EQ (a1.hash () == a2.hash (), true);
+}
+
 }
 
 
@@ -0,0 +1,99 @@
+# KLayout Layout Viewer
+# Copyright (C) 2006-2019 Matthias Koefferlein
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+# Measures the per-call overhead of the Python binding for overloaded
+# and non-overloaded methods with scalar and object arguments. This script
+# is not part of the test suite. Each case is run several times and the
+# best time is reported.
+#
+# Usage: python bench_dispatch.py [count]
+
+import klayout.db as db
+import sys
+import time
+
+def measure(name, func, n, repeat = 5):
+  best = None
+  for r in range(0, repeat):
+    start = time.time()
+    func(n)
+    dt = time.time() - start
+    if best is None or dt < best:
+      best = dt
+  print("%-44s %8.3f us/call" % (name, best * 1e6 / n))
+
+def plain_call(n):
+  # not overloaded
+  b = db.Box(0, 0, 100, 200)
+  for i in range(0, n):
+    b.width()
+
+def plain_object_arg(n):
+  # not overloaded, object argument
+  b = db.Box(0, 0, 100, 200)
+  b2 = db.Box(50, 50, 300, 300)
+  for i in range(0, n):
+    b.overlaps(b2)
+
+def point_arg(n):
+  # Box#contains with a Point or with x and y
+  b = db.Box(0, 0, 100, 200)
+  p = db.Point(10, 20)
+  for i in range(0, n):
+    b.contains(p)
+
+def scalar_args(n):
+  # overloaded: Box#* with a Box (convolution) or a number (scaling)
+  b = db.Box(0, 0, 100, 200)
+  for i in range(0, n):
+    b * 2.0
+
+def object_args(n):
+  # overloaded: Region#insert with Box, Polygon, Path, ...
+  r = db.Region()
+  box = db.Box(0, 0, 100, 200)
+  for i in range(0, n):
+    r.insert(box)
+
+def alternating_args(n):
+  # overloaded with varying argument types
+  r = db.Region()
+  box = db.Box(0, 0, 100, 200)
+  poly = db.Polygon(box)
+  for i in range(0, n // 2):
+    r.insert(box)
+    r.insert(poly)
+
+def list_args(n):
+  # overloaded with a list argument - resolution is not cached
+  r = db.Region()
+  polys = [ db.Polygon(db.Box(0, 0, 100, 200)) ]
+  for i in range(0, n):
+    r.insert(polys)
+
+n = 200000
+if len(sys.argv) > 1:
+  n = int(sys.argv[1])
+
+measure("non-overloaded method", plain_call, n)
+measure("non-overloaded method, object argument", plain_object_arg, n)
+measure("Point argument", point_arg, n)
+measure("overloaded method, scalar argument", scalar_args, n)
+measure("overloaded method, object argument", object_args, n)
+measure("overloaded method, alternating types", alternating_args, n)
+measure("overloaded method, list argument", list_args, n)
@@ -41,6 +41,99 @@ class BasicTest(unittest.TestCase):
     v.read(os.path.join(os.path.dirname(__file__), "..", "gds", "t10.gds"))
     self.assertEqual(v.top_cell().name, "RINGO")
 
+  def test_4(self):
+    # long-running methods release the GIL, so they can run in several Python threads
+    import threading
+    results = [ None ] * 4
+    def work(i):
+      r1 = db.Region()
+      r2 = db.Region()
+      for j in range(0, 100):
+        r1.insert(db.Box(j * 20, 0, j * 20 + 15, 1000))
+        r2.insert(db.Box(0, j * 20, 1000 + i, j * 20 + 15))
+      results[i] = (r1 & r2).area()
+    threads = [ threading.Thread(target = work, args = (i, )) for i in range(0, 4) ]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+    self.assertEqual(results, [ 750 * (750 + i) for i in range(0, 4) ])
+
+  def test_5(self):
+    # callbacks reacquire the GIL, even if issued from worker threads
+    class AreaReceiver(db.TileOutputReceiver):
+      area = 0
+      def put(self, ix, iy, tile, obj, dbu, clip):
+        self.area += obj
+    rin = db.Region()
+    rin.insert(db.Box(0, 0, 10000, 10000))
+    tp = db.TilingProcessor()
+    tp.input("in", rin)
+    rec = AreaReceiver()
+    tp.output("out", rec)
+    tp.dbu = 0.1
+    tp.tile_size(200.0, 500.0)
+    tp.threads = 2
+    tp.queue("_output(out, in.area(_tile.bbox))")
+    tp.execute("A job")
+    self.assertEqual(rec.area, 100000000)
+
+  def test_6(self):
+    # bulk access to the geometry through the buffer protocol
+    r = db.Region()
+    r.insert(db.Box(0, 0, 100, 200))
+    r.insert(db.Box(10, 20, 30, 40))
+    v = memoryview(r.box_array())
+    self.assertEqual(v.shape, (2, 4))
+    self.assertEqual(v.tolist(), [ [ 0, 0, 100, 200 ], [ 10, 20, 30, 40 ] ])
+    a = db.CoordArray(1, 2)
+    memoryview(a)[0, 1] = 17
+    self.assertEqual(a.value(0, 1), 17)
+    self.assertEqual(str(a), "0,17")
+
+  def test_7(self):
+    # bulk insertion from coordinate arrays
+    a = db.CoordArray(2, 4)
+    memoryview(a)[1, 2] = 100
+    memoryview(a)[1, 3] = 200
+    r = db.Region()
+    r.insert_boxes(a)
+    self.assertEqual(str(r), "(0,0;0,200;100,200;100,0)")
+    s = db.Shapes()
+    s.insert_boxes(a)
+    self.assertEqual(s.size(), 2)
+    r.insert(db.Box(10, 20, 30, 40))
+    r2 = db.Region()
+    r2.insert_polygons(r.point_array(), r.contour_array())
+    self.assertEqual(str(r2), str(r))
+
+  def test_8(self):
+    # overload resolution is cached per argument types - alternating types must still pick the right variant
+    class MyBox(db.Box):
+      pass
+    r = db.Region()
+    for i in range(0, 10):
+      r.insert(db.Box(i * 10, 0, i * 10 + 5, 5))
+      r.insert(db.Polygon(db.Box(i * 10, 10, i * 10 + 5, 15)))
+      r.insert([ db.Polygon(db.Box(i * 10, 20, i * 10 + 5, 25)) ])
+      r.insert(MyBox(i * 10, 30, i * 10 + 5, 35))
+    self.assertEqual(r.size(), 40)
+    self.assertEqual(r.area(), 1000)
+
+  def test_9(self):
+    # an array cannot be assigned or destroyed while its buffer is exported
+    a = db.CoordArray(1, 2)
+    v = memoryview(a)
+    self.assertRaises(RuntimeError, lambda: a.assign(db.CoordArray(100, 4)))
+    self.assertRaises(RuntimeError, lambda: a._destroy())
+    v[0, 1] = 17
+    self.assertEqual(str(a), "0,17")
+    v.release()
+    a.assign(db.CoordArray(2, 1))
+    self.assertEqual(str(a), "0;0")
+    a._destroy()
+    self.assertEqual(a._destroyed(), True)
+
 # run unit tests
 if __name__ == '__main__':
   suite = unittest.TestSuite()
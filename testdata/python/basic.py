@@ -2726,6 +2726,23 @@ class BasicTest(unittest.TestCase):
     go = None
     self.assertEqual(pya.GObject.g_inst_count(), gc)
 
+  # overload resolution cache and const object arguments
+  def test_81(self):
+    fc = pya.F.ic()
+    fnc = pya.F.inc()
+    self.assertEqual(fc.is_const_object(), True)
+    self.assertEqual(fnc.is_const_object(), False)
+    for i in range(0, 3):
+      # a const object can't be passed to "F &"
+      self.assertEqual(pya.F.ov(fnc), "F&")
+      err = ""
+      try:
+        pya.F.ov(fc)
+      except Exception as ex:
+        err = str(ex)
+      self.assertEqual(err.find("No overload with matching arguments") >= 0, True)
+      self.assertEqual(pya.F.ov(17), "int")
+
 
 # run unit tests
 if __name__ == '__main__':
@@ -0,0 +1,78 @@
+# KLayout Layout Viewer
+# Copyright (C) 2006-2019 Matthias Koefferlein
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+
+import pya
+import unittest
+import sys
+
+class AreaReceiver(pya.TileOutputReceiver):
+
+  area = 0
+  tiles = 0
+
+  def put(self, ix, iy, tile, obj, dbu, clip):
+    self.area += obj
+    self.tiles += 1
+
+class DBTilingProcessorTest(unittest.TestCase):
+
+  # "execute" releases the GIL while it waits for the worker threads
+  def test_1_ThreadedReceiver(self):
+
+    rin = pya.Region()
+    rin.insert(pya.Box(0, 0, 10000, 10000))
+    rin.insert(pya.Box(20000, 0, 30000, 10000))
+
+    tp = pya.TilingProcessor()
+    tp.input("in", rin)
+    rec = AreaReceiver()
+    tp.output("out", rec)
+    tp.dbu = 0.1
+    tp.tile_size(200.0, 500.0)
+    tp.threads = 4
+    tp.queue("_output(out, in.area(_tile.bbox))")
+    tp.execute("Threaded receiver")
+
+    self.assertEqual(rec.area, 200000000)
+    self.assertEqual(rec.tiles, 30)
+
+  # Region outputs are filled by the worker threads directly
+  def test_2_ThreadedRegion(self):
+
+    rin = pya.Region()
+    rin.insert(pya.Box(0, 0, 10000, 10000))
+
+    tp = pya.TilingProcessor()
+    tp.input("in", rin)
+    rout = pya.Region()
+    tp.output("out", rout)
+    tp.dbu = 0.1
+    tp.tile_size(200.0, 500.0)
+    tp.threads = 4
+    tp.queue("_output(out, in.sized(-10))")
+    tp.execute("Threaded region")
+
+    self.assertEqual(rout.merged().area(), 9980 * 9980)
+
+# run unit tests
+if __name__ == '__main__':
+  suite = unittest.TestLoader().loadTestsFromTestCase(DBTilingProcessorTest)
+
+  if not unittest.TextTestRunner(verbosity = 1).run(suite).wasSuccessful():
+    sys.exit(1)
+
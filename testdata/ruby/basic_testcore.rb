@@ -2635,4 +2635,27 @@ class Basic_TestClass < TestBase
 
   end
 
+  # overload resolution cache and const object arguments
+  def test_81
+
+    fc = RBA::F.ic
+    fnc = RBA::F.inc
+    assert_equal(fc.is_const_object?, true)
+    assert_equal(fnc.is_const_object?, false)
+
+    3.times do
+      # a const object can't be passed to "F &"
+      assert_equal(RBA::F.ov(fnc), "F&")
+      e = ""
+      begin
+        RBA::F.ov(fc)
+      rescue => ex
+        e = ex.to_s
+      end
+      assert_equal(e =~ /No overload with matching arguments/ ? true : false, true)
+      assert_equal(RBA::F.ov(17), "int")
+    end
+
+  end
+
 end
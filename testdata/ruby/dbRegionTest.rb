@@ -763,6 +763,25 @@ class DBRegion_TestClass < TestBase
 
   end
 
+  # hierarchical count
+  def test_15
+
+    ly = RBA::Layout::new
+    l1 = ly.layer(1, 0)
+    top = ly.create_cell("TOP")
+    c = ly.create_cell("C")
+    c.shapes(l1).insert(RBA::Box::new(0, 0, 10, 10))
+    top.insert(RBA::CellInstArray::new(c.cell_index, RBA::Trans::new, RBA::Vector::new(100, 0), RBA::Vector::new(0, 100), 5, 5))
+
+    r = RBA::Region::new(top.begin_shapes_rec(l1))
+    assert_equal(r.hier_count, 1)
+    assert_equal(r.size, 25)
+
+    r.insert(RBA::Box::new(0, 0, 10, 10))
+    assert_equal(r.hier_count, 26)
+
+  end
+
 end
 
 load("test_epilogue.rb")
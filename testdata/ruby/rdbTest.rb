@@ -838,6 +838,78 @@ class RDB_TestClass < TestBase
 
   end
 
+  # adding values and items while iterating
+  def test_13
+
+    rdb = RBA::ReportDatabase.new("neu")
+    cat = rdb.create_category("cat")
+    cell = rdb.create_cell("c1")
+
+    item = rdb.create_item(cell.rdb_id, cat.rdb_id)
+    item.add_value("v0")
+    item.add_value("v1")
+
+    vals = []
+    added = 0
+    item.each_value do |v|
+      vals << v
+      if added < 100
+        10.times { |i| item.add_value("w#{i}") }
+        added += 10
+      end
+    end
+    nv = 0
+    item.each_value { |v| nv += 1 }
+    assert_equal(nv, 102)
+    assert_equal(vals.size >= 2, true)
+    assert_equal(vals[0].to_s, "text: v0")
+    assert_equal(vals[1].to_s, "text: v1")
+
+    # the value objects taken from the iterator stay valid
+    1000.times { |i| item.add_value("x#{i}") }
+    assert_equal(vals[0].to_s, "text: v0")
+    assert_equal(vals[1].to_s, "text: v1")
+
+    4.times { rdb.create_item(cell.rdb_id, cat.rdb_id) }
+
+    items = []
+    rdb.each_item do |i|
+      items << i
+      100.times { rdb.create_item(cell.rdb_id, cat.rdb_id) }
+    end
+    # items created while iterating are not visited
+    assert_equal(items.size, 5)
+    assert_equal(rdb.num_items, 505)
+
+    n = 0
+    rdb.each_item_per_category(cat.rdb_id) do |i|
+      n += 1
+      rdb.create_item(cell.rdb_id, cat.rdb_id)
+    end
+    assert_equal(n, 505)
+    n = 0
+    rdb.each_item_per_cell(cell.rdb_id) do |i|
+      n += 1
+      rdb.create_item(cell.rdb_id, cat.rdb_id)
+    end
+    assert_equal(n, 1010)
+    n = 0
+    rdb.each_item_per_cell_and_category(cell.rdb_id, cat.rdb_id) do |i|
+      n += 1
+      rdb.create_item(cell.rdb_id, cat.rdb_id)
+    end
+    assert_equal(n, 2020)
+    assert_equal(rdb.num_items, 4040)
+
+    # the item objects taken from the iterator stay valid
+    assert_equal(items[0].cell_id, cell.rdb_id)
+    assert_equal(items[0].category_id, cat.rdb_id)
+    nv = 0
+    items[0].each_value { |v| nv += 1 }
+    assert_equal(nv, 1102)
+
+  end
+
 end
 
 load("test_epilogue.rb")